@@ -1,8 +1,110 @@
 #include <core/core.hpp>
 
+#include <charconv>
 #include <iostream>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+// Empty unless the whole text is a number.
+template <typename T>
+static std::optional<T>
+s_parse(std::string_view text) {
+    T value {};
+    char const* const end = text.data() + text.size();
+    auto const [last, error] = std::from_chars(text.data(), end, value);
+
+    if (error != std::errc {} || last != end) {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+static constexpr std::string_view s_usage {
+    "Usage: app [--headless] [--frames N] [--size WxH] [--capture out.png]\n"
+    "           [--latency low|balanced|throughput] [--objects N]\n"
+    "           [--cpu-culling] [--no-occlusion] [--lod-error PX]\n"
+    "           [--render-pass]\n"
+};
 
 int
-main() {
-    core::run();
-}
\ No newline at end of file
+main(int argc, char** argv) {
+    core::RendererSettings settings {};
+
+    // Stores the number, or prints why not and returns false.
+    auto const parse = [](auto& value, std::string_view text) {
+        auto const parsed = s_parse<std::remove_cvref_t<decltype(value)>>(text);
+
+        if (!parsed) {
+            std::cerr << "Not a valid number: " << text << '\n' << s_usage;
+            return false;
+        }
+
+        value = *parsed;
+        return true;
+    };
+
+    for (int i {1}; i < argc; ++i) {
+        std::string_view const arg {argv[i]};
+        bool const has_value = i + 1 < argc;
+
+        if (arg == "--headless") {
+            settings.headless = true;
+        } else if (arg == "--frames" && has_value) {
+            if (!parse(settings.frame_count, argv[++i])) {
+                return 1;
+            }
+        } else if (arg == "--size" && has_value) {
+            std::string_view const size {argv[++i]};
+            auto const x = size.find('x');
+
+            if (x == std::string_view::npos) {
+                std::cerr << "Expected --size WxH, got: " << size << '\n'
+                          << s_usage;
+                return 1;
+            }
+
+            if (!parse(settings.width, size.substr(0, x)) ||
+                !parse(settings.height, size.substr(x + 1))) {
+                return 1;
+            }
+        } else if (arg == "--capture" && has_value) {
+            settings.capture_path = argv[++i];
+        } else if (arg == "--latency" && has_value) {
+            std::string_view const mode {argv[++i]};
+
+            if (mode == "low") {
+                settings.latency_mode = core::LatencyMode::LowLatency;
+            } else if (mode == "balanced") {
+                settings.latency_mode = core::LatencyMode::Balanced;
+            } else if (mode == "throughput") {
+                settings.latency_mode = core::LatencyMode::Throughput;
+            } else {
+                std::cerr << "Unknown latency mode: " << mode << '\n'
+                          << s_usage;
+                return 1;
+            }
+        } else if (arg == "--objects" && has_value) {
+            if (!parse(settings.object_count, argv[++i])) {
+                return 1;
+            }
+        } else if (arg == "--cpu-culling") {
+            settings.gpu_culling = false;
+        } else if (arg == "--no-occlusion") {
+            settings.occlusion_culling = false;
+        } else if (arg == "--lod-error" && has_value) {
+            if (!parse(settings.lod_error_threshold, argv[++i])) {
+                return 1;
+            }
+        } else if (arg == "--render-pass") {
+            settings.dynamic_rendering = false;
+        } else {
+            std::cerr << "Unknown argument: " << arg << '\n' << s_usage;
+            return 1;
+        }
+    }
+
+    core::run(settings);
+}
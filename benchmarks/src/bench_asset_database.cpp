@@ -0,0 +1,150 @@
+#include <core/asset_database.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace core;
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+// Touch every byte so lazily faulted mappings are not unfairly fast.
+u64
+checksum(std::span<std::byte const> bytes) noexcept {
+    u64 sum {0};
+    for (std::byte const b : bytes) {
+        sum += static_cast<u64>(b);
+    }
+    return sum;
+}
+
+template <typename Fn>
+f64
+time_ms(u32 iterations, Fn&& fn) {
+    auto const start = clock_type::now();
+    for (u32 i {}; i < iterations; ++i) {
+        fn();
+    }
+    auto const end = clock_type::now();
+
+    return std::chrono::duration<f64, std::milli>(end - start).count() /
+        iterations;
+}
+
+void
+report(std::string const& name, usize bytes, f64 read_ms, f64 map_ms) {
+    f64 const mib = static_cast<f64>(bytes) / (1024.0 * 1024.0);
+    Log::info(name, " (", mib, " MiB)");
+    Log::sub_info("read: ", read_ms, " ms, ", mib / (read_ms / 1e3), " MiB/s");
+    Log::sub_info("map:  ", map_ms, " ms, ", mib / (map_ms / 1e3), " MiB/s");
+}
+
+void
+bench_asset(std::string const& relative_path, u32 iterations) {
+    u64 sink {0};
+
+    f64 const read_ms = time_ms(iterations, [&] {
+        std::string const buffer =
+            AssetDatabase::read_asset_file(relative_path);
+        sink += checksum(std::as_bytes(std::span {buffer}));
+    });
+
+    f64 const map_ms = time_ms(iterations, [&] {
+        MappedAsset const asset = AssetDatabase::map_asset_file(relative_path);
+        sink += checksum(asset.bytes());
+    });
+
+    usize const size = AssetDatabase::map_asset_file(relative_path).size();
+    report(relative_path, size, read_ms, map_ms);
+    Log::sub_info((usize)2, "checksum: ", sink);
+}
+
+// Same strategy as AssetDatabase::read_asset_file(), but for paths that
+// live outside the assets root.
+std::string
+read_whole_file(std::filesystem::path const& path) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    std::string buffer(static_cast<usize>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    return buffer;
+}
+
+void
+bench_large_file(usize size_bytes, u32 iterations) {
+    std::filesystem::path const path =
+        std::filesystem::temp_directory_path() / "v_engine_bench_asset.bin";
+
+    {
+        std::vector<char> block(1024 * 1024);
+        for (usize i {}; i < block.size(); ++i) {
+            block[i] = static_cast<char>(i * 31);
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        for (usize written {}; written < size_bytes; written += block.size()) {
+            out.write(block.data(), static_cast<std::streamsize>(block.size()));
+        }
+    }
+
+    u64 sink {0};
+
+    f64 const read_ms = time_ms(iterations, [&] {
+        std::string const buffer = read_whole_file(path);
+        sink += checksum(std::as_bytes(std::span {buffer}));
+    });
+
+    f64 const map_ms = time_ms(iterations, [&] {
+        MappedAsset const asset = MappedAsset::open(path);
+        sink += checksum(asset.bytes());
+    });
+
+    report("synthetic", std::filesystem::file_size(path), read_ms, map_ms);
+    Log::sub_info((usize)2, "checksum: ", sink);
+
+    std::filesystem::remove(path);
+}
+
+void
+bench_lookups(std::string const& relative_path, u32 iterations) {
+    u64 sink {0};
+
+    // What every lookup used to cost: build a path and stat() it.
+    f64 const uncached_ms = time_ms(iterations, [&] {
+        std::filesystem::path const path =
+            AssetDatabase::root() / relative_path;
+        sink += std::filesystem::exists(path);
+    });
+
+    f64 const cached_ms = time_ms(iterations, [&] {
+        sink += AssetDatabase::exists(relative_path);
+        sink += AssetDatabase::resolve(relative_path).native().size();
+    });
+
+    Log::info("lookup ", relative_path);
+    Log::sub_info("uncached: ", uncached_ms * 1e6, " ns");
+    Log::sub_info("cached:   ", cached_ms * 1e6, " ns");
+    Log::sub_info((usize)2, "checksum: ", sink);
+}
+
+} // namespace
+
+int
+main() {
+    Log::header("AssetDatabase: read vs map");
+
+    constexpr u32 iterations {50};
+    bench_asset("shaders/sh_default.vert", iterations);
+    bench_asset("textures/tex_viking_room.png", iterations);
+    bench_asset("models/model_viking_room.obj", iterations);
+
+    bench_lookups("models/model_viking_room.obj", 1'000'000);
+
+    constexpr usize large_size {256UL * 1024UL * 1024UL};
+    bench_large_file(large_size, 5);
+}
@@ -0,0 +1,156 @@
+#include <core/components.hpp>
+#include <core/job_system.hpp>
+#include <core/log.hpp>
+#include <core/transform_hierarchy.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace core;
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+template <typename Fn>
+f64
+time_ms(u32 iterations, Fn&& fn) {
+    auto const start = clock_type::now();
+    for (u32 i {}; i < iterations; ++i) {
+        fn();
+    }
+    auto const end = clock_type::now();
+
+    return std::chrono::duration<f64, std::milli>(end - start).count() /
+        iterations;
+}
+
+void
+report(char const* name, usize node_count, f64 ms) {
+    f64 const millions = static_cast<f64>(node_count) / 1e6;
+    Log::sub_info(name, ms, " ms, ", millions / (ms / 1e3), " M nodes/s");
+}
+
+glm::mat4
+local_matrix(Transform const& transform) noexcept {
+    return glm::translate(glm::mat4(1.0f), transform.position) *
+        glm::mat4_cast(transform.rotation) *
+        glm::scale(glm::mat4(1.0f), transform.scale);
+}
+
+Transform
+local_of(usize node) noexcept {
+    f32 const t = static_cast<f32>(node % 1'024) * 0.01f;
+
+    return {
+        .position = glm::vec3(t, 1.0f, 0.0f),
+        .rotation = glm::angleAxis(t, glm::vec3(0.0f, 0.0f, 1.0f)),
+        .scale = glm::vec3(1.0f),
+    };
+}
+
+// What the hierarchy would be without it: one struct per node, parents
+// first.
+struct Node {
+    Transform local {};
+    u32 parent {0};
+    bool root {true};
+    glm::mat4 world {1.0f};
+};
+
+} // namespace
+
+int
+main() {
+    // 1'000 roots, 100 children each, 10 grandchildren each child.
+    constexpr u32 root_count {1'000};
+    constexpr u32 children {100};
+    constexpr u32 grandchildren {10};
+    constexpr u32 iterations {20};
+
+    Log::header("Transform hierarchy: world matrices of 1.1M nodes");
+
+    JobSystem serial {};
+    JobSystem jobs {};
+    jobs.start(std::max(std::thread::hardware_concurrency(), 2U) - 1);
+    Log::info("Job system workers: ", jobs.worker_count());
+
+    TransformHierarchy hierarchy {};
+    std::vector<Node> nodes {};
+    std::vector<TransformNode> roots {};
+
+    for (u32 root {}; root < root_count; ++root) {
+        TransformNode const root_node = hierarchy.create();
+        nodes.push_back({});
+        roots.push_back(root_node);
+
+        for (u32 child {}; child < children; ++child) {
+            TransformNode const child_node = hierarchy.create(root_node);
+            nodes.push_back({.parent = root_node, .root = false});
+
+            for (u32 grandchild {}; grandchild < grandchildren; ++grandchild) {
+                hierarchy.create(child_node);
+                nodes.push_back({.parent = child_node, .root = false});
+            }
+        }
+    }
+
+    usize const node_count = nodes.size();
+
+    for (usize node {}; node < node_count; ++node) {
+        nodes[node].local = local_of(node);
+        hierarchy.set_local(static_cast<TransformNode>(node), local_of(node));
+    }
+
+    // Sorts by depth once.
+    hierarchy.update(jobs);
+
+    auto const set_all = [&] {
+        for (usize node {}; node < node_count; ++node) {
+            hierarchy.set_local(
+                static_cast<TransformNode>(node),
+                nodes[node].local
+            );
+        }
+    };
+
+    Log::info("every node moved");
+
+    report("array of structs:        ", node_count, time_ms(iterations, [&] {
+        for (Node& node : nodes) {
+            glm::mat4 const local = local_matrix(node.local);
+            node.world = node.root ? local : nodes[node.parent].world * local;
+        }
+    }));
+
+    report("hierarchy:               ", node_count, time_ms(iterations, [&] {
+        set_all();
+        hierarchy.update(serial);
+    }));
+
+    report("hierarchy, parallel:     ", node_count, time_ms(iterations, [&] {
+        set_all();
+        hierarchy.update(jobs);
+    }));
+
+    // Dirty flags: most subtrees are static.
+    Log::info("1% of the roots moved");
+
+    report("hierarchy, parallel:     ", node_count, time_ms(iterations, [&] {
+        for (usize root {}; root < root_count; root += 100) {
+            hierarchy.set_local(roots[root], nodes[roots[root]].local);
+        }
+        hierarchy.update(jobs);
+    }));
+
+    Log::sub_info(
+        (usize)2,
+        "checksum: ",
+        hierarchy.world(static_cast<TransformNode>(node_count - 1))[3][0] +
+            nodes.back().world[3][0]
+    );
+}
@@ -1,13 +1,47 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(binding = 1) uniform sampler2D tex_sampler;
+// Cutout: fragments under half coverage are discarded.
+#pragma shader_feature ALPHA_TEST
+
+struct Material {
+    vec4 base_color;
+    uint albedo_texture;
+    uint sampler_index;
+    uint padding0;
+    uint padding1;
+};
+
+layout(set = 0, binding = 1) readonly buffer Materials {
+    Material materials[];
+};
+
+// Bindless: every texture and sampler, indexed through the material.
+layout(set = 1, binding = 0) uniform texture2D textures[];
+layout(set = 1, binding = 1) uniform sampler samplers[];
 
 layout(location = 0) in vec3 frag_color;
 layout(location = 1) in vec2 frag_tex_coord;
+layout(location = 2) flat in uint frag_material_id;
 
 layout(location = 0) out vec4 out_color;
 
 void
 main() {
-    out_color = texture(tex_sampler, frag_tex_coord);
+    Material material = materials[frag_material_id];
+    vec4 albedo = texture(
+        nonuniformEXT(sampler2D(
+            textures[material.albedo_texture],
+            samplers[material.sampler_index]
+        )),
+        frag_tex_coord
+    );
+
+    out_color = material.base_color * albedo;
+
+#ifdef ALPHA_TEST
+    if (out_color.a < 0.5) {
+        discard;
+    }
+#endif
 }
\ No newline at end of file
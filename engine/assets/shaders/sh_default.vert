@@ -1,22 +1,67 @@
 #version 450
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
+// Indirect draws carry no per-draw push constants, the material comes
+// from the object instead.
+layout(constant_id = 0) const bool GPU_DRIVEN = true;
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 view;
     mat4 projection;
+    vec4 frustum_planes[6];
+    vec4 camera_position;
+    float projection_scale;
+    float lod_error_threshold;
 } ubo;
 
+struct Object {
+    mat4 model;
+    vec4 bounding_sphere;
+    uint index_count;
+    uint first_index;
+    int vertex_offset;
+    uint material_id;
+    uint first_meshlet;
+    uint meshlet_count; // 0: drawn as a whole.
+    uint first_lod;
+    uint lod_count; // 0: no levels, always the full mesh.
+};
+
+layout(set = 0, binding = 2) readonly buffer Objects {
+    Object objects[];
+};
+
+layout(push_constant) uniform DrawConstants {
+    mat4 model;
+    uint material_id;
+    uint pushed_model; // Bool.
+} draw;
+
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 layout(location = 2) in vec2 tex_coords;
 
 layout(location = 0) out vec3 frag_color;
 layout(location = 1) out vec2 frag_tex_coords;
+layout(location = 2) flat out uint frag_material_id;
 
 void
 main() {
-    gl_Position =
-        ubo.projection * ubo.view * ubo.model * vec4(position, 1.0);
+    mat4 model;
+    uint material_id;
+
+    if (!GPU_DRIVEN && draw.pushed_model != 0) {
+        // A single instance, never written to the instance buffer.
+        model = draw.model;
+        material_id = draw.material_id;
+    } else {
+        // Draws start at their first instance in the instance buffer.
+        Object object = objects[gl_InstanceIndex];
+        model = object.model;
+        material_id = GPU_DRIVEN ? object.material_id : draw.material_id;
+    }
+
+    gl_Position = ubo.projection * ubo.view * model * vec4(position, 1.0);
     frag_color = color;
     frag_tex_coords = tex_coords;
+    frag_material_id = material_id;
 }
\ No newline at end of file
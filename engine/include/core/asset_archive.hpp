@@ -0,0 +1,149 @@
+// include/core/asset_archive.hpp
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "asset_id.hpp"
+#include "hash.hpp"
+#include "log.hpp"
+#include "mapped_asset.hpp"
+#include "types.hpp"
+
+namespace core {
+
+// Packed asset archive (.pak).
+//
+// One file, one mmap: instead of an exists() + open() + read() per asset,
+// every lookup is a hash probe into a table that lives inside the mapping.
+//
+// Layout (little-endian, every section is 8-byte aligned):
+//   PakHeader
+//   PakEntry[entry_count]      sorted by path_hash.
+//   u32[bucket_count]          open addressing table, entry index or empty.
+//   char[strings_size]         entry paths, for collision checks / listing.
+//   data...                    each entry aligned to data_alignment.
+struct PakHeader {
+    static constexpr u32 s_magic {0x4B415056}; // "VPAK".
+    static constexpr u32 s_version {1};
+
+    u32 magic {s_magic};
+    u32 version {s_version};
+    u32 entry_count {0};
+    u32 bucket_count {0}; // Power of two.
+    u64 entries_offset {0};
+    u64 buckets_offset {0};
+    u64 strings_offset {0};
+    u64 strings_size {0};
+    u32 data_alignment {0};
+    u32 flags {0};
+};
+
+enum class PakCompression : u32 {
+    None = 0,
+    Lz4 = 1,
+};
+
+struct PakEntry {
+    u64 path_hash {0}; // hash_fnv1a() of the normalized relative path.
+    u64 content_hash {0}; // hash_fnv1a() of the uncompressed bytes.
+    u64 offset {0}; // From the start of the archive.
+    u64 size {0}; // Uncompressed.
+    u64 stored_size {0}; // As stored in the archive.
+    u32 path_offset {0}; // Into the strings section.
+    u32 path_length {0};
+    PakCompression compression {PakCompression::None};
+    u32 reserved {0};
+};
+
+static_assert(sizeof(PakHeader) == 56);
+static_assert(sizeof(PakEntry) == 56);
+
+// Assets are keyed by their path relative to the assets root, always
+// with forward slashes ("shaders/sh_default.vert").
+std::string
+normalize_asset_path(std::string_view relative_path);
+
+class AssetArchive : public std::enable_shared_from_this<AssetArchive> {
+public:
+    static constexpr u32 s_empty_bucket {0xFFFFFFFF};
+
+    // Archives are shared: assets read from them keep the mapping alive.
+    // Null if any section or entry lies outside the file.
+    static std::shared_ptr<AssetArchive>
+    open(std::filesystem::path const& path) noexcept;
+
+    PakEntry const*
+    find(std::string_view relative_path) const noexcept;
+
+    PakEntry const*
+    find(u64 path_hash, std::string_view relative_path) const noexcept;
+
+    // Uncompressed entries are returned as views into the archive mapping,
+    // compressed entries are decompressed into an owned buffer. Invalid if
+    // the entry doesn't decompress or verify.
+    MappedAsset
+    read(PakEntry const& entry, bool verify_content = false) const noexcept;
+
+    std::string_view
+    path_of(PakEntry const& entry) const noexcept;
+
+    std::span<PakEntry const>
+    entries() const noexcept {
+        return _entries;
+    }
+
+    std::filesystem::path const&
+    path() const noexcept {
+        return _path;
+    }
+
+private:
+    AssetArchive() = default;
+
+private:
+    std::filesystem::path _path {};
+    MappedAsset _file {};
+    PakHeader const* _header {nullptr};
+    std::span<PakEntry const> _entries {};
+    std::span<u32 const> _buckets {};
+    std::string_view _strings {};
+};
+
+// Builds .pak files (used by the vpak tool).
+class AssetArchiveWriter {
+public:
+    explicit AssetArchiveWriter(u32 data_alignment = 16) noexcept;
+
+    void
+    add(std::string_view relative_path,
+        std::span<std::byte const> content,
+        bool compress);
+
+    bool
+    write(std::filesystem::path const& output_path) const;
+
+    usize
+    entry_count() const noexcept {
+        return _pending.size();
+    }
+
+private:
+    struct PendingEntry {
+        std::string path {};
+        u64 path_hash {0};
+        u64 content_hash {0};
+        u64 size {0};
+        PakCompression compression {PakCompression::None};
+        std::vector<std::byte> stored {};
+    };
+
+    u32 _data_alignment {16};
+    std::vector<PendingEntry> _pending {};
+};
+
+} // namespace core
@@ -2,15 +2,27 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
 #include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "asset_archive.hpp"
+#include "asset_id.hpp"
 #include "log.hpp"
+#include "mapped_asset.hpp"
 #include "types.hpp"
 
 namespace core {
 
+struct AssetMetadata {
+    u64 size {0}; // Uncompressed size in bytes.
+    i64 modified_ticks {0}; // Last write time. Only meant for comparisons.
+    bool exists {false};
+    bool archived {false}; // Served from a mounted archive.
+};
+
 class AssetDatabase {
 public:
     static constexpr auto s_assets_dir {ASSETS_DIR};
@@ -18,21 +30,81 @@ public:
     static std::filesystem::path const&
     root();
 
-    static std::filesystem::path
-    resolve(std::string const& relative_path);
+    // Paths are resolved and stat'ed once, the first time they are seen.
+    // After that every lookup is a hash probe in a sharded, read-mostly cache:
+    // no allocation and no syscall. Returned paths live until program exit.
+    static AssetId
+    intern(std::string_view relative_path);
+
+    static std::filesystem::path const&
+    resolve(std::string_view relative_path);
+
+    static std::filesystem::path const&
+    resolve(AssetId id);
 
     static std::string
-    read_asset_file(std::string const& assets_relative_path);
+    read_asset_file(std::string_view assets_relative_path);
 
-    static std::filesystem::path
-    absolute_path(std::string const& assets_relative_path);
+    // Zero-copy alternative to read_asset_file(), prefer it for large assets.
+    static MappedAsset
+    map_asset_file(
+        std::string_view assets_relative_path,
+        AccessHint hint = AccessHint::Sequential
+    );
+
+    static std::filesystem::path const&
+    absolute_path(std::string_view assets_relative_path);
+
+    static bool
+    exists(std::string_view assets_relative_path);
 
+    // Cached metadata, default constructed for ids that were never interned.
+    static AssetMetadata
+    metadata(AssetId id);
+
+    // Re-stat a cached asset (e.g. after a file watcher event).
+    static AssetMetadata
+    refresh(AssetId id);
+
+    // Mounted archives are searched (most recent first) before loose files.
+    // Not thread-safe: mount while no other thread is loading assets.
     static bool
-    exists(std::string const& assets_relative_path);
+    mount(std::filesystem::path const& archive_path);
+
+    static void
+    unmount_all();
 
 private:
+    struct AssetRecord;
+    struct CacheShard;
+
+    static std::span<CacheShard>
+    _cache();
+
+    static AssetRecord const&
+    _record(std::string_view relative_path);
+
+    static AssetRecord const*
+    _find_record(AssetId id);
+
+    static void
+    _stat(AssetRecord& record);
+
+    static void
+    _refresh_all();
+
+    static std::pair<AssetArchive const*, PakEntry const*>
+    _cached_archive_entry(AssetRecord const& record);
+
+    static std::vector<std::shared_ptr<AssetArchive>>&
+    _mounted_archives();
+
+    // Returns the archive entry for the asset, if any archive has it.
+    static std::pair<AssetArchive const*, PakEntry const*>
+    _find_in_archives(AssetId id, std::string_view relative_path);
+
     static std::filesystem::path
     _init_assets_root();
 };
 
-} // namespace core
\ No newline at end of file
+} // namespace core
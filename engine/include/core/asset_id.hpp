@@ -0,0 +1,204 @@
+// include/core/asset_id.hpp
+#pragma once
+
+#include <functional>
+#include <string_view>
+
+#include "hash.hpp"
+#include "types.hpp"
+
+namespace core {
+
+// Asset paths are relative to the assets root and use forward slashes.
+// Paths are normalized on the fly, so hashing or comparing one never
+// allocates: '\' separates segments too, empty and "." segments are
+// dropped and ".." drops the segment before it ("a/./b/../c" is "a/c").
+// Case is kept, paths name files on case sensitive file systems.
+class AssetPathSegments {
+public:
+    constexpr explicit AssetPathSegments(std::string_view path) noexcept
+        : _path {path} {}
+
+    // The next segment of the normalized path, empty past the last one.
+    constexpr std::string_view
+    next() noexcept {
+        while (_position < _path.size()) {
+            usize const begin = _position;
+            std::string_view const segment = _segment_at(begin);
+            _position = begin + segment.size() + 1;
+
+            if (_kind(segment) == Kind::Skipped) {
+                continue;
+            }
+
+            if (_kind(segment) == Kind::Parent ? !_parent_matched(begin)
+                                               : !_dropped(begin)) {
+                return segment;
+            }
+        }
+
+        return {};
+    }
+
+private:
+    enum class Kind : u8 {
+        Skipped,
+        Parent,
+        Name,
+    };
+
+    static constexpr bool
+    _is_separator(char c) noexcept {
+        return c == '/' || c == '\\';
+    }
+
+    static constexpr Kind
+    _kind(std::string_view segment) noexcept {
+        if (segment.empty() || segment == ".") {
+            return Kind::Skipped;
+        }
+
+        return segment == ".." ? Kind::Parent : Kind::Name;
+    }
+
+    constexpr std::string_view
+    _segment_at(usize begin) const noexcept {
+        usize end = begin;
+
+        while (end < _path.size() && !_is_separator(_path[end])) {
+            ++end;
+        }
+
+        return _path.substr(begin, end - begin);
+    }
+
+    // A name is dropped by the first ".." after it that no name between
+    // them takes (matched like brackets).
+    constexpr bool
+    _dropped(usize begin) const noexcept {
+        usize depth {1};
+
+        for (usize i = begin + _segment_at(begin).size() + 1;
+             i < _path.size();) {
+            std::string_view const segment = _segment_at(i);
+            Kind const kind = _kind(segment);
+
+            if (kind == Kind::Name) {
+                ++depth;
+            } else if (kind == Kind::Parent && --depth == 0) {
+                return true;
+            }
+
+            i += segment.size() + 1;
+        }
+
+        return false;
+    }
+
+    // Otherwise the ".." climbs out of the root and is kept.
+    constexpr bool
+    _parent_matched(usize begin) const noexcept {
+        usize depth {1};
+        usize end = begin;
+
+        while (end > 0) {
+            // Back to the start of the segment before.
+            usize start = end - 1;
+
+            while (start > 0 && !_is_separator(_path[start - 1])) {
+                --start;
+            }
+
+            Kind const kind = _kind(_path.substr(start, end - 1 - start));
+
+            if (kind == Kind::Parent) {
+                ++depth;
+            } else if (kind == Kind::Name && --depth == 0) {
+                return true;
+            }
+
+            end = start;
+        }
+
+        return false;
+    }
+
+    std::string_view _path {};
+    usize _position {0};
+};
+
+constexpr u64
+hash_asset_path(std::string_view path) noexcept {
+    u64 hash = s_fnv1a_offset_basis;
+    AssetPathSegments segments {path};
+    bool first {true};
+
+    for (std::string_view segment = segments.next(); !segment.empty();
+         segment = segments.next()) {
+        if (!first) {
+            hash ^= static_cast<u8>('/');
+            hash *= s_fnv1a_prime;
+        }
+
+        for (char const c : segment) {
+            hash ^= static_cast<u8>(c);
+            hash *= s_fnv1a_prime;
+        }
+
+        first = false;
+    }
+
+    return hash;
+}
+
+constexpr bool
+asset_paths_equal(std::string_view a, std::string_view b) noexcept {
+    AssetPathSegments a_segments {a};
+    AssetPathSegments b_segments {b};
+
+    while (true) {
+        std::string_view const a_segment = a_segments.next();
+        std::string_view const b_segment = b_segments.next();
+
+        if (a_segment != b_segment) {
+            return false;
+        }
+
+        if (a_segment.empty()) {
+            return true;
+        }
+    }
+}
+
+// Interned asset handle: the hash of the normalized relative path.
+// Cheap to copy, compare and use as a key; can be built at compile time:
+//     constexpr AssetId s_default_vert {"shaders/sh_default.vert"};
+struct AssetId {
+    u64 value {0};
+
+    constexpr AssetId() = default;
+
+    constexpr explicit AssetId(std::string_view relative_path) noexcept
+        : value {hash_asset_path(relative_path)} {}
+
+    constexpr bool
+    is_valid() const noexcept {
+        return value != 0;
+    }
+
+    constexpr bool
+    operator==(AssetId const&) const = default;
+};
+
+} // namespace core
+
+namespace std {
+template <>
+struct hash<core::AssetId> {
+    size_t
+    operator()(core::AssetId const& id) const noexcept {
+        // Already a good hash.
+        return static_cast<size_t>(id.value);
+    }
+};
+} // namespace std
@@ -0,0 +1,59 @@
+// include/core/asset_watcher.hpp
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "asset_id.hpp"
+#include "log.hpp"
+#include "types.hpp"
+
+namespace core {
+
+struct AssetChange {
+    AssetId id {};
+    std::string relative_path {};
+};
+
+// Watches a directory tree for modified files (inotify on Linux).
+// poll() never blocks, so it can be called once per frame from the render
+// loop. On platforms without a backend start() returns false and poll()
+// always returns nothing.
+class AssetWatcher {
+public:
+    AssetWatcher() = default;
+    ~AssetWatcher();
+    AssetWatcher(AssetWatcher const&) = delete;
+    AssetWatcher&
+    operator=(AssetWatcher const&) = delete;
+
+    bool
+    start(std::filesystem::path const& root) noexcept;
+
+    void
+    stop() noexcept;
+
+    // Files written since the last poll, each reported once, relative to
+    // the watched root. The AssetDatabase cache is refreshed for them.
+    std::vector<AssetChange>
+    poll() noexcept;
+
+    bool
+    is_running() const noexcept {
+        return _fd >= 0;
+    }
+
+private:
+    void
+    _watch_directory(std::filesystem::path const& directory) noexcept;
+
+private:
+    int _fd {-1};
+    std::filesystem::path _root {};
+    // Watch descriptor -> directory relative to _root.
+    std::unordered_map<int, std::filesystem::path> _directories {};
+};
+
+} // namespace core
@@ -0,0 +1,46 @@
+// include/core/components.hpp
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "types.hpp"
+
+namespace core {
+
+// Components of scene entities, see World.
+
+// Scale, then rotation, then translation.
+struct Transform {
+    glm::vec3 position {0.0f};
+    glm::quat rotation {1.0f, 0.0f, 0.0f, 0.0f}; // w, x, y, z.
+    glm::vec3 scale {1.0f};
+};
+
+// Model matrix drawn with, computed from Transform.
+struct WorldTransform {
+    glm::mat4 matrix {1.0f};
+};
+
+// Into the renderer's TransformHierarchy, where Transform is local to the
+// node's parent.
+struct SceneNode {
+    u32 id {0};
+};
+
+// Into the renderer's meshes.
+struct Mesh {
+    u32 id {0};
+};
+
+// Into the renderer's material table.
+struct Material {
+    u32 id {0};
+};
+
+// Object space, as MeshRange::bounding_sphere: center (xyz), radius (w).
+struct Bounds {
+    glm::vec4 sphere {};
+};
+
+} // namespace core
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "types.hpp"
+
+namespace core {
+
+// LZ4 block format (no frame, no checksums).
+// src: https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+// Greedy single-probe matcher: compresses a bit worse than the reference
+// implementation, but decompression speed is the same, which is what matters
+// for asset loading.
+
+usize
+lz4_compress_bound(usize input_size) noexcept;
+
+// Appends the compressed block to dst and returns its size.
+usize
+lz4_compress(std::span<std::byte const> src, std::vector<std::byte>& dst);
+
+// dst must be exactly the uncompressed size.
+// Returns false on malformed input instead of reading out of bounds.
+bool
+lz4_decompress(
+    std::span<std::byte const> src,
+    std::span<std::byte> dst
+) noexcept;
+
+} // namespace core
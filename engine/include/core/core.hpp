@@ -7,6 +7,6 @@
 namespace core {
 
 void
-run();
+run(RendererSettings const& settings = {});
 
 } // namespace core
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "types.hpp"
+
+namespace core {
+
+// Deferred destruction keyed by a monotonically increasing GPU progress
+// value (frame number, timeline semaphore value...).
+//
+// Anything that owns a GPU object can be pushed: RAII handles
+// (vk::UniqueBuffer, vk::UniqueImage, vk::UniquePipeline, ...), containers
+// of them, or a callable for handles without an owner. It is destroyed by
+// collect() once the GPU has passed the value it was pushed with, without
+// waiting for the device.
+//
+// Values must be pushed in non-decreasing order, so collecting is a pop
+// from the front. Destruction happens in push order.
+class DeletionQueue {
+public:
+    DeletionQueue() = default;
+    ~DeletionQueue();
+    DeletionQueue(DeletionQueue const&) = delete;
+    DeletionQueue&
+    operator=(DeletionQueue const&) = delete;
+
+    template <typename T>
+    void
+    push(u64 value, T&& resource) {
+        static_assert(
+            !std::is_lvalue_reference_v<T>,
+            "Move the resource into the queue."
+        );
+        using Resource = std::remove_cvref_t<T>;
+        _push(value, std::make_unique<Holder<Resource>>(std::move(resource)));
+    }
+
+    // Calls destroy() instead of destroying an owner.
+    template <typename F>
+    void
+    defer(u64 value, F&& destroy) {
+        using Function = std::remove_cvref_t<F>;
+        _push(
+            value,
+            std::make_unique<Callback<Function>>(Function {
+                std::forward<F>(destroy)
+            })
+        );
+    }
+
+    // Destroys everything pushed with a value <= completed_value.
+    void
+    collect(u64 completed_value) noexcept;
+
+    // Destroys everything. The caller guarantees the GPU is idle.
+    void
+    flush() noexcept;
+
+    usize
+    size() const noexcept {
+        return _entries.size();
+    }
+
+    bool
+    empty() const noexcept {
+        return _entries.empty();
+    }
+
+private:
+    struct Node {
+        virtual ~Node() = default;
+    };
+
+    template <typename T>
+    struct Holder final : Node {
+        explicit Holder(T&& value) : resource {std::move(value)} {}
+        T resource;
+    };
+
+    template <typename F>
+    struct Callback final : Node {
+        explicit Callback(F&& function) : destroy {std::move(function)} {}
+        ~Callback() override {
+            destroy();
+        }
+        F destroy;
+    };
+
+    struct Entry {
+        u64 value {0};
+        std::unique_ptr<Node> node {};
+    };
+
+    void
+    _push(u64 value, std::unique_ptr<Node> node);
+
+    std::deque<Entry> _entries {};
+};
+
+} // namespace core
@@ -0,0 +1,329 @@
+// include/core/ecs.hpp
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "job_system.hpp"
+#include "types.hpp"
+
+namespace core {
+
+// Stale once its entity is destroyed: the index is reused with another
+// generation.
+struct Entity {
+    u32 index {0};
+    u32 generation {0}; // 0: no entity.
+
+    bool
+    operator==(Entity const&) const = default;
+};
+
+using ComponentId = u32;
+
+// Component types of every world together, ids index a 64-bit mask.
+static constexpr u32 s_max_component_types {64};
+
+// Entities and their components, stored by archetype.
+//
+// Entities with the same set of components share an archetype, whose
+// components live in fixed size chunks, one tightly packed array per
+// component (structure of arrays). Systems iterate chunk by chunk over
+// the archetypes holding what they ask for, touching only those arrays,
+// and chunks are independent units for the job system.
+//
+// Components are plain data (trivially copyable): adding or removing one
+// moves the entity to another archetype with memcpy. A chunk stays
+// packed when an entity leaves it, the last one of its archetype takes
+// the hole, so nothing may add, remove, create or destroy while
+// iterating.
+class World {
+public:
+    // Columns of a chunk fit in L1 together.
+    static constexpr usize s_chunk_size {16 * 1'024};
+
+    World() = default;
+    World(World const&) = delete;
+    World&
+    operator=(World const&) = delete;
+
+    // Dense, assigned the first time a type is used.
+    template <typename T>
+    static ComponentId
+    component_id() noexcept {
+        return _component_id<std::remove_cvref_t<T>>();
+    }
+
+    template <typename... Components>
+    Entity
+    create(Components const&... components) noexcept {
+        Entity const entity = _allocate_entity();
+        _place(entity, _archetype_for(_mask_of<Components...>()));
+        (_write(entity, components), ...);
+
+        return entity;
+    }
+
+    void
+    destroy(Entity entity) noexcept;
+
+    bool
+    alive(Entity entity) const noexcept;
+
+    usize
+    entity_count() const noexcept;
+
+    // Replaces the component if the entity already has one.
+    template <typename T>
+    void
+    add(Entity entity, T const& component = {}) noexcept {
+        ComponentMask const mask = _record(entity).mask;
+        ComponentMask const bit = _mask_of<T>();
+
+        if ((mask & bit) == 0) {
+            _move(entity, _archetype_for(mask | bit));
+        }
+
+        _write(entity, component);
+    }
+
+    template <typename T>
+    void
+    remove(Entity entity) noexcept {
+        ComponentMask const mask = _record(entity).mask;
+        ComponentMask const bit = _mask_of<T>();
+
+        if ((mask & bit) != 0) {
+            _move(entity, _archetype_for(mask & ~bit));
+        }
+    }
+
+    template <typename T>
+    bool
+    has(Entity entity) const noexcept {
+        return alive(entity) &&
+            (_records[entity.index].mask & _mask_of<T>()) != 0;
+    }
+
+    // Null if the entity doesn't have it. Valid until the next structural
+    // change.
+    template <typename T>
+    T*
+    get(Entity entity) noexcept {
+        if (!has<T>(entity)) {
+            return nullptr;
+        }
+
+        EntityRecord const& record = _records[entity.index];
+        return _column<T>(
+            _archetypes[record.archetype],
+            record.chunk
+        ) + record.row;
+    }
+
+    // fn(std::span<Entity const>, std::span<Components>...) once per chunk
+    // holding all of Components. Const components are read only.
+    template <typename... Components, typename Fn>
+    void
+    each_chunk(Fn&& fn) {
+        ComponentMask const mask = _mask_of<Components...>();
+
+        for (Archetype& archetype : _archetypes) {
+            if ((archetype.mask & mask) != mask) {
+                continue;
+            }
+
+            for (u32 chunk {}; chunk < archetype.chunks.size(); ++chunk) {
+                _call<Components...>(fn, archetype, chunk);
+            }
+        }
+    }
+
+    // Same, chunks spread over the job system: fn may run concurrently,
+    // on different chunks.
+    template <typename... Components, typename Fn>
+    void
+    each_chunk(JobSystem& jobs, Fn&& fn) {
+        std::vector<ChunkRef> const chunks =
+            _chunks_with(_mask_of<Components...>());
+        // A few ranges per thread, enough to balance uneven chunks.
+        usize const grain = chunks.size() / ((jobs.worker_count() + 1) * 4);
+
+        jobs.parallel_for(chunks.size(), grain, [&](usize begin, usize end) {
+            for (usize i = begin; i < end; ++i) {
+                _call<Components...>(
+                    fn,
+                    _archetypes[chunks[i].archetype],
+                    chunks[i].chunk
+                );
+            }
+        });
+    }
+
+    // fn(Components&...) once per entity.
+    template <typename... Components, typename Fn>
+    void
+    each(Fn&& fn) {
+        each_chunk<Components...>(
+            [&](std::span<Entity const> entities,
+                std::span<Components>... columns) {
+                for (usize i {}; i < entities.size(); ++i) {
+                    fn(columns[i]...);
+                }
+            }
+        );
+    }
+
+    template <typename... Components, typename Fn>
+    void
+    each(JobSystem& jobs, Fn&& fn) {
+        each_chunk<Components...>(
+            jobs,
+            [&](std::span<Entity const> entities,
+                std::span<Components>... columns) {
+                for (usize i {}; i < entities.size(); ++i) {
+                    fn(columns[i]...);
+                }
+            }
+        );
+    }
+
+private:
+    using ComponentMask = u64;
+
+    static constexpr u8 s_no_column {0xFF};
+
+    struct alignas(64) ChunkBytes {
+        std::byte data[s_chunk_size];
+    };
+
+    struct Chunk {
+        std::unique_ptr<ChunkBytes> bytes {};
+        u32 count {0};
+    };
+
+    struct Column {
+        ComponentId component {0};
+        usize size {0};
+        usize alignment {0};
+        usize offset {0}; // Into the chunk, entities come first.
+    };
+
+    struct Archetype {
+        ComponentMask mask {0};
+        std::vector<Column> columns {}; // By component id.
+        std::array<u8, s_max_component_types> column_of {};
+        u32 chunk_capacity {0};
+        // Every chunk but the last is full.
+        std::vector<Chunk> chunks {};
+    };
+
+    struct EntityRecord {
+        u32 generation {1};
+        ComponentMask mask {0};
+        u32 archetype {0};
+        u32 chunk {0};
+        u32 row {0};
+    };
+
+    struct ChunkRef {
+        u32 archetype {0};
+        u32 chunk {0};
+    };
+
+    static ComponentId
+    _register_component(usize size, usize alignment) noexcept;
+
+    // One instantiation per type, whatever its qualifiers.
+    template <typename Component>
+    static ComponentId
+    _component_id() noexcept {
+        static_assert(
+            std::is_trivially_copyable_v<Component>,
+            "Components are plain data, moved with memcpy."
+        );
+
+        static ComponentId const id =
+            _register_component(sizeof(Component), alignof(Component));
+        return id;
+    }
+
+    template <typename... Components>
+    static ComponentMask
+    _mask_of() noexcept {
+        return (ComponentMask {0} | ... |
+                (ComponentMask {1} << component_id<Components>()));
+    }
+
+    static Entity*
+    _entities(Chunk const& chunk) noexcept {
+        return reinterpret_cast<Entity*>(chunk.bytes->data);
+    }
+
+    template <typename T>
+    static T*
+    _column(Archetype const& archetype, u32 chunk) noexcept {
+        Column const& column =
+            archetype.columns[archetype.column_of[component_id<T>()]];
+        return reinterpret_cast<std::remove_cv_t<T>*>(
+            archetype.chunks[chunk].bytes->data + column.offset
+        );
+    }
+
+    template <typename... Components, typename Fn>
+    static void
+    _call(Fn& fn, Archetype const& archetype, u32 chunk) {
+        u32 const count = archetype.chunks[chunk].count;
+        fn(std::span<Entity const> {_entities(archetype.chunks[chunk]), count},
+           std::span<Components> {
+               _column<Components>(archetype, chunk),
+               count
+           }...);
+    }
+
+    template <typename T>
+    void
+    _write(Entity entity, T const& component) noexcept {
+        EntityRecord const& record = _records[entity.index];
+        _column<T>(_archetypes[record.archetype], record.chunk)[record.row] =
+            component;
+    }
+
+    EntityRecord const&
+    _record(Entity entity) const noexcept;
+
+    Entity
+    _allocate_entity() noexcept;
+
+    // Creates the archetype the first time.
+    u32
+    _archetype_for(ComponentMask mask) noexcept;
+
+    // Appends the entity to the archetype, its components zeroed.
+    void
+    _place(Entity entity, u32 archetype) noexcept;
+
+    // Keeps the components both archetypes have.
+    void
+    _move(Entity entity, u32 archetype) noexcept;
+
+    // Fills the hole with the last entity of the archetype.
+    void
+    _erase(u32 archetype, u32 chunk, u32 row) noexcept;
+
+    std::vector<ChunkRef>
+    _chunks_with(ComponentMask mask) const;
+
+    std::vector<Archetype> _archetypes {};
+    std::unordered_map<ComponentMask, u32> _archetype_of_mask {};
+    std::vector<EntityRecord> _records {}; // By entity index.
+    std::vector<u32> _free_indices {};
+    usize _entity_count {0};
+};
+
+} // namespace core
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+#include "types.hpp"
+
+namespace core {
+
+// 64-bit FNV-1a.
+// Not cryptographic, just a fast and stable hash for asset paths and content
+// checks. Stable means it must never change: hashes are stored on disk.
+static constexpr u64 s_fnv1a_offset_basis {0xCBF29CE484222325ULL};
+static constexpr u64 s_fnv1a_prime {0x100000001B3ULL};
+
+constexpr u64
+hash_fnv1a(std::string_view text, u64 seed = s_fnv1a_offset_basis) noexcept {
+    u64 hash = seed;
+    for (char const c : text) {
+        hash ^= static_cast<u8>(c);
+        hash *= s_fnv1a_prime;
+    }
+    return hash;
+}
+
+inline u64
+hash_fnv1a(
+    std::span<std::byte const> bytes,
+    u64 seed = s_fnv1a_offset_basis
+) noexcept {
+    u64 hash = seed;
+    for (std::byte const b : bytes) {
+        hash ^= static_cast<u8>(b);
+        hash *= s_fnv1a_prime;
+    }
+    return hash;
+}
+
+// Mix another hash into seed (boost::hash_combine, 64-bit constant).
+constexpr u64
+hash_combine(u64 seed, u64 value) noexcept {
+    return seed ^
+        (value + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+}
+
+} // namespace core
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+#include "types.hpp"
+
+namespace core {
+
+// Minimal image writers for frame captures (headless renders, regression
+// screenshots). Pixels are tightly packed 8-bit channels, top row first.
+
+// PNG with stored (uncompressed) deflate blocks: no zlib dependency,
+// readable by every decoder, larger than an optimized PNG.
+// src: https://www.w3.org/TR/png/
+bool
+write_png(
+    std::filesystem::path const& path,
+    u32 width,
+    u32 height,
+    u32 channels,
+    std::span<std::byte const> pixels
+);
+
+// Raw pixel dump, byte for byte. Cheapest to write and to diff.
+bool
+write_raw(
+    std::filesystem::path const& path,
+    std::span<std::byte const> pixels
+);
+
+u32
+crc32(std::span<std::byte const> data, u32 crc = 0) noexcept;
+
+} // namespace core
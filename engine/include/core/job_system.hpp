@@ -0,0 +1,60 @@
+// include/core/job_system.hpp
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "types.hpp"
+
+namespace core {
+
+// Worker threads running ranges of data parallel loops.
+//
+// The thread calling parallel_for() runs ranges too until its loop is
+// done, so loops may be nested (a range can start its own loop) and a
+// system without workers still runs everything, on the caller.
+class JobSystem {
+public:
+    JobSystem() = default;
+    ~JobSystem();
+    JobSystem(JobSystem const&) = delete;
+    JobSystem&
+    operator=(JobSystem const&) = delete;
+
+    // Without calling it, loops run on the calling thread.
+    void
+    start(u32 worker_count) noexcept;
+
+    // Joins the workers. Called on destruction.
+    void
+    stop() noexcept;
+
+    u32
+    worker_count() const noexcept;
+
+    // Calls job(begin, end) over [0, count) in ranges of at most grain
+    // items, spread over the workers, and returns once every range ran.
+    void
+    parallel_for(
+        usize count,
+        usize grain,
+        std::function<void(usize begin, usize end)> const& job
+    ) noexcept;
+
+private:
+    void
+    _work() noexcept;
+
+    mutable std::mutex _mutex {};
+    std::condition_variable _work_available {};
+    std::condition_variable _range_done {};
+    std::deque<std::function<void()>> _queue {};
+    bool _stopping {false};
+    std::vector<std::thread> _workers {};
+};
+
+} // namespace core
@@ -0,0 +1,46 @@
+// include/core/linear_allocator.hpp
+#pragma once
+
+#include <optional>
+
+#include "types.hpp"
+
+namespace core {
+
+// Hands out aligned ranges of a fixed size buffer, front to back, all
+// freed at once by reset() (e.g. the uniform blocks of a frame). Never
+// wraps around: once full, allocate() fails until the next reset() instead
+// of handing out a range that is still in use.
+class LinearAllocator {
+public:
+    LinearAllocator() = default;
+    // The alignment must be a power of two.
+    LinearAllocator(u64 capacity, u64 alignment) noexcept;
+
+    // Offset of size bytes, aligned. Empty if they don't fit.
+    std::optional<u64>
+    allocate(u64 size) noexcept;
+
+    void
+    reset() noexcept {
+        _head = 0;
+    }
+
+    u64
+    capacity() const noexcept {
+        return _capacity;
+    }
+
+    // Including the alignment padding.
+    u64
+    used() const noexcept {
+        return _head;
+    }
+
+private:
+    u64 _capacity {0};
+    u64 _alignment {1};
+    u64 _head {0}; // Next free byte, aligned or the capacity.
+};
+
+} // namespace core
@@ -0,0 +1,119 @@
+// include/core/mapped_asset.hpp
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+#include "log.hpp"
+#include "types.hpp"
+
+namespace core {
+
+// How the consumer is going to walk the mapped bytes.
+// Forwarded to the kernel (madvise) so it can tune read-ahead.
+enum class AccessHint : u8 {
+    Sequential, // Parsers (shaders, OBJ, images): read once, front to back.
+    Random, // Binary caches and archives: jump around through an index.
+    WillNeed, // Small hot files: fault everything in right away.
+};
+
+// Read-only view of a whole file, backed by mmap.
+// The bytes stay valid for as long as the MappedAsset is alive, so consumers
+// can parse straight from the page cache without copying into a std::string.
+class MappedAsset {
+public:
+    MappedAsset() = default;
+    ~MappedAsset();
+    MappedAsset(MappedAsset const&) = delete;
+    MappedAsset&
+    operator=(MappedAsset const&) = delete;
+    MappedAsset(MappedAsset&& other) noexcept;
+    MappedAsset&
+    operator=(MappedAsset&& other) noexcept;
+
+    static MappedAsset
+    open(
+        std::filesystem::path const& path,
+        AccessHint hint = AccessHint::Sequential
+    ) noexcept;
+
+    // Bytes that live inside someone else's mapping (e.g. an archive entry).
+    // owner is kept alive for as long as this asset is.
+    static MappedAsset
+    from_view(
+        std::span<std::byte const> bytes,
+        std::shared_ptr<void const> owner
+    ) noexcept;
+
+    // Bytes that had to be materialized (e.g. a decompressed archive entry).
+    static MappedAsset
+    from_buffer(std::vector<std::byte>&& buffer) noexcept;
+
+    std::span<std::byte const>
+    bytes() const noexcept {
+        return {_data, _size};
+    }
+
+    // Shader sources and OBJ files are text, save the reinterpret_cast.
+    std::string_view
+    text() const noexcept {
+        return {reinterpret_cast<char const*>(_data), _size};
+    }
+
+    std::byte const*
+    data() const noexcept {
+        return _data;
+    }
+
+    usize
+    size() const noexcept {
+        return _size;
+    }
+
+    bool
+    empty() const noexcept {
+        return _size == 0;
+    }
+
+    bool
+    is_valid() const noexcept {
+        return _valid;
+    }
+
+private:
+    void
+    _release() noexcept;
+
+private:
+    std::byte const* _data {nullptr};
+    usize _size {0};
+    bool _valid {false};
+
+    // Owned mapping (munmap'ed on destruction).
+    void* _mapping {nullptr};
+    usize _mapping_size {0};
+
+    // Platforms without mmap fall back to reading the file here.
+    std::vector<std::byte> _owned {};
+
+    // Borrowed views keep their backing mapping alive through this.
+    std::shared_ptr<void const> _owner {};
+};
+
+// Lets std::istream based parsers (tinyobj) read from mapped memory.
+class SpanStreamBuffer : public std::streambuf {
+public:
+    explicit SpanStreamBuffer(std::span<std::byte const> bytes) noexcept {
+        // std::streambuf wants non-const pointers, but we never write.
+        char* begin =
+            const_cast<char*>(reinterpret_cast<char const*>(bytes.data()));
+        setg(begin, begin, begin + bytes.size());
+    }
+};
+
+} // namespace core
@@ -0,0 +1,106 @@
+// include/core/mesh_file.hpp
+#pragma once
+
+#include <filesystem>
+#include <span>
+
+#include "mapped_asset.hpp"
+#include "mesh_lod.hpp"
+#include "meshlet.hpp"
+#include "types.hpp"
+
+namespace core {
+
+// Cooked mesh (.vmesh): what the renderer uploads, ready to use.
+//
+// Built once from a source model (OBJ parsing, vertex deduplication, LOD
+// chain, meshlets) and mapped afterwards, so loading is a header check and two
+// memcpy. Vertices are opaque here, their layout is the renderer's
+// (vertex_stride guards against a mismatch).
+//
+// Layout (little-endian, every section is 16-byte aligned):
+//   MeshFileHeader
+//   bytes[vertex_count * vertex_stride]
+//   u32[index_count]            every LOD, meshlet ranges are contiguous.
+//   Meshlet[meshlet_count]      every LOD.
+//   MeshLod[lod_count]          finest first, at least one.
+struct MeshFileHeader {
+    static constexpr u32 s_magic {0x48534D56}; // "VMSH".
+    static constexpr u32 s_version {2}; // 2: LOD chain.
+
+    u32 magic {s_magic};
+    u32 version {s_version};
+    // Size and modification time of the source, a different one means
+    // the file is stale.
+    u64 source_size {0};
+    i64 source_modified_ticks {0};
+    u32 vertex_stride {0};
+    u32 vertex_count {0};
+    u32 index_count {0};
+    u32 meshlet_count {0};
+    u32 lod_count {0};
+    u32 reserved {0};
+    u64 vertices_offset {0};
+    u64 indices_offset {0};
+    u64 meshlets_offset {0};
+    u64 lods_offset {0};
+    glm::vec4 bounding_sphere {}; // Whole mesh, as in Meshlet.
+};
+
+static_assert(sizeof(MeshFileHeader) == 96);
+
+// Size and modification time of a source file, zero if it is missing.
+struct MeshSourceStamp {
+    u64 size {0};
+    i64 modified_ticks {0};
+
+    bool
+    operator==(MeshSourceStamp const&) const = default;
+
+    static MeshSourceStamp
+    of(std::filesystem::path const& path) noexcept;
+};
+
+struct MeshFileContents {
+    MeshSourceStamp source {};
+    u32 vertex_stride {0};
+    std::span<std::byte const> vertices {};
+    std::span<u32 const> indices {};
+    std::span<Meshlet const> meshlets {};
+    std::span<MeshLod const> lods {};
+    glm::vec4 bounding_sphere {};
+};
+
+class MeshFile {
+public:
+    // Invalid (see is_valid()) if missing, corrupted or of another version.
+    // Indices, meshlet and LOD ranges are checked against their counts,
+    // and there is at least one level.
+    // Staleness is the caller's call, compare contents().source.
+    static MeshFile
+    open(std::filesystem::path const& path) noexcept;
+
+    static bool
+    write(
+        std::filesystem::path const& path,
+        MeshFileContents const& contents
+    ) noexcept;
+
+    bool
+    is_valid() const noexcept {
+        return _header != nullptr;
+    }
+
+    // Views into the mapping, valid while the MeshFile lives.
+    MeshFileContents const&
+    contents() const noexcept {
+        return _contents;
+    }
+
+private:
+    MappedAsset _file {};
+    MeshFileHeader const* _header {nullptr};
+    MeshFileContents _contents {};
+};
+
+} // namespace core
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+#include "meshlet.hpp"
+#include "types.hpp"
+
+namespace core {
+
+// One level of detail of a mesh: a range of its indices and of its
+// meshlets. std430 layout, also stored as is in mesh files.
+struct MeshLod {
+    u32 first_index {0}; // Relative to the mesh's first index.
+    u32 index_count {0};
+    u32 first_meshlet {0}; // Relative to the mesh's first meshlet.
+    u32 meshlet_count {0};
+    // Largest distance from the full resolution surface, in object space
+    // units. Projected to the screen to select the level to draw.
+    f32 error {0.0f};
+    u32 padding[3] {};
+};
+
+static_assert(sizeof(MeshLod) == 32, "Must match the std430 layout.");
+
+struct SimplifiedMesh {
+    std::vector<u32> indices {}; // Into the same vertices.
+    f32 error {0.0f}; // See MeshLod::error.
+};
+
+// Quadric error edge collapse (Garland & Heckbert), vertices only move
+// onto one of their neighbors so the vertex buffer is shared by every
+// level. Stops at target_index_count or when nothing can collapse anymore:
+// border and seam vertices (several vertices at the same position, for
+// texture coordinates) never move, so the mesh keeps its outline and UVs.
+SimplifiedMesh
+simplify_mesh(
+    std::span<glm::vec3 const> positions,
+    std::span<u32 const> indices,
+    usize target_index_count
+);
+
+struct LodMesh {
+    // Every level one after another, each made of meshlets.
+    std::vector<u32> indices {};
+    std::vector<Meshlet> meshlets {};
+    std::vector<MeshLod> lods {}; // Finest first.
+};
+
+// Level i keeps about 1 / 2^i of the triangles (100, 50, 25, 12.5%...).
+// Levels that would barely be smaller than the previous one are dropped.
+LodMesh
+build_lod_chain(
+    std::span<glm::vec3 const> positions,
+    std::span<u32 const> indices,
+    u32 max_lod_count = 4,
+    MeshletLimits limits = {}
+);
+
+} // namespace core
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+#include "types.hpp"
+
+namespace core {
+
+// A small cluster of triangles culled as a whole on the GPU
+// (see sh_cluster_cull.comp), drawn as one range of the index buffer.
+// std430 layout, also stored as is in mesh files.
+struct Meshlet {
+    glm::vec4 bounding_sphere {}; // Object space center (xyz), radius (w).
+    // Normal cone: axis (xyz) and cutoff (w). The whole meshlet faces away
+    // from a camera at p when:
+    //     dot(center - p, axis) >= cutoff * length(center - p) + radius
+    // A cutoff of 1 never passes the test (no usable cone).
+    glm::vec4 cone {0.0f, 0.0f, 1.0f, 1.0f};
+    u32 first_index {0}; // Relative to the mesh's first index.
+    u32 index_count {0};
+    u32 vertex_count {0}; // Unique vertices referenced.
+    u32 padding {0};
+};
+
+static_assert(sizeof(Meshlet) == 48, "Must match the std430 layout.");
+
+// 64 / 124 keeps each meshlet within the limits mesh shaders favor, while
+// being large enough to amortize one indirect draw each.
+struct MeshletLimits {
+    u32 max_vertices {64};
+    u32 max_triangles {124};
+};
+
+struct MeshletMesh {
+    // The input triangles, reordered so each meshlet is a contiguous range.
+    std::vector<u32> indices {};
+    std::vector<Meshlet> meshlets {};
+};
+
+// Greedy clustering: a meshlet grows with the unused triangle sharing the
+// most vertices with it, and a new one starts from the next unused
+// triangle in index order when it is full or has no neighbor left.
+MeshletMesh
+build_meshlets(
+    std::span<glm::vec3 const> positions,
+    std::span<u32 const> indices,
+    MeshletLimits limits = {}
+);
+
+} // namespace core
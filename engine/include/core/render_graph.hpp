@@ -0,0 +1,224 @@
+// include/core/render_graph.hpp
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "types.hpp"
+
+namespace core {
+
+// Frame described as passes reading and writing resources, compiled into
+// the barriers between them.
+//
+// Passes run in the order they were added, the graph only decides what
+// each one has to wait for:
+// - Barriers: per resource, the writes to flush and make visible, the
+//   reads to wait for before overwriting, and image layout transitions.
+//   A reader that already saw the last write gets no second barrier.
+// - Culling: a pass only runs if something it writes is read by a later
+//   pass that runs, or is exported (outlives the graph).
+// - Aliasing: transient resources (created, not imported) get an offset
+//   in one block of memory, shared by those whose lifetimes (first to
+//   last pass using them) don't overlap. The memory is reused by the next
+//   execution, whose first uses wait for this one's last.
+//
+// No API here: usages and layouts are abstract and the renderer maps them
+// to stages, access types and layouts, so graphs compile without a device.
+
+// How a pass uses a resource.
+enum class RenderGraphUsage : u8 {
+    ColorAttachment,
+    DepthAttachment,
+    // Sampled image in a compute shader.
+    ComputeSampled,
+    // Storage buffer or image in a compute shader (General layout, images
+    // that are both written and sampled in place are storage too).
+    ComputeStorage,
+    IndirectArguments,
+    Transfer,
+    Present,
+};
+
+// One bit per RenderGraphUsage.
+using RenderGraphUsageMask = u32;
+
+constexpr RenderGraphUsageMask
+to_mask(RenderGraphUsage usage) noexcept {
+    return RenderGraphUsageMask {1} << static_cast<u32>(usage);
+}
+
+enum class RenderGraphLayout : u8 {
+    Undefined, // Contents discarded.
+    General,
+    ColorAttachment,
+    DepthAttachment,
+    DepthReadOnly,
+    ShaderReadOnly,
+    TransferSource,
+    TransferDestination,
+    Present,
+};
+
+// Layout of an image used this way.
+RenderGraphLayout
+to_layout(RenderGraphUsage usage, bool write) noexcept;
+
+using RenderGraphResource = u32;
+using RenderGraphPass = u32;
+
+// What happened to an imported resource before the graph.
+struct RenderGraphImport {
+    // Its last users, the first use in the graph waits for them.
+    RenderGraphUsageMask usages {0};
+    bool written {false}; // They wrote it.
+    RenderGraphLayout layout {RenderGraphLayout::Undefined};
+};
+
+// Memory of a transient resource.
+struct RenderGraphMemory {
+    u64 size {0};
+    u64 alignment {1};
+};
+
+// Everything one resource needs before a pass. Images transition from
+// old_layout to new_layout, buffers keep Undefined.
+struct RenderGraphBarrier {
+    RenderGraphResource resource {0};
+    // Usages to wait for, none for a first use.
+    RenderGraphUsageMask src_usages {0};
+    // Of those, the ones whose writes are flushed.
+    RenderGraphUsageMask src_writes {0};
+    // Usages that wait, and what they do.
+    RenderGraphUsageMask dst_reads {0};
+    RenderGraphUsageMask dst_writes {0};
+    RenderGraphLayout old_layout {RenderGraphLayout::Undefined};
+    RenderGraphLayout new_layout {RenderGraphLayout::Undefined};
+};
+
+struct RenderGraphStep {
+    RenderGraphPass pass {0};
+    std::vector<RenderGraphBarrier> barriers {}; // Before the pass.
+};
+
+struct CompiledRenderGraph {
+    static constexpr u64 s_no_memory {~u64 {0}};
+
+    std::vector<RenderGraphStep> steps {}; // Passes left, in order.
+    // Exported resources to their final usage, after the last step.
+    std::vector<RenderGraphBarrier> final_barriers {};
+    // Per resource, s_no_memory unless transient and used.
+    std::vector<u64> memory_offsets {};
+    u64 memory_size {0};
+};
+
+class RenderGraph {
+public:
+    RenderGraphResource
+    import_buffer(std::string_view name, RenderGraphImport state = {});
+
+    RenderGraphResource
+    import_image(std::string_view name, RenderGraphImport state = {});
+
+    // Transient: contents only live between the passes using it.
+    RenderGraphResource
+    create_buffer(std::string_view name, RenderGraphMemory memory);
+
+    RenderGraphResource
+    create_image(std::string_view name, RenderGraphMemory memory);
+
+    // Keeps the last writes to it, and leaves it in final_usage if any.
+    void
+    export_resource(
+        RenderGraphResource resource,
+        std::optional<RenderGraphUsage> final_usage = std::nullopt
+    );
+
+    RenderGraphPass
+    add_pass(std::string_view name, std::function<void()> record = {});
+
+    // Read and write declare the same resource as often as needed, every
+    // image usage of a pass must share one layout.
+    void
+    read(
+        RenderGraphPass pass,
+        RenderGraphResource resource,
+        RenderGraphUsage usage
+    );
+
+    void
+    write(
+        RenderGraphPass pass,
+        RenderGraphResource resource,
+        RenderGraphUsage usage
+    );
+
+    CompiledRenderGraph
+    compile() const;
+
+    // Records each step after handing its barriers to record_barriers.
+    void
+    execute(
+        CompiledRenderGraph const& compiled,
+        std::function<void(std::span<RenderGraphBarrier const>)> const&
+            record_barriers
+    ) const;
+
+    bool
+    is_image(RenderGraphResource resource) const noexcept {
+        return _resources[resource].image;
+    }
+
+    std::string_view
+    pass_name(RenderGraphPass pass) const noexcept {
+        return _passes[pass].name;
+    }
+
+    std::string_view
+    resource_name(RenderGraphResource resource) const noexcept {
+        return _resources[resource].name;
+    }
+
+    usize
+    resource_count() const noexcept {
+        return _resources.size();
+    }
+
+private:
+    struct Resource {
+        std::string name {};
+        bool image {false};
+        bool transient {false};
+        bool exported {false};
+        std::optional<RenderGraphUsage> final_usage {};
+        RenderGraphImport import {};
+        RenderGraphMemory memory {};
+    };
+
+    struct Access {
+        RenderGraphResource resource {0};
+        RenderGraphUsageMask reads {0};
+        RenderGraphUsageMask writes {0};
+    };
+
+    struct Pass {
+        std::string name {};
+        std::function<void()> record {};
+        std::vector<Access> accesses {};
+    };
+
+    RenderGraphResource
+    _add_resource(Resource resource);
+
+    Access&
+    _access(RenderGraphPass pass, RenderGraphResource resource);
+
+    std::vector<Resource> _resources {};
+    std::vector<Pass> _passes {};
+};
+
+} // namespace core
@@ -2,6 +2,8 @@
 
 #include <GLFW/glfw3.h>
 #include <concepts>
+#include <string>
+#include <string_view>
 #include <type_traits>
 
 #include "log.hpp"
@@ -13,18 +15,76 @@ struct RenderInfo {
     std::string texture_file_path {};
     std::string model_file_path {};
     std::string vertex_file_path {};
-    std::string vertex_source {};
+    // Sources are views, the caller keeps the backing storage (usually a
+    // MappedAsset) alive until the renderer has been initialized.
+    std::string_view vertex_source {};
     std::string fragment_file_path {};
-    std::string fragment_source {};
+    std::string_view fragment_source {};
+};
+
+// Trade-off between input latency and GPU utilization.
+enum class LatencyMode : u8 {
+    // 2 frames in flight, MAILBOX when available, FIFO otherwise.
+    Balanced,
+    // 1 frame in flight, MAILBOX or IMMEDIATE, and the CPU waits for the
+    // previous frame *before* sampling input, so input is as fresh as
+    // possible when the frame is recorded.
+    LowLatency,
+    // 3 frames in flight, FIFO with a deeper swap chain. Keeps the GPU
+    // busy at the cost of up to 3 frames of latency.
+    Throughput,
+};
+
+constexpr std::string_view
+to_string(LatencyMode mode) noexcept {
+    switch (mode) {
+        case LatencyMode::LowLatency: return "low-latency";
+        case LatencyMode::Throughput: return "throughput";
+        default: return "balanced";
+    }
+}
+
+struct RendererSettings {
+    // Render into offscreen images instead of a window (CI, render farms).
+    // No window, surface or swap chain is created.
+    bool headless {false};
+    u32 width {1280};
+    u32 height {960};
+    // Stop after this many frames, 0 = until the window is closed.
+    // Headless rendering always needs a frame count.
+    u32 frame_count {0};
+    // Headless only: the last frame is read back and written here,
+    // as PNG when the extension is ".png", as raw RGBA8 otherwise.
+    std::string capture_path {};
+    LatencyMode latency_mode {LatencyMode::Balanced};
+    // Copies of the model laid out on a grid.
+    u32 object_count {1};
+    // Frustum culling and draw generation in a compute shader, drawn with
+    // one indirect call. Falls back to CPU culling and one draw per visible
+    // object when off or unsupported by the device.
+    bool gpu_culling {true};
+    // GPU culling only: also skip objects hidden behind the depth of the
+    // previous draws (hierarchical Z, two phases).
+    bool occlusion_culling {true};
+    // Each object draws its coarsest LOD whose simplification error
+    // projects to at most this many pixels, 0 only allows lossless ones.
+    f32 lod_error_threshold {1.0f};
+    // Vulkan 1.3 dynamic rendering: pipelines are created against the
+    // attachment formats, no render pass or framebuffers. Falls back to
+    // render passes when off or unsupported by the device.
+    bool dynamic_rendering {true};
 };
 
 template <typename T>
 concept RendererAPI = requires(
     T renderer,
     GLFWwindow* window,
-    RenderInfo const& test_render_info
+    RenderInfo const& test_render_info,
+    RendererSettings const& settings
 ) {
-    { renderer.init(window, test_render_info) } -> std::same_as<void>;
+    {
+        renderer.init(window, test_render_info, settings)
+    } -> std::same_as<void>;
     { renderer.render() } -> std::same_as<void>;
     { renderer.cleanup() } -> std::same_as<void>;
 };
@@ -32,13 +92,20 @@ concept RendererAPI = requires(
 template <RendererAPI GraphicsAPI>
 class Renderer {
 public:
-    explicit Renderer(GraphicsAPI& graphics, RenderInfo const& test_render_info)
+    explicit Renderer(
+        GraphicsAPI& graphics,
+        RenderInfo const& test_render_info,
+        RendererSettings const& settings = {}
+    )
         : _graphics {graphics} {
-        _init_glfw();
+        if (!settings.headless) {
+            _init_glfw(settings.width, settings.height);
+        }
 
         _graphics.init(
             _window,
-            test_render_info
+            test_render_info,
+            settings
         ); // Give _graphics the ownership of _window.
     }
 
@@ -53,7 +120,7 @@ public:
 
 private:
     void
-    _init_glfw() {
+    _init_glfw(u32 width, u32 height) {
         if (!glfwInit()) {
             Log::error("Failed to initialize GLFW");
         }
@@ -61,10 +128,13 @@ private:
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
         glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 
-        constexpr u32 width {1280};
-        constexpr u32 height {960};
-
-        _window = glfwCreateWindow(width, height, "Vuwulkan", nullptr, nullptr);
+        _window = glfwCreateWindow(
+            static_cast<int>(width),
+            static_cast<int>(height),
+            "Vuwulkan",
+            nullptr,
+            nullptr
+        );
 
         if (!_window) {
             Log::error("Failed to create window");
@@ -7,6 +7,8 @@
 #include <array>
 #include <cstddef> // offsetof() macro.
 
+#include "../types.hpp"
+
 namespace core {
 
 struct UniformBufferObject {
@@ -26,11 +28,121 @@ struct UniformBufferObject {
         How to pseudo-automate this:
         src: https://docs.vulkan.org/tutorial/latest/05_Uniform_buffers/01_Descriptor_pool_and_sets.html#:~:text=Luckily%20there%20is%20a%20way%20to%20not%20have%20to%20think%20about%20these%20alignment%20requirements%20most%20of%20the%20time.%20We%20can%20define%20GLM_FORCE_DEFAULT_ALIGNED_GENTYPES%20right%20before%20including%20GLM:
     */
-    alignas(16) glm::mat4 model {};
     alignas(16) glm::mat4 view {};
     alignas(16) glm::mat4 projection {};
+    // World space, normalized, normals pointing inwards.
+    // Left, right, bottom, top, near, far.
+    alignas(16) glm::vec4 frustum_planes[6] {};
+    alignas(16) glm::vec4 camera_position {}; // World space (xyz).
+    // LOD selection: pixels covered by one unit seen from a distance of
+    // one, and the largest error allowed on screen, in pixels.
+    f32 projection_scale {0.0f};
+    f32 lod_error_threshold {1.0f};
+};
+
+// A mesh inside the shared vertex and index buffers.
+struct MeshRange {
+    u32 index_count {0};
+    u32 first_index {0};
+    i32 vertex_offset {0};
+    glm::vec4 bounding_sphere {}; // Object space center (xyz), radius (w).
+    // Into the meshlet buffer. Without meshlets the mesh is culled and
+    // drawn as a whole.
+    u32 first_meshlet {0};
+    u32 meshlet_count {0};
+    // Into the LOD buffer, level 0 being the ranges above. Without levels
+    // the mesh is always drawn at full resolution.
+    u32 first_lod {0};
+    u32 lod_count {0};
+};
+
+// One instance in the instance storage buffer (std430, see sh_cull.comp).
+// Everything needed to cull and draw it without the CPU.
+struct GpuObject {
+    glm::mat4 model {1.0f};
+    glm::vec4 bounding_sphere {};
+    u32 index_count {0};
+    u32 first_index {0};
+    i32 vertex_offset {0};
+    u32 material_id {0};
+    u32 first_meshlet {0};
+    u32 meshlet_count {0};
+    u32 first_lod {0};
+    u32 lod_count {0};
+};
+
+static_assert(sizeof(GpuObject) == 112, "Must match the std430 layout.");
+
+// Two-phase occlusion culling (see _record_command_buffer()):
+// Early draws what was visible last frame, Late tests everything against
+// the depth pyramid built from it and draws what became visible.
+// Without occlusion culling there is only the Early phase, frustum only.
+enum class CullPhase : u32 {
+    Early = 0,
+    Late = 1,
+};
+
+struct CullPushConstants {
+    u32 object_count {0};
+    CullPhase phase {CullPhase::Early};
+    u32 occlusion_culling {0}; // Bool.
+    u32 draw_capacity {0}; // Per phase, late draws start after it.
 };
 
+// Meshlets of one object at the level the cull shader selected, left to
+// the cluster cull shader (std430, see sh_cluster_cull.comp).
+struct GpuClusterTask {
+    u32 object {0};
+    u32 first_meshlet {0}; // Into the meshlet buffer.
+    u32 meshlet_count {0};
+};
+
+static_assert(sizeof(GpuClusterTask) == 12, "Must match the std430 layout.");
+
+// Written by the cull shaders (std430, see sh_cull.comp). Per phase: the
+// number of draws, the dispatch of the cluster cull shader and the objects
+// left to it. The dispatch keeps one workgroup per object up to the
+// 65535 workgroups every device supports, the workgroups loop past it.
+struct DrawCounters {
+    u32 draw_counts[2] {};
+    vk::DispatchIndirectCommand cluster_dispatches[2] {
+        {.x = 0, .y = 1, .z = 1},
+        {.x = 0, .y = 1, .z = 1},
+    };
+    u32 cluster_task_counts[2] {};
+};
+
+static_assert(sizeof(DrawCounters) == 40, "Must match the std430 layout.");
+
+// Scene set (0) bindings of occlusion culling, only written while it is on
+// so they are partially bound. Must match VISIBILITY_BINDING and
+// DEPTH_PYRAMID_BINDING in sh_cull.comp, checked against its reflection.
+static constexpr u32 s_visibility_binding {5};
+static constexpr u32 s_depth_pyramid_binding {6};
+
+// One entry of the material storage buffer (std430, see sh_default.frag).
+// Textures and samplers are indices into the bindless arrays.
+struct GpuMaterial {
+    glm::vec4 base_color {1.0f};
+    u32 albedo_texture {0};
+    u32 sampler {0};
+    u32 padding[2] {};
+};
+
+static_assert(sizeof(GpuMaterial) == 32, "Must match the std430 layout.");
+
+// Per-draw data, pushed instead of bound, so changing material or
+// transform between draws costs no descriptor work (see sh_default.vert).
+struct DrawPushConstants {
+    // Single instance draws carry their transform instead of writing it
+    // to the instance buffer.
+    glm::mat4 model {1.0f};
+    u32 material_id {0};
+    u32 pushed_model {0}; // Bool, read from the instance buffer otherwise.
+};
+
+static_assert(sizeof(DrawPushConstants) == 72, "Must match the shaders.");
+
 struct Vertex {
     glm::vec3 position {};
     glm::vec3 color {};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../hash.hpp"
+#include "../types.hpp"
+
+namespace core {
+
+enum class PipelineBlendMode : u8 {
+    Opaque,
+    AlphaBlend, // src * src.a + dst * (1 - src.a).
+    Additive, // src + dst.
+};
+
+// Fixed-function state a material chooses.
+struct PipelineState {
+    PipelineBlendMode blend_mode {PipelineBlendMode::Opaque};
+    vk::CullModeFlagBits cull_mode {vk::CullModeFlagBits::eBack};
+    bool depth_test {true};
+    bool depth_write {true};
+    vk::CompareOp depth_compare {vk::CompareOp::eLess};
+
+    bool
+    operator==(PipelineState const&) const = default;
+};
+
+// Everything a graphics pipeline is created from, two equal keys give the
+// same pipeline.
+struct PipelineKey {
+    // Shader variants, see ShaderVariantCache::request().
+    u64 vertex_shader {0};
+    u64 fragment_shader {0};
+    bool gpu_driven {false}; // GPU_DRIVEN specialization constant.
+    PipelineState state {};
+    // Attachments.
+    vk::Format color_format {vk::Format::eUndefined};
+    vk::Format depth_format {vk::Format::eUndefined};
+    vk::SampleCountFlagBits samples {vk::SampleCountFlagBits::e1};
+
+    bool
+    operator==(PipelineKey const&) const = default;
+};
+
+// Everything a descriptor set layout is created from, equal keys share a
+// layout.
+struct DescriptorSetLayoutKey {
+    struct Binding {
+        u32 binding {0};
+        vk::DescriptorType type {vk::DescriptorType::eUniformBuffer};
+        u32 count {0};
+        vk::ShaderStageFlags stages {};
+        vk::DescriptorBindingFlags flags {};
+
+        bool
+        operator==(Binding const&) const = default;
+    };
+
+    vk::DescriptorSetLayoutCreateFlags flags {};
+    std::vector<Binding> bindings {};
+
+    bool
+    operator==(DescriptorSetLayoutKey const&) const = default;
+};
+
+// Everything a pipeline layout is created from, equal keys share a layout.
+struct PipelineLayoutKey {
+    std::vector<vk::DescriptorSetLayout> set_layouts {};
+    vk::ShaderStageFlags push_constant_stages {};
+    u32 push_constant_size {0};
+
+    bool
+    operator==(PipelineLayoutKey const&) const = default;
+};
+
+} // namespace core
+
+namespace std {
+template <>
+struct hash<core::PipelineKey> {
+    size_t
+    operator()(core::PipelineKey const& key) const noexcept {
+        using core::u64;
+        core::PipelineState const& state = key.state;
+
+        u64 hash = core::hash_combine(key.vertex_shader, key.fragment_shader);
+        hash = core::hash_combine(hash, key.gpu_driven);
+        hash = core::hash_combine(hash, static_cast<u64>(state.blend_mode));
+        hash = core::hash_combine(hash, static_cast<u64>(state.cull_mode));
+        hash = core::hash_combine(hash, state.depth_test);
+        hash = core::hash_combine(hash, state.depth_write);
+        hash = core::hash_combine(hash, static_cast<u64>(state.depth_compare));
+        hash = core::hash_combine(hash, static_cast<u64>(key.color_format));
+        hash = core::hash_combine(hash, static_cast<u64>(key.depth_format));
+        hash = core::hash_combine(hash, static_cast<u64>(key.samples));
+
+        return static_cast<size_t>(hash);
+    }
+};
+
+template <>
+struct hash<core::DescriptorSetLayoutKey> {
+    size_t
+    operator()(core::DescriptorSetLayoutKey const& key) const noexcept {
+        using core::u64;
+
+        u64 hash = static_cast<VkFlags>(key.flags);
+
+        for (core::DescriptorSetLayoutKey::Binding const& binding :
+             key.bindings) {
+            hash = core::hash_combine(hash, binding.binding);
+            hash = core::hash_combine(hash, static_cast<u64>(binding.type));
+            hash = core::hash_combine(hash, binding.count);
+            hash = core::hash_combine(
+                hash,
+                static_cast<VkFlags>(binding.stages)
+            );
+            hash = core::hash_combine(
+                hash,
+                static_cast<VkFlags>(binding.flags)
+            );
+        }
+
+        return static_cast<size_t>(hash);
+    }
+};
+
+template <>
+struct hash<core::PipelineLayoutKey> {
+    size_t
+    operator()(core::PipelineLayoutKey const& key) const noexcept {
+        using core::u64;
+
+        u64 hash = core::hash_combine(
+            static_cast<VkFlags>(key.push_constant_stages),
+            key.push_constant_size
+        );
+
+        for (vk::DescriptorSetLayout const set_layout : key.set_layouts) {
+            auto const handle = static_cast<VkDescriptorSetLayout>(set_layout);
+            hash = core::hash_combine(hash, reinterpret_cast<u64>(handle));
+        }
+
+        return static_cast<size_t>(hash);
+    }
+};
+} // namespace std
+
+namespace core {
+
+// Graphics pipelines by PipelineKey, created on worker threads.
+//
+// find() never blocks on a compilation: a key seen for the first time is
+// queued and the caller draws with a fallback until a later find() returns
+// its pipeline. Pipelines live until take() or destruction, a failed
+// compilation is not retried (the fallback stays).
+//
+// The builder runs on the workers, concurrently: it may only read state
+// that does not change while the cache is running, or is thread-safe (the
+// shader variants).
+class VulkanPipelineCache {
+public:
+    using Builder = std::function<vk::UniquePipeline(PipelineKey const&)>;
+
+    VulkanPipelineCache() = default;
+    ~VulkanPipelineCache();
+    VulkanPipelineCache(VulkanPipelineCache const&) = delete;
+    VulkanPipelineCache&
+    operator=(VulkanPipelineCache const&) = delete;
+
+    void
+    start(Builder builder, u32 worker_count) noexcept;
+
+    // Joins the workers, queued keys are dropped. Called on destruction.
+    void
+    stop() noexcept;
+
+    // Null until compiled, the first call queues the compilation.
+    vk::Pipeline
+    find(PipelineKey const& key) noexcept;
+
+    // Compiles on the calling thread if needed, for a fallback that must
+    // be ready at once.
+    vk::Pipeline
+    find_now(PipelineKey const& key) noexcept;
+
+    // Gives the pipeline back (e.g. to retire it), the next find()
+    // compiles it again.
+    vk::UniquePipeline
+    take(PipelineKey const& key) noexcept;
+
+private:
+    struct Entry {
+        vk::UniquePipeline pipeline {nullptr};
+        // Queued or compiling, a worker will fill pipeline.
+        bool pending {false};
+    };
+
+    void
+    _work() noexcept;
+
+    vk::UniquePipeline
+    _build(PipelineKey const& key) const noexcept;
+
+    Builder _builder {};
+    mutable std::mutex _mutex {};
+    std::condition_variable _work_available {};
+    std::unordered_map<PipelineKey, Entry> _entries {};
+    std::deque<PipelineKey> _queue {};
+    bool _stopping {false};
+    std::vector<std::thread> _workers {};
+};
+
+} // namespace core
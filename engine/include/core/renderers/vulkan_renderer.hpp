@@ -8,17 +8,41 @@
 
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <memory>
 #include <optional>
-
+#include <span>
+#include <thread>
+#include <unordered_map>
+
+#include "../asset_database.hpp"
+#include "../asset_watcher.hpp"
+#include "../components.hpp"
+#include "../deletion_queue.hpp"
+#include "../ecs.hpp"
+#include "../image_writer.hpp"
+#include "../job_system.hpp"
+#include "../linear_allocator.hpp"
 #include "../log.hpp"
+#include "../mapped_asset.hpp"
+#include "../mesh_file.hpp"
+#include "../mesh_lod.hpp"
+#include "../meshlet.hpp"
+#include "../render_graph.hpp"
 #include "../renderer.hpp"
+#include "../shader_variants.hpp"
+#include "../spirv_reflection.hpp"
 #include "../stb_image.h"
 #include "../tiny_obj_loader.hpp"
+#include "../transform_hierarchy.hpp"
 #include "../types.hpp"
 #include "vulkan_drawable.hpp"
+#include "vulkan_pipeline_cache.hpp"
 
 #define USE_VALIDATION_LAYERS
+#define USE_HOT_RELOAD // Comment to deactivate.
 
 namespace core {
 
@@ -34,7 +58,11 @@ public:
     operator=(VulkanRenderer&&) = delete;
 
     void
-    init(GLFWwindow* window, RenderInfo const& test_render_info) noexcept;
+    init(
+        GLFWwindow* window,
+        RenderInfo const& test_render_info,
+        RendererSettings const& settings
+    ) noexcept;
 
     void
     render() noexcept;
@@ -47,45 +75,99 @@ public:
         _framebuffer_resized = value;
     }
 
+    // Draws one instance of the mesh per transform, in a single draw call
+    // (CPU culling) or as part of the frame's indirect draw (GPU culling,
+    // with the default material's pipeline state).
+    // Applies to the next frame drawn, the transforms are copied.
+    void
+    submit(
+        MeshRange const& mesh,
+        u32 material_id,
+        std::span<glm::mat4 const> transforms
+    ) noexcept;
+
 private:
     void
     _init_vulkan() noexcept {
         core_assert(
-            !_default_vertex_shader_spirv.empty() &&
-                !_default_fragment_shader_spirv.empty(),
+            _vertex_shader_source != 0 && _fragment_shader_source != 0,
             "Please add a default material to initialize renderer."
         );
 
         // Execution order is extremely important, do not modify.
         _create_vk_instance();
-        _create_surface();
+        if (!_settings.headless) {
+            _create_surface();
+        }
         _create_physical_device();
         _create_logical_device();
-        _create_swap_chain();
+        _create_timeline_semaphore();
+        if (_settings.headless) {
+            _create_offscreen_targets();
+        } else {
+            _create_swap_chain();
+        }
         _create_image_views();
         _create_render_pass();
         _create_descriptor_set_layout();
+        _create_bindless_descriptors();
         _create_graphics_pipeline();
+        _create_cull_pipeline();
+        _create_cluster_cull_pipeline();
+        _create_depth_pyramid_pipelines();
         _create_command_pool();
         _create_color_resources();
         _create_depth_resources();
+        _bind_attachment_memory();
+        _create_depth_pyramid();
         _create_framebuffers();
         _create_texture_image();
         _create_texture_image_view();
         _create_texture_sampler();
+        _create_default_material();
         _load_model();
         _create_vertex_buffer();
         _create_index_buffer();
-        _create_uniform_buffers();
+        _create_meshlet_buffer();
+        _create_lod_buffer();
+        _create_scene();
+        _create_uniform_rings();
+        _create_material_buffers();
+        _create_instance_buffers();
         _create_descriptor_pool();
         _create_descriptor_sets();
-        _create_command_buffers();
+        _create_frame_command_pools();
         _create_sync_objects();
     }
 
     void
     _draw_frame() noexcept;
 
+    // Waits until the current frame slot is free again and releases what
+    // its previous frame kept alive. Cheap if it was already waited.
+    void
+    _wait_for_frame() noexcept;
+
+    void
+    _process_asset_changes() noexcept;
+
+    bool
+    _reload_shader(AssetId id) noexcept;
+
+    void
+    _reload_texture() noexcept;
+
+    void
+    _reload_model() noexcept;
+
+    // Keeps a resource alive until every submission that may still
+    // reference it has finished on the GPU, then destroys it (no wait).
+    template <typename T>
+    void
+    _retire(T&& resource) {
+        _deletion_queue.push(_timeline_value, std::forward<T>(resource));
+    }
+
     void
     _create_vk_instance() noexcept;
 
@@ -101,30 +183,165 @@ private:
     void
     _create_swap_chain() noexcept;
 
+    // Hands the old swap chain to the new one and retires what it
+    // replaces, without waiting for the device.
     void
-    _cleanup_swap_chain() noexcept;
+    _recreate_swap_chain() noexcept;
 
+    // Headless replacement for the swap chain: one offscreen color target
+    // per frame in flight, read back with _write_capture().
     void
-    _recreate_swap_chain() noexcept;
+    _create_offscreen_targets() noexcept;
+
+    void
+    _write_capture() noexcept;
 
     void
     _create_image_views() noexcept;
 
+    // None with dynamic rendering.
     void
     _create_render_pass() noexcept;
 
+    // Set 0 (scene) and the layouts of the graphics and cull pipelines,
+    // reflected from their shaders.
     void
     _create_descriptor_set_layout() noexcept;
 
+    // Shared by every caller with the same bindings. Runtime arrays are
+    // bindless, see _create_bindless_descriptors(). Dynamic uniform
+    // buffers are bound at an offset, see _push_uniforms().
+    vk::DescriptorSetLayout
+    _descriptor_set_layout_for(
+        std::span<ShaderBinding const> bindings,
+        std::span<u32 const> partially_bound_bindings = {},
+        bool dynamic_uniform_buffers = false
+    ) noexcept;
+
+    // Shared by every caller with the same sets and push constants.
+    vk::PipelineLayout
+    _pipeline_layout_for(
+        std::span<vk::DescriptorSetLayout const> set_layouts,
+        ShaderLayout const& layout
+    ) noexcept;
+
+    // Sized from the scene set layout.
     void
     _create_descriptor_pool() noexcept;
 
     void
     _create_descriptor_sets() noexcept;
 
+    void
+    _write_descriptor_set(usize frame) noexcept;
+
+    // For resources shared by every frame slot (depth pyramid, visibility):
+    // each set is rewritten before its slot records again, sets of frames
+    // in flight are left alone.
+    void
+    _mark_descriptor_sets_stale() noexcept;
+
+    // Set 1: one update-after-bind set shared by every draw, holding all
+    // sampled images and samplers. Bound once per frame.
+    void
+    _create_bindless_descriptors() noexcept;
+
+    // Returns the slot to use as a texture index in GpuMaterial, empty
+    // (nothing written) once every slot is taken.
+    std::optional<u32>
+    _register_bindless_texture(vk::ImageView image_view) noexcept;
+
+    bool
+    _has_free_bindless_texture() const noexcept;
+
+    // The slot is reused once the frames that may sample it are done.
+    void
+    _release_bindless_texture(u32 slot) noexcept;
+
+    // Empty once every slot is taken.
+    std::optional<u32>
+    _register_bindless_sampler(vk::Sampler sampler) noexcept;
+
+    // Returns the material ID pushed with each draw. Its shader variants
+    // (the keywords it enables) and pipeline start compiling, drawn with
+    // the default one until ready.
+    u32
+    _add_material(
+        GpuMaterial const& material,
+        PipelineState const& state = {},
+        std::span<std::string const> shader_keywords = {}
+    ) noexcept;
+
+    void
+    _update_material(u32 material_id, GpuMaterial const& material) noexcept;
+
+    void
+    _create_default_material() noexcept;
+
+    void
+    _create_material_buffers() noexcept;
+
+    // Copies the material table to the current frame's buffer if it
+    // changed since that buffer was last written.
+    void
+    _upload_materials() noexcept;
+
+    // Pipeline layout and pipeline cache, with the default pipeline ready.
     void
     _create_graphics_pipeline() noexcept;
 
+    // Pipeline cache builder, runs on its workers. Waits for the shader
+    // variants of the key.
+    vk::UniquePipeline
+    _build_graphics_pipeline(PipelineKey const& key) noexcept;
+
+    struct MaterialPipeline;
+
+    // Requests the variants of the current graphics shaders with the
+    // material's keywords.
+    void
+    _request_shader_variants(MaterialPipeline& pipeline) noexcept;
+
+    PipelineKey
+    _pipeline_key(MaterialPipeline const& pipeline) const noexcept;
+
+    // Default state and no keywords.
+    PipelineKey
+    _default_pipeline_key() noexcept;
+
+    // The material's pipeline, or its previous one while it compiles, or
+    // the fallback.
+    vk::Pipeline
+    _graphics_pipeline_for(u32 material_id) noexcept;
+
+    // Same state and keywords as the default material, all GPU culling
+    // supports (one indirect draw, one pipeline).
+    bool
+    _shares_default_pipeline(u32 material_id) const noexcept;
+
+    // Unless a material or the fallback still draws with it.
+    void
+    _retire_unused_pipeline(PipelineKey const& key) noexcept;
+
+    // Compute pipeline writing the indirect draws (GPU culling only).
+    void
+    _create_cull_pipeline() noexcept;
+
+    // Second culling step, per meshlet of the objects the cull pipeline
+    // kept. Shares its layout.
+    void
+    _create_cluster_cull_pipeline() noexcept;
+
+    // Occlusion culling only: the depth pyramid reduction, one dispatch
+    // per level, the first one reading the depth buffer.
+    void
+    _create_depth_pyramid_pipelines() noexcept;
+
+    // Sized to the swap chain, recreated with the depth buffer.
+    void
+    _create_depth_pyramid() noexcept;
+
+    // None with dynamic rendering.
     void
     _create_framebuffers() noexcept;
 
@@ -132,19 +349,56 @@ private:
     _create_command_pool() noexcept;
 
     void
-    _create_command_buffers() noexcept;
+    _create_frame_command_pools() noexcept;
+
+    // Resets every command buffer of the current frame at once.
+    // Only valid once the frame slot has been waited.
+    void
+    _reset_frame_command_pool() noexcept;
+
+    // Valid until the next reset of the current frame's pool.
+    vk::CommandBuffer
+    _allocate_frame_command_buffer(
+        vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary
+    ) noexcept;
 
     void
     _create_sync_objects() noexcept;
 
+    void
+    _create_timeline_semaphore() noexcept;
+
     void
     _create_vertex_buffer() noexcept;
 
     void
     _create_index_buffer() noexcept;
 
+    // Meshlets of every mesh, read by the cluster cull shader.
     void
-    _create_uniform_buffers() noexcept;
+    _create_meshlet_buffer() noexcept;
+
+    // LOD ranges of every mesh, read by the cull shader.
+    void
+    _create_lod_buffer() noexcept;
+
+    // Uploads through a staging buffer, without waiting for the copy.
+    void
+    _create_device_local_buffer(
+        std::span<std::byte const> data,
+        vk::BufferUsageFlags usage,
+        vk::UniqueBuffer& buffer,
+        vk::UniqueDeviceMemory& buffer_memory
+    ) noexcept;
+
+    void
+    _create_uniform_rings() noexcept;
+
+    // Copies the block into the current frame's uniform ring and returns
+    // its dynamic offset. Valid until the frame slot comes around again.
+    // Empty, and logged, if the ring is too small for the frame's blocks.
+    std::optional<u32>
+    _push_uniforms(std::span<std::byte const> block) noexcept;
 
     void
     _create_texture_image() noexcept;
@@ -155,17 +409,112 @@ private:
     void
     _create_texture_sampler() noexcept;
 
+    // Creates the image, its memory is bound by _bind_attachment_memory().
     void
     _create_depth_resources() noexcept;
 
+    // Same as the depth image.
     void
     _create_color_resources() noexcept;
 
+    // MSAA color and depth share one allocation, at the offsets the frame
+    // graph gives them (aliased when their lifetimes don't overlap).
+    void
+    _bind_attachment_memory() noexcept;
+
+    // Loads the cooked mesh next to the model if it is up to date,
+    // otherwise parses the model, builds its meshlets and cooks it.
     void
     _load_model() noexcept;
 
+    // Fills _vertices and _indices from the OBJ file, deduplicated.
+    void
+    _parse_model_obj() noexcept;
+
+    void
+    _update_uniform_buffer() noexcept;
+
+    // Entities drawing the model on a grid, see RendererSettings.
+    void
+    _create_scene() noexcept;
+
+    // Grid positions and bounds from the model, again after a reload.
+    void
+    _lay_out_scene() noexcept;
+
+    // Animates the scene on the job system and submits it.
+    void
+    _update_scene() noexcept;
+
+    // The coarsest level whose error covers at most the LOD error
+    // threshold on screen, as select_lod() in sh_cull.comp.
+    u32
+    _select_lod(
+        MeshRange const& mesh,
+        glm::vec3 center,
+        f32 radius,
+        f32 scale
+    ) const noexcept;
+
+    // Level 0 of a mesh without levels is the mesh itself.
+    MeshLod
+    _mesh_lod(MeshRange const& mesh, u32 level) const noexcept;
+
+    void
+    _create_instance_buffers() noexcept;
+
+    // Grows a frame's InstanceBuffer (by doubling) and points its
+    // descriptor set at the new buffers.
+    void
+    _reserve_instances(
+        usize frame,
+        usize instance_count,
+        usize draw_count
+    ) noexcept;
+
+    // Streams the submitted instances to the current frame's buffer.
+    void
+    _upload_instances() noexcept;
+
+    // Per instance "visible last frame" flags, kept across frames.
+    void
+    _reserve_visibility(usize instance_count) noexcept;
+
+    // GPU culling: zeroes the draw counts (and the visibility flags the
+    // first time) before the early cull.
+    void
+    _record_cull_reset(vk::CommandBuffer command_buffer) noexcept;
+
+    // GPU culling: dispatches the cull shader, then the cluster cull
+    // shader over the objects it kept.
+    void
+    _record_culling(
+        vk::CommandBuffer command_buffer,
+        CullPhase phase
+    ) noexcept;
+
+    // Reduces the depth written so far into the depth pyramid.
     void
-    _update_uniform_buffer(u32 current_image) noexcept;
+    _record_depth_pyramid(vk::CommandBuffer command_buffer) noexcept;
+
+    // Dynamic rendering: begins the geometry pass without a render pass
+    // or framebuffer.
+    void
+    _begin_rendering(
+        vk::CommandBuffer command_buffer,
+        u32 image_index,
+        bool late,
+        std::span<vk::ClearValue const, 2> clear_values
+    ) const noexcept;
+
+    // Begins the pass, binds everything and draws: the phase's indirect
+    // draws (GPU culling) or the batches (CPU culling, early phase only).
+    void
+    _record_geometry_pass(
+        vk::CommandBuffer command_buffer,
+        u32 image_index,
+        CullPhase phase
+    ) noexcept;
 
     vk::UniqueImageView
     _create_image_view(
@@ -176,11 +525,42 @@ private:
     ) noexcept;
 
     void
-    _record_command_buffer(u32 image_index) noexcept;
+    _record_command_buffer(
+        vk::CommandBuffer command_buffer,
+        u32 image_index
+    ) noexcept;
+
+    // Transient resources of the frame graph backed by the renderer.
+    struct FrameGraphAttachments {
+        RenderGraphResource color {0};
+        RenderGraphResource depth {0};
+    };
+
+    // Declares the frame's passes and what they read and write, the graph
+    // orders them with barriers (see _record_graph_barriers()). The passes
+    // record into command_buffer when the graph executes.
+    FrameGraphAttachments
+    _build_frame_graph(
+        RenderGraph& graph,
+        vk::CommandBuffer command_buffer,
+        u32 image_index
+    ) noexcept;
+
+    // One pipeline barrier for all of them: a global memory barrier for
+    // buffers, an image barrier (and layout transition) per image.
+    void
+    _record_graph_barriers(
+        vk::CommandBuffer command_buffer,
+        RenderGraph const& graph,
+        std::span<RenderGraphBarrier const> barriers
+    ) const noexcept;
 
     vk::CommandBuffer
     _begin_single_time_commands() noexcept;
 
+    // Submits without waiting. Later frames wait for it on the GPU, the
+    // command buffer (and anything the caller retires) is released once
+    // the timeline has passed it.
     void
     _end_single_time_commands(vk::CommandBuffer& command_buffer) noexcept;
 
@@ -200,13 +580,17 @@ private:
         vk::DeviceSize const size
     ) noexcept;
 
-    std::vector<u32>
-    _compile_shader_to_spirv(
-        const std::string& source_code,
-        std::string const& file_path,
-        shaderc_shader_kind shader_kind
+    // Compute shader of the assets, compiled in the background.
+    ShaderVariantId
+    _compute_shader_variant(
+        std::string_view path,
+        std::span<std::string const> keywords = {}
     ) noexcept;
 
+    // Waits for the variant, empty if it failed to compile.
+    ShaderReflection
+    _reflect_shader(ShaderVariantId variant) noexcept;
+
     void
     _create_image(
         u32 width,
@@ -221,6 +605,19 @@ private:
         vk::UniqueDeviceMemory& image_memory
     ) noexcept;
 
+    // Without memory, for the caller to bind.
+    void
+    _create_image(
+        u32 width,
+        u32 height,
+        u32 mip_levels,
+        vk::SampleCountFlagBits sample_count,
+        vk::Format format,
+        vk::ImageTiling tiling,
+        vk::ImageUsageFlags usage,
+        vk::UniqueImage& image
+    ) noexcept;
+
     void
     _copy_buffer_to_image(
         vk::UniqueBuffer& buffer,
@@ -229,13 +626,14 @@ private:
         u32 height
     ) noexcept;
 
+    // Outside of the frame graph (uploads), with the same stages, access
+    // types and layouts as its barriers.
     void
     _transition_image_layout(
         vk::Image image,
-        vk::Format format,
-        vk::ImageLayout old_layout,
-        vk::ImageLayout new_layout,
-        u32 mip_levels
+        vk::ImageAspectFlags aspect,
+        u32 mip_levels,
+        RenderGraphBarrier const& barrier
     ) noexcept;
 
     void
@@ -256,17 +654,78 @@ private:
 #else
     static constexpr bool s_enable_validation_layers {true};
 #endif
-    static constexpr u32 s_max_frames_in_flight {2U};
 
+    // Sized to _frames_in_flight at init, it depends on the latency mode.
     template <typename T>
-    using PerFrameArray = std::array<T, s_max_frames_in_flight>;
+    using PerFrameArray = std::vector<T>;
 
+    RendererSettings _settings {};
+    u32 _frames_in_flight {2U};
     u32 _current_frame {0};
     bool _framebuffer_resized {false};
 
+    // Frames rendered so far.
+    u64 _frame_number {0};
+
+    // GPU timeline. Every submission (frames and uploads) signals the next
+    // value of _timeline, so one counter drives frame pacing, upload
+    // completion and deferred destruction.
+    vk::UniqueSemaphore _timeline {nullptr};
+    // Last value signaled by a submission.
+    u64 _timeline_value {0};
+    // Last value the GPU was observed to reach.
+    u64 _completed_value {0};
+    // Last value signaled by an upload, frames wait on it on the GPU.
+    u64 _upload_value {0};
+    // Value signaled by the last frame of each slot (0 = never used).
+    PerFrameArray<u64> _frame_slot_values {};
+
+    // Latency: input sampling -> present call, and -> GPU completion
+    // (observed when the frame slot fence is waited, so an upper bound).
+    struct LatencyStats {
+        f64 total_ms {0.0};
+        f64 max_ms {0.0};
+        u64 samples {0};
+
+        void
+        add(f64 ms) noexcept {
+            total_ms += ms;
+            max_ms = std::max(max_ms, ms);
+            ++samples;
+        }
+
+        f64
+        average_ms() const noexcept {
+            return samples > 0 ? total_ms / static_cast<f64>(samples) : 0.0;
+        }
+    };
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point _input_sample_time {};
+    PerFrameArray<Clock::time_point> _frame_input_times {};
+    LatencyStats _present_latency {};
+    LatencyStats _completion_latency {};
+
+    // Hot-reload.
+#if defined(USE_HOT_RELOAD)
+    static constexpr bool s_enable_hot_reload {true};
+#else
+    static constexpr bool s_enable_hot_reload {false};
+#endif
+    AssetWatcher _asset_watcher {};
+    std::string _vertex_shader_path {}; // Relative to the assets root.
+    std::string _fragment_shader_path {};
+    AssetId _vertex_shader_id {};
+    AssetId _fragment_shader_id {};
+    AssetId _texture_id {};
+    AssetId _model_id {};
+    AssetId _cull_shader_id {};
+    AssetId _cluster_cull_shader_id {};
+
     // Vulkan Core.
     GLFWwindow* _window {nullptr};
     vk::UniqueInstance _vk_instance {nullptr};
+    u32 _api_version {0}; // Of the instance, without patch.
     vk::UniqueSurfaceKHR _surface {nullptr};
     // PhysicalDevice is implicitaly destroyed when _vk_instance is destroyed.
     vk::PhysicalDevice _physical_device {nullptr};
@@ -283,44 +742,199 @@ private:
     // Image views.
     std::vector<vk::UniqueImageView> _swap_chain_image_views {};
 
+    // Headless: owners of _swap_chain_images, plus the capture readback.
+    std::vector<vk::UniqueImage> _offscreen_images {};
+    std::vector<vk::UniqueDeviceMemory> _offscreen_images_memory {};
+    vk::UniqueBuffer _readback_buffer {nullptr};
+    vk::UniqueDeviceMemory _readback_buffer_memory {nullptr};
+
     // Render Pipeline.
     vk::UniqueRenderPass _render_pass {nullptr};
-    vk::UniqueDescriptorSetLayout _descriptor_set_layout {nullptr};
+    // Occlusion culling: same attachments, loaded instead of cleared.
+    vk::UniqueRenderPass _late_render_pass {nullptr};
+    // Layouts by what they are made of, identical ones are shared.
+    std::unordered_map<DescriptorSetLayoutKey, vk::UniqueDescriptorSetLayout>
+        _descriptor_set_layouts {};
+    std::unordered_map<PipelineLayoutKey, vk::UniquePipelineLayout>
+        _pipeline_layouts {};
+    // Reflected. The graphics and cull pipelines share the scene set (0),
+    // which holds the bindings of both.
+    ShaderLayout _graphics_layout {};
+    ShaderLayout _cull_layout {};
+    vk::DescriptorSetLayout _descriptor_set_layout {nullptr};
     vk::UniqueDescriptorPool _descriptor_pool {nullptr};
     PerFrameArray<vk::UniqueDescriptorSet> _descriptor_sets {};
-    vk::UniquePipelineLayout _pipeline_Layout {nullptr};
-    vk::UniquePipeline _graphics_pipeline {nullptr};
-    std::vector<u32> _default_vertex_shader_spirv {};
-    std::vector<u32> _default_fragment_shader_spirv {};
+    PerFrameArray<bool> _descriptor_sets_stale {};
+    // Bindless.
+    static constexpr u32 s_max_bindless_textures {4096};
+    static constexpr u32 s_max_bindless_samplers {16};
+    static constexpr u32 s_max_materials {4096};
+    vk::DescriptorSetLayout _bindless_set_layout {nullptr};
+    vk::UniqueDescriptorPool _bindless_descriptor_pool {nullptr};
+    vk::DescriptorSet _bindless_set {nullptr}; // Freed with its pool.
+    u32 _bindless_texture_count {0}; // Slots ever handed out.
+    std::vector<u32> _free_bindless_textures {};
+    u32 _bindless_sampler_count {0};
+    vk::PipelineLayout _pipeline_Layout {nullptr};
+    vk::ShaderStageFlags _draw_push_constant_stages {};
+    vk::UniquePipelineCache _driver_pipeline_cache {nullptr};
+    // Graphics shaders, sources (see ShaderVariantCache::add_source()) of
+    // the variants materials use.
+    ShaderVariantCache _shader_variants {};
+    u64 _vertex_shader_source {0};
+    u64 _fragment_shader_source {0};
+    // Graphics pipelines by key. Declared after everything its builder
+    // reads, so that its workers stop first.
+    VulkanPipelineCache _pipeline_cache {};
+    // Default state, always ready.
+    PipelineKey _fallback_pipeline_key {};
+    vk::PipelineLayout _cull_pipeline_layout {nullptr};
+    vk::UniquePipeline _cull_pipeline {nullptr};
+    ShaderVariantId _cull_shader {0};
+    vk::UniquePipeline _cluster_cull_pipeline {nullptr};
+    ShaderVariantId _cluster_cull_shader {0};
+    vk::DescriptorSetLayout _depth_pyramid_set_layout {nullptr};
+    vk::PipelineLayout _depth_pyramid_pipeline_layout {nullptr};
+    vk::UniquePipeline _depth_pyramid_first_pipeline {nullptr};
+    vk::UniquePipeline _depth_pyramid_pipeline {nullptr};
 
     // Framebuffers.
     std::vector<vk::UniqueFramebuffer> _swap_chain_framebuffers {};
 
     // Commands.
     vk::UniqueCommandPool _command_pool {nullptr};
-    PerFrameArray<vk::UniqueCommandBuffer> _command_buffers {};
+    // Per frame in flight: a transient pool reset as a whole when the frame
+    // starts, and the buffers allocated from it, handed out linearly and
+    // reused after each reset (no per-buffer reset or free).
+    struct FrameCommandPool {
+        vk::UniqueCommandPool pool {nullptr};
+        std::vector<vk::CommandBuffer> primary {};
+        std::vector<vk::CommandBuffer> secondary {};
+        usize primary_used {0};
+        usize secondary_used {0};
+    };
+
+    PerFrameArray<FrameCommandPool> _frame_command_pools {};
 
     // Sync objetcs.
     // An image has been acquired from the swapchain and is ready for redering.
     PerFrameArray<vk::UniqueSemaphore> _image_available_semaphores {};
     // Rendering has finished and presentation can happen.
+    // (presentation only accepts binary semaphores, frame completion on
+    // the CPU side is tracked by _timeline).
     PerFrameArray<vk::UniqueSemaphore> _render_finished_semapahores {};
-    // Indicates if a frames is currentyl rendering.
-    // (to make sure only one frame is rendering at a time).
-    PerFrameArray<vk::UniqueFence> _frame_in_flight_fences {};
 
     // Buffers.
     vk::UniqueBuffer _vertex_buffer {nullptr};
     vk::UniqueDeviceMemory _vertex_buffer_memory {nullptr};
     vk::UniqueBuffer _index_buffer {nullptr};
     vk::UniqueDeviceMemory _index_buffer_memory {nullptr};
-    PerFrameArray<vk::UniqueBuffer> _uniform_buffers {};
-    PerFrameArray<vk::UniqueDeviceMemory> _uniform_buffers_memory {};
-    PerFrameArray<void*> _uniform_buffers_mapped {};
+
+    // Uniform blocks. One persistently mapped buffer per frame slot,
+    // sub-allocated from the start every frame and bound with dynamic
+    // offsets, so more blocks would cost no descriptor work. Only the
+    // scene block lives there for now.
+    struct UniformRing {
+        vk::UniqueBuffer buffer {nullptr};
+        vk::UniqueDeviceMemory memory {nullptr};
+        std::byte* mapped {nullptr};
+        LinearAllocator allocator {};
+    };
+
+    PerFrameArray<UniformRing> _uniform_rings {};
+    vk::DeviceSize _uniform_alignment {1}; // minUniformBufferOffsetAlignment.
+    u32 _scene_uniform_offset {0}; // UniformBufferObject of the frame.
+
+    // Materials. The CPU table is the source of truth, each frame slot has
+    // its own copy on the GPU so updates never race frames in flight.
+    std::vector<GpuMaterial> _materials {};
+    struct MaterialPipeline {
+        PipelineState state {};
+        std::vector<std::string> shader_keywords {};
+        ShaderVariantId vertex_shader {0};
+        ShaderVariantId fragment_shader {0};
+        // Drawn with after a shader reload until the new one is ready.
+        std::optional<PipelineKey> previous_key {};
+    };
+
+    std::vector<MaterialPipeline> _material_pipelines {}; // By material.
+    u64 _materials_version {0};
+    PerFrameArray<u64> _material_buffer_versions {};
+    PerFrameArray<vk::UniqueBuffer> _material_buffers {};
+    PerFrameArray<vk::UniqueDeviceMemory> _material_buffers_memory {};
+    PerFrameArray<void*> _material_buffers_mapped {};
+    u32 _default_material {0};
+
+    // Instances. Culled on the GPU when the settings ask for it and the
+    // device supports indirect count draws, while submitting otherwise
+    // (only visible instances are kept).
+    bool _gpu_culling {false};
+    bool _occlusion_culling {false}; // Implies _gpu_culling.
+    // Begins rendering with vkCmdBeginRendering when the settings ask for
+    // it and the device supports Vulkan 1.3, with render passes otherwise.
+    bool _dynamic_rendering {false};
+
+    // One per submit() call, drawn with a single drawIndexed (CPU culling).
+    struct DrawBatch {
+        MeshRange mesh {};
+        u32 material_id {0};
+        u32 first_instance {0};
+        u32 instance_count {0};
+        // A single instance pushes its transform with the draw instead.
+        bool pushed_model {false};
+        glm::mat4 model {1.0f};
+    };
+
+    // Submitted for the frame being built.
+    std::vector<GpuObject> _instances {};
+    std::vector<DrawBatch> _draw_batches {};
+    // CPU culling: (level, transform index) of the visible instances of
+    // one submit() call, to batch them by level.
+    std::vector<std::pair<u32, u32>> _visible_instances {};
+    // Draws the cull shaders may write per phase: one per meshlet (or per
+    // object without meshlets) of every submitted instance.
+    usize _max_draw_count {0};
+
+    // Host visible, persistently mapped, rewritten every frame. The draw
+    // commands written by the cull shaders (late ones after the first
+    // draw_capacity) and the objects left for cluster culling (per phase
+    // too) are sized along with it.
+    struct InstanceBuffer {
+        usize capacity {0}; // In instances.
+        usize draw_capacity {0}; // In draws, per phase.
+        vk::UniqueBuffer instances {nullptr};
+        vk::UniqueDeviceMemory instances_memory {nullptr};
+        void* instances_mapped {nullptr};
+        vk::UniqueBuffer draw_commands {nullptr};
+        vk::UniqueDeviceMemory draw_commands_memory {nullptr};
+        vk::UniqueBuffer cluster_work {nullptr};
+        vk::UniqueDeviceMemory cluster_work_memory {nullptr};
+    };
+
+    PerFrameArray<InstanceBuffer> _instance_buffers {};
+    // DrawCounters, reset at the start of each frame.
+    PerFrameArray<vk::UniqueBuffer> _draw_count_buffers {};
+    PerFrameArray<vk::UniqueDeviceMemory> _draw_count_buffers_memory {};
+    std::array<glm::vec4, 6> _frustum_planes {};
+    glm::vec3 _camera_position {};
+    f32 _projection_scale {0.0f}; // See UniformBufferObject.
+
+    // Occlusion culling. Visibility is indexed by instance, so it carries
+    // over frames as long as the submission order does.
+    usize _visibility_capacity {0};
+    bool _visibility_cleared {false};
+    vk::UniqueBuffer _visibility_buffer {nullptr};
+    vk::UniqueDeviceMemory _visibility_buffer_memory {nullptr};
 
     // Data to draw.
     std::vector<Vertex> _vertices {};
-    std::vector<u32> _indices {};
+    std::vector<u32> _indices {}; // Meshlet ranges are contiguous.
+    std::vector<Meshlet> _meshlets {};
+    vk::UniqueBuffer _meshlet_buffer {nullptr};
+    vk::UniqueDeviceMemory _meshlet_buffer_memory {nullptr};
+    std::vector<MeshLod> _mesh_lods {};
+    vk::UniqueBuffer _lod_buffer {nullptr};
+    vk::UniqueDeviceMemory _lod_buffer_memory {nullptr};
 
     // Textures.
     std::string _default_texture_path {};
@@ -329,21 +943,66 @@ private:
     vk::UniqueDeviceMemory _texture_image_memory {nullptr};
     vk::UniqueImageView _texture_image_view {nullptr};
     vk::UniqueSampler _texture_sampler {nullptr};
+    u32 _texture_slot {0}; // Bindless index of _texture_image_view.
+
+    // MSAA color and depth, see _bind_attachment_memory(). Declared
+    // before them so that it outlives them.
+    vk::UniqueDeviceMemory _attachment_memory {nullptr};
+
+    // Images of the frame graph being built, by resource (empty for
+    // buffers), for its barriers.
+    struct FrameGraphImage {
+        vk::Image image {};
+        vk::ImageSubresourceRange range {};
+    };
+
+    std::vector<FrameGraphImage> _frame_graph_images {};
 
     // Depth Buffering.
     vk::UniqueImage _depth_image {nullptr};
-    vk::UniqueDeviceMemory _depth_image_memory {nullptr};
+    vk::MemoryRequirements _depth_image_requirements {};
     vk::UniqueImageView _depth_image_view {nullptr};
+    vk::Format _depth_format {};
+
+    // Hierarchical Z: farthest depth per texel, each level half the size
+    // of the previous one, the first the depth buffer's rounded down to a
+    // power of two. Always in the general layout.
+    vk::Extent2D _depth_pyramid_extent {};
+    u32 _depth_pyramid_levels {0};
+    vk::UniqueImage _depth_pyramid {nullptr};
+    vk::UniqueDeviceMemory _depth_pyramid_memory {nullptr};
+    vk::UniqueImageView _depth_pyramid_view {nullptr}; // Every level.
+    std::vector<vk::UniqueImageView> _depth_pyramid_level_views {};
+    vk::UniqueSampler _depth_pyramid_sampler {nullptr};
+    // One set per level (source, destination), freed with the pool.
+    vk::UniqueDescriptorPool _depth_pyramid_descriptor_pool {nullptr};
+    std::vector<vk::DescriptorSet> _depth_pyramid_sets {};
 
     // Model.
     std::string _model_file_path {};
+    MeshRange _model_mesh {};
+
+    // Scene. Entities draw a Mesh (into _meshes) with a Material, their
+    // Transform local to their SceneNode's parent in _transforms.
+    JobSystem _jobs {};
+    World _world {};
+    TransformHierarchy _transforms {};
+    TransformNode _scene_root {s_no_transform_node};
+    std::vector<MeshRange> _meshes {};
+    u32 _scene_mesh {0}; // The model, into _meshes.
+    // World transforms of the submit() call being gathered.
+    std::vector<glm::mat4> _scene_frame_transforms {};
 
     // MSAA.
     // 1 sample per-pixel is equivalent to no use of multisampling at all.
     vk::SampleCountFlagBits _msaa_samples = vk::SampleCountFlagBits::e1;
     vk::UniqueImage _color_image {nullptr};
-    vk::UniqueDeviceMemory _color_image_memory {nullptr};
+    vk::MemoryRequirements _color_image_requirements {};
     vk::UniqueImageView _color_image_view {nullptr};
+
+    // Retired GPU objects, keyed by _timeline value.
+    // Declared last so it is destroyed first, while the device still lives.
+    DeletionQueue _deletion_queue {};
 };
 
 } // namespace core
@@ -0,0 +1,133 @@
+// include/core/shader_variants.hpp
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <shaderc/shaderc.hpp>
+
+#include "types.hpp"
+
+namespace core {
+
+// Feature keywords a shader declares, in order, without duplicates:
+//   #pragma shader_feature ALPHA_TEST VERTEX_COLOR
+// (glslang ignores pragmas it does not know).
+std::vector<std::string>
+parse_shader_keywords(std::string_view source);
+
+// Content address of a compiled variant: hash of the source, its stage and
+// the keywords it was compiled with.
+using ShaderVariantId = u64;
+
+// SPIR-V of shader variants, compiled on demand.
+//
+// A variant is a source compiled with a subset of its keywords defined.
+// Only requested variants are compiled (never the whole permutation set),
+// on worker threads that each own a shaderc::Compiler. Equal requests give
+// the same id and compile once, sources edited back and forth (hot reload)
+// find their variants still cached.
+//
+// With a directory, compiled variants are also stored there by id, so
+// later runs load them instead of compiling.
+class ShaderVariantCache {
+public:
+    ShaderVariantCache() = default;
+    ~ShaderVariantCache();
+    ShaderVariantCache(ShaderVariantCache const&) = delete;
+    ShaderVariantCache&
+    operator=(ShaderVariantCache const&) = delete;
+
+    void
+    start(
+        u32 worker_count,
+        std::filesystem::path const& directory = {}
+    ) noexcept;
+
+    // Joins the workers, queued variants are compiled by spirv() instead.
+    // Called on destruction.
+    void
+    stop() noexcept;
+
+    // Returns the id variants of the source are requested with. Sources
+    // are kept for the cache lifetime, adding one twice is free.
+    u64
+    add_source(
+        std::string_view path,
+        std::string_view text,
+        shaderc_shader_kind kind
+    ) noexcept;
+
+    // Keywords the source declares.
+    std::span<std::string const>
+    keywords(u64 source) const noexcept;
+
+    // Never blocks: queues the variant unless cached. Keywords the source
+    // doesn't declare are ignored, so one set serves every stage.
+    ShaderVariantId
+    request(u64 source, std::span<std::string const> keywords) noexcept;
+
+    // Waits for the variant, compiling it on the calling thread if no
+    // worker started it yet. Empty if it failed to compile. Valid for the
+    // cache lifetime.
+    std::span<u32 const>
+    spirv(ShaderVariantId variant) noexcept;
+
+    // Variants compiled so far (neither cached nor loaded from disk).
+    usize
+    compiled_count() const noexcept;
+
+private:
+    struct Source {
+        std::string path {};
+        std::string text {};
+        shaderc_shader_kind kind {};
+        std::vector<std::string> keywords {};
+    };
+
+    enum class VariantState : u8 {
+        Queued,
+        Compiling,
+        Ready,
+    };
+
+    struct Variant {
+        Source const* source {nullptr};
+        std::vector<std::string> defines {}; // Sorted.
+        VariantState state {VariantState::Queued};
+        std::vector<u32> spirv {}; // Empty if it failed.
+    };
+
+    void
+    _work() noexcept;
+
+    // Without the lock: reads the variant's source and defines only.
+    std::vector<u32>
+    _load_or_compile(
+        shaderc::Compiler const& compiler,
+        ShaderVariantId id,
+        Variant const& variant
+    ) noexcept;
+
+    mutable std::mutex _mutex {};
+    std::condition_variable _work_available {};
+    std::condition_variable _variant_ready {};
+    // Node based: sources and variants never move.
+    std::unordered_map<u64, Source> _sources {};
+    std::unordered_map<ShaderVariantId, Variant> _variants {};
+    std::deque<ShaderVariantId> _queue {};
+    std::filesystem::path _directory {};
+    usize _compiled_count {0};
+    bool _stopping {false};
+    std::vector<std::thread> _workers {};
+};
+
+} // namespace core
@@ -0,0 +1,105 @@
+// include/core/spirv_reflection.hpp
+#pragma once
+
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "types.hpp"
+
+namespace core {
+
+// What a SPIR-V module declares, read from its words: the descriptors it
+// binds, the size of its push constants and its vertex inputs. Layouts
+// are made from it instead of being kept in sync with the shaders by hand.
+//
+// No API here, like the render graph: the renderer maps these to its
+// descriptor types, stages and formats.
+
+enum class ShaderStage : u8 {
+    Vertex,
+    Fragment,
+    Compute,
+};
+
+// One bit per ShaderStage.
+using ShaderStageMask = u32;
+
+constexpr ShaderStageMask
+to_mask(ShaderStage stage) noexcept {
+    return ShaderStageMask {1} << static_cast<u32>(stage);
+}
+
+enum class ShaderDescriptorType : u8 {
+    UniformBuffer,
+    StorageBuffer,
+    SampledImage,
+    StorageImage,
+    Sampler,
+    CombinedImageSampler,
+    UniformTexelBuffer,
+    StorageTexelBuffer,
+};
+
+struct ShaderBinding {
+    u32 set {0};
+    u32 binding {0};
+    ShaderDescriptorType type {ShaderDescriptorType::UniformBuffer};
+    u32 count {1}; // 0: runtime array, sized by whoever makes the layout.
+    ShaderStageMask stages {0};
+
+    bool
+    operator==(ShaderBinding const&) const = default;
+};
+
+enum class ShaderScalarType : u8 {
+    Float,
+    Int,
+    Uint,
+};
+
+// 32-bit scalar or vector.
+struct ShaderVertexInput {
+    u32 location {0};
+    ShaderScalarType type {ShaderScalarType::Float};
+    u32 component_count {1};
+
+    bool
+    operator==(ShaderVertexInput const&) const = default;
+};
+
+struct ShaderReflection {
+    ShaderStage stage {ShaderStage::Vertex};
+    std::vector<ShaderBinding> bindings {}; // By set, then binding.
+    u32 push_constant_size {0}; // 0: none.
+    std::vector<ShaderVertexInput> vertex_inputs {}; // By location.
+};
+
+// Empty if the words are not a valid module, or declare a descriptor
+// or vertex input this can't describe.
+std::optional<ShaderReflection>
+reflect_spirv(std::span<u32 const> words);
+
+// Layout of the stages of one pipeline.
+struct ShaderLayout {
+    // By set number, bindings by binding number. A set no stage uses is
+    // empty.
+    std::vector<std::vector<ShaderBinding>> sets {};
+    u32 push_constant_size {0};
+    ShaderStageMask push_constant_stages {0};
+};
+
+// A binding used by several stages gets all of them. Empty if two stages
+// declare the same binding differently.
+std::optional<ShaderLayout>
+merge_shader_layouts(std::span<ShaderReflection const> stages);
+
+// The stage only uses bindings of the layout (declared the same way and
+// visible to it), and push constants within its range.
+bool
+fits_shader_layout(
+    ShaderReflection const& stage,
+    ShaderLayout const& layout
+) noexcept;
+
+} // namespace core
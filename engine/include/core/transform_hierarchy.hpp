@@ -0,0 +1,91 @@
+// include/core/transform_hierarchy.hpp
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "components.hpp"
+#include "job_system.hpp"
+#include "types.hpp"
+
+namespace core {
+
+using TransformNode = u32;
+
+// Parent of root nodes.
+static constexpr TransformNode s_no_transform_node {~0U};
+
+// Parent-child transforms and the world matrices they make.
+//
+// Local transforms are stored as one array per float (structure of
+// arrays), sorted by depth in the hierarchy: update() runs level by level,
+// each level after its parents, spreading a level over the job system.
+// Nodes are computed in batches of 8 (AVX2) or 4 (SSE2) lanes, the local
+// matrices built side by side from the arrays and multiplied with the
+// parent matrices of the lanes, all affine (the bottom row is 0, 0, 0, 1).
+//
+// A node is computed again only if its local transform was set or its
+// parent's world matrix changed since the last update, so a static
+// subtree costs one flag check per node.
+class TransformHierarchy {
+public:
+    TransformHierarchy() noexcept;
+    TransformHierarchy(TransformHierarchy const&) = delete;
+    TransformHierarchy&
+    operator=(TransformHierarchy const&) = delete;
+
+    // Nodes last as long as the hierarchy. Its local transform is the
+    // identity.
+    TransformNode
+    create(TransformNode parent = s_no_transform_node) noexcept;
+
+    usize
+    node_count() const noexcept;
+
+    // Relative to the parent. Different nodes may be set concurrently.
+    void
+    set_local(TransformNode node, Transform const& local) noexcept;
+
+    Transform
+    local(TransformNode node) const noexcept;
+
+    // As of the last update().
+    glm::mat4 const&
+    world(TransformNode node) const noexcept;
+
+    void
+    update(JobSystem& jobs) noexcept;
+
+private:
+    // Nodes of one depth, [begin, end) slots.
+    struct Level {
+        u32 begin {0};
+        u32 end {0};
+    };
+
+    void
+    _push_slot(u32 parent, u32 depth) noexcept;
+
+    // Reorders the slots by depth, then by parent.
+    void
+    _sort() noexcept;
+
+    void
+    _update_range(u32 begin, u32 end) noexcept;
+
+    // By slot. Slot 0 is the identity every root is the child of.
+    std::array<std::vector<f32>, 3> _positions {};
+    std::array<std::vector<f32>, 4> _rotations {}; // x, y, z, w.
+    std::array<std::vector<f32>, 3> _scales {};
+    std::vector<u32> _parents {};
+    std::vector<u32> _depths {};
+    std::vector<u8> _dirty {};   // Local transform set.
+    std::vector<u8> _changed {}; // World matrix computed by the update.
+    std::vector<glm::mat4> _worlds {};
+
+    std::vector<u32> _slot_of {}; // By node.
+    std::vector<Level> _levels {}; // By depth.
+    bool _sorted {true};
+};
+
+} // namespace core
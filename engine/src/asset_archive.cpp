@@ -0,0 +1,387 @@
+#include "../include/core/asset_archive.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+#include "../include/core/compression.hpp"
+
+namespace core {
+
+static constexpr u64
+s_align_up(u64 value, u64 alignment) noexcept {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// [offset, offset + size) within [0, limit), without overflowing.
+static constexpr bool
+s_in_range(u64 offset, u64 size, u64 limit) noexcept {
+    return offset <= limit && size <= limit - offset;
+}
+
+// LZ4 can't expand a byte into more than 255.
+static constexpr u64 s_max_lz4_ratio {255};
+
+std::string
+normalize_asset_path(std::string_view relative_path) {
+    std::string normalized {};
+    AssetPathSegments segments {relative_path};
+
+    for (std::string_view segment = segments.next(); !segment.empty();
+         segment = segments.next()) {
+        if (!normalized.empty()) {
+            normalized += '/';
+        }
+        normalized += segment;
+    }
+
+    return normalized;
+}
+
+#pragma region READER
+
+std::shared_ptr<AssetArchive>
+AssetArchive::open(std::filesystem::path const& path) noexcept {
+    // Private constructor, no make_shared.
+    std::shared_ptr<AssetArchive> archive {new AssetArchive {}};
+    archive->_path = path;
+    archive->_file = MappedAsset::open(path, AccessHint::Random);
+
+    std::span<std::byte const> const bytes = archive->_file.bytes();
+
+    if (bytes.size() < sizeof(PakHeader)) {
+        Log::error("Asset archive is too small: ", path.string());
+        return nullptr;
+    }
+
+    // The mapping is page aligned, so the header can be read in place.
+    auto const* header = reinterpret_cast<PakHeader const*>(bytes.data());
+
+    if (header->magic != PakHeader::s_magic ||
+        header->version != PakHeader::s_version) {
+        Log::error("Not a valid asset archive: ", path.string());
+        return nullptr;
+    }
+
+    u64 const file_size = bytes.size();
+
+    // Sections are read in place, they must be aligned too.
+    if (!s_in_range(
+            header->entries_offset,
+            u64 {header->entry_count} * sizeof(PakEntry),
+            file_size
+        ) ||
+        !s_in_range(
+            header->buckets_offset,
+            u64 {header->bucket_count} * sizeof(u32),
+            file_size
+        ) ||
+        !s_in_range(header->strings_offset, header->strings_size, file_size) ||
+        header->entries_offset % alignof(PakEntry) != 0 ||
+        header->buckets_offset % alignof(u32) != 0 ||
+        !std::has_single_bit(header->bucket_count) ||
+        header->bucket_count <= header->entry_count) {
+        Log::error("Corrupted asset archive index: ", path.string());
+        return nullptr;
+    }
+
+    archive->_header = header;
+    archive->_entries = {
+        reinterpret_cast<PakEntry const*>(
+            bytes.data() + header->entries_offset
+        ),
+        header->entry_count
+    };
+    archive->_buckets = {
+        reinterpret_cast<u32 const*>(bytes.data() + header->buckets_offset),
+        header->bucket_count
+    };
+    archive->_strings = {
+        reinterpret_cast<char const*>(bytes.data() + header->strings_offset),
+        header->strings_size
+    };
+
+    // Lookups and reads trust the index from here on.
+    for (PakEntry const& entry : archive->_entries) {
+        bool const known_compression =
+            entry.compression == PakCompression::None ||
+            entry.compression == PakCompression::Lz4;
+        bool const sizes_match = entry.compression == PakCompression::Lz4
+            ? entry.size <= entry.stored_size * s_max_lz4_ratio
+            : entry.size == entry.stored_size;
+
+        if (!s_in_range(entry.offset, entry.stored_size, file_size) ||
+            !s_in_range(
+                entry.path_offset,
+                entry.path_length,
+                header->strings_size
+            ) ||
+            !known_compression || !sizes_match) {
+            Log::error("Corrupted asset archive entry: ", path.string());
+            return nullptr;
+        }
+    }
+
+    // Probing stops at an empty bucket, the writer leaves most of them
+    // empty but a corrupted table may have none.
+    bool has_empty_bucket {false};
+
+    for (u32 const bucket : archive->_buckets) {
+        if (bucket != s_empty_bucket && bucket >= header->entry_count) {
+            Log::error("Corrupted asset archive buckets: ", path.string());
+            return nullptr;
+        }
+
+        has_empty_bucket |= bucket == s_empty_bucket;
+    }
+
+    if (!has_empty_bucket) {
+        Log::error("Corrupted asset archive buckets: ", path.string());
+        return nullptr;
+    }
+
+    Log::info(
+        "Mounted asset archive: ",
+        path.string(),
+        " (",
+        header->entry_count,
+        " entries)"
+    );
+
+    return archive;
+}
+
+PakEntry const*
+AssetArchive::find(std::string_view relative_path) const noexcept {
+    return find(hash_asset_path(relative_path), relative_path);
+}
+
+PakEntry const*
+AssetArchive::find(u64 path_hash, std::string_view relative_path)
+    const noexcept {
+    if (_buckets.empty()) {
+        return nullptr;
+    }
+
+    u64 const mask = _buckets.size() - 1;
+
+    // Linear probing, the table is at most half full.
+    for (u64 slot = path_hash & mask;; slot = (slot + 1) & mask) {
+        u32 const index = _buckets[slot];
+
+        if (index == s_empty_bucket) {
+            return nullptr;
+        }
+
+        PakEntry const& entry = _entries[index];
+
+        if (entry.path_hash == path_hash &&
+            asset_paths_equal(path_of(entry), relative_path)) {
+            return &entry;
+        }
+    }
+}
+
+std::string_view
+AssetArchive::path_of(PakEntry const& entry) const noexcept {
+    return _strings.substr(entry.path_offset, entry.path_length);
+}
+
+MappedAsset
+AssetArchive::read(PakEntry const& entry, bool verify_content) const noexcept {
+    std::span<std::byte const> const stored =
+        _file.bytes().subspan(entry.offset, entry.stored_size);
+
+    MappedAsset asset {};
+
+    switch (entry.compression) {
+        case PakCompression::None:
+            asset = MappedAsset::from_view(stored, shared_from_this());
+            break;
+
+        case PakCompression::Lz4: {
+            std::vector<std::byte> buffer(entry.size);
+
+            if (!lz4_decompress(stored, buffer)) {
+                Log::error(
+                    "Corrupted compressed archive entry: ",
+                    path_of(entry)
+                );
+                return {};
+            }
+
+            asset = MappedAsset::from_buffer(std::move(buffer));
+            break;
+        }
+    }
+
+    if (verify_content && hash_fnv1a(asset.bytes()) != entry.content_hash) {
+        Log::error("Archive entry content hash mismatch: ", path_of(entry));
+        return {};
+    }
+
+    return asset;
+}
+
+#pragma endregion READER
+
+#pragma region WRITER
+
+AssetArchiveWriter::AssetArchiveWriter(u32 data_alignment) noexcept
+    : _data_alignment {std::max<u32>(std::bit_ceil(data_alignment), 8)} {}
+
+void
+AssetArchiveWriter::add(
+    std::string_view relative_path,
+    std::span<std::byte const> content,
+    bool compress
+) {
+    PendingEntry entry {
+        .path = normalize_asset_path(relative_path),
+        .content_hash = hash_fnv1a(content),
+        .size = content.size(),
+    };
+    entry.path_hash = hash_fnv1a(entry.path);
+
+    if (compress) {
+        lz4_compress(content, entry.stored);
+
+        // Not worth it (already compressed formats such as png/jpg).
+        if (entry.stored.size() >= content.size()) {
+            entry.stored.clear();
+        } else {
+            entry.compression = PakCompression::Lz4;
+        }
+    }
+
+    if (entry.compression == PakCompression::None) {
+        entry.stored.assign(content.begin(), content.end());
+    }
+
+    _pending.push_back(std::move(entry));
+}
+
+bool
+AssetArchiveWriter::write(std::filesystem::path const& output_path) const {
+    std::vector<PendingEntry const*> sorted {};
+    sorted.reserve(_pending.size());
+    for (PendingEntry const& entry : _pending) {
+        sorted.push_back(&entry);
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](auto const* a, auto const* b) {
+        return a->path_hash < b->path_hash;
+    });
+
+    for (usize i {1}; i < sorted.size(); ++i) {
+        if (sorted[i]->path == sorted[i - 1]->path) {
+            Log::error("Duplicated archive entry: ", sorted[i]->path);
+            return false;
+        }
+    }
+
+    PakHeader header {};
+    header.entry_count = static_cast<u32>(sorted.size());
+    // Keep the load factor <= 0.5 so probe chains stay short.
+    header.bucket_count =
+        std::bit_ceil(std::max<u32>(header.entry_count * 2, 1));
+    header.data_alignment = _data_alignment;
+
+    std::string strings {};
+    std::vector<PakEntry> entries(sorted.size());
+
+    for (usize i {}; i < sorted.size(); ++i) {
+        entries[i] = PakEntry {
+            .path_hash = sorted[i]->path_hash,
+            .content_hash = sorted[i]->content_hash,
+            .size = sorted[i]->size,
+            .stored_size = sorted[i]->stored.size(),
+            .path_offset = static_cast<u32>(strings.size()),
+            .path_length = static_cast<u32>(sorted[i]->path.size()),
+            .compression = sorted[i]->compression,
+        };
+        strings += sorted[i]->path;
+    }
+
+    std::vector<u32> buckets(
+        header.bucket_count,
+        AssetArchive::s_empty_bucket
+    );
+    u64 const mask = header.bucket_count - 1;
+
+    for (u32 i {}; i < entries.size(); ++i) {
+        u64 slot = entries[i].path_hash & mask;
+        while (buckets[slot] != AssetArchive::s_empty_bucket) {
+            slot = (slot + 1) & mask;
+        }
+        buckets[slot] = i;
+    }
+
+    // Table of contents.
+    header.entries_offset = s_align_up(sizeof(PakHeader), 8);
+    header.buckets_offset = s_align_up(
+        header.entries_offset + entries.size() * sizeof(PakEntry),
+        8
+    );
+    header.strings_offset =
+        s_align_up(header.buckets_offset + buckets.size() * sizeof(u32), 8);
+    header.strings_size = strings.size();
+
+    // Data.
+    u64 offset = header.strings_offset + header.strings_size;
+    for (PakEntry& entry : entries) {
+        offset = s_align_up(offset, _data_alignment);
+        entry.offset = offset;
+        offset += entry.stored_size;
+    }
+
+    std::ofstream file(output_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        Log::error("Failed to open archive: ", output_path.string());
+        return false;
+    }
+
+    auto write_at = [&file](u64 position, void const* data, usize size) {
+        // Fill alignment padding with zeroes.
+        static constexpr char s_zeroes[64] {};
+        u64 current = static_cast<u64>(file.tellp());
+        while (current < position) {
+            usize const pad =
+                std::min<u64>(position - current, sizeof(s_zeroes));
+            file.write(s_zeroes, static_cast<std::streamsize>(pad));
+            current += pad;
+        }
+        file.write(
+            static_cast<char const*>(data),
+            static_cast<std::streamsize>(size)
+        );
+    };
+
+    write_at(0, &header, sizeof(header));
+    write_at(
+        header.entries_offset,
+        entries.data(),
+        entries.size() * sizeof(PakEntry)
+    );
+    write_at(
+        header.buckets_offset,
+        buckets.data(),
+        buckets.size() * sizeof(u32)
+    );
+    write_at(header.strings_offset, strings.data(), strings.size());
+
+    for (usize i {}; i < entries.size(); ++i) {
+        write_at(
+            entries[i].offset,
+            sorted[i]->stored.data(),
+            sorted[i]->stored.size()
+        );
+    }
+
+    return file.good();
+}
+
+#pragma endregion WRITER
+
+} // namespace core
@@ -1,30 +1,85 @@
 #include "../include/core/asset_database.hpp"
 
+#include <array>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
 namespace core {
 
+struct AssetDatabase::AssetRecord {
+    std::string relative_path {};
+    std::filesystem::path resolved {};
+    std::filesystem::path absolute {};
+
+    // Mutable state, guarded by the owning shard mutex.
+    AssetMetadata metadata {};
+    AssetArchive const* archive {nullptr};
+    PakEntry const* entry {nullptr};
+};
+
+struct AssetDatabase::CacheShard {
+    mutable std::shared_mutex mutex {};
+    // Node based: records never move, so handing out references is safe.
+    std::unordered_map<AssetId, AssetRecord> records {};
+};
+
+// Independent locks so concurrent loaders rarely contend.
+static constexpr usize s_cache_shard_count {16};
+
+std::span<AssetDatabase::CacheShard>
+AssetDatabase::_cache() {
+    static std::array<CacheShard, s_cache_shard_count> s_shards {};
+    return s_shards;
+}
+
+static usize
+s_shard_index(AssetId id) noexcept {
+    // Low bits index the map buckets, use the high ones for shards.
+    return static_cast<usize>(id.value >> 60) % s_cache_shard_count;
+}
+
 std::filesystem::path const&
 AssetDatabase::root() {
     static std::filesystem::path const s_assets_root = _init_assets_root();
     return s_assets_root;
 }
 
-std::filesystem::path
-AssetDatabase::resolve(std::string const& relative_path) {
-    std::filesystem::path const resolved = root() / relative_path;
+AssetId
+AssetDatabase::intern(std::string_view relative_path) {
+    return AssetId {_record(relative_path).relative_path};
+}
+
+std::filesystem::path const&
+AssetDatabase::resolve(std::string_view relative_path) {
+    AssetRecord const& record = _record(relative_path);
     core_assert(
-        std::filesystem::exists(resolved),
+        metadata(AssetId {relative_path}).exists,
         "Failed to resolve path: file does not exists."
     );
 
-    return resolved;
+    return record.resolved;
+}
+
+std::filesystem::path const&
+AssetDatabase::resolve(AssetId id) {
+    AssetRecord const* record = _find_record(id);
+    core_assert(record, "Failed to resolve path: asset was never interned.");
+
+    return record->resolved;
 }
 
 std::string
-AssetDatabase::read_asset_file(std::string const& assets_relative_path) {
-    std::ifstream file(
-        resolve(assets_relative_path),
-        std::ios::ate | std::ios::binary
-    );
+AssetDatabase::read_asset_file(std::string_view assets_relative_path) {
+    AssetRecord const& record = _record(assets_relative_path);
+
+    if (auto [archive, entry] = _cached_archive_entry(record); entry) {
+        // Compressed entries own their bytes, copy before they're freed.
+        MappedAsset const asset = archive->read(*entry);
+        return std::string(asset.text());
+    }
+
+    std::ifstream file(record.resolved, std::ios::ate | std::ios::binary);
 
     core_assert(file.is_open(), "Failed to open asset file.");
 
@@ -39,20 +94,196 @@ AssetDatabase::read_asset_file(std::string const& assets_relative_path) {
     return buffer;
 }
 
-std::filesystem::path
-AssetDatabase::absolute_path(std::string const& assets_relative_path) {
-    std::filesystem::path const path = resolve(assets_relative_path);
+MappedAsset
+AssetDatabase::map_asset_file(
+    std::string_view assets_relative_path,
+    AccessHint hint
+) {
+    AssetRecord const& record = _record(assets_relative_path);
+
+    if (auto [archive, entry] = _cached_archive_entry(record); entry) {
+        return archive->read(*entry);
+    }
+
+    return MappedAsset::open(record.resolved, hint);
+}
+
+std::filesystem::path const&
+AssetDatabase::absolute_path(std::string_view assets_relative_path) {
+    AssetRecord const& record = _record(assets_relative_path);
     core_assert(
-        exists(path),
+        metadata(AssetId {assets_relative_path}).exists,
         "Failed to get absolute path: file does not exists."
     );
 
-    return std::filesystem::absolute(path);
+    return record.absolute;
+}
+
+bool
+AssetDatabase::exists(std::string_view assets_relative_path) {
+    _record(assets_relative_path);
+    return metadata(AssetId {assets_relative_path}).exists;
+}
+
+AssetMetadata
+AssetDatabase::metadata(AssetId id) {
+    CacheShard const& shard = _cache()[s_shard_index(id)];
+    std::shared_lock const lock {shard.mutex};
+
+    auto const it = shard.records.find(id);
+    return it != shard.records.end() ? it->second.metadata : AssetMetadata {};
+}
+
+AssetMetadata
+AssetDatabase::refresh(AssetId id) {
+    CacheShard& shard = _cache()[s_shard_index(id)];
+    std::unique_lock const lock {shard.mutex};
+
+    auto const it = shard.records.find(id);
+    if (it == shard.records.end()) {
+        return {};
+    }
+
+    _stat(it->second);
+    return it->second.metadata;
 }
 
 bool
-AssetDatabase::exists(std::string const& assets_relative_path) {
-    return std::filesystem::exists(resolve(assets_relative_path));
+AssetDatabase::mount(std::filesystem::path const& archive_path) {
+    std::shared_ptr<AssetArchive> archive = AssetArchive::open(archive_path);
+
+    if (!archive) {
+        Log::warn("Failed to mount asset archive: ", archive_path.string());
+        return false;
+    }
+
+    _mounted_archives().push_back(std::move(archive));
+    _refresh_all();
+
+    return true;
+}
+
+void
+AssetDatabase::unmount_all() {
+    // Assets already read from an archive keep it alive on their own.
+    _mounted_archives().clear();
+    _refresh_all();
+}
+
+AssetDatabase::AssetRecord const&
+AssetDatabase::_record(std::string_view relative_path) {
+    AssetId const id {relative_path};
+    CacheShard& shard = _cache()[s_shard_index(id)];
+
+    // Hot path: shared lock, hash probe, no allocation.
+    {
+        std::shared_lock const lock {shard.mutex};
+        auto const it = shard.records.find(id);
+
+        if (it != shard.records.end()) {
+            core_assert(
+                asset_paths_equal(it->second.relative_path, relative_path),
+                "Asset path hash collision."
+            );
+            return it->second;
+        }
+    }
+
+    // First sighting: resolve and stat outside of the lock.
+    AssetRecord record {};
+    record.relative_path = normalize_asset_path(relative_path);
+    record.resolved = root() / record.relative_path;
+    record.absolute = std::filesystem::absolute(record.resolved);
+    _stat(record);
+
+    std::unique_lock const lock {shard.mutex};
+    // Another thread may have won the race, in which case keep theirs.
+    return shard.records.try_emplace(id, std::move(record)).first->second;
+}
+
+AssetDatabase::AssetRecord const*
+AssetDatabase::_find_record(AssetId id) {
+    CacheShard const& shard = _cache()[s_shard_index(id)];
+    std::shared_lock const lock {shard.mutex};
+
+    auto const it = shard.records.find(id);
+    return it != shard.records.end() ? &it->second : nullptr;
+}
+
+void
+AssetDatabase::_stat(AssetRecord& record) {
+    AssetId const id {record.relative_path};
+    auto const [archive, entry] = _find_in_archives(id, record.relative_path);
+
+    record.archive = archive;
+    record.entry = entry;
+
+    if (entry) {
+        record.metadata = {
+            .size = entry->size,
+            .modified_ticks = 0,
+            .exists = true,
+            .archived = true,
+        };
+        return;
+    }
+
+    // directory_entry caches the result of a single stat() call.
+    std::error_code error {};
+    std::filesystem::directory_entry const file {record.resolved, error};
+
+    if (error || !file.is_regular_file(error)) {
+        record.metadata = {};
+        return;
+    }
+
+    record.metadata = {
+        .size = file.file_size(error),
+        .modified_ticks = static_cast<i64>(
+            file.last_write_time(error).time_since_epoch().count()
+        ),
+        .exists = true,
+        .archived = false,
+    };
+}
+
+void
+AssetDatabase::_refresh_all() {
+    for (CacheShard& shard : _cache()) {
+        std::unique_lock const lock {shard.mutex};
+
+        for (auto& [id, record] : shard.records) {
+            _stat(record);
+        }
+    }
+}
+
+std::pair<AssetArchive const*, PakEntry const*>
+AssetDatabase::_cached_archive_entry(AssetRecord const& record) {
+    AssetId const id {record.relative_path};
+    std::shared_lock const lock {_cache()[s_shard_index(id)].mutex};
+
+    return {record.archive, record.entry};
+}
+
+std::vector<std::shared_ptr<AssetArchive>>&
+AssetDatabase::_mounted_archives() {
+    static std::vector<std::shared_ptr<AssetArchive>> s_archives {};
+    return s_archives;
+}
+
+std::pair<AssetArchive const*, PakEntry const*>
+AssetDatabase::_find_in_archives(AssetId id, std::string_view relative_path) {
+    auto const& archives = _mounted_archives();
+
+    // Later mounts override earlier ones (patches over the base archive).
+    for (auto it = archives.rbegin(); it != archives.rend(); ++it) {
+        if (PakEntry const* entry = (*it)->find(id.value, relative_path)) {
+            return {it->get(), entry};
+        }
+    }
+
+    return {nullptr, nullptr};
 }
 
 std::filesystem::path
@@ -69,4 +300,4 @@ AssetDatabase::_init_assets_root() {
     return root;
 }
 
-} // namespace core
\ No newline at end of file
+} // namespace core
@@ -0,0 +1,172 @@
+#include "../include/core/asset_watcher.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include "../include/core/asset_database.hpp"
+
+#if defined(__linux__)
+    #define CORE_HAS_INOTIFY
+    #include <cerrno>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+namespace core {
+
+AssetWatcher::~AssetWatcher() {
+    stop();
+}
+
+#ifdef CORE_HAS_INOTIFY
+
+// Editors either write in place (close-write) or write a temporary file and
+// rename it over the original (moved-to). New directories need a watch too,
+// inotify is not recursive.
+static constexpr u32 s_watch_mask {
+    IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR
+};
+
+bool
+AssetWatcher::start(std::filesystem::path const& root) noexcept {
+    stop();
+
+    _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_fd < 0) {
+        Log::warn("Failed to initialize inotify, hot-reload disabled.");
+        return false;
+    }
+
+    _root = root;
+    _watch_directory(root);
+
+    std::error_code error {};
+    for (auto const& item :
+         std::filesystem::recursive_directory_iterator(root, error)) {
+        if (item.is_directory(error)) {
+            _watch_directory(item.path());
+        }
+    }
+
+    Log::info(
+        "Watching ",
+        _directories.size(),
+        " asset directories for changes: ",
+        root.string()
+    );
+
+    return true;
+}
+
+void
+AssetWatcher::stop() noexcept {
+    if (_fd >= 0) {
+        ::close(_fd); // Also drops every watch.
+    }
+
+    _fd = -1;
+    _directories.clear();
+}
+
+void
+AssetWatcher::_watch_directory(std::filesystem::path const& directory
+) noexcept {
+    int const wd = inotify_add_watch(_fd, directory.c_str(), s_watch_mask);
+
+    if (wd < 0) {
+        Log::warn("Failed to watch directory: ", directory.string());
+        return;
+    }
+
+    _directories[wd] = directory.lexically_relative(_root);
+}
+
+std::vector<AssetChange>
+AssetWatcher::poll() noexcept {
+    std::vector<AssetChange> changes {};
+
+    if (_fd < 0) {
+        return changes;
+    }
+
+    // Large enough for many events, aligned as inotify_event requires.
+    alignas(inotify_event) std::array<char, 16 * 1024> buffer {};
+
+    while (true) {
+        isize const length = ::read(_fd, buffer.data(), buffer.size());
+
+        // EAGAIN: nothing left to read (non-blocking descriptor).
+        if (length <= 0) {
+            break;
+        }
+
+        for (isize offset {}; offset < length;) {
+            auto const* event =
+                reinterpret_cast<inotify_event const*>(buffer.data() + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            auto const directory = _directories.find(event->wd);
+            if (event->len == 0 || directory == _directories.end()) {
+                continue;
+            }
+
+            std::filesystem::path const relative =
+                (directory->second / event->name).lexically_normal();
+
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    _watch_directory(_root / relative);
+                }
+                continue;
+            }
+
+            // A created file is reported again on close-write.
+            if (!(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))) {
+                continue;
+            }
+
+            std::string path = relative.generic_string();
+            AssetId const id {path};
+
+            bool const already_reported = std::any_of(
+                changes.begin(),
+                changes.end(),
+                [id](AssetChange const& change) { return change.id == id; }
+            );
+
+            if (!already_reported) {
+                changes.push_back({.id = id, .relative_path = std::move(path)});
+            }
+        }
+    }
+
+    for (AssetChange const& change : changes) {
+        AssetDatabase::refresh(change.id);
+        Log::info("Asset changed: ", change.relative_path);
+    }
+
+    return changes;
+}
+
+#else
+
+bool
+AssetWatcher::start(std::filesystem::path const&) noexcept {
+    Log::warn("Asset watching is not supported on this platform.");
+    return false;
+}
+
+void
+AssetWatcher::stop() noexcept {}
+
+void
+AssetWatcher::_watch_directory(std::filesystem::path const&) noexcept {}
+
+std::vector<AssetChange>
+AssetWatcher::poll() noexcept {
+    return {};
+}
+
+#endif
+
+} // namespace core
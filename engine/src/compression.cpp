@@ -0,0 +1,207 @@
+#include "../include/core/compression.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace core {
+
+static constexpr usize s_min_match {4};
+// The last 5 bytes of a block are always literals and the last match must
+// start at least 12 bytes before the end of the block (spec requirements).
+static constexpr usize s_last_literals {5};
+static constexpr usize s_match_find_limit {12};
+static constexpr usize s_max_offset {65'535};
+static constexpr u32 s_hash_log {12};
+
+static u32
+s_read_u32(std::byte const* ptr) noexcept {
+    u32 value {};
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static u32
+s_hash_sequence(u32 sequence) noexcept {
+    // Knuth's multiplicative hash, keep the top bits.
+    return (sequence * 2'654'435'761U) >> (32 - s_hash_log);
+}
+
+static void
+s_write_length(std::vector<std::byte>& dst, usize length) {
+    while (length >= 255) {
+        dst.push_back(std::byte {255});
+        length -= 255;
+    }
+    dst.push_back(static_cast<std::byte>(length));
+}
+
+static void
+s_write_sequence(
+    std::vector<std::byte>& dst,
+    std::span<std::byte const> literals,
+    usize offset,
+    usize match_length
+) {
+    usize const literal_length = literals.size();
+    usize const match_code = match_length - s_min_match;
+
+    u8 token = static_cast<u8>(std::min<usize>(literal_length, 15) << 4);
+    if (match_length > 0) {
+        token |= static_cast<u8>(std::min<usize>(match_code, 15));
+    }
+    dst.push_back(static_cast<std::byte>(token));
+
+    if (literal_length >= 15) {
+        s_write_length(dst, literal_length - 15);
+    }
+    dst.insert(dst.end(), literals.begin(), literals.end());
+
+    // Last sequence: literals only.
+    if (match_length == 0) {
+        return;
+    }
+
+    dst.push_back(static_cast<std::byte>(offset & 0xFF));
+    dst.push_back(static_cast<std::byte>((offset >> 8) & 0xFF));
+
+    if (match_code >= 15) {
+        s_write_length(dst, match_code - 15);
+    }
+}
+
+usize
+lz4_compress_bound(usize input_size) noexcept {
+    return input_size + (input_size / 255) + 16;
+}
+
+usize
+lz4_compress(std::span<std::byte const> src, std::vector<std::byte>& dst) {
+    usize const start_size = dst.size();
+    dst.reserve(start_size + lz4_compress_bound(src.size()));
+
+    usize const size = src.size();
+    std::byte const* const base = src.data();
+
+    usize anchor {0};
+
+    if (size > s_match_find_limit) {
+        // Positions are stored +1 so that zero means "empty slot".
+        std::vector<u32> table(usize {1} << s_hash_log, 0);
+        usize const match_limit = size - s_match_find_limit;
+        usize const match_end_limit = size - s_last_literals;
+
+        usize i {0};
+        while (i < match_limit) {
+            u32 const sequence = s_read_u32(base + i);
+            u32 const hash = s_hash_sequence(sequence);
+            u32 const candidate = table[hash];
+            table[hash] = static_cast<u32>(i + 1);
+
+            if (candidate == 0 || i - (candidate - 1) > s_max_offset ||
+                s_read_u32(base + candidate - 1) != sequence) {
+                ++i;
+                continue;
+            }
+
+            usize const match = candidate - 1;
+            usize length {s_min_match};
+            while (i + length < match_end_limit &&
+                   base[match + length] == base[i + length]) {
+                ++length;
+            }
+
+            s_write_sequence(
+                dst,
+                src.subspan(anchor, i - anchor),
+                i - match,
+                length
+            );
+
+            i += length;
+            anchor = i;
+        }
+    }
+
+    s_write_sequence(dst, src.subspan(anchor), 0, 0);
+
+    return dst.size() - start_size;
+}
+
+bool
+lz4_decompress(
+    std::span<std::byte const> src,
+    std::span<std::byte> dst
+) noexcept {
+    usize in {0};
+    usize out {0};
+
+    auto read_length = [&](usize& length) -> bool {
+        u8 extra {255};
+        while (extra == 255) {
+            if (in >= src.size()) {
+                return false;
+            }
+            extra = static_cast<u8>(src[in++]);
+            length += extra;
+        }
+        return true;
+    };
+
+    while (in < src.size()) {
+        u8 const token = static_cast<u8>(src[in++]);
+
+        usize literal_length = token >> 4;
+        if (literal_length == 15 && !read_length(literal_length)) {
+            return false;
+        }
+
+        if (literal_length > src.size() - in ||
+            literal_length > dst.size() - out) {
+            return false;
+        }
+
+        std::memcpy(dst.data() + out, src.data() + in, literal_length);
+        in += literal_length;
+        out += literal_length;
+
+        // The last sequence has no match part.
+        if (in == src.size()) {
+            break;
+        }
+
+        if (src.size() - in < 2) {
+            return false;
+        }
+
+        usize const offset = static_cast<usize>(src[in]) |
+            (static_cast<usize>(src[in + 1]) << 8);
+        in += 2;
+
+        if (offset == 0 || offset > out) {
+            return false;
+        }
+
+        usize match_length = token & 0x0F;
+        if (match_length == 15 && !read_length(match_length)) {
+            return false;
+        }
+        match_length += s_min_match;
+
+        if (match_length > dst.size() - out) {
+            return false;
+        }
+
+        // Matches may overlap their own output (run-length style),
+        // so copy forward one byte at a time.
+        std::byte* const out_ptr = dst.data() + out;
+        std::byte const* const match_ptr = out_ptr - offset;
+        for (usize i {}; i < match_length; ++i) {
+            out_ptr[i] = match_ptr[i];
+        }
+        out += match_length;
+    }
+
+    return out == dst.size();
+}
+
+} // namespace core
@@ -5,32 +5,33 @@
 namespace core {
 
 void
-run() {
+run(RendererSettings const& settings) {
     std::string const texture_file_path =
         AssetDatabase::resolve("textures/tex_viking_room.png");
     std::string const vert_file_path =
         AssetDatabase::resolve("shaders/sh_default.vert").string();
     std::string const frag_file_path =
-        AssetDatabase::resolve("shaders/sh_default.vert").string();
+        AssetDatabase::resolve("shaders/sh_default.frag").string();
     std::string const model_file_path =
         AssetDatabase::resolve("models/model_viking_room.obj");
 
-    std::string vert_shader_src =
-        AssetDatabase::read_asset_file("shaders/sh_default.vert");
-    std::string frag_shader_src =
-        AssetDatabase::read_asset_file("shaders/sh_default.frag");
+    // Mapped sources must outlive the renderer initialization.
+    MappedAsset const vert_shader_src =
+        AssetDatabase::map_asset_file("shaders/sh_default.vert");
+    MappedAsset const frag_shader_src =
+        AssetDatabase::map_asset_file("shaders/sh_default.frag");
 
     RenderInfo const default_material {
         .texture_file_path = texture_file_path,
         .model_file_path = model_file_path,
         .vertex_file_path = vert_file_path,
-        .vertex_source = vert_shader_src,
+        .vertex_source = vert_shader_src.text(),
         .fragment_file_path = frag_file_path,
-        .fragment_source = frag_shader_src,
+        .fragment_source = frag_shader_src.text(),
     };
 
     VulkanRenderer vk_renderer {};
-    Renderer renderer {vk_renderer, default_material};
+    Renderer renderer {vk_renderer, default_material, settings};
     renderer.render();
 }
 
@@ -0,0 +1,35 @@
+#include "../include/core/deletion_queue.hpp"
+
+#include "../include/core/log.hpp"
+
+namespace core {
+
+DeletionQueue::~DeletionQueue() {
+    flush();
+}
+
+void
+DeletionQueue::collect(u64 completed_value) noexcept {
+    while (!_entries.empty() && _entries.front().value <= completed_value) {
+        _entries.pop_front();
+    }
+}
+
+void
+DeletionQueue::flush() noexcept {
+    while (!_entries.empty()) {
+        _entries.pop_front();
+    }
+}
+
+void
+DeletionQueue::_push(u64 value, std::unique_ptr<Node> node) {
+    core_assert(
+        _entries.empty() || _entries.back().value <= value,
+        "Deletion queue values must not decrease."
+    );
+
+    _entries.push_back({.value = value, .node = std::move(node)});
+}
+
+} // namespace core
@@ -0,0 +1,268 @@
+#include "../include/core/ecs.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <mutex>
+
+#include "../include/core/log.hpp"
+
+namespace core {
+
+struct ComponentInfo {
+    usize size {0};
+    usize alignment {0};
+};
+
+// Shared by every world, so ids are the same in all of them.
+static std::mutex s_component_mutex {};
+static std::vector<ComponentInfo> s_components {};
+
+static constexpr usize
+s_align_up(usize offset, usize alignment) noexcept {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+ComponentId
+World::_register_component(usize size, usize alignment) noexcept {
+    std::scoped_lock const lock {s_component_mutex};
+
+    core_assert(
+        s_components.size() < s_max_component_types,
+        "Too many component types, raise s_max_component_types."
+    );
+    core_assert(
+        alignment <= alignof(ChunkBytes),
+        "Components can't be aligned more than chunks."
+    );
+
+    s_components.push_back({.size = size, .alignment = alignment});
+    return static_cast<ComponentId>(s_components.size() - 1);
+}
+
+void
+World::destroy(Entity entity) noexcept {
+    if (!alive(entity)) {
+        return;
+    }
+
+    EntityRecord& record = _records[entity.index];
+    _erase(record.archetype, record.chunk, record.row);
+
+    // Handles to it are stale from now on.
+    record.generation = std::max(record.generation + 1, 1U);
+    record.mask = 0;
+    _free_indices.push_back(entity.index);
+    --_entity_count;
+}
+
+bool
+World::alive(Entity entity) const noexcept {
+    return entity.generation != 0 && entity.index < _records.size() &&
+        _records[entity.index].generation == entity.generation;
+}
+
+usize
+World::entity_count() const noexcept {
+    return _entity_count;
+}
+
+World::EntityRecord const&
+World::_record(Entity entity) const noexcept {
+    core_assert(alive(entity), "Entity was destroyed.");
+    return _records[entity.index];
+}
+
+Entity
+World::_allocate_entity() noexcept {
+    ++_entity_count;
+
+    if (_free_indices.empty()) {
+        _records.emplace_back();
+        return {
+            .index = static_cast<u32>(_records.size() - 1),
+            .generation = _records.back().generation,
+        };
+    }
+
+    u32 const index = _free_indices.back();
+    _free_indices.pop_back();
+
+    return {.index = index, .generation = _records[index].generation};
+}
+
+u32
+World::_archetype_for(ComponentMask mask) noexcept {
+    auto const [found, inserted] = _archetype_of_mask.try_emplace(
+        mask,
+        static_cast<u32>(_archetypes.size())
+    );
+
+    if (!inserted) {
+        return found->second;
+    }
+
+    Archetype archetype {.mask = mask};
+    archetype.column_of.fill(s_no_column);
+
+    usize row_size = sizeof(Entity);
+    {
+        std::scoped_lock const lock {s_component_mutex};
+
+        for (ComponentMask bits = mask; bits != 0; bits &= bits - 1) {
+            auto const id = static_cast<ComponentId>(std::countr_zero(bits));
+            archetype.column_of[id] =
+                static_cast<u8>(archetype.columns.size());
+            archetype.columns.push_back({
+                .component = id,
+                .size = s_components[id].size,
+                .alignment = s_components[id].alignment,
+            });
+            row_size += s_components[id].size;
+        }
+    }
+
+    // Lays the columns out for capacity rows, returns the bytes used.
+    auto const lay_out = [&archetype](usize capacity) {
+        usize offset = sizeof(Entity) * capacity;
+
+        for (Column& column : archetype.columns) {
+            offset = s_align_up(offset, column.alignment);
+            column.offset = offset;
+            offset += column.size * capacity;
+        }
+
+        return offset;
+    };
+
+    // As many rows as fit once every column is aligned.
+    usize capacity = s_chunk_size / row_size;
+
+    while (capacity > 1 && lay_out(capacity) > s_chunk_size) {
+        --capacity;
+    }
+
+    usize const chunk_bytes = lay_out(capacity);
+    core_assert(
+        capacity > 0 && chunk_bytes <= s_chunk_size,
+        "Components of one entity don't fit in a chunk."
+    );
+
+    archetype.chunk_capacity = static_cast<u32>(capacity);
+    _archetypes.push_back(std::move(archetype));
+
+    return found->second;
+}
+
+void
+World::_place(Entity entity, u32 archetype_index) noexcept {
+    Archetype& archetype = _archetypes[archetype_index];
+
+    if (archetype.chunks.empty() ||
+        archetype.chunks.back().count == archetype.chunk_capacity) {
+        archetype.chunks.push_back({
+            .bytes = std::make_unique<ChunkBytes>(),
+            .count = 0,
+        });
+    }
+
+    Chunk& chunk = archetype.chunks.back();
+    u32 const row = chunk.count++;
+    _entities(chunk)[row] = entity;
+
+    for (Column const& column : archetype.columns) {
+        std::memset(
+            chunk.bytes->data + column.offset + row * column.size,
+            0,
+            column.size
+        );
+    }
+
+    _records[entity.index] = {
+        .generation = entity.generation,
+        .mask = archetype.mask,
+        .archetype = archetype_index,
+        .chunk = static_cast<u32>(archetype.chunks.size() - 1),
+        .row = row,
+    };
+}
+
+void
+World::_move(Entity entity, u32 archetype_index) noexcept {
+    EntityRecord const from = _records[entity.index];
+    _place(entity, archetype_index);
+    EntityRecord const& to = _records[entity.index];
+
+    Archetype const& source = _archetypes[from.archetype];
+    Archetype const& destination = _archetypes[to.archetype];
+    std::byte const* const source_bytes =
+        source.chunks[from.chunk].bytes->data;
+    std::byte* const destination_bytes =
+        destination.chunks[to.chunk].bytes->data;
+
+    for (Column const& column : destination.columns) {
+        u8 const source_column = source.column_of[column.component];
+
+        if (source_column == s_no_column) {
+            continue;
+        }
+
+        std::memcpy(
+            destination_bytes + column.offset + to.row * column.size,
+            source_bytes + source.columns[source_column].offset +
+                from.row * column.size,
+            column.size
+        );
+    }
+
+    _erase(from.archetype, from.chunk, from.row);
+}
+
+void
+World::_erase(u32 archetype_index, u32 chunk_index, u32 row) noexcept {
+    Archetype& archetype = _archetypes[archetype_index];
+    Chunk& chunk = archetype.chunks[chunk_index];
+    Chunk& last_chunk = archetype.chunks.back();
+    u32 const last_row = last_chunk.count - 1;
+
+    if (&chunk != &last_chunk || row != last_row) {
+        Entity const moved = _entities(last_chunk)[last_row];
+        _entities(chunk)[row] = moved;
+
+        for (Column const& column : archetype.columns) {
+            std::memcpy(
+                chunk.bytes->data + column.offset + row * column.size,
+                last_chunk.bytes->data + column.offset +
+                    last_row * column.size,
+                column.size
+            );
+        }
+
+        _records[moved.index].chunk = chunk_index;
+        _records[moved.index].row = row;
+    }
+
+    if (--last_chunk.count == 0) {
+        archetype.chunks.pop_back();
+    }
+}
+
+std::vector<World::ChunkRef>
+World::_chunks_with(ComponentMask mask) const {
+    std::vector<ChunkRef> chunks {};
+
+    for (u32 archetype {}; archetype < _archetypes.size(); ++archetype) {
+        if ((_archetypes[archetype].mask & mask) != mask) {
+            continue;
+        }
+
+        for (u32 chunk {}; chunk < _archetypes[archetype].chunks.size();
+             ++chunk) {
+            chunks.push_back({.archetype = archetype, .chunk = chunk});
+        }
+    }
+
+    return chunks;
+}
+
+} // namespace core
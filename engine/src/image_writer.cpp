@@ -0,0 +1,176 @@
+#include "../include/core/image_writer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include "../include/core/log.hpp"
+
+namespace core {
+
+static constexpr std::array<u32, 256>
+s_make_crc_table() noexcept {
+    std::array<u32, 256> table {};
+
+    for (u32 n {}; n < 256; ++n) {
+        u32 c = n;
+        for (u32 k {}; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+        }
+        table[n] = c;
+    }
+
+    return table;
+}
+
+static constexpr std::array<u32, 256> s_crc_table = s_make_crc_table();
+
+u32
+crc32(std::span<std::byte const> data, u32 crc) noexcept {
+    crc = ~crc;
+    for (std::byte const b : data) {
+        crc = s_crc_table[(crc ^ static_cast<u8>(b)) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void
+s_append_u32_be(std::vector<std::byte>& out, u32 value) {
+    out.push_back(static_cast<std::byte>(value >> 24));
+    out.push_back(static_cast<std::byte>(value >> 16));
+    out.push_back(static_cast<std::byte>(value >> 8));
+    out.push_back(static_cast<std::byte>(value));
+}
+
+static void
+s_append_chunk(
+    std::vector<std::byte>& out,
+    std::string_view type,
+    std::span<std::byte const> data
+) {
+    s_append_u32_be(out, static_cast<u32>(data.size()));
+
+    usize const type_offset = out.size();
+    for (char const c : type) {
+        out.push_back(static_cast<std::byte>(c));
+    }
+    out.insert(out.end(), data.begin(), data.end());
+
+    // The CRC covers the chunk type and data, not the length.
+    s_append_u32_be(
+        out,
+        crc32(std::span {out}.subspan(type_offset, type.size() + data.size()))
+    );
+}
+
+bool
+write_png(
+    std::filesystem::path const& path,
+    u32 width,
+    u32 height,
+    u32 channels,
+    std::span<std::byte const> pixels
+) {
+    // Gray, -, RGB, RGBA (color types 0, 2, 6; gray + alpha is 4).
+    constexpr std::array<u8, 5> color_types {0, 0, 4, 2, 6};
+
+    if (channels == 0 || channels > 4 ||
+        pixels.size() < usize {width} * height * channels) {
+        Log::warn("Invalid image for PNG capture: ", path.string());
+        return false;
+    }
+
+    usize const row_size = usize {width} * channels;
+
+    // Every scanline is prefixed by its filter type (0 = none).
+    std::vector<std::byte> scanlines {};
+    scanlines.reserve((row_size + 1) * height);
+    for (u32 y {}; y < height; ++y) {
+        auto const row = pixels.subspan(y * row_size, row_size);
+        scanlines.push_back(std::byte {0});
+        scanlines.insert(scanlines.end(), row.begin(), row.end());
+    }
+
+    // zlib stream: header, stored deflate blocks (<= 65535 bytes each),
+    // Adler-32 of the uncompressed data.
+    constexpr usize max_block_size {65'535};
+    std::vector<std::byte> idat {};
+    idat.reserve(scanlines.size() + scanlines.size() / max_block_size * 5 + 16);
+    idat.push_back(std::byte {0x78}); // Deflate, 32K window.
+    idat.push_back(std::byte {0x01}); // No dictionary, check bits.
+
+    usize offset {0};
+    do {
+        usize const size = std::min(max_block_size, scanlines.size() - offset);
+        bool const last = offset + size == scanlines.size();
+
+        idat.push_back(static_cast<std::byte>(last ? 1 : 0)); // BTYPE = 00.
+        idat.push_back(static_cast<std::byte>(size));
+        idat.push_back(static_cast<std::byte>(size >> 8));
+        idat.push_back(static_cast<std::byte>(~size));
+        idat.push_back(static_cast<std::byte>(~size >> 8));
+        idat.insert(
+            idat.end(),
+            scanlines.begin() + static_cast<isize>(offset),
+            scanlines.begin() + static_cast<isize>(offset + size)
+        );
+
+        offset += size;
+    } while (offset < scanlines.size());
+
+    u32 a {1};
+    u32 b {0};
+    for (std::byte const byte : scanlines) {
+        a = (a + static_cast<u8>(byte)) % 65'521;
+        b = (b + a) % 65'521;
+    }
+    s_append_u32_be(idat, (b << 16) | a);
+
+    std::vector<std::byte> header {};
+    s_append_u32_be(header, width);
+    s_append_u32_be(header, height);
+    header.push_back(std::byte {8}); // Bit depth.
+    header.push_back(static_cast<std::byte>(color_types[channels]));
+    header.push_back(std::byte {0}); // Compression: deflate.
+    header.push_back(std::byte {0}); // Filter method: adaptive.
+    header.push_back(std::byte {0}); // No interlace.
+
+    constexpr std::array<u8, 8> signature {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'
+    };
+
+    std::vector<std::byte> png {};
+    png.reserve(idat.size() + 64);
+    for (u8 const c : signature) {
+        png.push_back(static_cast<std::byte>(c));
+    }
+    s_append_chunk(png, "IHDR", header);
+    s_append_chunk(png, "IDAT", idat);
+    s_append_chunk(png, "IEND", {});
+
+    return write_raw(path, png);
+}
+
+bool
+write_raw(
+    std::filesystem::path const& path,
+    std::span<std::byte const> pixels
+) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open()) {
+        Log::warn("Failed to open file for writing: ", path.string());
+        return false;
+    }
+
+    file.write(
+        reinterpret_cast<char const*>(pixels.data()),
+        static_cast<std::streamsize>(pixels.size())
+    );
+
+    return file.good();
+}
+
+} // namespace core
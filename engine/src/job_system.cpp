@@ -0,0 +1,127 @@
+#include "../include/core/job_system.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#include "../include/core/log.hpp"
+
+namespace core {
+
+JobSystem::~JobSystem() {
+    stop();
+}
+
+void
+JobSystem::start(u32 worker_count) noexcept {
+    core_assert(_workers.empty(), "Job system already started.");
+
+    _workers.reserve(worker_count);
+
+    for (u32 i {}; i < worker_count; ++i) {
+        _workers.emplace_back([this] { _work(); });
+    }
+}
+
+void
+JobSystem::stop() noexcept {
+    {
+        std::scoped_lock const lock {_mutex};
+        _stopping = true;
+    }
+
+    _work_available.notify_all();
+
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+
+    _workers.clear();
+    _stopping = false;
+}
+
+u32
+JobSystem::worker_count() const noexcept {
+    return static_cast<u32>(_workers.size());
+}
+
+void
+JobSystem::parallel_for(
+    usize count,
+    usize grain,
+    std::function<void(usize begin, usize end)> const& job
+) noexcept {
+    grain = std::max<usize>(grain, 1);
+    usize const range_count = (count + grain - 1) / grain;
+
+    if (range_count <= 1 || _workers.empty()) {
+        if (count > 0) {
+            job(0, count);
+        }
+        return;
+    }
+
+    std::atomic<usize> remaining {range_count};
+
+    {
+        std::scoped_lock const lock {_mutex};
+
+        for (usize begin {}; begin < count; begin += grain) {
+            _queue.emplace_back([this, &job, &remaining, begin, count, grain] {
+                job(begin, std::min(begin + grain, count));
+
+                // Notified under the lock, the caller can't miss it
+                // between checking and waiting.
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::scoped_lock const lock {_mutex};
+                    _range_done.notify_all();
+                }
+            });
+        }
+    }
+
+    _work_available.notify_all();
+
+    // Ranges of any loop are run while waiting, ours are among them.
+    std::unique_lock lock {_mutex};
+
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (_queue.empty()) {
+            _range_done.wait(lock, [this, &remaining] {
+                return remaining.load(std::memory_order_acquire) == 0 ||
+                    !_queue.empty();
+            });
+            continue;
+        }
+
+        std::function<void()> const range = std::move(_queue.front());
+        _queue.pop_front();
+
+        lock.unlock();
+        range();
+        lock.lock();
+    }
+}
+
+void
+JobSystem::_work() noexcept {
+    std::unique_lock lock {_mutex};
+
+    while (true) {
+        _work_available.wait(lock, [this] {
+            return _stopping || !_queue.empty();
+        });
+
+        if (_stopping) {
+            return;
+        }
+
+        std::function<void()> const range = std::move(_queue.front());
+        _queue.pop_front();
+
+        lock.unlock();
+        range();
+        lock.lock();
+    }
+}
+
+} // namespace core
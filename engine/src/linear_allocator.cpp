@@ -0,0 +1,33 @@
+#include "../include/core/linear_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#include "../include/core/log.hpp"
+
+namespace core {
+
+LinearAllocator::LinearAllocator(u64 capacity, u64 alignment) noexcept
+    : _capacity {capacity}, _alignment {alignment} {
+    core_assert(
+        std::has_single_bit(alignment),
+        "Alignment must be a power of two."
+    );
+}
+
+std::optional<u64>
+LinearAllocator::allocate(u64 size) noexcept {
+    u64 const offset = _head;
+
+    if (size > _capacity - offset) {
+        return std::nullopt;
+    }
+
+    // Rounded up for the next range, never past the end.
+    u64 const end = offset + size;
+    _head = std::min((end + _alignment - 1) & ~(_alignment - 1), _capacity);
+
+    return offset;
+}
+
+} // namespace core
@@ -0,0 +1,190 @@
+#include "../include/core/mapped_asset.hpp"
+
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define CORE_HAS_MMAP
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace core {
+
+MappedAsset::~MappedAsset() {
+    _release();
+}
+
+MappedAsset::MappedAsset(MappedAsset&& other) noexcept
+    : _data {std::exchange(other._data, nullptr)},
+      _size {std::exchange(other._size, 0)},
+      _valid {std::exchange(other._valid, false)},
+      _mapping {std::exchange(other._mapping, nullptr)},
+      _mapping_size {std::exchange(other._mapping_size, 0)},
+      _owned {std::move(other._owned)},
+      _owner {std::move(other._owner)} {}
+
+MappedAsset&
+MappedAsset::operator=(MappedAsset&& other) noexcept {
+    if (this != &other) {
+        _release();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+        _valid = std::exchange(other._valid, false);
+        _mapping = std::exchange(other._mapping, nullptr);
+        _mapping_size = std::exchange(other._mapping_size, 0);
+        _owned = std::move(other._owned);
+        _owner = std::move(other._owner);
+    }
+
+    return *this;
+}
+
+MappedAsset
+MappedAsset::from_view(
+    std::span<std::byte const> bytes,
+    std::shared_ptr<void const> owner
+) noexcept {
+    MappedAsset asset {};
+    asset._data = bytes.data();
+    asset._size = bytes.size();
+    asset._owner = std::move(owner);
+    asset._valid = true;
+
+    return asset;
+}
+
+MappedAsset
+MappedAsset::from_buffer(std::vector<std::byte>&& buffer) noexcept {
+    MappedAsset asset {};
+    asset._owned = std::move(buffer);
+    asset._data = asset._owned.data();
+    asset._size = asset._owned.size();
+    asset._valid = true;
+
+    return asset;
+}
+
+#ifdef CORE_HAS_MMAP
+
+static int
+s_to_madvise(AccessHint hint) noexcept {
+    switch (hint) {
+        case AccessHint::Sequential:
+            return MADV_SEQUENTIAL;
+        case AccessHint::Random:
+            return MADV_RANDOM;
+        case AccessHint::WillNeed:
+            return MADV_WILLNEED;
+    }
+
+    return MADV_NORMAL;
+}
+
+MappedAsset
+MappedAsset::open(std::filesystem::path const& path, AccessHint hint) noexcept {
+    MappedAsset asset {};
+
+    int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    core_assert(fd >= 0, "Failed to open asset file: " + path.string());
+
+    if (fd < 0) {
+        return asset;
+    }
+
+    struct stat file_stat {};
+    bool const stat_ok = ::fstat(fd, &file_stat) == 0;
+    core_assert(stat_ok, "Failed to stat asset file: " + path.string());
+
+    if (!stat_ok) {
+        ::close(fd);
+        return asset;
+    }
+
+    usize const file_size = static_cast<usize>(file_stat.st_size);
+
+    // mmap() rejects zero-length mappings, an empty file is still valid.
+    if (file_size > 0) {
+        void* mapping =
+            ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        core_assert(
+            mapping != MAP_FAILED,
+            "Failed to map asset file: " + path.string()
+        );
+
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            return asset;
+        }
+
+        // Only a hint, the kernel is free to ignore it.
+        ::madvise(mapping, file_size, s_to_madvise(hint));
+
+        asset._mapping = mapping;
+        asset._mapping_size = file_size;
+        asset._data = static_cast<std::byte const*>(mapping);
+        asset._size = file_size;
+    }
+
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    asset._valid = true;
+
+    return asset;
+}
+
+void
+MappedAsset::_release() noexcept {
+    if (_mapping) {
+        ::munmap(_mapping, _mapping_size);
+    }
+
+    _mapping = nullptr;
+    _mapping_size = 0;
+    _owned.clear();
+    _owner.reset();
+    _data = nullptr;
+    _size = 0;
+    _valid = false;
+}
+
+#else
+
+MappedAsset
+MappedAsset::open(std::filesystem::path const& path, AccessHint) noexcept {
+    MappedAsset asset {};
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+    core_assert(file.is_open(), "Failed to open asset file: " + path.string());
+
+    if (!file.is_open()) {
+        return asset;
+    }
+
+    asset._owned.resize(static_cast<usize>(file.tellg()));
+    file.seekg(0);
+    file.read(
+        reinterpret_cast<char*>(asset._owned.data()),
+        static_cast<std::streamsize>(asset._owned.size())
+    );
+
+    asset._data = asset._owned.data();
+    asset._size = asset._owned.size();
+    asset._valid = true;
+
+    return asset;
+}
+
+void
+MappedAsset::_release() noexcept {
+    _owned.clear();
+    _owner.reset();
+    _data = nullptr;
+    _size = 0;
+    _valid = false;
+}
+
+#endif
+
+} // namespace core
@@ -0,0 +1,292 @@
+#include "../include/core/mesh_file.hpp"
+
+#include <fstream>
+
+#include "../include/core/log.hpp"
+
+namespace core {
+
+static constexpr u64 s_section_alignment {16};
+
+static constexpr u64
+s_align_up(u64 value, u64 alignment) noexcept {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// [offset, offset + size) within [0, limit), without overflowing.
+static constexpr bool
+s_in_range(u64 offset, u64 size, u64 limit) noexcept {
+    return offset <= limit && size <= limit - offset;
+}
+
+// Every range the renderer will index with, so a corrupted file is
+// rejected here instead of reading out of bounds on the GPU.
+static bool
+s_ranges_are_valid(
+    u32 vertex_count,
+    std::span<u32 const> indices,
+    std::span<Meshlet const> meshlets,
+    std::span<MeshLod const> lods
+) noexcept {
+    for (u32 const index : indices) {
+        if (index >= vertex_count) {
+            return false;
+        }
+    }
+
+    for (Meshlet const& meshlet : meshlets) {
+        if (!s_in_range(
+                meshlet.first_index,
+                meshlet.index_count,
+                indices.size()
+            )) {
+            return false;
+        }
+    }
+
+    for (MeshLod const& lod : lods) {
+        if (!s_in_range(lod.first_index, lod.index_count, indices.size()) ||
+            !s_in_range(
+                lod.first_meshlet,
+                lod.meshlet_count,
+                meshlets.size()
+            )) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+MeshSourceStamp
+MeshSourceStamp::of(std::filesystem::path const& path) noexcept {
+    std::error_code error {};
+    u64 const size = std::filesystem::file_size(path, error);
+    if (error) {
+        return {};
+    }
+
+    auto const modified = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return {};
+    }
+
+    return {
+        .size = size,
+        .modified_ticks = modified.time_since_epoch().count(),
+    };
+}
+
+MeshFile
+MeshFile::open(std::filesystem::path const& path) noexcept {
+    // Not cooked yet, not an error (MappedAsset would assert).
+    std::error_code error {};
+    if (!std::filesystem::is_regular_file(path, error)) {
+        return {};
+    }
+
+    MeshFile mesh {};
+    mesh._file = MappedAsset::open(path, AccessHint::Sequential);
+
+    if (!mesh._file.is_valid()) {
+        return {};
+    }
+
+    std::span<std::byte const> const bytes = mesh._file.bytes();
+
+    if (bytes.size() < sizeof(MeshFileHeader)) {
+        Log::warn("Mesh file is too small: ", path.string());
+        return {};
+    }
+
+    auto const* header = reinterpret_cast<MeshFileHeader const*>(bytes.data());
+
+    if (header->magic != MeshFileHeader::s_magic) {
+        Log::warn("Not a valid mesh file: ", path.string());
+        return {};
+    }
+
+    // Older versions are rebuilt from the source, quietly.
+    if (header->version != MeshFileHeader::s_version) {
+        return {};
+    }
+
+    u64 const file_size = bytes.size();
+
+    bool const aligned = header->indices_offset % alignof(u32) == 0 &&
+                         header->meshlets_offset % alignof(Meshlet) == 0 &&
+                         header->lods_offset % alignof(MeshLod) == 0;
+
+    if (!s_in_range(
+            header->vertices_offset,
+            u64 {header->vertex_count} * header->vertex_stride,
+            file_size
+        ) ||
+        !s_in_range(
+            header->indices_offset,
+            u64 {header->index_count} * sizeof(u32),
+            file_size
+        ) ||
+        !s_in_range(
+            header->meshlets_offset,
+            u64 {header->meshlet_count} * sizeof(Meshlet),
+            file_size
+        ) ||
+        !s_in_range(
+            header->lods_offset,
+            u64 {header->lod_count} * sizeof(MeshLod),
+            file_size
+        ) ||
+        !aligned || header->lod_count == 0) {
+        Log::warn("Corrupted mesh file: ", path.string());
+        return {};
+    }
+
+    mesh._header = header;
+    mesh._contents = {
+        .source =
+            {
+                .size = header->source_size,
+                .modified_ticks = header->source_modified_ticks,
+            },
+        .vertex_stride = header->vertex_stride,
+        .vertices = bytes.subspan(
+            header->vertices_offset,
+            u64 {header->vertex_count} * header->vertex_stride
+        ),
+        .indices =
+            {
+                reinterpret_cast<u32 const*>(
+                    bytes.data() + header->indices_offset
+                ),
+                header->index_count,
+            },
+        .meshlets =
+            {
+                reinterpret_cast<Meshlet const*>(
+                    bytes.data() + header->meshlets_offset
+                ),
+                header->meshlet_count,
+            },
+        .lods =
+            {
+                reinterpret_cast<MeshLod const*>(
+                    bytes.data() + header->lods_offset
+                ),
+                header->lod_count,
+            },
+        .bounding_sphere = header->bounding_sphere,
+    };
+
+    if (!s_ranges_are_valid(
+            header->vertex_count,
+            mesh._contents.indices,
+            mesh._contents.meshlets,
+            mesh._contents.lods
+        )) {
+        Log::warn("Corrupted mesh file: ", path.string());
+        return {};
+    }
+
+    return mesh;
+}
+
+bool
+MeshFile::write(
+    std::filesystem::path const& path,
+    MeshFileContents const& contents
+) noexcept {
+    core_assert(
+        contents.vertex_stride > 0 &&
+            contents.vertices.size() % contents.vertex_stride == 0,
+        "Vertex bytes must be a whole number of vertices."
+    );
+
+    MeshFileHeader header {
+        .source_size = contents.source.size,
+        .source_modified_ticks = contents.source.modified_ticks,
+        .vertex_stride = contents.vertex_stride,
+        .vertex_count = static_cast<u32>(
+            contents.vertices.size() / contents.vertex_stride
+        ),
+        .index_count = static_cast<u32>(contents.indices.size()),
+        .meshlet_count = static_cast<u32>(contents.meshlets.size()),
+        .lod_count = static_cast<u32>(contents.lods.size()),
+        .bounding_sphere = contents.bounding_sphere,
+    };
+
+    header.vertices_offset =
+        s_align_up(sizeof(MeshFileHeader), s_section_alignment);
+    header.indices_offset = s_align_up(
+        header.vertices_offset + contents.vertices.size_bytes(),
+        s_section_alignment
+    );
+    header.meshlets_offset = s_align_up(
+        header.indices_offset + contents.indices.size_bytes(),
+        s_section_alignment
+    );
+    header.lods_offset = s_align_up(
+        header.meshlets_offset + contents.meshlets.size_bytes(),
+        s_section_alignment
+    );
+
+    // Written next to the source by whoever loads it first, a concurrent
+    // reader must never map a half written file: write aside, then rename.
+    std::filesystem::path temporary_path = path;
+    temporary_path += ".tmp";
+
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        auto write_at = [&file](u64 position, void const* data, usize size) {
+            // Fill alignment padding with zeroes.
+            static constexpr char s_zeroes[s_section_alignment] {};
+            u64 const current = static_cast<u64>(file.tellp());
+            // Sections only ever skip less than one alignment.
+            file.write(
+                s_zeroes,
+                static_cast<std::streamsize>(position - current)
+            );
+            file.write(
+                static_cast<char const*>(data),
+                static_cast<std::streamsize>(size)
+            );
+        };
+
+        write_at(0, &header, sizeof(header));
+        write_at(
+            header.vertices_offset,
+            contents.vertices.data(),
+            contents.vertices.size_bytes()
+        );
+        write_at(
+            header.indices_offset,
+            contents.indices.data(),
+            contents.indices.size_bytes()
+        );
+        write_at(
+            header.meshlets_offset,
+            contents.meshlets.data(),
+            contents.meshlets.size_bytes()
+        );
+        write_at(
+            header.lods_offset,
+            contents.lods.data(),
+            contents.lods.size_bytes()
+        );
+
+        if (!file.good()) {
+            return false;
+        }
+    }
+
+    std::error_code error {};
+    std::filesystem::rename(temporary_path, path, error);
+
+    return !error;
+}
+
+} // namespace core
@@ -0,0 +1,423 @@
+#include "../include/core/mesh_lod.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+#include "../include/core/log.hpp"
+
+namespace core {
+
+// A level barely smaller than the previous one is not worth its memory
+// and selection step.
+static constexpr f32 s_min_lod_reduction {0.85f};
+
+// Sum of squared distances to a set of planes, as p^T A p + 2 b.p + c.
+// Weighted by triangle area, divided by the total weight when evaluated,
+// so that the error is a squared distance whatever the tessellation.
+struct Quadric {
+    f64 a00 {0}, a01 {0}, a02 {0}, a11 {0}, a12 {0}, a22 {0};
+    f64 b0 {0}, b1 {0}, b2 {0};
+    f64 c {0};
+    f64 weight {0};
+
+    Quadric&
+    operator+=(Quadric const& other) noexcept {
+        a00 += other.a00;
+        a01 += other.a01;
+        a02 += other.a02;
+        a11 += other.a11;
+        a12 += other.a12;
+        a22 += other.a22;
+        b0 += other.b0;
+        b1 += other.b1;
+        b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+        return *this;
+    }
+};
+
+static Quadric
+s_plane_quadric(glm::vec3 a, glm::vec3 b, glm::vec3 c) noexcept {
+    glm::vec3 const cross = glm::cross(b - a, c - a);
+    f32 const double_area = glm::length(cross);
+
+    if (double_area == 0.0f) {
+        return {};
+    }
+
+    // Plane nx * x + ny * y + nz * z + d = 0, in double precision.
+    f64 const nx = cross.x / double_area;
+    f64 const ny = cross.y / double_area;
+    f64 const nz = cross.z / double_area;
+    f64 const d = -(nx * a.x + ny * a.y + nz * a.z);
+    f64 const w = 0.5 * double_area;
+
+    return {
+        .a00 = w * nx * nx,
+        .a01 = w * nx * ny,
+        .a02 = w * nx * nz,
+        .a11 = w * ny * ny,
+        .a12 = w * ny * nz,
+        .a22 = w * nz * nz,
+        .b0 = w * nx * d,
+        .b1 = w * ny * d,
+        .b2 = w * nz * d,
+        .c = w * d * d,
+        .weight = w,
+    };
+}
+
+static f64
+s_evaluate(Quadric const& q, glm::vec3 point) noexcept {
+    f64 const x = point.x;
+    f64 const y = point.y;
+    f64 const z = point.z;
+
+    f64 const error = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+        2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+        2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+
+    // Rounding can make a zero error slightly negative.
+    return q.weight > 0.0 ? std::max(error / q.weight, 0.0) : 0.0;
+}
+
+static u64
+s_edge_key(u32 a, u32 b) noexcept {
+    return (u64 {std::min(a, b)} << 32) | std::max(a, b);
+}
+
+// Vertices that must never move: on a border or a non-manifold edge of
+// the mesh welded by position, or sharing their position with another
+// vertex (a seam, moving one side would tear the mesh apart).
+static std::vector<bool>
+s_find_locked_vertices(
+    std::span<glm::vec3 const> positions,
+    std::span<u32 const> indices
+) {
+    usize const vertex_count = positions.size();
+
+    std::vector<u32> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0U);
+    std::sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+        glm::vec3 const& pa = positions[a];
+        glm::vec3 const& pb = positions[b];
+        return pa.x != pb.x ? pa.x < pb.x
+            : pa.y != pb.y  ? pa.y < pb.y
+                            : pa.z < pb.z;
+    });
+
+    std::vector<u32> welded(vertex_count);
+    std::vector<bool> locked(vertex_count, false);
+
+    for (usize i {}; i < vertex_count;) {
+        usize end = i + 1;
+        while (end < vertex_count &&
+               positions[order[end]] == positions[order[i]]) {
+            ++end;
+        }
+
+        for (usize j = i; j < end; ++j) {
+            welded[order[j]] = order[i];
+            locked[order[j]] = end - i > 1;
+        }
+
+        i = end;
+    }
+
+    // Manifold interior edges are shared by exactly two triangles.
+    std::unordered_map<u64, u32> edge_uses {};
+    edge_uses.reserve(indices.size());
+
+    for (usize i {}; i < indices.size(); i += 3) {
+        for (usize corner {}; corner < 3; ++corner) {
+            u32 const a = welded[indices[i + corner]];
+            u32 const b = welded[indices[i + (corner + 1) % 3]];
+            ++edge_uses[s_edge_key(a, b)];
+        }
+    }
+
+    for (usize i {}; i < indices.size(); i += 3) {
+        for (usize corner {}; corner < 3; ++corner) {
+            u32 const a = indices[i + corner];
+            u32 const b = indices[i + (corner + 1) % 3];
+
+            if (edge_uses[s_edge_key(welded[a], welded[b])] != 2) {
+                locked[a] = true;
+                locked[b] = true;
+            }
+        }
+    }
+
+    return locked;
+}
+
+SimplifiedMesh
+simplify_mesh(
+    std::span<glm::vec3 const> positions,
+    std::span<u32 const> indices,
+    usize target_index_count
+) {
+    core_assert(indices.size() % 3 == 0, "Expected a triangle list.");
+
+    usize const vertex_count = positions.size();
+    SimplifiedMesh result {};
+
+    // Degenerate triangles would only get in the way.
+    result.indices.reserve(indices.size());
+    for (usize i {}; i < indices.size(); i += 3) {
+        u32 const a = indices[i + 0];
+        u32 const b = indices[i + 1];
+        u32 const c = indices[i + 2];
+
+        if (a != b && b != c && c != a) {
+            result.indices.insert(result.indices.end(), {a, b, c});
+        }
+    }
+
+    std::vector<bool> const locked =
+        s_find_locked_vertices(positions, result.indices);
+
+    std::vector<Quadric> quadrics(vertex_count);
+    for (usize i {}; i < result.indices.size(); i += 3) {
+        u32 const* triangle = &result.indices[i];
+        Quadric const plane = s_plane_quadric(
+            positions[triangle[0]],
+            positions[triangle[1]],
+            positions[triangle[2]]
+        );
+
+        for (usize corner {}; corner < 3; ++corner) {
+            quadrics[triangle[corner]] += plane;
+        }
+    }
+
+    struct Collapse {
+        u32 from {0};
+        u32 to {0};
+        f64 error {0.0};
+    };
+
+    std::vector<Collapse> collapses {};
+    std::vector<u32> adjacency_offsets(vertex_count + 1);
+    std::vector<u32> adjacency {};
+    std::vector<u32> remap(vertex_count);
+    std::vector<bool> touched(vertex_count);
+    f64 max_error {0.0};
+
+    // Every pass collapses the cheapest independent edges, then rebuilds.
+    while (result.indices.size() > target_index_count) {
+        usize const triangle_count = result.indices.size() / 3;
+
+        // Vertex -> triangles using it.
+        std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0U);
+        for (u32 const index : result.indices) {
+            ++adjacency_offsets[index + 1];
+        }
+
+        for (usize i {}; i < vertex_count; ++i) {
+            adjacency_offsets[i + 1] += adjacency_offsets[i];
+        }
+
+        adjacency.resize(result.indices.size());
+        std::vector<u32> fill(
+            adjacency_offsets.begin(),
+            adjacency_offsets.end() - 1
+        );
+
+        for (usize i {}; i < result.indices.size(); ++i) {
+            adjacency[fill[result.indices[i]]++] = static_cast<u32>(i / 3);
+        }
+
+        // Both directions of every edge, the error is the merged quadric
+        // at the destination.
+        auto const add_collapse = [&](u32 from, u32 to) {
+            if (locked[from]) {
+                return;
+            }
+
+            Quadric merged = quadrics[from];
+            merged += quadrics[to];
+            collapses.push_back({
+                .from = from,
+                .to = to,
+                .error = s_evaluate(merged, positions[to]),
+            });
+        };
+
+        collapses.clear();
+        for (usize i {}; i < result.indices.size(); i += 3) {
+            for (usize corner {}; corner < 3; ++corner) {
+                u32 const a = result.indices[i + corner];
+                u32 const b = result.indices[i + (corner + 1) % 3];
+                add_collapse(a, b);
+                add_collapse(b, a);
+            }
+        }
+
+        std::sort(
+            collapses.begin(),
+            collapses.end(),
+            [](Collapse const& a, Collapse const& b) {
+                return a.error < b.error;
+            }
+        );
+
+        std::iota(remap.begin(), remap.end(), 0U);
+        std::fill(touched.begin(), touched.end(), false);
+        usize remaining_triangles = triangle_count;
+        usize applied {0};
+
+        for (Collapse const& collapse : collapses) {
+            if (remaining_triangles * 3 <= target_index_count) {
+                break;
+            }
+
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            std::span<u32 const> const around {
+                adjacency.data() + adjacency_offsets[collapse.from],
+                adjacency.data() + adjacency_offsets[collapse.from + 1]
+            };
+
+            // Moving the vertex must not flip any remaining triangle.
+            bool flips {false};
+            usize removed {0};
+
+            for (u32 const triangle : around) {
+                u32 const* corners = &result.indices[3 * triangle];
+
+                if (std::find(corners, corners + 3, collapse.to) !=
+                    corners + 3) {
+                    ++removed;
+                    continue;
+                }
+
+                glm::vec3 moved[3] {};
+                for (usize corner {}; corner < 3; ++corner) {
+                    moved[corner] = corners[corner] == collapse.from
+                        ? positions[collapse.to]
+                        : positions[corners[corner]];
+                }
+
+                glm::vec3 const before = glm::cross(
+                    positions[corners[1]] - positions[corners[0]],
+                    positions[corners[2]] - positions[corners[0]]
+                );
+                glm::vec3 const after =
+                    glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+                if (glm::dot(before, after) <= 0.0f) {
+                    flips = true;
+                    break;
+                }
+            }
+
+            if (flips) {
+                continue;
+            }
+
+            // Collapses in the same pass must not share a triangle, or
+            // their flip checks would not hold together.
+            for (u32 const triangle : around) {
+                for (usize corner {}; corner < 3; ++corner) {
+                    touched[result.indices[3 * triangle + corner]] = true;
+                }
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            max_error = std::max(max_error, collapse.error);
+            remaining_triangles -= removed;
+            ++applied;
+        }
+
+        if (applied == 0) {
+            break; // Everything left is locked or would flip.
+        }
+
+        usize kept {0};
+        for (usize i {}; i < result.indices.size(); i += 3) {
+            u32 const a = remap[result.indices[i + 0]];
+            u32 const b = remap[result.indices[i + 1]];
+            u32 const c = remap[result.indices[i + 2]];
+
+            if (a != b && b != c && c != a) {
+                result.indices[kept++] = a;
+                result.indices[kept++] = b;
+                result.indices[kept++] = c;
+            }
+        }
+
+        result.indices.resize(kept);
+    }
+
+    result.error = static_cast<f32>(std::sqrt(max_error));
+
+    return result;
+}
+
+LodMesh
+build_lod_chain(
+    std::span<glm::vec3 const> positions,
+    std::span<u32 const> indices,
+    u32 max_lod_count,
+    MeshletLimits limits
+) {
+    core_assert(max_lod_count >= 1, "The full resolution is a level too.");
+
+    LodMesh result {};
+    std::vector<u32> level_indices(indices.begin(), indices.end());
+    f32 error {0.0f};
+
+    for (u32 level {}; level < max_lod_count; ++level) {
+        if (level > 0) {
+            usize const target = indices.size() / 3 >> level;
+            SimplifiedMesh simplified =
+                simplify_mesh(positions, level_indices, 3 * target);
+
+            if (simplified.indices.empty() ||
+                static_cast<f32>(simplified.indices.size()) >
+                    s_min_lod_reduction *
+                        static_cast<f32>(level_indices.size())) {
+                break;
+            }
+
+            level_indices = std::move(simplified.indices);
+            // Simplified from the previous level, errors add up.
+            error += simplified.error;
+        }
+
+        MeshletMesh const meshlets =
+            build_meshlets(positions, level_indices, limits);
+
+        MeshLod const lod {
+            .first_index = static_cast<u32>(result.indices.size()),
+            .index_count = static_cast<u32>(meshlets.indices.size()),
+            .first_meshlet = static_cast<u32>(result.meshlets.size()),
+            .meshlet_count = static_cast<u32>(meshlets.meshlets.size()),
+            .error = error,
+        };
+
+        result.indices.insert(
+            result.indices.end(),
+            meshlets.indices.begin(),
+            meshlets.indices.end()
+        );
+
+        for (Meshlet meshlet : meshlets.meshlets) {
+            meshlet.first_index += lod.first_index;
+            result.meshlets.push_back(meshlet);
+        }
+
+        result.lods.push_back(lod);
+    }
+
+    return result;
+}
+
+} // namespace core
@@ -0,0 +1,256 @@
+#include "../include/core/meshlet.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "../include/core/log.hpp"
+
+namespace core {
+
+static constexpr u32 s_none {std::numeric_limits<u32>::max()};
+// Cones wider than this (smallest cosine between the axis and a triangle
+// normal) would never cull anything.
+static constexpr f32 s_min_cone_spread {0.1f};
+
+static glm::vec3
+s_triangle_normal(
+    std::span<glm::vec3 const> positions,
+    std::span<u32 const> indices,
+    usize triangle
+) noexcept {
+    glm::vec3 const a = positions[indices[3 * triangle + 0]];
+    glm::vec3 const b = positions[indices[3 * triangle + 1]];
+    glm::vec3 const c = positions[indices[3 * triangle + 2]];
+
+    // Not normalized, zero for degenerate triangles.
+    return glm::cross(b - a, c - a);
+}
+
+static void
+s_compute_bounds(
+    Meshlet& meshlet,
+    std::span<glm::vec3 const> positions,
+    std::span<u32 const> meshlet_indices,
+    std::span<u32 const> meshlet_vertices
+) noexcept {
+    // Same sphere as the whole model: around the bounding box center.
+    glm::vec3 min_corner {std::numeric_limits<f32>::max()};
+    glm::vec3 max_corner {std::numeric_limits<f32>::lowest()};
+
+    for (u32 const vertex : meshlet_vertices) {
+        min_corner = glm::min(min_corner, positions[vertex]);
+        max_corner = glm::max(max_corner, positions[vertex]);
+    }
+
+    glm::vec3 const center = (min_corner + max_corner) * 0.5f;
+    f32 radius {0.0f};
+
+    for (u32 const vertex : meshlet_vertices) {
+        radius = std::max(radius, glm::distance(center, positions[vertex]));
+    }
+
+    meshlet.bounding_sphere = glm::vec4(center, radius);
+
+    // Cone around the average normal, as wide as the farthest normal.
+    usize const triangle_count = meshlet_indices.size() / 3;
+    glm::vec3 normal_sum {0.0f};
+
+    for (usize i {}; i < triangle_count; ++i) {
+        glm::vec3 const normal =
+            s_triangle_normal(positions, meshlet_indices, i);
+        f32 const length = glm::length(normal);
+
+        if (length > 0.0f) {
+            normal_sum += normal / length;
+        }
+    }
+
+    f32 const sum_length = glm::length(normal_sum);
+    if (sum_length == 0.0f) {
+        return; // Degenerate or closed, keep the default cone.
+    }
+
+    glm::vec3 const axis = normal_sum / sum_length;
+    f32 min_dot {1.0f};
+
+    for (usize i {}; i < triangle_count; ++i) {
+        glm::vec3 const normal =
+            s_triangle_normal(positions, meshlet_indices, i);
+        f32 const length = glm::length(normal);
+
+        if (length > 0.0f) {
+            min_dot = std::min(min_dot, glm::dot(axis, normal / length));
+        }
+    }
+
+    if (min_dot < s_min_cone_spread) {
+        return;
+    }
+
+    // Sine of the half angle: the test is against the sphere center,
+    // not the cone apex, see Meshlet::cone.
+    meshlet.cone = glm::vec4(axis, std::sqrt(1.0f - min_dot * min_dot));
+}
+
+MeshletMesh
+build_meshlets(
+    std::span<glm::vec3 const> positions,
+    std::span<u32 const> indices,
+    MeshletLimits limits
+) {
+    core_assert(indices.size() % 3 == 0, "Expected a triangle list.");
+    core_assert(
+        limits.max_vertices >= 3 && limits.max_triangles >= 1,
+        "Meshlet limits are too small for a triangle."
+    );
+
+    usize const triangle_count = indices.size() / 3;
+    usize const vertex_count = positions.size();
+
+    // Vertex -> triangles using it.
+    std::vector<u32> adjacency_offsets(vertex_count + 1, 0);
+    for (u32 const index : indices) {
+        ++adjacency_offsets[index + 1];
+    }
+
+    for (usize i {}; i < vertex_count; ++i) {
+        adjacency_offsets[i + 1] += adjacency_offsets[i];
+    }
+
+    std::vector<u32> adjacency(indices.size());
+    std::vector<u32> adjacency_fill(
+        adjacency_offsets.begin(),
+        adjacency_offsets.end() - 1
+    );
+
+    for (usize triangle {}; triangle < triangle_count; ++triangle) {
+        for (usize corner {}; corner < 3; ++corner) {
+            u32 const vertex = indices[3 * triangle + corner];
+            adjacency[adjacency_fill[vertex]++] = static_cast<u32>(triangle);
+        }
+    }
+
+    std::vector<bool> emitted(triangle_count, false);
+    // Whether each vertex is part of the meshlet being built.
+    std::vector<bool> in_meshlet(vertex_count, false);
+    std::vector<u32> meshlet_vertices {};
+    std::vector<u32> meshlet_triangles {};
+    meshlet_vertices.reserve(limits.max_vertices);
+    meshlet_triangles.reserve(limits.max_triangles);
+
+    MeshletMesh result {};
+    result.indices.reserve(indices.size());
+
+    auto const new_vertex_count = [&](usize triangle) {
+        u32 count {0};
+        for (usize corner {}; corner < 3; ++corner) {
+            count += in_meshlet[indices[3 * triangle + corner]] ? 0 : 1;
+        }
+        return count;
+    };
+
+    auto const add_triangle = [&](usize triangle) {
+        emitted[triangle] = true;
+        meshlet_triangles.push_back(static_cast<u32>(triangle));
+
+        for (usize corner {}; corner < 3; ++corner) {
+            u32 const vertex = indices[3 * triangle + corner];
+
+            if (!in_meshlet[vertex]) {
+                in_meshlet[vertex] = true;
+                meshlet_vertices.push_back(vertex);
+            }
+        }
+    };
+
+    auto const finish_meshlet = [&]() {
+        if (meshlet_triangles.empty()) {
+            return;
+        }
+
+        usize const first_index = result.indices.size();
+
+        for (u32 const triangle : meshlet_triangles) {
+            for (usize corner {}; corner < 3; ++corner) {
+                result.indices.push_back(indices[3 * triangle + corner]);
+            }
+        }
+
+        Meshlet meshlet {
+            .first_index = static_cast<u32>(first_index),
+            .index_count = static_cast<u32>(3 * meshlet_triangles.size()),
+            .vertex_count = static_cast<u32>(meshlet_vertices.size()),
+        };
+
+        s_compute_bounds(
+            meshlet,
+            positions,
+            std::span {result.indices}.subspan(first_index),
+            meshlet_vertices
+        );
+
+        result.meshlets.push_back(meshlet);
+
+        for (u32 const vertex : meshlet_vertices) {
+            in_meshlet[vertex] = false;
+        }
+
+        meshlet_vertices.clear();
+        meshlet_triangles.clear();
+    };
+
+    usize scan_cursor {0};
+
+    for (usize added {}; added < triangle_count; ++added) {
+        // Neighbor adding the fewest vertices, keeps meshlets compact
+        // (tighter spheres and cones).
+        u32 best_triangle {s_none};
+        u32 best_new_vertices {4};
+
+        for (u32 const vertex : meshlet_vertices) {
+            for (u32 i = adjacency_offsets[vertex];
+                 i < adjacency_offsets[vertex + 1] && best_new_vertices > 0;
+                 ++i) {
+                u32 const triangle = adjacency[i];
+
+                if (emitted[triangle]) {
+                    continue;
+                }
+
+                u32 const new_vertices = new_vertex_count(triangle);
+                if (new_vertices < best_new_vertices) {
+                    best_triangle = triangle;
+                    best_new_vertices = new_vertices;
+                }
+            }
+        }
+
+        // No neighbor left, continue where the mesh order left off.
+        if (best_triangle == s_none) {
+            while (emitted[scan_cursor]) {
+                ++scan_cursor;
+            }
+
+            best_triangle = static_cast<u32>(scan_cursor);
+            best_new_vertices = new_vertex_count(scan_cursor);
+        }
+
+        bool const full =
+            meshlet_vertices.size() + best_new_vertices >
+                limits.max_vertices ||
+            meshlet_triangles.size() + 1 > limits.max_triangles;
+
+        if (full) {
+            finish_meshlet();
+        }
+
+        add_triangle(best_triangle);
+    }
+
+    finish_meshlet();
+
+    return result;
+}
+
+} // namespace core
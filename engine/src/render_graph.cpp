@@ -0,0 +1,494 @@
+#include "../include/core/render_graph.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "../include/core/log.hpp"
+
+namespace core {
+
+static constexpr u32 s_unused {std::numeric_limits<u32>::max()};
+
+// Where a resource stands between two passes.
+struct ResourceState {
+    // Usages of the last write (or layout transition).
+    RenderGraphUsageMask writer {0};
+    // Of those, the writes not flushed yet.
+    RenderGraphUsageMask dirty {0};
+    // Usages the last write was made visible to.
+    RenderGraphUsageMask visible {0};
+    // Usages that read it since the last write.
+    RenderGraphUsageMask readers {0};
+    RenderGraphLayout layout {RenderGraphLayout::Undefined};
+};
+
+static constexpr u64
+s_align_up(u64 value, u64 alignment) noexcept {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Updates the state for one use, and returns the barrier it needs if any.
+static std::optional<RenderGraphBarrier>
+s_use(
+    ResourceState& state,
+    RenderGraphResource resource,
+    bool image,
+    RenderGraphUsageMask reads,
+    RenderGraphUsageMask writes,
+    RenderGraphLayout layout
+) noexcept {
+    if (!image) {
+        layout = RenderGraphLayout::Undefined;
+    }
+
+    RenderGraphBarrier barrier {
+        .resource = resource,
+        .dst_reads = reads,
+        .dst_writes = writes,
+        .old_layout = state.layout,
+        .new_layout = layout,
+    };
+
+    bool const transition = layout != state.layout;
+
+    // Read after read needs nothing, read after write a barrier per usage,
+    // the first one also flushes the write.
+    if (writes == 0 && !transition) {
+        RenderGraphUsageMask const unseen = reads & ~state.visible;
+        state.readers |= reads;
+
+        if (unseen == 0 || state.writer == 0) {
+            return std::nullopt;
+        }
+
+        barrier.src_usages = state.writer;
+        barrier.src_writes = state.dirty;
+        barrier.dst_reads = unseen;
+        state.dirty = 0;
+        state.visible |= unseen;
+
+        return barrier;
+    }
+
+    // Overwriting (or transitioning) waits for the reads since the last
+    // write, those already waited for the write itself.
+    barrier.src_usages = state.readers != 0 ? state.readers : state.writer;
+    barrier.src_writes = state.dirty;
+    state.layout = layout;
+
+    if (writes != 0) {
+        state.writer = writes;
+        state.dirty = writes;
+        state.visible = 0;
+        state.readers = 0;
+    } else {
+        // The transition is the last write, visible to the readers.
+        state.writer = reads;
+        state.dirty = 0;
+        state.visible = reads;
+        state.readers = reads;
+    }
+
+    if (barrier.src_usages == 0 && !transition) {
+        return std::nullopt;
+    }
+
+    return barrier;
+}
+
+RenderGraphLayout
+to_layout(RenderGraphUsage usage, bool write) noexcept {
+    switch (usage) {
+        case RenderGraphUsage::ColorAttachment:
+            return RenderGraphLayout::ColorAttachment;
+        case RenderGraphUsage::DepthAttachment:
+            return write ? RenderGraphLayout::DepthAttachment
+                         : RenderGraphLayout::DepthReadOnly;
+        case RenderGraphUsage::ComputeSampled:
+            return RenderGraphLayout::ShaderReadOnly;
+        case RenderGraphUsage::Transfer:
+            return write ? RenderGraphLayout::TransferDestination
+                         : RenderGraphLayout::TransferSource;
+        case RenderGraphUsage::Present: return RenderGraphLayout::Present;
+        default: return RenderGraphLayout::General;
+    }
+}
+
+// The one layout every usage of an image in a pass shares.
+static RenderGraphLayout
+s_pass_layout(
+    RenderGraphUsageMask reads,
+    RenderGraphUsageMask writes
+) noexcept {
+    RenderGraphLayout layout {RenderGraphLayout::Undefined};
+    bool first {true};
+
+    for (u32 bit {}; bit < 32; ++bit) {
+        if (((reads | writes) & (1U << bit)) == 0) {
+            continue;
+        }
+
+        RenderGraphLayout const usage_layout = to_layout(
+            static_cast<RenderGraphUsage>(bit),
+            (writes & (1U << bit)) != 0
+        );
+
+        core_assert(
+            first || usage_layout == layout,
+            "An image has one layout per pass."
+        );
+        layout = usage_layout;
+        first = false;
+    }
+
+    return layout;
+}
+
+RenderGraphResource
+RenderGraph::import_buffer(std::string_view name, RenderGraphImport state) {
+    return _add_resource({
+        .name = std::string {name},
+        .image = false,
+        .import = state,
+    });
+}
+
+RenderGraphResource
+RenderGraph::import_image(std::string_view name, RenderGraphImport state) {
+    return _add_resource({
+        .name = std::string {name},
+        .image = true,
+        .import = state,
+    });
+}
+
+RenderGraphResource
+RenderGraph::create_buffer(std::string_view name, RenderGraphMemory memory) {
+    return _add_resource({
+        .name = std::string {name},
+        .image = false,
+        .transient = true,
+        .memory = memory,
+    });
+}
+
+RenderGraphResource
+RenderGraph::create_image(std::string_view name, RenderGraphMemory memory) {
+    return _add_resource({
+        .name = std::string {name},
+        .image = true,
+        .transient = true,
+        .memory = memory,
+    });
+}
+
+void
+RenderGraph::export_resource(
+    RenderGraphResource resource,
+    std::optional<RenderGraphUsage> final_usage
+) {
+    core_assert(resource < _resources.size(), "Unknown resource.");
+
+    _resources[resource].exported = true;
+    _resources[resource].final_usage = final_usage;
+}
+
+RenderGraphPass
+RenderGraph::add_pass(std::string_view name, std::function<void()> record) {
+    _passes.push_back({
+        .name = std::string {name},
+        .record = std::move(record),
+    });
+
+    return static_cast<RenderGraphPass>(_passes.size() - 1);
+}
+
+void
+RenderGraph::read(
+    RenderGraphPass pass,
+    RenderGraphResource resource,
+    RenderGraphUsage usage
+) {
+    _access(pass, resource).reads |= to_mask(usage);
+}
+
+void
+RenderGraph::write(
+    RenderGraphPass pass,
+    RenderGraphResource resource,
+    RenderGraphUsage usage
+) {
+    _access(pass, resource).writes |= to_mask(usage);
+}
+
+CompiledRenderGraph
+RenderGraph::compile() const {
+    usize const resource_count = _resources.size();
+    CompiledRenderGraph compiled {};
+
+    // Culling, from the last pass: one is kept if it writes contents a
+    // kept pass reads later (or that are exported).
+    std::vector<bool> contents_needed(resource_count);
+    std::vector<bool> kept(_passes.size(), false);
+
+    for (usize i {}; i < resource_count; ++i) {
+        contents_needed[i] = _resources[i].exported;
+    }
+
+    for (usize i = _passes.size(); i-- > 0;) {
+        std::vector<Access> const& accesses = _passes[i].accesses;
+
+        kept[i] = std::ranges::any_of(accesses, [&](Access const& access) {
+            return access.writes != 0 && contents_needed[access.resource];
+        });
+
+        if (!kept[i]) {
+            continue;
+        }
+
+        // Overwritten here, unless also read here.
+        for (Access const& access : accesses) {
+            if (access.writes != 0) {
+                contents_needed[access.resource] = false;
+            }
+        }
+
+        for (Access const& access : accesses) {
+            if (access.reads != 0) {
+                contents_needed[access.resource] = true;
+            }
+        }
+    }
+
+    for (usize i {}; i < _passes.size(); ++i) {
+        if (kept[i]) {
+            compiled.steps.push_back({.pass = static_cast<RenderGraphPass>(i)});
+        }
+    }
+
+    // Lifetimes, in steps.
+    std::vector<u32> first_step(resource_count, s_unused);
+    std::vector<u32> last_step(resource_count, s_unused);
+
+    for (u32 step {}; step < compiled.steps.size(); ++step) {
+        for (Access const& access :
+             _passes[compiled.steps[step].pass].accesses) {
+            first_step[access.resource] =
+                std::min(first_step[access.resource], step);
+            last_step[access.resource] = step;
+        }
+    }
+
+    // Aliasing: largest first, each at the lowest offset free for its
+    // whole lifetime.
+    compiled.memory_offsets.assign(
+        resource_count,
+        CompiledRenderGraph::s_no_memory
+    );
+
+    std::vector<RenderGraphResource> transients {};
+
+    for (RenderGraphResource i {}; i < resource_count; ++i) {
+        if (_resources[i].transient && first_step[i] != s_unused) {
+            transients.push_back(i);
+        }
+    }
+
+    std::ranges::stable_sort(transients, [&](auto a, auto b) {
+        return _resources[a].memory.size > _resources[b].memory.size;
+    });
+
+    auto const lifetimes_overlap = [&](auto a, auto b) {
+        return first_step[a] <= last_step[b] && first_step[b] <= last_step[a];
+    };
+
+    auto const memory_overlaps = [&](auto a, auto b) {
+        u64 const a_offset = compiled.memory_offsets[a];
+        u64 const b_offset = compiled.memory_offsets[b];
+
+        return a_offset < b_offset + _resources[b].memory.size &&
+            b_offset < a_offset + _resources[a].memory.size;
+    };
+
+    std::vector<std::pair<u64, u64>> taken {};
+
+    for (usize i {}; i < transients.size(); ++i) {
+        RenderGraphResource const resource = transients[i];
+        RenderGraphMemory const memory = _resources[resource].memory;
+        u64 const alignment = std::max<u64>(memory.alignment, 1);
+
+        taken.clear();
+
+        for (usize j {}; j < i; ++j) {
+            RenderGraphResource const other = transients[j];
+
+            if (lifetimes_overlap(resource, other)) {
+                u64 const offset = compiled.memory_offsets[other];
+                taken.emplace_back(
+                    offset,
+                    offset + _resources[other].memory.size
+                );
+            }
+        }
+
+        std::ranges::sort(taken);
+
+        // First gap large enough.
+        u64 offset {0};
+
+        for (auto const& [begin, end] : taken) {
+            offset = s_align_up(offset, alignment);
+
+            if (offset + memory.size <= begin) {
+                break;
+            }
+
+            offset = std::max(offset, end);
+        }
+
+        offset = s_align_up(offset, alignment);
+        compiled.memory_offsets[resource] = offset;
+        compiled.memory_size =
+            std::max(compiled.memory_size, offset + memory.size);
+    }
+
+    // Barriers, in order. Transient memory is reused by the next execution
+    // of the graph (the next frame), whose first uses also wait for what
+    // overlaps them at the end of this one: a first run finds it.
+    std::vector<ResourceState> states(resource_count);
+    std::vector<ResourceState> end_states(resource_count);
+
+    for (bool const record : {false, true}) {
+        for (usize i {}; i < resource_count; ++i) {
+            RenderGraphImport const& import = _resources[i].import;
+
+            states[i] = {
+                .writer = import.written ? import.usages : 0,
+                .dirty = import.written ? import.usages : 0,
+                .readers = import.written ? 0 : import.usages,
+                .layout = import.layout,
+            };
+        }
+
+        for (u32 step {}; step < compiled.steps.size(); ++step) {
+            RenderGraphStep& current = compiled.steps[step];
+
+            for (Access const& access : _passes[current.pass].accesses) {
+                RenderGraphResource const resource = access.resource;
+                ResourceState& state = states[resource];
+
+                // Aliased memory: the first use waits for the last users of
+                // what lived there before, earlier in this execution or at
+                // the end of the previous one. The contents are discarded.
+                if (_resources[resource].transient &&
+                    first_step[resource] == step) {
+                    for (RenderGraphResource const other : transients) {
+                        if (!memory_overlaps(resource, other)) {
+                            continue;
+                        }
+
+                        ResourceState const& previous = last_step[other] < step
+                            ? states[other]
+                            : end_states[other];
+                        state.writer |= previous.readers != 0
+                            ? previous.readers
+                            : previous.writer;
+                        state.dirty |= previous.dirty;
+                    }
+                }
+
+                RenderGraphLayout layout {RenderGraphLayout::Undefined};
+
+                if (_resources[resource].image) {
+                    layout = s_pass_layout(access.reads, access.writes);
+                }
+
+                std::optional<RenderGraphBarrier> const barrier = s_use(
+                    state,
+                    resource,
+                    _resources[resource].image,
+                    access.reads,
+                    access.writes,
+                    layout
+                );
+
+                if (barrier && record) {
+                    current.barriers.push_back(*barrier);
+                }
+            }
+        }
+
+        end_states = states;
+    }
+
+    for (RenderGraphResource i {}; i < resource_count; ++i) {
+        std::optional<RenderGraphUsage> const final_usage =
+            _resources[i].final_usage;
+
+        if (!final_usage) {
+            continue;
+        }
+
+        std::optional<RenderGraphBarrier> const barrier = s_use(
+            states[i],
+            i,
+            _resources[i].image,
+            to_mask(*final_usage),
+            0,
+            to_layout(*final_usage, false)
+        );
+
+        if (barrier) {
+            compiled.final_barriers.push_back(*barrier);
+        }
+    }
+
+    return compiled;
+}
+
+void
+RenderGraph::execute(
+    CompiledRenderGraph const& compiled,
+    std::function<void(std::span<RenderGraphBarrier const>)> const&
+        record_barriers
+) const {
+    for (RenderGraphStep const& step : compiled.steps) {
+        if (!step.barriers.empty()) {
+            record_barriers(step.barriers);
+        }
+
+        if (_passes[step.pass].record) {
+            _passes[step.pass].record();
+        }
+    }
+
+    if (!compiled.final_barriers.empty()) {
+        record_barriers(compiled.final_barriers);
+    }
+}
+
+RenderGraphResource
+RenderGraph::_add_resource(Resource resource) {
+    _resources.push_back(std::move(resource));
+    return static_cast<RenderGraphResource>(_resources.size() - 1);
+}
+
+RenderGraph::Access&
+RenderGraph::_access(RenderGraphPass pass, RenderGraphResource resource) {
+    core_assert(pass < _passes.size(), "Unknown pass.");
+    core_assert(resource < _resources.size(), "Unknown resource.");
+
+    std::vector<Access>& accesses = _passes[pass].accesses;
+
+    auto const found =
+        std::ranges::find(accesses, resource, &Access::resource);
+
+    if (found != accesses.end()) {
+        return *found;
+    }
+
+    return accesses.emplace_back(Access {.resource = resource});
+}
+
+} // namespace core
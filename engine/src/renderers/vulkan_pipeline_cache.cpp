@@ -0,0 +1,154 @@
+// Vulkan configuration first, see vulkan_renderer.hpp.
+#include <core/renderers/vulkan_renderer.hpp>
+
+#include <core/renderers/vulkan_pipeline_cache.hpp>
+
+#include <chrono>
+
+namespace core {
+
+VulkanPipelineCache::~VulkanPipelineCache() {
+    stop();
+}
+
+void
+VulkanPipelineCache::start(Builder builder, u32 worker_count) noexcept {
+    core_assert(_workers.empty(), "Pipeline cache already started.");
+    core_assert(worker_count > 0, "Pipelines need at least one worker.");
+
+    _builder = std::move(builder);
+    _workers.reserve(worker_count);
+
+    for (u32 i {}; i < worker_count; ++i) {
+        _workers.emplace_back([this] { _work(); });
+    }
+}
+
+void
+VulkanPipelineCache::stop() noexcept {
+    {
+        std::scoped_lock const lock {_mutex};
+        _stopping = true;
+
+        // Never compiled, the next find() queues them again.
+        for (PipelineKey const& key : _queue) {
+            _entries.erase(key);
+        }
+
+        _queue.clear();
+    }
+
+    _work_available.notify_all();
+
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+
+    _workers.clear();
+    _stopping = false;
+}
+
+vk::Pipeline
+VulkanPipelineCache::find(PipelineKey const& key) noexcept {
+    std::scoped_lock const lock {_mutex};
+    auto const [entry, inserted] = _entries.try_emplace(key);
+
+    if (inserted) {
+        entry->second.pending = true;
+        _queue.push_back(key);
+        _work_available.notify_one();
+    }
+
+    return *entry->second.pipeline;
+}
+
+vk::Pipeline
+VulkanPipelineCache::find_now(PipelineKey const& key) noexcept {
+    {
+        std::scoped_lock const lock {_mutex};
+        auto const found = _entries.find(key);
+
+        if (found != _entries.end() && found->second.pipeline) {
+            return *found->second.pipeline;
+        }
+    }
+
+    // Possibly compiled twice if a worker has it, the first one is kept
+    // (the other one was never handed out).
+    vk::UniquePipeline pipeline = _build(key);
+
+    std::scoped_lock const lock {_mutex};
+    Entry& entry = _entries[key];
+
+    if (!entry.pipeline) {
+        entry.pipeline = std::move(pipeline);
+    }
+
+    return *entry.pipeline;
+}
+
+vk::UniquePipeline
+VulkanPipelineCache::take(PipelineKey const& key) noexcept {
+    std::scoped_lock const lock {_mutex};
+    auto const found = _entries.find(key);
+
+    // A worker still owns pending ones.
+    if (found == _entries.end() || found->second.pending) {
+        return vk::UniquePipeline {nullptr};
+    }
+
+    vk::UniquePipeline pipeline = std::move(found->second.pipeline);
+    _entries.erase(found);
+
+    return pipeline;
+}
+
+void
+VulkanPipelineCache::_work() noexcept {
+    std::unique_lock lock {_mutex};
+
+    while (true) {
+        _work_available.wait(lock, [this] {
+            return _stopping || !_queue.empty();
+        });
+
+        if (_stopping) {
+            return;
+        }
+
+        PipelineKey const key = _queue.front();
+        _queue.pop_front();
+
+        lock.unlock();
+        vk::UniquePipeline pipeline = _build(key);
+        lock.lock();
+
+        Entry& entry = _entries[key];
+        entry.pending = false;
+
+        // find_now() may have been faster.
+        if (!entry.pipeline) {
+            entry.pipeline = std::move(pipeline);
+        }
+    }
+}
+
+vk::UniquePipeline
+VulkanPipelineCache::_build(PipelineKey const& key) const noexcept {
+    auto const start_time = std::chrono::steady_clock::now();
+    vk::UniquePipeline pipeline = _builder(key);
+
+    if (!pipeline) {
+        Log::warn("Failed to create pipeline, keeping the fallback.");
+        return pipeline;
+    }
+
+    std::chrono::duration<f64, std::milli> const elapsed =
+        std::chrono::steady_clock::now() - start_time;
+
+    Log::info("Pipeline created in ", elapsed.count(), " ms.");
+
+    return pipeline;
+}
+
+} // namespace core
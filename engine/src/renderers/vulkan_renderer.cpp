@@ -7,6 +7,7 @@
 
 #include <algorithm> // clamp.
 #include <array>
+#include <bit> // bit_width.
 #include <chrono>
 #include <cstring> // strcmp.
 #include <filesystem>
@@ -20,6 +21,34 @@
 namespace core {
 
 static constexpr vk::Result s_success {vk::Result::eSuccess};
+// Set 0 bindings only written with occlusion culling.
+static constexpr std::array s_partially_bound_scene_bindings {
+    s_visibility_binding,
+    s_depth_pyramid_binding,
+};
+// Per frame slot: the scene block, the ring's only block, at the largest
+// offset alignment (256 bytes). Grows with the blocks pushed each frame.
+static constexpr vk::DeviceSize s_uniform_ring_size {
+    (sizeof(UniformBufferObject) + 255) & ~vk::DeviceSize {255}
+};
+// Must match local_size_x in sh_cull.comp.
+static constexpr u32 s_cull_group_size {64};
+// Closer than this, LODs are selected as from this far (the camera can
+// be inside a bounding sphere). Must match MIN_LOD_DISTANCE in sh_cull.comp.
+static constexpr f32 s_min_lod_distance {1e-3f};
+static constexpr std::string_view s_cull_shader_path {"shaders/sh_cull.comp"};
+static constexpr std::string_view s_cluster_cull_shader_path {
+    "shaders/sh_cluster_cull.comp"
+};
+// Must match local_size_x and local_size_y in sh_depth_pyramid.comp.
+static constexpr u32 s_depth_pyramid_group_size {8};
+static constexpr std::string_view s_depth_pyramid_shader_path {
+    "shaders/sh_depth_pyramid.comp"
+};
+// Compiled shader variants, by id (see ShaderVariantCache).
+static constexpr std::string_view s_shader_variants_directory {
+    "shaders/.variants"
+};
 static constexpr std::array s_physical_device_extensions {
     vk::KHRSwapchainExtensionName
 };
@@ -60,28 +89,94 @@ s_frame_buffer_resize_callback(
 
 #pragma region PUBLIC_GFX_API
 
+static u32
+_frames_in_flight_for(LatencyMode mode) noexcept {
+    switch (mode) {
+        case LatencyMode::LowLatency: return 1;
+        case LatencyMode::Throughput: return 3;
+        default: return 2;
+    }
+}
+
 void
 VulkanRenderer::init(
     GLFWwindow* window,
-    RenderInfo const& test_render_info
+    RenderInfo const& test_render_info,
+    RendererSettings const& settings
 ) noexcept {
-    _default_vertex_shader_spirv = _compile_shader_to_spirv(
-        test_render_info.vertex_source,
+    _settings = settings;
+
+    if (_settings.headless && _settings.frame_count == 0) {
+        Log::warn("Headless rendering needs a frame count, rendering 1.");
+        _settings.frame_count = 1;
+    }
+
+    _frames_in_flight = _frames_in_flight_for(_settings.latency_mode);
+    _frame_slot_values.assign(_frames_in_flight, 0);
+    _material_buffer_versions.assign(_frames_in_flight, 0);
+    _frame_input_times.assign(_frames_in_flight, {});
+
+    Log::info(
+        "Latency mode: ",
+        to_string(_settings.latency_mode),
+        " (",
+        _frames_in_flight,
+        " frames in flight)."
+    );
+
+    // The calling thread runs loops too.
+    _jobs.start(std::max(std::thread::hardware_concurrency(), 2U) - 1);
+
+    // Every core compiles variants, pipeline workers wait for theirs.
+    _shader_variants.start(
+        std::max(std::thread::hardware_concurrency(), 1U),
+        AssetDatabase::root() / s_shader_variants_directory
+    );
+
+    _vertex_shader_source = _shader_variants.add_source(
         test_render_info.vertex_file_path,
+        test_render_info.vertex_source,
         shaderc_shader_kind::shaderc_vertex_shader
     );
 
-    _default_fragment_shader_spirv = _compile_shader_to_spirv(
-        test_render_info.fragment_source,
+    _fragment_shader_source = _shader_variants.add_source(
         test_render_info.fragment_file_path,
+        test_render_info.fragment_source,
         shaderc_shader_kind::shaderc_fragment_shader
     );
 
+    // Compiled while the device is created, set 0 is reflected from them
+    // (with or without GPU culling).
+    _cull_shader = _compute_shader_variant(s_cull_shader_path);
+    _cluster_cull_shader = _compute_shader_variant(s_cluster_cull_shader_path);
+
     _default_texture_path = test_render_info.texture_file_path;
     _model_file_path = test_render_info.model_file_path;
 
-    glfwSetWindowUserPointer(window, this);
-    glfwSetFramebufferSizeCallback(window, s_frame_buffer_resize_callback);
+    if constexpr (s_enable_hot_reload) {
+        auto const to_relative = [](std::string const& path) {
+            return std::filesystem::path(path)
+                .lexically_relative(AssetDatabase::root())
+                .generic_string();
+        };
+
+        _vertex_shader_path = to_relative(test_render_info.vertex_file_path);
+        _fragment_shader_path =
+            to_relative(test_render_info.fragment_file_path);
+        _vertex_shader_id = AssetId {_vertex_shader_path};
+        _fragment_shader_id = AssetId {_fragment_shader_path};
+        _texture_id = AssetId {to_relative(_default_texture_path)};
+        _model_id = AssetId {to_relative(_model_file_path)};
+        _cull_shader_id = AssetId {s_cull_shader_path};
+        _cluster_cull_shader_id = AssetId {s_cluster_cull_shader_path};
+
+        _asset_watcher.start(AssetDatabase::root());
+    }
+
+    if (window) {
+        glfwSetWindowUserPointer(window, this);
+        glfwSetFramebufferSizeCallback(window, s_frame_buffer_resize_callback);
+    }
 
     _window = window;
     Log::header("Initializing Vulkan Renderer.");
@@ -90,7 +185,9 @@ VulkanRenderer::init(
 
 void
 VulkanRenderer::cleanup() noexcept {
-    glfwDestroyWindow(_window);
+    if (_window) {
+        glfwDestroyWindow(_window);
+    }
     glfwTerminate();
     Log::info("Vulkan cleanup completed.");
 }
@@ -98,11 +195,72 @@ VulkanRenderer::cleanup() noexcept {
 void
 VulkanRenderer::render() noexcept {
     Log::header("Starting render loop.");
-    while (!glfwWindowShouldClose(_window)) {
-        glfwPollEvents();
+
+    auto const start_time = std::chrono::steady_clock::now();
+    u32 const frame_count = _settings.frame_count;
+
+    while (frame_count == 0 || _frame_number < frame_count) {
+        if (!_settings.headless) {
+            if (glfwWindowShouldClose(_window)) {
+                break;
+            }
+
+            // Low latency: block on the GPU *before* sampling input instead
+            // of after, the frame is then recorded with the freshest input.
+            if (_settings.latency_mode == LatencyMode::LowLatency) {
+                _wait_for_frame();
+            }
+
+            glfwPollEvents();
+            _input_sample_time = Clock::now();
+        }
+
+        if constexpr (s_enable_hot_reload) {
+            _process_asset_changes();
+        }
+
         _draw_frame();
     }
+
+    // Frames may still be in flight, the device must be idle before the
+    // readback and before any resource is destroyed.
+    vk_expect(_device->waitIdle(), "Failed to wait idle");
+
+    std::chrono::duration<f64> const elapsed =
+        std::chrono::steady_clock::now() - start_time;
+    f64 const seconds = elapsed.count();
+
     Log::info("Render loop terminated.");
+    Log::sub_info(
+        "Frames: ",
+        _frame_number,
+        ", ",
+        seconds * 1'000.0 / static_cast<f64>(std::max<u64>(_frame_number, 1)),
+        " ms/frame, ",
+        static_cast<f64>(_frame_number) / seconds,
+        " fps."
+    );
+
+    if (!_settings.headless) {
+        Log::sub_info(
+            "Input -> present: ",
+            _present_latency.average_ms(),
+            " ms avg, ",
+            _present_latency.max_ms,
+            " ms max."
+        );
+        Log::sub_info(
+            "Input -> GPU done: <= ",
+            _completion_latency.average_ms(),
+            " ms avg, ",
+            _completion_latency.max_ms,
+            " ms max."
+        );
+    }
+
+    if (_settings.headless && !_settings.capture_path.empty()) {
+        _write_capture();
+    }
 }
 
 #pragma endregion PUBLIC_GFX_API
@@ -160,6 +318,7 @@ VulkanRenderer::_create_vk_instance() noexcept {
     // Zero out patch number. (see VK_API_VERSION_PATCH definition).
     // This is done to ensure maximum compatibility / stability.
     version &= ~(0xFFFU); // Lower twelve bytes.
+    _api_version = version;
 
     vk::ApplicationInfo const app_info {
         .pApplicationName = "App",
@@ -169,10 +328,12 @@ VulkanRenderer::_create_vk_instance() noexcept {
         .apiVersion = version,
     };
 
-    // GLFW Extensions.
+    // GLFW Extensions (surface support), none when rendering headless.
     u32 glfw_extension_count {0};
     char const** glfw_extensions {
-        glfwGetRequiredInstanceExtensions(&glfw_extension_count)
+        _settings.headless
+            ? nullptr
+            : glfwGetRequiredInstanceExtensions(&glfw_extension_count)
     };
 
     Log::info("GLFW Required extensions:");
@@ -267,6 +428,13 @@ _find_queue_families(
             indices.graphics_family = i;
         }
 
+        // Headless: nothing is presented, the graphics queue is enough.
+        if (!surface) {
+            indices.present_family = indices.graphics_family;
+            ++i;
+            continue;
+        }
+
         auto const& [result, supported] = device.getSurfaceSupportKHR(
             indices.graphics_family.value(),
             surface.get()
@@ -366,15 +534,29 @@ _choose_swap_surface_format(
 
 vk::PresentModeKHR
 _choose_swap_present_mode(
-    std::vector<vk::PresentModeKHR> const& available_present_modes
+    std::vector<vk::PresentModeKHR> const& available_present_modes,
+    LatencyMode latency_mode
 ) noexcept {
-    //
-    for (auto const& present_mode : available_present_modes) {
-        // Recommended default.
-        // src: https://docs.vulkan.org/tutorial/latest/03_Drawing_a_triangle/01_Presentation/01_Swap_chain.html#_enabling_device_extensions:~:text=personally%20think%20that-,VK_PRESENT_MODE_MAILBOX_KHR,-is%20a%20very
-        if (present_mode == vk::PresentModeKHR::eMailbox) {
-            return present_mode;
-        }
+    auto const is_available = [&](vk::PresentModeKHR mode) {
+        return std::ranges::find(available_present_modes, mode) !=
+            available_present_modes.end();
+    };
+
+    // Throughput: FIFO never drops a rendered frame.
+    if (latency_mode == LatencyMode::Throughput) {
+        return vk::PresentModeKHR::eFifo;
+    }
+
+    // Recommended default.
+    // src: https://docs.vulkan.org/tutorial/latest/03_Drawing_a_triangle/01_Presentation/01_Swap_chain.html#_enabling_device_extensions:~:text=personally%20think%20that-,VK_PRESENT_MODE_MAILBOX_KHR,-is%20a%20very
+    if (is_available(vk::PresentModeKHR::eMailbox)) {
+        return vk::PresentModeKHR::eMailbox;
+    }
+
+    // Low latency: tearing is preferred over waiting for vblank.
+    if (latency_mode == LatencyMode::LowLatency &&
+        is_available(vk::PresentModeKHR::eImmediate)) {
+        return vk::PresentModeKHR::eImmediate;
     }
 
     return vk::PresentModeKHR::eFifo; // Guaranteed to be available.
@@ -430,14 +612,21 @@ VulkanRenderer::_create_swap_chain() noexcept {
     Log::info("Chosen surface format: ", vk::to_string(surface_format.format));
 
     vk::PresentModeKHR present_mode =
-        _choose_swap_present_mode(swap_chain_info.present_modes);
+        _choose_swap_present_mode(
+            swap_chain_info.present_modes,
+            _settings.latency_mode
+        );
     Log::info("Chosen present mode: ", vk::to_string(present_mode));
 
     vk::Extent2D extent =
         _choose_swap_extent(swap_chain_info.capabilities, _window);
     Log::info("Chosen swap extent: ", extent.width, "x", extent.height);
 
-    u32 image_count = swap_chain_info.capabilities.minImageCount + 1;
+    // Throughput queues one more image so FIFO never starves the GPU.
+    u32 const extra_images =
+        _settings.latency_mode == LatencyMode::Throughput ? 2 : 1;
+    u32 image_count =
+        swap_chain_info.capabilities.minImageCount + extra_images;
     u32 const max_image_count = swap_chain_info.capabilities.maxImageCount;
 
     if (max_image_count > 0 && image_count > max_image_count) {
@@ -480,13 +669,20 @@ VulkanRenderer::_create_swap_chain() noexcept {
         vk::CompositeAlphaFlagBitsKHR::eOpaque;
     swap_chain_create_info.presentMode = present_mode;
     swap_chain_create_info.clipped = vk::True;
-    swap_chain_create_info.oldSwapchain = nullptr;
+    // Lets the driver reuse resources and keep presenting during a resize.
+    swap_chain_create_info.oldSwapchain = _swap_chain.get();
 
-    _swap_chain = vk_expect_value(
+    vk::UniqueSwapchainKHR swap_chain = vk_expect_value(
         _device->createSwapchainKHRUnique(swap_chain_create_info),
         "Failed to create Swap Chain"
     );
 
+    // Images of the old one may still be presented or rendered to.
+    if (_swap_chain) {
+        _retire(std::move(_swap_chain));
+    }
+    _swap_chain = std::move(swap_chain);
+
     Log::info(Log::LIGHT_GREEN, "Swap Chain successfully created.");
 
     // Retrieve images.
@@ -515,63 +711,160 @@ VulkanRenderer::_recreate_swap_chain() noexcept {
         glfwWaitEvents();
     }
 
-    vk_expect(_device->waitIdle(), "Failed to wait idle");
+    auto const start_time = std::chrono::steady_clock::now();
 
-    _cleanup_swap_chain();
+    vk::Extent2D const old_extent = _swap_chain_extent;
+    vk::Format const old_format = _swap_chain_image_format;
 
+    // No device wait: frames in flight keep using the old objects, which
+    // are destroyed once those frames have completed (see _retire()).
+    // The old swap chain itself is retired by _create_swap_chain().
     _create_swap_chain();
+
+    _retire(std::move(_swap_chain_framebuffers));
+    _retire(std::move(_swap_chain_image_views));
+    _swap_chain_framebuffers.clear();
+    _swap_chain_image_views.clear();
+
     _create_image_views();
-    _create_color_resources();
-    _create_depth_resources();
+
+    // MSAA color, depth and the depth pyramid only depend on the extent
+    // and format, e.g. a minimize / restore gives back the same ones.
+    bool const keep_attachments = old_extent == _swap_chain_extent &&
+        old_format == _swap_chain_image_format;
+
+    if (!keep_attachments) {
+        _retire(std::move(_color_image_view));
+        _retire(std::move(_color_image));
+        _retire(std::move(_depth_image_view));
+        _retire(std::move(_depth_image));
+        _retire(std::move(_attachment_memory));
+        // Freeing the pool frees the sets.
+        _retire(std::move(_depth_pyramid_descriptor_pool));
+        _retire(std::move(_depth_pyramid_level_views));
+        _retire(std::move(_depth_pyramid_view));
+        _retire(std::move(_depth_pyramid));
+        _retire(std::move(_depth_pyramid_memory));
+        _depth_pyramid_level_views.clear();
+
+        _create_color_resources();
+        _create_depth_resources();
+        _bind_attachment_memory();
+        _create_depth_pyramid();
+    }
+
     _create_framebuffers();
+
+    std::chrono::duration<f64, std::milli> const elapsed =
+        std::chrono::steady_clock::now() - start_time;
+
+    Log::info(
+        "Swap chain recreated in ",
+        elapsed.count(),
+        " ms (",
+        keep_attachments ? "attachments kept" : "attachments recreated",
+        ", ",
+        _deletion_queue.size(),
+        " objects pending retirement)."
+    );
 }
 
+#pragma endregion SWAP_CHAIN
+
+#pragma region HEADLESS
+
 void
-VulkanRenderer::_cleanup_swap_chain() noexcept {
-    for (auto& framebuffer : _swap_chain_framebuffers) {
-        core_assert(framebuffer, "Framebuffer is nullptr.");
-        _device->destroyFramebuffer(*framebuffer, nullptr);
+VulkanRenderer::_create_offscreen_targets() noexcept {
+    Log::header("Initializing Offscreen Targets (headless).");
+
+    // RGBA so the readback can be written as-is, sRGB like the swap chain.
+    _swap_chain_image_format = vk::Format::eR8G8B8A8Srgb;
+    _swap_chain_extent = vk::Extent2D {
+        .width = _settings.width,
+        .height = _settings.height,
+    };
+
+    _offscreen_images.resize(_frames_in_flight);
+    _offscreen_images_memory.resize(_frames_in_flight);
+    _swap_chain_images.resize(_frames_in_flight);
+
+    for (usize i {}; i < _frames_in_flight; ++i) {
+        _create_image(
+            _swap_chain_extent.width,
+            _swap_chain_extent.height,
+            1, // Mip levels.
+            vk::SampleCountFlagBits::e1,
+            _swap_chain_image_format,
+            vk::ImageTiling::eOptimal,
+            vk::ImageUsageFlagBits::eColorAttachment |
+                vk::ImageUsageFlagBits::eTransferSrc,
+            vk::MemoryPropertyFlagBits::eDeviceLocal,
+            _offscreen_images[i],
+            _offscreen_images_memory[i]
+        );
+
+        _swap_chain_images[i] = *_offscreen_images[i];
     }
 
-    _swap_chain_framebuffers.clear();
+    if (!_settings.capture_path.empty()) {
+        vk::DeviceSize const size = vk::DeviceSize {_swap_chain_extent.width} *
+            _swap_chain_extent.height * 4;
 
-    for (auto& image_view : _swap_chain_image_views) {
-        core_assert(image_view, "Image view is nullptr.");
-        _device->destroyImageView(*image_view, nullptr);
+        _create_buffer_unique(
+            size,
+            vk::BufferUsageFlagBits::eTransferDst,
+            vk::MemoryPropertyFlagBits::eHostVisible |
+                vk::MemoryPropertyFlagBits::eHostCoherent,
+            _readback_buffer,
+            _readback_buffer_memory
+        );
     }
 
-    _swap_chain_image_views.clear();
+    Log::info(
+        "Rendering ",
+        _settings.frame_count,
+        " frames offscreen at ",
+        _swap_chain_extent.width,
+        "x",
+        _swap_chain_extent.height
+    );
+}
 
-    core_assert(_depth_image_view, "Depth image view is nullptr.");
-    _device->destroyImageView(*_depth_image_view, nullptr);
-    _depth_image_view.reset();
+void
+VulkanRenderer::_write_capture() noexcept {
+    core_assert(_readback_buffer, "Readback buffer is nullptr.");
 
-    core_assert(_depth_image, "Depth image is nullptr.");
-    _device->destroyImage(*_depth_image, nullptr);
-    _depth_image.reset();
+    vk::DeviceSize const size = vk::DeviceSize {_swap_chain_extent.width} *
+        _swap_chain_extent.height * 4;
 
-    core_assert(_depth_image_memory, "Depth image memory is nullptr.");
-    _device->freeMemory(*_depth_image_memory, nullptr);
-    _depth_image_memory.reset();
+    void* data = vk_expect_value(
+        _device->mapMemory(*_readback_buffer_memory, 0, size),
+        "Failed to map readback buffer."
+    );
 
-    core_assert(_color_image_view, "Color image view is nullptr.");
-    _device->destroyImageView(*_color_image_view, nullptr);
-    _color_image_view.reset();
+    std::span const pixels {static_cast<std::byte const*>(data), size};
+    std::filesystem::path const path {_settings.capture_path};
 
-    core_assert(_color_image, "Color image is nullptr.");
-    _device->destroyImage(*_color_image, nullptr);
-    _color_image.reset();
+    bool const written = path.extension() == ".png"
+        ? write_png(
+              path,
+              _swap_chain_extent.width,
+              _swap_chain_extent.height,
+              4,
+              pixels
+          )
+        : write_raw(path, pixels);
 
-    core_assert(_color_image_memory, "Color image memory is nullptr.");
-    _device->freeMemory(*_color_image_memory, nullptr);
-    _color_image_memory.reset();
+    _device->unmapMemory(*_readback_buffer_memory);
 
-    core_assert(_swap_chain, "Swap chain is nullptr.");
-    _device->destroySwapchainKHR(*_swap_chain, nullptr);
-    _swap_chain.reset();
+    if (written) {
+        Log::info("Captured last frame to ", path.string());
+    } else {
+        Log::error("Failed to write capture to ", path.string());
+    }
 }
 
-#pragma endregion SWAP_CHAIN
+#pragma endregion HEADLESS
 
 #pragma region IMAGE_VIEWS
 
@@ -659,6 +952,12 @@ void
 VulkanRenderer::_create_color_resources() noexcept {
     vk::Format color_format = _swap_chain_image_format;
 
+    // The late pass of occlusion culling loads what the early one drew.
+    vk::ImageUsageFlags const usage = _occlusion_culling
+        ? vk::ImageUsageFlagBits::eColorAttachment
+        : vk::ImageUsageFlagBits::eTransientAttachment |
+            vk::ImageUsageFlagBits::eColorAttachment;
+
     _create_image(
         _swap_chain_extent.width,
         _swap_chain_extent.height,
@@ -666,27 +965,101 @@ VulkanRenderer::_create_color_resources() noexcept {
         _msaa_samples,
         color_format,
         vk::ImageTiling::eOptimal,
-        vk::ImageUsageFlagBits::eTransientAttachment |
-            vk::ImageUsageFlagBits::eColorAttachment,
-        vk::MemoryPropertyFlagBits::eDeviceLocal,
-        _color_image,
-        _color_image_memory
+        usage,
+        _color_image
+    );
+
+    _color_image_requirements =
+        _device->getImageMemoryRequirements(*_color_image);
+}
+
+void
+VulkanRenderer::_bind_attachment_memory() noexcept {
+    // The frame graph every frame is built from, only its memory layout is
+    // used here: it does not depend on what the frame records.
+    RenderGraph graph {};
+    FrameGraphAttachments const attachments =
+        _build_frame_graph(graph, vk::CommandBuffer {}, 0);
+    CompiledRenderGraph const compiled = graph.compile();
+
+    u32 const memory_type_bits = _color_image_requirements.memoryTypeBits &
+        _depth_image_requirements.memoryTypeBits;
+    core_assert(memory_type_bits != 0, "Attachments can not share memory.");
+
+    vk::MemoryAllocateInfo const alloc_info {
+        .allocationSize = compiled.memory_size,
+        .memoryTypeIndex = _find_memory_type(
+            _physical_device,
+            memory_type_bits,
+            vk::MemoryPropertyFlagBits::eDeviceLocal
+        ),
+    };
+
+    _attachment_memory = vk_expect_value(
+        _device->allocateMemoryUnique(alloc_info),
+        "Failed to allocate attachment memory."
+    );
+
+    vk_expect(
+        _device->bindImageMemory(
+            *_color_image,
+            *_attachment_memory,
+            compiled.memory_offsets[attachments.color]
+        ),
+        "Failed to bind color attachment memory."
+    );
+
+    vk_expect(
+        _device->bindImageMemory(
+            *_depth_image,
+            *_attachment_memory,
+            compiled.memory_offsets[attachments.depth]
+        ),
+        "Failed to bind depth attachment memory."
     );
 
+    // Views need bound memory.
     _color_image_view = _create_image_view(
         *_color_image,
-        color_format,
+        _swap_chain_image_format,
         vk::ImageAspectFlagBits::eColor,
         1 // Mip maps.
     );
+
+    _depth_image_view = _create_image_view(
+        *_depth_image,
+        _depth_format,
+        vk::ImageAspectFlagBits::eDepth,
+        1 // Mip levels.
+    );
+
+    Log::info(
+        "Attachment memory: ",
+        compiled.memory_size,
+        " bytes (",
+        _color_image_requirements.size + _depth_image_requirements.size,
+        " without aliasing)."
+    );
 }
 
 #pragma endregion MSAA
 
 #pragma region PHYSICAL_DEVICE
 
+// Swap chain support is only needed when presenting to a surface.
+std::span<char const* const>
+_required_device_extensions(bool headless) noexcept {
+    if (headless) {
+        return {};
+    }
+    return s_physical_device_extensions;
+}
+
 bool
-_check_device_extension_support(vk::PhysicalDevice const& device) {
+_check_device_extension_support(
+    vk::PhysicalDevice const& device,
+    std::span<char const* const> extensions
+) {
     auto available_extensions = vk_expect_value(
         device.enumerateDeviceExtensionProperties(),
         "Failed to get physical device extension properties."
@@ -698,8 +1071,8 @@ _check_device_extension_support(vk::PhysicalDevice const& device) {
     }
 
     std::set<std::string> required_extensions(
-        s_physical_device_extensions.begin(),
-        s_physical_device_extensions.end()
+        extensions.begin(),
+        extensions.end()
     );
 
     for (auto const& extension : available_extensions) {
@@ -723,11 +1096,15 @@ _is_device_suitable(
     vk::UniqueSurfaceKHR const& surface
 ) noexcept {
     // Edit this function if you have exclusion criteria for devices.
+    bool const headless = !surface;
     QueueFamilyIndices const& indices = _find_queue_families(device, surface);
-    bool extensions_supported = _check_device_extension_support(device);
-    bool swap_chain_adequate {false};
+    bool extensions_supported = _check_device_extension_support(
+        device,
+        _required_device_extensions(headless)
+    );
+    bool swap_chain_adequate {headless};
 
-    if (extensions_supported) {
+    if (extensions_supported && !headless) {
         SwapChainSupportInfo swap_chain_info =
             _query_swapchain_support(device, surface);
 
@@ -737,8 +1114,31 @@ _is_device_suitable(
 
     auto supported_features = device.getFeatures();
 
+    bool const vulkan_12 =
+        device.getProperties().apiVersion >= VK_API_VERSION_1_2;
+    auto const vulkan_12_features =
+        device
+            .getFeatures2<
+                vk::PhysicalDeviceFeatures2,
+                vk::PhysicalDeviceVulkan12Features>()
+            .get<vk::PhysicalDeviceVulkan12Features>();
+
+    // Frame pacing, uploads and deferred destruction use a timeline
+    // semaphore (Vulkan 1.2 core).
+    bool const timeline_supported =
+        vulkan_12 && vulkan_12_features.timelineSemaphore;
+
+    // Bindless textures (descriptor indexing, Vulkan 1.2 core).
+    bool const bindless_supported = vulkan_12 &&
+        vulkan_12_features.runtimeDescriptorArray &&
+        vulkan_12_features.descriptorBindingPartiallyBound &&
+        vulkan_12_features.descriptorBindingSampledImageUpdateAfterBind &&
+        vulkan_12_features.descriptorBindingUpdateUnusedWhilePending &&
+        vulkan_12_features.shaderSampledImageArrayNonUniformIndexing;
+
     bool const suitable = indices.is_complete() && extensions_supported &&
-        swap_chain_adequate && supported_features.samplerAnisotropy;
+        swap_chain_adequate && supported_features.samplerAnisotropy &&
+        timeline_supported && bindless_supported;
 
     Log::info(
         "Checking if device is suitable: ",
@@ -756,6 +1156,14 @@ _is_device_suitable(
         "Present family: ",
         Log::to_string(indices.present_family.has_value())
     );
+    Log::sub_info(
+        "Timeline semaphores: ",
+        Log::to_string(timeline_supported)
+    );
+    Log::sub_info(
+        "Descriptor indexing: ",
+        Log::to_string(bindless_supported)
+    );
     Log::sub_info("Suitable: ", Log::to_string(suitable));
 
     return suitable;
@@ -788,7 +1196,7 @@ _rate_device_suitability(vk::PhysicalDevice const& device) noexcept {
 
 void
 VulkanRenderer::_create_physical_device() noexcept {
-    core_assert(_surface.get(), "Surface is nullptr.");
+    core_assert(_settings.headless || _surface.get(), "Surface is nullptr.");
 
     auto physical_devices = vk_expect_value(
         _vk_instance->enumeratePhysicalDevices(),
@@ -847,20 +1255,82 @@ VulkanRenderer::_create_logical_device() noexcept {
         queue_create_infos.push_back(queue_create_info);
     }
 
+    // GPU culling writes a variable number of indirect draws, each one
+    // passing its object index as first instance.
+    auto const supported_features = _physical_device.getFeatures2<
+        vk::PhysicalDeviceFeatures2,
+        vk::PhysicalDeviceVulkan12Features>();
+    vk::PhysicalDeviceFeatures const& supported_10_features =
+        supported_features.get<vk::PhysicalDeviceFeatures2>().features;
+
+    _gpu_culling = _settings.gpu_culling &&
+        supported_10_features.multiDrawIndirect &&
+        supported_10_features.drawIndirectFirstInstance &&
+        supported_features.get<vk::PhysicalDeviceVulkan12Features>()
+            .drawIndirectCount;
+
+    vk::Bool32 const gpu_culling = _gpu_culling ? vk::True : vk::False;
+
+    // Vulkan 1.3 core, for both the instance and the device.
+    u32 const device_version = _physical_device.getProperties().apiVersion;
+    bool const vulkan_13 =
+        std::min(_api_version, device_version) >= VK_API_VERSION_1_3;
+
+    _dynamic_rendering = _settings.dynamic_rendering && vulkan_13 &&
+        _physical_device
+            .getFeatures2<
+                vk::PhysicalDeviceFeatures2,
+                vk::PhysicalDeviceVulkan13Features>()
+            .get<vk::PhysicalDeviceVulkan13Features>()
+            .dynamicRendering;
+
+    // Only needs what bindless already requires (partially bound sets).
+    _occlusion_culling = _gpu_culling && _settings.occlusion_culling;
+
+    Log::info("GPU culling: ", Log::to_string(_gpu_culling));
+    Log::info("Occlusion culling: ", Log::to_string(_occlusion_culling));
+    Log::info("Dynamic rendering: ", Log::to_string(_dynamic_rendering));
+    if (_settings.gpu_culling && !_gpu_culling) {
+        Log::warn("Indirect count draws unsupported, culling on the CPU.");
+    }
+    if (_settings.dynamic_rendering && !_dynamic_rendering) {
+        Log::warn("Dynamic rendering unsupported, using render passes.");
+    }
+
     // Specify device features.
-    constexpr vk::PhysicalDeviceFeatures device_features {
+    vk::PhysicalDeviceFeatures const device_features {
         .sampleRateShading = vk::True,
+        .multiDrawIndirect = gpu_culling,
+        .drawIndirectFirstInstance = gpu_culling,
         .samplerAnisotropy = vk::True,
     };
 
+    auto const extensions = _required_device_extensions(_settings.headless);
+
+    vk::PhysicalDeviceVulkan13Features vulkan_13_features {
+        .dynamicRendering = vk::True,
+    };
+
+    vk::PhysicalDeviceVulkan12Features vulkan_12_features {
+        .pNext = _dynamic_rendering ? &vulkan_13_features : nullptr,
+        .drawIndirectCount = gpu_culling,
+        // Bindless textures, see _create_bindless_descriptors().
+        .shaderSampledImageArrayNonUniformIndexing = vk::True,
+        .descriptorBindingSampledImageUpdateAfterBind = vk::True,
+        .descriptorBindingUpdateUnusedWhilePending = vk::True,
+        .descriptorBindingPartiallyBound = vk::True,
+        .runtimeDescriptorArray = vk::True,
+        .timelineSemaphore = vk::True,
+    };
+
     // Create Logical Device.
     vk::DeviceCreateInfo device_create_info {
+        .pNext = &vulkan_12_features,
         .queueCreateInfoCount = static_cast<u32>(queue_create_infos.size()),
         .pQueueCreateInfos = queue_create_infos.data(),
         // Add per-device extensions here.
-        .enabledExtensionCount =
-            static_cast<u32>(s_physical_device_extensions.size()),
-        .ppEnabledExtensionNames = s_physical_device_extensions.data(),
+        .enabledExtensionCount = static_cast<u32>(extensions.size()),
+        .ppEnabledExtensionNames = extensions.data(),
         .pEnabledFeatures = &device_features,
     };
 
@@ -884,54 +1354,294 @@ VulkanRenderer::_create_logical_device() noexcept {
 
 #pragma region DESCRIPTORS
 
+vk::DescriptorType
+_to_descriptor_type(ShaderDescriptorType type, bool dynamic) noexcept {
+    switch (type) {
+        case ShaderDescriptorType::UniformBuffer:
+            return dynamic ? vk::DescriptorType::eUniformBufferDynamic
+                           : vk::DescriptorType::eUniformBuffer;
+        case ShaderDescriptorType::StorageBuffer:
+            return vk::DescriptorType::eStorageBuffer;
+        case ShaderDescriptorType::SampledImage:
+            return vk::DescriptorType::eSampledImage;
+        case ShaderDescriptorType::StorageImage:
+            return vk::DescriptorType::eStorageImage;
+        case ShaderDescriptorType::Sampler:
+            return vk::DescriptorType::eSampler;
+        case ShaderDescriptorType::CombinedImageSampler:
+            return vk::DescriptorType::eCombinedImageSampler;
+        case ShaderDescriptorType::UniformTexelBuffer:
+            return vk::DescriptorType::eUniformTexelBuffer;
+        case ShaderDescriptorType::StorageTexelBuffer:
+            return vk::DescriptorType::eStorageTexelBuffer;
+    }
+
+    return vk::DescriptorType::eUniformBuffer;
+}
+
+vk::ShaderStageFlags
+_to_shader_stages(ShaderStageMask stages) noexcept {
+    vk::ShaderStageFlags flags {};
+
+    if (stages & to_mask(ShaderStage::Vertex)) {
+        flags |= vk::ShaderStageFlagBits::eVertex;
+    }
+    if (stages & to_mask(ShaderStage::Fragment)) {
+        flags |= vk::ShaderStageFlagBits::eFragment;
+    }
+    if (stages & to_mask(ShaderStage::Compute)) {
+        flags |= vk::ShaderStageFlagBits::eCompute;
+    }
+
+    return flags;
+}
+
 void
 VulkanRenderer::_create_descriptor_set_layout() noexcept {
-    constexpr vk::DescriptorSetLayoutBinding ubo_layout_binding {
-        // This binding is used in vertex shader.
-        // layout (binding = 0) uniform UBO...
-        .binding = 0,
-        .descriptorType = vk::DescriptorType::eUniformBuffer,
-        .descriptorCount = 1,
-        // Stages in which the descriptor is going to be referenced.
-        .stageFlags = vk::ShaderStageFlagBits::eVertex,
-        .pImmutableSamplers = nullptr, // Optional. (for image sampling).
+    MaterialPipeline default_pipeline {};
+    _request_shader_variants(default_pipeline);
+
+    std::array const graphics_stages {
+        _reflect_shader(default_pipeline.vertex_shader),
+        _reflect_shader(default_pipeline.fragment_shader),
     };
 
-    constexpr vk::DescriptorSetLayoutBinding sampler_layout_binding {
-        .binding = 1,
-        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-        .descriptorCount = 1,
-        // Sampler are usually used in fragment shaders, but they can also be
-        // used in vertex shader, for example to dynamically deform a grid
-        // of vertices by a heightmap.
-        .stageFlags = vk::ShaderStageFlagBits::eFragment,
-        .pImmutableSamplers = nullptr,
+    std::array const cull_stages {
+        _reflect_shader(_cull_shader),
+        _reflect_shader(_cluster_cull_shader),
+    };
+
+    std::vector<ShaderReflection> scene_stages {
+        graphics_stages.begin(),
+        graphics_stages.end(),
+    };
+    scene_stages.insert(
+        scene_stages.end(),
+        cull_stages.begin(),
+        cull_stages.end()
+    );
+
+    std::optional<ShaderLayout> graphics =
+        merge_shader_layouts(graphics_stages);
+    std::optional<ShaderLayout> cull = merge_shader_layouts(cull_stages);
+    std::optional<ShaderLayout> const scene =
+        merge_shader_layouts(scene_stages);
+
+    core_assert(
+        graphics && cull && scene,
+        "Shaders declare the same binding differently."
+    );
+    core_assert(
+        scene && scene->sets.size() == 2 && graphics->sets.size() == 2,
+        "Shaders use set 0 (scene) and set 1 (bindless), nothing else."
+    );
+
+    if (!graphics || !cull || !scene || scene->sets.size() != 2) {
+        return;
+    }
+
+    // Each pipeline holds the shared sets up to the last one it uses.
+    graphics->sets.assign(
+        scene->sets.begin(),
+        scene->sets.begin() + static_cast<isize>(graphics->sets.size())
+    );
+    cull->sets.assign(
+        scene->sets.begin(),
+        scene->sets.begin() + static_cast<isize>(cull->sets.size())
+    );
+
+    // Written by _write_descriptor_set() with these types.
+    auto const declares = [&](u32 binding, ShaderDescriptorType type) {
+        return std::ranges::any_of(
+            scene->sets[0],
+            [&](ShaderBinding const& declared) {
+                return declared.binding == binding && declared.type == type;
+            }
+        );
     };
+    core_assert(
+        declares(s_visibility_binding, ShaderDescriptorType::StorageBuffer) &&
+            declares(
+                s_depth_pyramid_binding,
+                ShaderDescriptorType::CombinedImageSampler
+            ),
+        "sh_cull.comp and vulkan_drawable.hpp disagree on the occlusion "
+        "culling bindings."
+    );
 
-    std::array const bindings = {ubo_layout_binding, sampler_layout_binding};
+    _graphics_layout = std::move(*graphics);
+    _cull_layout = std::move(*cull);
+
+    // Scene uniform blocks live in the frame's uniform ring.
+    _descriptor_set_layout = _descriptor_set_layout_for(
+        _graphics_layout.sets[0],
+        s_partially_bound_scene_bindings,
+        true
+    );
+
+    Log::info(
+        "Scene descriptor set layout reflected (",
+        _graphics_layout.sets[0].size(),
+        " bindings)."
+    );
+}
+
+vk::DescriptorSetLayout
+VulkanRenderer::_descriptor_set_layout_for(
+    std::span<ShaderBinding const> bindings,
+    std::span<u32 const> partially_bound_bindings,
+    bool dynamic_uniform_buffers
+) noexcept {
+    // Slots are filled as textures are loaded, unused ones are never read.
+    // Update-after-bind lets new slots be written while frames using the
+    // set are still in flight.
+    constexpr vk::DescriptorBindingFlags bindless_flags =
+        vk::DescriptorBindingFlagBits::ePartiallyBound |
+        vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+        vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+
+    DescriptorSetLayoutKey key {};
+
+    for (ShaderBinding const& binding : bindings) {
+        vk::DescriptorType const type =
+            _to_descriptor_type(binding.type, dynamic_uniform_buffers);
+        bool const bindless = binding.count == 0;
+        u32 count = binding.count;
+        vk::DescriptorBindingFlags flags {};
+
+        if (bindless) {
+            core_assert(
+                type == vk::DescriptorType::eSampledImage ||
+                    type == vk::DescriptorType::eSampler,
+                "Bindless arrays hold sampled images or samplers."
+            );
+            count = type == vk::DescriptorType::eSampler
+                ? s_max_bindless_samplers
+                : s_max_bindless_textures;
+            flags = bindless_flags;
+            key.flags |=
+                vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+        }
+
+        if (std::ranges::find(partially_bound_bindings, binding.binding) !=
+            partially_bound_bindings.end()) {
+            flags |= vk::DescriptorBindingFlagBits::ePartiallyBound;
+        }
+
+        key.bindings.push_back({
+            .binding = binding.binding,
+            .type = type,
+            .count = count,
+            .stages = _to_shader_stages(binding.stages),
+            .flags = flags,
+        });
+    }
+
+    auto const [layout, inserted] = _descriptor_set_layouts.try_emplace(key);
+
+    if (!inserted) {
+        return *layout->second;
+    }
+
+    std::vector<vk::DescriptorSetLayoutBinding> layout_bindings {};
+    std::vector<vk::DescriptorBindingFlags> binding_flags {};
+
+    for (DescriptorSetLayoutKey::Binding const& binding : key.bindings) {
+        layout_bindings.push_back({
+            .binding = binding.binding,
+            .descriptorType = binding.type,
+            .descriptorCount = binding.count,
+            .stageFlags = binding.stages,
+        });
+        binding_flags.push_back(binding.flags);
+    }
+
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo const flags_info {
+        .bindingCount = static_cast<u32>(binding_flags.size()),
+        .pBindingFlags = binding_flags.data(),
+    };
 
     vk::DescriptorSetLayoutCreateInfo const layout_info {
-        .bindingCount = static_cast<u32>(bindings.size()),
-        .pBindings = bindings.data(),
+        .pNext = &flags_info,
+        .flags = key.flags,
+        .bindingCount = static_cast<u32>(layout_bindings.size()),
+        .pBindings = layout_bindings.data(),
     };
 
-    _descriptor_set_layout = vk_expect_value(
+    layout->second = vk_expect_value(
         _device->createDescriptorSetLayoutUnique(layout_info),
         "Failed to create Descriptor Set Layout."
     );
+
+    return *layout->second;
+}
+
+vk::PipelineLayout
+VulkanRenderer::_pipeline_layout_for(
+    std::span<vk::DescriptorSetLayout const> set_layouts,
+    ShaderLayout const& layout
+) noexcept {
+    vk::PushConstantRange const push_constant_range {
+        .stageFlags = _to_shader_stages(layout.push_constant_stages),
+        .offset = 0,
+        .size = layout.push_constant_size,
+    };
+
+    PipelineLayoutKey key {
+        .set_layouts {set_layouts.begin(), set_layouts.end()},
+        .push_constant_stages = push_constant_range.stageFlags,
+        .push_constant_size = push_constant_range.size,
+    };
+
+    auto const [pipeline_layout, inserted] =
+        _pipeline_layouts.try_emplace(std::move(key));
+
+    if (!inserted) {
+        return *pipeline_layout->second;
+    }
+
+    vk::PipelineLayoutCreateInfo const pipeline_layout_info {
+        .setLayoutCount = static_cast<u32>(set_layouts.size()),
+        .pSetLayouts = set_layouts.data(),
+        .pushConstantRangeCount = layout.push_constant_size > 0 ? 1U : 0U,
+        .pPushConstantRanges = &push_constant_range,
+    };
+
+    pipeline_layout->second = vk_expect_value(
+        _device->createPipelineLayoutUnique(pipeline_layout_info),
+        "Failed to create pipeline layout."
+    );
+
+    return *pipeline_layout->second;
 }
 
 void
 VulkanRenderer::_create_descriptor_pool() noexcept {
-    std::array<vk::DescriptorPoolSize, 2> pool_sizes {};
-    pool_sizes[0].descriptorCount = s_max_frames_in_flight;
-    pool_sizes[1].descriptorCount = s_max_frames_in_flight;
+    // Every descriptor of the scene set, once per frame slot.
+    std::vector<vk::DescriptorPoolSize> pool_sizes {};
+
+    for (ShaderBinding const& binding : _graphics_layout.sets[0]) {
+        vk::DescriptorType const type = _to_descriptor_type(binding.type, true);
+        auto pool_size = std::ranges::find(
+            pool_sizes,
+            type,
+            &vk::DescriptorPoolSize::type
+        );
+
+        if (pool_size == pool_sizes.end()) {
+            pool_sizes.push_back({.type = type, .descriptorCount = 0});
+            pool_size = std::prev(pool_sizes.end());
+        }
+
+        pool_size->descriptorCount += binding.count * _frames_in_flight;
+    }
 
     // Warning:
     // src: https://docs.vulkan.org/tutorial/latest/06_Texture_mapping/02_Combined_image_sampler.html#:~:text=Inadequate%20descriptor%20pools%20are%20a,machines%2C%20but%20fails%20on%20others.
     vk::DescriptorPoolCreateInfo const pool_info {
-        .flags = {},
-        .maxSets = s_max_frames_in_flight,
+        // Sets are vk::UniqueDescriptorSet, which frees them individually.
+        .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+        .maxSets = _frames_in_flight,
         .poolSizeCount = static_cast<u32>(pool_sizes.size()),
         .pPoolSizes = pool_sizes.data(),
     };
@@ -945,13 +1655,13 @@ VulkanRenderer::_create_descriptor_pool() noexcept {
 void
 VulkanRenderer::_create_descriptor_sets() noexcept {
     std::vector<vk::DescriptorSetLayout> const layouts(
-        s_max_frames_in_flight,
-        *_descriptor_set_layout
+        _frames_in_flight,
+        _descriptor_set_layout
     );
 
     vk::DescriptorSetAllocateInfo const alloc_info {
         .descriptorPool = *_descriptor_pool,
-        .descriptorSetCount = s_max_frames_in_flight,
+        .descriptorSetCount = _frames_in_flight,
         .pSetLayouts = layouts.data(),
     };
 
@@ -960,107 +1670,400 @@ VulkanRenderer::_create_descriptor_sets() noexcept {
         _device->allocateDescriptorSetsUnique(alloc_info);
     core_assert(result == s_success, "Failed to allocate Descriptor Sets.");
 
-    std::move(
-        descriptor_sets.begin(),
-        descriptor_sets.end(),
-        _descriptor_sets.data()
-    );
+    _descriptor_sets = std::move(descriptor_sets);
+    _descriptor_sets_stale.assign(_frames_in_flight, false);
 
     // The descriptor sets have been allocated.
     // Now we need to configure the descriptor within them.
-    for (usize i {}; i < s_max_frames_in_flight; ++i) {
-        vk::DescriptorBufferInfo const descriptor_buffer_info {
-            .buffer = *_uniform_buffers[i],
-            .offset = 0,
-            // If you're overwriting the whole buffer, like we are in this case,
-            // then it is also possible to use the vk::WholeSize value for the range.
-            .range = sizeof(UniformBufferObject)
-        };
+    for (usize i {}; i < _frames_in_flight; ++i) {
+        _write_descriptor_set(i);
+    }
+}
 
-        vk::DescriptorImageInfo const image_info {
-            .sampler = *_texture_sampler,
-            .imageView = *_texture_image_view,
-            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+void
+VulkanRenderer::_write_descriptor_set(usize frame) noexcept {
+    // The frame's block is selected by the dynamic offset at bind time.
+    vk::DescriptorBufferInfo const descriptor_buffer_info {
+        .buffer = *_uniform_rings[frame].buffer,
+        .offset = 0,
+        .range = sizeof(UniformBufferObject)
+    };
+
+    vk::DescriptorBufferInfo const material_buffer_info {
+        .buffer = *_material_buffers[frame],
+        .offset = 0,
+        .range = vk::WholeSize,
+    };
+
+    // Objects, draw commands and draw count (bindings 2, 3 and 4), then
+    // meshlets, cluster work and LODs (bindings 7, 8 and 9).
+    std::array const object_buffers = {
+        *_instance_buffers[frame].instances,
+        *_instance_buffers[frame].draw_commands,
+        *_draw_count_buffers[frame],
+        *_meshlet_buffer,
+        *_instance_buffers[frame].cluster_work,
+        *_lod_buffer,
+    };
+    constexpr std::array<u32, 6> object_bindings {2, 3, 4, 7, 8, 9};
+
+    vk::WriteDescriptorSet const ubo_descriptor_write {
+        // Descriptor set to update and it's binding.
+        .dstSet = *_descriptor_sets[frame],
+        .dstBinding = 0,
+        // Descriptor could be an array (not in this case).
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
+        .pImageInfo = nullptr, // Optional.
+        .pBufferInfo = &descriptor_buffer_info,
+        .pTexelBufferView = nullptr, // Optional.
+    };
+
+    vk::WriteDescriptorSet const material_descriptor_write {
+        .dstSet = *_descriptor_sets[frame],
+        .dstBinding = 1,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eStorageBuffer,
+        .pBufferInfo = &material_buffer_info,
+    };
+
+    std::array<vk::DescriptorBufferInfo, 6> object_buffer_infos {};
+    std::array<vk::WriteDescriptorSet, 8> descriptor_writes {
+        ubo_descriptor_write,
+        material_descriptor_write
+    };
+
+    // Separate writes, the bindings are not visible to the same stages.
+    for (usize i {}; i < object_buffers.size(); ++i) {
+        object_buffer_infos[i] = {
+            .buffer = object_buffers[i],
+            .offset = 0,
+            .range = vk::WholeSize,
         };
 
-        vk::WriteDescriptorSet const ubo_descriptor_write {
-            // Descriptor set to update and it's binding.
-            .dstSet = *_descriptor_sets[i],
-            .dstBinding = 0,
-            // Descriptor could be an array (not in this case).
+        descriptor_writes[2 + i] = {
+            .dstSet = *_descriptor_sets[frame],
+            .dstBinding = object_bindings[i],
             .dstArrayElement = 0,
             .descriptorCount = 1,
-            .descriptorType = vk::DescriptorType::eUniformBuffer,
-            .pImageInfo = nullptr, // Optional.
-            .pBufferInfo = &descriptor_buffer_info,
-            .pTexelBufferView = nullptr, // Optional.
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo = &object_buffer_infos[i],
         };
+    }
 
-        vk::WriteDescriptorSet const sampler_descriptor_write {
-            .dstSet = *_descriptor_sets[i],
-            .dstBinding = 1,
+    // We can pass an array to make copies of the descriptor set.
+    // But not for now so we set it as nullptr.
+    _device->updateDescriptorSets(
+        static_cast<u32>(descriptor_writes.size()),
+        descriptor_writes.data(),
+        // Copy stuff, disabled for now.
+        0,
+        nullptr
+    );
+
+    if (!_occlusion_culling) {
+        return;
+    }
+
+    vk::DescriptorBufferInfo const visibility_buffer_info {
+        .buffer = *_visibility_buffer,
+        .offset = 0,
+        .range = vk::WholeSize,
+    };
+
+    vk::DescriptorImageInfo const depth_pyramid_info {
+        .sampler = *_depth_pyramid_sampler,
+        .imageView = *_depth_pyramid_view,
+        .imageLayout = vk::ImageLayout::eGeneral,
+    };
+
+    std::array const occlusion_writes {
+        vk::WriteDescriptorSet {
+            .dstSet = *_descriptor_sets[frame],
+            .dstBinding = s_visibility_binding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo = &visibility_buffer_info,
+        },
+        vk::WriteDescriptorSet {
+            .dstSet = *_descriptor_sets[frame],
+            .dstBinding = s_depth_pyramid_binding,
             .dstArrayElement = 0,
             .descriptorCount = 1,
             .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-            .pImageInfo = &image_info,
-            .pTexelBufferView = nullptr, // Optional.
-        };
+            .pImageInfo = &depth_pyramid_info,
+        },
+    };
 
-        std::array<vk::WriteDescriptorSet, 2> const descriptor_writes {
-            ubo_descriptor_write,
-            sampler_descriptor_write
-        };
+    _device->updateDescriptorSets(occlusion_writes, nullptr);
+}
 
-        // We can pass an array to make copies of the descriptor set.
-        // But not for now so we set it as nullptr.
-        _device->updateDescriptorSets(
-            static_cast<u32>(descriptor_writes.size()),
-            descriptor_writes.data(),
-            // Copy stuff, disabled for now.
-            0,
-            nullptr
-        );
-    }
+void
+VulkanRenderer::_mark_descriptor_sets_stale() noexcept {
+    // None at init, they are written once created.
+    std::fill(
+        _descriptor_sets_stale.begin(),
+        _descriptor_sets_stale.end(),
+        true
+    );
 }
 
 #pragma endregion DESCRIPTORS
 
-#pragma region SHADERS
+#pragma region BINDLESS
+
+void
+VulkanRenderer::_create_bindless_descriptors() noexcept {
+    // layout(set = 1, binding = 0) uniform texture2D textures[];
+    // layout(set = 1, binding = 1) uniform sampler samplers[];
+    _bindless_set_layout = _descriptor_set_layout_for(_graphics_layout.sets[1]);
+
+    constexpr std::array pool_sizes {
+        vk::DescriptorPoolSize {
+            .type = vk::DescriptorType::eSampledImage,
+            .descriptorCount = s_max_bindless_textures,
+        },
+        vk::DescriptorPoolSize {
+            .type = vk::DescriptorType::eSampler,
+            .descriptorCount = s_max_bindless_samplers,
+        },
+    };
+
+    vk::DescriptorPoolCreateInfo const pool_info {
+        .flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+        .maxSets = 1,
+        .poolSizeCount = static_cast<u32>(pool_sizes.size()),
+        .pPoolSizes = pool_sizes.data(),
+    };
+
+    _bindless_descriptor_pool = vk_expect_value(
+        _device->createDescriptorPoolUnique(pool_info),
+        "Failed to create Bindless Descriptor Pool."
+    );
+
+    vk::DescriptorSetAllocateInfo const alloc_info {
+        .descriptorPool = *_bindless_descriptor_pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &_bindless_set_layout,
+    };
+
+    _bindless_set = vk_expect_value(
+        _device->allocateDescriptorSets(alloc_info),
+        "Failed to allocate Bindless Descriptor Set."
+    )[0];
+
+    Log::info(
+        Log::LIGHT_GREEN,
+        "Bindless descriptors successfully created (",
+        s_max_bindless_textures,
+        " textures, ",
+        s_max_bindless_samplers,
+        " samplers)."
+    );
+}
+
+std::optional<u32>
+VulkanRenderer::_register_bindless_texture(vk::ImageView image_view
+) noexcept {
+    if (!_has_free_bindless_texture()) {
+        Log::error("Out of bindless texture slots.");
+        return std::nullopt;
+    }
+
+    u32 slot {_bindless_texture_count};
+
+    if (!_free_bindless_textures.empty()) {
+        slot = _free_bindless_textures.back();
+        _free_bindless_textures.pop_back();
+    } else {
+        ++_bindless_texture_count;
+    }
+
+    vk::DescriptorImageInfo const image_info {
+        .imageView = image_view,
+        .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+    };
+
+    vk::WriteDescriptorSet const texture_write {
+        .dstSet = _bindless_set,
+        .dstBinding = 0,
+        .dstArrayElement = slot,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eSampledImage,
+        .pImageInfo = &image_info,
+    };
+
+    _device->updateDescriptorSets(texture_write, nullptr);
+
+    return slot;
+}
+
+bool
+VulkanRenderer::_has_free_bindless_texture() const noexcept {
+    return !_free_bindless_textures.empty() ||
+        _bindless_texture_count < s_max_bindless_textures;
+}
+
+void
+VulkanRenderer::_release_bindless_texture(u32 slot) noexcept {
+    // Frames in flight may still sample it, only reuse it afterwards.
+    _deletion_queue.defer(_timeline_value, [this, slot] {
+        _free_bindless_textures.push_back(slot);
+    });
+}
+
+std::optional<u32>
+VulkanRenderer::_register_bindless_sampler(vk::Sampler sampler) noexcept {
+    if (_bindless_sampler_count == s_max_bindless_samplers) {
+        Log::error("Out of bindless sampler slots.");
+        return std::nullopt;
+    }
+
+    u32 const slot = _bindless_sampler_count++;
 
-std::vector<u32>
-VulkanRenderer::_compile_shader_to_spirv(
-    std::string const& source,
-    std::string const& file_path,
-    shaderc_shader_kind kind
+    vk::DescriptorImageInfo const sampler_info {.sampler = sampler};
+
+    vk::WriteDescriptorSet const sampler_write {
+        .dstSet = _bindless_set,
+        .dstBinding = 1,
+        .dstArrayElement = slot,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eSampler,
+        .pImageInfo = &sampler_info,
+    };
+
+    _device->updateDescriptorSets(sampler_write, nullptr);
+
+    return slot;
+}
+
+u32
+VulkanRenderer::_add_material(
+    GpuMaterial const& material,
+    PipelineState const& state,
+    std::span<std::string const> shader_keywords
 ) noexcept {
-    shaderc::Compiler compiler;
-    shaderc::CompileOptions options;
-    options.SetTargetEnvironment(
-        shaderc_target_env_vulkan,
-        shaderc_env_version_vulkan_1_3
+    core_assert(_materials.size() < s_max_materials, "Too many materials.");
+
+    _materials.push_back(material);
+    ++_materials_version;
+
+    MaterialPipeline& pipeline = _material_pipelines.emplace_back(
+        MaterialPipeline {
+            .state = state,
+            .shader_keywords {shader_keywords.begin(), shader_keywords.end()},
+        }
     );
-    options.SetOptimizationLevel(shaderc_optimization_level_performance);
 
-    Log::info("Compiling shader to SPIR-V.");
-    Log::info("Shader source code:\n", source);
+    // Compiled in the background from now on, not when first drawn.
+    _request_shader_variants(pipeline);
+    _pipeline_cache.find(_pipeline_key(pipeline));
+
+    return static_cast<u32>(_materials.size() - 1);
+}
 
-    shaderc::SpvCompilationResult result =
-        compiler.CompileGlslToSpv(source, kind, file_path.c_str(), options);
+void
+VulkanRenderer::_update_material(
+    u32 material_id,
+    GpuMaterial const& material
+) noexcept {
+    core_assert(material_id < _materials.size(), "Invalid material ID.");
 
-    if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
-        Log::error("Shader compilation failed: ", result.GetErrorMessage());
-        return {};
+    _materials[material_id] = material;
+    ++_materials_version;
+}
+
+void
+VulkanRenderer::_create_default_material() noexcept {
+    std::optional<u32> const texture =
+        _register_bindless_texture(*_texture_image_view);
+    std::optional<u32> const sampler =
+        _register_bindless_sampler(*_texture_sampler);
+    core_assert(
+        texture && sampler,
+        "The default material takes the first bindless slots."
+    );
+
+    _texture_slot = texture.value_or(0);
+    _default_material = _add_material({
+        .albedo_texture = _texture_slot,
+        .sampler = sampler.value_or(0),
+    });
+}
+
+void
+VulkanRenderer::_create_material_buffers() noexcept {
+    constexpr vk::DeviceSize buffer_size =
+        sizeof(GpuMaterial) * s_max_materials;
+
+    _material_buffers.resize(_frames_in_flight);
+    _material_buffers_memory.resize(_frames_in_flight);
+    _material_buffers_mapped.resize(_frames_in_flight);
+
+    for (usize i {}; i < _frames_in_flight; ++i) {
+        _create_buffer_unique(
+            buffer_size,
+            vk::BufferUsageFlagBits::eStorageBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible |
+                vk::MemoryPropertyFlagBits::eHostCoherent,
+            _material_buffers[i],
+            _material_buffers_memory[i]
+        );
+
+        _material_buffers_mapped[i] = vk_expect_value(
+            // Persistent mapping.
+            _device->mapMemory(*_material_buffers_memory[i], 0, buffer_size),
+            "Failed to map memory for material buffer."
+        );
     }
+}
 
-    std::vector<u32> spirv(result.begin(), result.end());
-    Log::info("Shader compiled successfully.");
+void
+VulkanRenderer::_upload_materials() noexcept {
+    u64& buffer_version = _material_buffer_versions[_current_frame];
 
-    // Imprimir algunos bytes para depuración
-    for (usize i = 0; i < std::min<usize>(spirv.size(), 10); ++i) {
-        Log::info("SPIR-V byte: ", spirv[i]);
+    if (buffer_version == _materials_version) {
+        return;
     }
 
-    return spirv;
+    std::memcpy(
+        _material_buffers_mapped[_current_frame],
+        _materials.data(),
+        _materials.size() * sizeof(GpuMaterial)
+    );
+
+    buffer_version = _materials_version;
+}
+
+#pragma endregion BINDLESS
+
+#pragma region SHADERS
+
+ShaderVariantId
+VulkanRenderer::_compute_shader_variant(
+    std::string_view path,
+    std::span<std::string const> keywords
+) noexcept {
+    MappedAsset const source = AssetDatabase::map_asset_file(path);
+    u64 const shader_source = _shader_variants.add_source(
+        AssetDatabase::absolute_path(path).string(),
+        source.text(),
+        shaderc_shader_kind::shaderc_compute_shader
+    );
+
+    return _shader_variants.request(shader_source, keywords);
+}
+
+ShaderReflection
+VulkanRenderer::_reflect_shader(ShaderVariantId variant) noexcept {
+    std::optional<ShaderReflection> reflection =
+        reflect_spirv(_shader_variants.spirv(variant));
+    core_assert(reflection, "Failed to compile or reflect a shader.");
+
+    return std::move(reflection).value_or(ShaderReflection {});
 }
 
 #pragma endregion
@@ -1070,7 +2073,7 @@ VulkanRenderer::_compile_shader_to_spirv(
 vk::UniqueShaderModule
 _create_shader_module(
     vk::UniqueDevice const& logical_device,
-    std::vector<u32> const& spirv_code
+    std::span<u32 const> spirv_code
 ) {
     vk::ShaderModuleCreateInfo const shader_module_info {
         .codeSize = spirv_code.size() * sizeof(u32), // in bytes.
@@ -1085,6 +2088,14 @@ _create_shader_module(
 
 void
 VulkanRenderer::_create_render_pass() noexcept {
+    // Also the format of the pipelines and of the depth image.
+    _depth_format = _find_depth_format(_physical_device);
+
+    // Attachments are given when rendering begins instead.
+    if (_dynamic_rendering) {
+        return;
+    }
+
     vk::AttachmentDescription const color_attachment {
         .format = _swap_chain_image_format,
         .samples = _msaa_samples,
@@ -1096,20 +2107,23 @@ VulkanRenderer::_create_render_pass() noexcept {
         .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
         .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
 
-        // We don't care how images come, we'll clear them anyway.
-        .initialLayout = vk::ImageLayout::eUndefined,
-        // Since this is a multi-sampled image, it cannot be presented.
+        // Layouts are the frame graph's business: every attachment comes
+        // and stays in the layout the subpass uses, its barriers
+        // transition them before and after the pass.
+        .initialLayout = vk::ImageLayout::eColorAttachmentOptimal,
         .finalLayout = vk::ImageLayout::eColorAttachmentOptimal,
     };
 
     vk::AttachmentDescription const depth_attachment {
-        .format = _find_depth_format(_physical_device),
+        .format = _depth_format,
         .samples = _msaa_samples,
         .loadOp = vk::AttachmentLoadOp::eClear, // Clear on load.
-        .storeOp = vk::AttachmentStoreOp::eDontCare,
+        // Occlusion culling builds the depth pyramid from it.
+        .storeOp = _occlusion_culling ? vk::AttachmentStoreOp::eStore
+                                      : vk::AttachmentStoreOp::eDontCare,
         .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
         .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
-        .initialLayout = vk::ImageLayout::eUndefined,
+        .initialLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
         .finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
     };
 
@@ -1121,8 +2135,9 @@ VulkanRenderer::_create_render_pass() noexcept {
         .storeOp = vk::AttachmentStoreOp::eStore,
         .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
         .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
-        .initialLayout = vk::ImageLayout::eUndefined,
-        .finalLayout = vk::ImageLayout::ePresentSrcKHR,
+        // Presented (or copied to the host) after a graph barrier.
+        .initialLayout = vk::ImageLayout::eColorAttachmentOptimal,
+        .finalLayout = vk::ImageLayout::eColorAttachmentOptimal,
     };
 
     constexpr vk::AttachmentReference color_attachment_ref {
@@ -1149,24 +2164,11 @@ VulkanRenderer::_create_render_pass() noexcept {
         .pDepthStencilAttachment = &depth_attachment_ref,
     };
 
-    constexpr vk::SubpassDependency subpass_dependency {
-        // SubpassExternal: Implicit subpass before or after the render pass.
-        .srcSubpass = vk::SubpassExternal,
-        .dstSubpass = 0,
-
-        // Wait for this operations to occur.
-        .srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput |
-            vk::PipelineStageFlagBits::eLateFragmentTests,
-        .dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput |
-            vk::PipelineStageFlagBits::eEarlyFragmentTests,
-        .srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite |
-            vk::AccessFlagBits::eDepthStencilAttachmentWrite,
-        .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite |
-            vk::AccessFlagBits::eDepthStencilAttachmentWrite
-    };
+    // No subpass dependencies: the frame graph's barriers before and after
+    // the pass order it with the rest of the frame.
 
     // Clear values should match this order also.
-    std::array const attachments =
+    std::array attachments =
         {color_attachment, depth_attachment, color_attachment_resolve};
 
     vk::RenderPassCreateInfo const render_pass_info {
@@ -1174,38 +2176,280 @@ VulkanRenderer::_create_render_pass() noexcept {
         .pAttachments = attachments.data(),
         .subpassCount = 1,
         .pSubpasses = &subpass,
-        .dependencyCount = 1,
-        .pDependencies = &subpass_dependency,
     };
 
     _render_pass = vk_expect_value(
         _device->createRenderPassUnique(render_pass_info),
         "Failed to create Render Pass"
     );
+
+    if (!_occlusion_culling) {
+        return;
+    }
+
+    // Late pass: continues the early one. Only load and store operations
+    // differ, so both passes are compatible and share framebuffers and
+    // pipelines. The early pass also resolves, the late resolve
+    // overwrites it.
+    attachments[0].loadOp = vk::AttachmentLoadOp::eLoad;
+    attachments[1].loadOp = vk::AttachmentLoadOp::eLoad;
+    attachments[1].storeOp = vk::AttachmentStoreOp::eDontCare;
+
+    _late_render_pass = vk_expect_value(
+        _device->createRenderPassUnique(render_pass_info),
+        "Failed to create late Render Pass"
+    );
 }
 
 void
 VulkanRenderer::_create_graphics_pipeline() noexcept {
     Log::header("Creating Graphics Pipeline.");
 
-    // Set up shaders.
-    Log::sub_info("Size: ", _default_vertex_shader_spirv.size());
-    Log::sub_info("Size: ", _default_fragment_shader_spirv.size());
+    // Pipeline Layout.
+    // Set 0: per frame (uniform buffer object, materials).
+    // Set 1: bindless textures and samplers.
+    std::array const set_layouts = {
+        _descriptor_set_layout,
+        _bindless_set_layout,
+    };
+
+    core_assert(
+        _graphics_layout.push_constant_size == sizeof(DrawPushConstants),
+        "DrawPushConstants must match the default shaders."
+    );
+
+    _draw_push_constant_stages =
+        _to_shader_stages(_graphics_layout.push_constant_stages);
+    _pipeline_Layout = _pipeline_layout_for(set_layouts, _graphics_layout);
+
+    Log::info("Pipeline layout created.");
+
+    // Shared by every pipeline, the driver reuses what it compiled.
+    _driver_pipeline_cache = vk_expect_value(
+        _device->createPipelineCacheUnique({}),
+        "Failed to create pipeline cache."
+    );
+
+    // Everything the builder reads is set by now and never changes.
+    u32 const worker_count =
+        std::clamp(std::thread::hardware_concurrency() / 2, 1U, 4U);
+
+    _pipeline_cache.start(
+        [this](PipelineKey const& key) {
+            return _build_graphics_pipeline(key);
+        },
+        worker_count
+    );
+
+    // Compiled here, the first frame draws with it.
+    _fallback_pipeline_key = _default_pipeline_key();
+    vk::Pipeline const fallback =
+        _pipeline_cache.find_now(_fallback_pipeline_key);
+    core_assert(fallback, "Failed to create Graphics Pipeline");
+
+    Log::info(Log::LIGHT_GREEN, "Graphics Pipeline successfully created.");
+}
+
+void
+VulkanRenderer::_request_shader_variants(
+    MaterialPipeline& pipeline
+) noexcept {
+    pipeline.vertex_shader = _shader_variants.request(
+        _vertex_shader_source,
+        pipeline.shader_keywords
+    );
+    pipeline.fragment_shader = _shader_variants.request(
+        _fragment_shader_source,
+        pipeline.shader_keywords
+    );
+}
+
+PipelineKey
+VulkanRenderer::_pipeline_key(
+    MaterialPipeline const& pipeline
+) const noexcept {
+    return {
+        .vertex_shader = pipeline.vertex_shader,
+        .fragment_shader = pipeline.fragment_shader,
+        .gpu_driven = _gpu_culling,
+        .state = pipeline.state,
+        .color_format = _swap_chain_image_format,
+        .depth_format = _depth_format,
+        .samples = _msaa_samples,
+    };
+}
+
+PipelineKey
+VulkanRenderer::_default_pipeline_key() noexcept {
+    MaterialPipeline pipeline {};
+    _request_shader_variants(pipeline);
+
+    return _pipeline_key(pipeline);
+}
+
+vk::Pipeline
+VulkanRenderer::_graphics_pipeline_for(u32 material_id) noexcept {
+    MaterialPipeline const& material = _material_pipelines[material_id];
+
+    if (vk::Pipeline const pipeline =
+            _pipeline_cache.find(_pipeline_key(material))) {
+        return pipeline;
+    }
+
+    // Keeps its own state while its reloaded shaders compile.
+    if (material.previous_key) {
+        if (vk::Pipeline const pipeline =
+                _pipeline_cache.find(*material.previous_key)) {
+            return pipeline;
+        }
+    }
+
+    return _pipeline_cache.find(_fallback_pipeline_key);
+}
+
+bool
+VulkanRenderer::_shares_default_pipeline(u32 material_id) const noexcept {
+    MaterialPipeline const& material = _material_pipelines[material_id];
+    MaterialPipeline const& fallback = _material_pipelines[_default_material];
+
+    return material.state == fallback.state &&
+        material.shader_keywords == fallback.shader_keywords;
+}
+
+void
+VulkanRenderer::_retire_unused_pipeline(PipelineKey const& key) noexcept {
+    bool const in_use = key == _fallback_pipeline_key ||
+        std::ranges::any_of(
+            _material_pipelines,
+            [&](MaterialPipeline const& pipeline) {
+                return pipeline.previous_key == key ||
+                    _pipeline_key(pipeline) == key;
+            }
+        );
+
+    if (!in_use) {
+        _retire(_pipeline_cache.take(key));
+    }
+}
+
+vk::Format
+_to_vertex_format(ShaderVertexInput const& input) noexcept {
+    constexpr std::array s_float_formats {
+        vk::Format::eR32Sfloat,
+        vk::Format::eR32G32Sfloat,
+        vk::Format::eR32G32B32Sfloat,
+        vk::Format::eR32G32B32A32Sfloat,
+    };
+    constexpr std::array s_int_formats {
+        vk::Format::eR32Sint,
+        vk::Format::eR32G32Sint,
+        vk::Format::eR32G32B32Sint,
+        vk::Format::eR32G32B32A32Sint,
+    };
+    constexpr std::array s_uint_formats {
+        vk::Format::eR32Uint,
+        vk::Format::eR32G32Uint,
+        vk::Format::eR32G32B32Uint,
+        vk::Format::eR32G32B32A32Uint,
+    };
+
+    if (input.component_count == 0 || input.component_count > 4) {
+        return vk::Format::eUndefined;
+    }
+
+    usize const index = input.component_count - 1;
+
+    switch (input.type) {
+        case ShaderScalarType::Float:
+            return s_float_formats[index];
+        case ShaderScalarType::Int:
+            return s_int_formats[index];
+        case ShaderScalarType::Uint:
+            return s_uint_formats[index];
+    }
 
+    return vk::Format::eUndefined;
+}
+
+vk::UniquePipeline
+VulkanRenderer::_build_graphics_pipeline(PipelineKey const& key) noexcept {
+    std::span<u32 const> const vertex_spirv =
+        _shader_variants.spirv(key.vertex_shader);
+    std::span<u32 const> const fragment_spirv =
+        _shader_variants.spirv(key.fragment_shader);
+
+    // The variant cache logged why.
+    if (vertex_spirv.empty() || fragment_spirv.empty()) {
+        return vk::UniquePipeline {nullptr};
+    }
+
+    std::optional<ShaderReflection> const vertex_reflection =
+        reflect_spirv(vertex_spirv);
+    std::optional<ShaderReflection> const fragment_reflection =
+        reflect_spirv(fragment_spirv);
+
+    // Descriptor sets are bound once for every pipeline.
+    if (!vertex_reflection || !fragment_reflection ||
+        !fits_shader_layout(*vertex_reflection, _graphics_layout) ||
+        !fits_shader_layout(*fragment_reflection, _graphics_layout)) {
+        Log::warn("Shader variant doesn't fit the graphics pipeline layout.");
+        return vk::UniquePipeline {nullptr};
+    }
+
+    // The attributes the vertex shader reads, the buffer layout is Vertex.
+    constexpr auto binding_description = Vertex::binding_description();
+    constexpr auto vertex_attributes = Vertex::attribute_description();
+    std::vector<vk::VertexInputAttributeDescription> attribute_descriptions {};
+
+    for (ShaderVertexInput const& input : vertex_reflection->vertex_inputs) {
+        auto const attribute = std::ranges::find(
+            vertex_attributes,
+            input.location,
+            &vk::VertexInputAttributeDescription::location
+        );
+
+        if (attribute == vertex_attributes.end() ||
+            attribute->format != _to_vertex_format(input)) {
+            Log::warn(
+                "Vertex has no attribute matching vertex shader location ",
+                input.location,
+                "."
+            );
+            return vk::UniquePipeline {nullptr};
+        }
+
+        attribute_descriptions.push_back(*attribute);
+    }
+
+    // Set up shaders.
     vk::UniqueShaderModule vert_shader_module =
-        _create_shader_module(_device, _default_vertex_shader_spirv);
-    Log::info("Vertex shader module created.");
+        _create_shader_module(_device, vertex_spirv);
 
     vk::UniqueShaderModule frag_shader_module =
-        _create_shader_module(_device, _default_fragment_shader_spirv);
-    Log::info("Fragment shader module created.");
+        _create_shader_module(_device, fragment_spirv);
+
+    // layout(constant_id = 0) const bool GPU_DRIVEN.
+    vk::Bool32 const gpu_driven = key.gpu_driven ? vk::True : vk::False;
+
+    constexpr vk::SpecializationMapEntry gpu_driven_entry {
+        .constantID = 0,
+        .offset = 0,
+        .size = sizeof(vk::Bool32),
+    };
+
+    vk::SpecializationInfo const vertex_specialization_info {
+        .mapEntryCount = 1,
+        .pMapEntries = &gpu_driven_entry,
+        .dataSize = sizeof(gpu_driven),
+        .pData = &gpu_driven,
+    };
 
     // Create Render Pipeline.
     vk::PipelineShaderStageCreateInfo const vertex_shader_stage_info {
         .stage = vk::ShaderStageFlagBits::eVertex,
         .module = *vert_shader_module,
         .pName = "main", // Vertex shader code entry point.
-        .pSpecializationInfo = nullptr, // We'll see later.
+        .pSpecializationInfo = &vertex_specialization_info,
     };
 
     vk::PipelineShaderStageCreateInfo const fragment_shader_stage_info {
@@ -1220,9 +2464,6 @@ VulkanRenderer::_create_graphics_pipeline() noexcept {
         fragment_shader_stage_info,
     };
 
-    constexpr auto binding_description = Vertex::binding_description();
-    constexpr auto attribute_descriptions = Vertex::attribute_description();
-
     vk::PipelineVertexInputStateCreateInfo const vertex_input_info {
         .vertexBindingDescriptionCount = 1,
         .pVertexBindingDescriptions = &binding_description,
@@ -1236,23 +2477,6 @@ VulkanRenderer::_create_graphics_pipeline() noexcept {
         .primitiveRestartEnable = vk::False,
     };
 
-    // Viewports define the transformations from vk::Image to framebuffer.
-    vk::Viewport viewport {
-        .x = 0.0f,
-        .y = 0.0f,
-        .width = static_cast<f32>(_swap_chain_extent.width),
-        .height = static_cast<f32>(_swap_chain_extent.height),
-        .minDepth = 0.0f,
-        .maxDepth = 1.0f,
-    };
-
-    // Difference between Viewport and Scissor:
-    // src: https://docs.vulkan.org/tutorial/latest/03_Drawing_a_triangle/02_Graphics_pipeline_basics/02_Fixed_functions.html#:~:text=than%20the%20viewport.-,viewports%20scissors,-So%20if%20we
-    vk::Rect2D scissor {
-        .offset = {0, 0},
-        .extent = _swap_chain_extent,
-    };
-
     // Pipelines are "immutable", but some part might be modifiable at draw time,
     // Although this requires explicit implementation.
     constexpr std::array dynamic_pipeline_states = {
@@ -1265,20 +2489,25 @@ VulkanRenderer::_create_graphics_pipeline() noexcept {
         .pDynamicStates = dynamic_pipeline_states.data(),
     };
 
-    vk::PipelineViewportStateCreateInfo const viewport_state_info {
+    // Viewports define the transformations from vk::Image to framebuffer.
+    // Both are dynamic, set when recording (the extent changes with the
+    // swap chain, pipelines don't).
+    // Difference between Viewport and Scissor:
+    // src: https://docs.vulkan.org/tutorial/latest/03_Drawing_a_triangle/02_Graphics_pipeline_basics/02_Fixed_functions.html#:~:text=than%20the%20viewport.-,viewports%20scissors,-So%20if%20we
+    constexpr vk::PipelineViewportStateCreateInfo viewport_state_info {
         .viewportCount = 1,
-        .pViewports = &viewport,
+        .pViewports = nullptr,
         .scissorCount = 1,
-        .pScissors = &scissor,
+        .pScissors = nullptr,
     };
 
     // Rasterizer.
-    constexpr vk::PipelineRasterizationStateCreateInfo rasterizer_info {
+    vk::PipelineRasterizationStateCreateInfo const rasterizer_info {
         .depthClampEnable = vk::False, // Discard fragments beyond near/far.
         .rasterizerDiscardEnable = vk::False, // Geometry is rasterized lol.
         .polygonMode = vk::PolygonMode::eFill, // Fill polygons with fragments.
         // Culling.
-        .cullMode = vk::CullModeFlagBits::eBack,
+        .cullMode = key.state.cull_mode,
         .frontFace = vk::FrontFace::eCounterClockwise,
         // Depth.
         .depthBiasEnable = vk::False,
@@ -1290,7 +2519,7 @@ VulkanRenderer::_create_graphics_pipeline() noexcept {
 
     // Multi-sample. ((e.g: for anti-alising)).
     vk::PipelineMultisampleStateCreateInfo const multi_sampling_info {
-        .rasterizationSamples = _msaa_samples,
+        .rasterizationSamples = key.samples,
         .sampleShadingEnable = vk::True,
         .minSampleShading = 0.2f,
         .pSampleMask = nullptr, // Optional.
@@ -1299,17 +2528,17 @@ VulkanRenderer::_create_graphics_pipeline() noexcept {
     };
 
     // Enable Depth and Stencil.
-    constexpr vk::PipelineDepthStencilStateCreateInfo depth_stencil_info {
+    vk::PipelineDepthStencilStateCreateInfo const depth_stencil_info {
         // The depth of new fragments should be compared to the depth buffer
         // to determine if they should be discarded.
-        .depthTestEnable = vk::True,
+        .depthTestEnable = key.state.depth_test ? vk::True : vk::False,
         // The new depth of fragments that pass the depth test shoubld be
         // written to the depth buffer.
-        .depthWriteEnable = vk::True,
+        .depthWriteEnable = key.state.depth_write ? vk::True : vk::False,
         // Lower depth = closer to the "camera".
         // The depth of the fragments should be less than the other
         // to pass the depth test and not be discarded.
-        .depthCompareOp = vk::CompareOp::eLess,
+        .depthCompareOp = key.state.depth_compare,
         // Stencil Test (WIP).
 
         // Optional depth bound and stencil test.
@@ -1338,12 +2567,19 @@ VulkanRenderer::_create_graphics_pipeline() noexcept {
         finalColor.rgb = newAlpha * newColor + (1 - newAlpha) * oldColor;
         finalColor.a = newAlpha.a;
     */
-    constexpr vk::PipelineColorBlendAttachmentState color_blend_attachment {
-        .blendEnable = vk::False,
-
-        .srcColorBlendFactor = vk::BlendFactor::eSrcAlpha, // Optional.
-        .dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha, // Optional.
-        .colorBlendOp = vk::BlendOp::eAdd, // Optional.
+    bool const additive =
+        key.state.blend_mode == PipelineBlendMode::Additive;
+
+    vk::PipelineColorBlendAttachmentState const color_blend_attachment {
+        .blendEnable = key.state.blend_mode != PipelineBlendMode::Opaque
+            ? vk::True
+            : vk::False,
+
+        .srcColorBlendFactor = additive ? vk::BlendFactor::eOne
+                                        : vk::BlendFactor::eSrcAlpha,
+        .dstColorBlendFactor = additive ? vk::BlendFactor::eOne
+                                        : vk::BlendFactor::eOneMinusSrcAlpha,
+        .colorBlendOp = vk::BlendOp::eAdd,
         .srcAlphaBlendFactor = vk::BlendFactor::eOne, // Optional.
         .dstAlphaBlendFactor = vk::BlendFactor::eZero, // Optional.
         .alphaBlendOp = vk::BlendOp::eAdd, // Optional.
@@ -1366,24 +2602,17 @@ VulkanRenderer::_create_graphics_pipeline() noexcept {
     color_blending.blendConstants[2] = 0.0f; // Optional.
     color_blending.blendConstants[3] = 0.0f; // Optional.
 
-    // Pipeline Layout.
-    vk::PipelineLayoutCreateInfo const pipeline_layout_info {
-        // Uniform buffer object.
-        .setLayoutCount = 1,
-        .pSetLayouts = &(*_descriptor_set_layout),
-        .pushConstantRangeCount = 0, // Optional.
-        .pPushConstantRanges = nullptr, // Optional.
+    // Dynamic rendering: the attachment formats replace the render pass,
+    // the same ones as its attachments (resolve included).
+    vk::PipelineRenderingCreateInfo const rendering_info {
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &key.color_format,
+        .depthAttachmentFormat = key.depth_format,
     };
 
-    _pipeline_Layout = vk_expect_value(
-        _device->createPipelineLayoutUnique(pipeline_layout_info),
-        "Failed to create pipeline layout."
-    );
-
-    Log::info("Pipeline layout created.");
-
     // FINALLY... IT'S ALIVE!!! THE RENDER PIPELINE!!!
     vk::GraphicsPipelineCreateInfo const graphics_pipeline_info {
+        .pNext = _dynamic_rendering ? &rendering_info : nullptr,
         // Shader stages.
         .stageCount = 2, // Vertex and fragment.
         .pStages = shader_stages.data(),
@@ -1399,9 +2628,9 @@ VulkanRenderer::_create_graphics_pipeline() noexcept {
         .pDynamicState = &dynamic_state_info,
 
         // Pipeline layout.
-        .layout = *_pipeline_Layout,
+        .layout = _pipeline_Layout,
 
-        // Render pass.
+        // Render pass, none with dynamic rendering (see pNext).
         .renderPass = *_render_pass,
         .subpass = 0, // Index of the sub-pass, there is one so: zero.
 
@@ -1410,23 +2639,105 @@ VulkanRenderer::_create_graphics_pipeline() noexcept {
         .basePipelineIndex = -1, // Optional.
     };
 
-    _graphics_pipeline = vk_expect_value(
-        _device->createGraphicsPipelineUnique(nullptr, graphics_pipeline_info),
-        "Failed to create Graphics Pipeline"
+    // Runs on the pipeline cache workers: a failure is theirs to report.
+    auto result = _device->createGraphicsPipelineUnique(
+        *_driver_pipeline_cache,
+        graphics_pipeline_info
     );
 
-    Log::info(Log::LIGHT_GREEN, "Graphics Pipeline successfully created.");
-}
-
-#pragma endregion
+    if (result.result != s_success) {
+        return vk::UniquePipeline {nullptr};
+    }
 
-#pragma region FRAMEBUFFERS
+    return std::move(result.value);
+}
 
 void
-VulkanRenderer::_create_framebuffers() noexcept {
-    _swap_chain_framebuffers.resize(_swap_chain_image_views.size());
+VulkanRenderer::_create_cull_pipeline() noexcept {
+    if (!_gpu_culling) {
+        return;
+    }
 
-    for (usize i {}; i < _swap_chain_image_views.size(); ++i) {
+    vk::UniqueShaderModule cull_shader_module =
+        _create_shader_module(_device, _shader_variants.spirv(_cull_shader));
+
+    core_assert(
+        _cull_layout.push_constant_size == sizeof(CullPushConstants),
+        "CullPushConstants must match the cull shaders."
+    );
+
+    // Same set 0 as the graphics pipeline, bound to the compute point.
+    _cull_pipeline_layout =
+        _pipeline_layout_for({&_descriptor_set_layout, 1}, _cull_layout);
+
+    vk::ComputePipelineCreateInfo const cull_pipeline_info {
+        .stage =
+            {
+                .stage = vk::ShaderStageFlagBits::eCompute,
+                .module = *cull_shader_module,
+                .pName = "main",
+            },
+        .layout = _cull_pipeline_layout,
+    };
+
+    _cull_pipeline = vk_expect_value(
+        _device->createComputePipelineUnique(nullptr, cull_pipeline_info),
+        "Failed to create Cull Pipeline"
+    );
+
+    Log::info(Log::LIGHT_GREEN, "Cull Pipeline successfully created.");
+}
+
+void
+VulkanRenderer::_create_cluster_cull_pipeline() noexcept {
+    if (!_gpu_culling) {
+        return;
+    }
+
+    vk::UniqueShaderModule cluster_cull_shader_module = _create_shader_module(
+        _device,
+        _shader_variants.spirv(_cluster_cull_shader)
+    );
+
+    // Same set and push constants as the cull pipeline.
+    vk::ComputePipelineCreateInfo const cluster_cull_pipeline_info {
+        .stage =
+            {
+                .stage = vk::ShaderStageFlagBits::eCompute,
+                .module = *cluster_cull_shader_module,
+                .pName = "main",
+            },
+        .layout = _cull_pipeline_layout,
+    };
+
+    _cluster_cull_pipeline = vk_expect_value(
+        _device->createComputePipelineUnique(
+            nullptr,
+            cluster_cull_pipeline_info
+        ),
+        "Failed to create Cluster Cull Pipeline"
+    );
+
+    Log::info(
+        Log::LIGHT_GREEN,
+        "Cluster Cull Pipeline successfully created."
+    );
+}
+
+#pragma endregion
+
+#pragma region FRAMEBUFFERS
+
+void
+VulkanRenderer::_create_framebuffers() noexcept {
+    // Image views are given when rendering begins instead.
+    if (_dynamic_rendering) {
+        return;
+    }
+
+    _swap_chain_framebuffers.resize(_swap_chain_image_views.size());
+
+    for (usize i {}; i < _swap_chain_image_views.size(); ++i) {
         std::array const attachments = {
             *_color_image_view,
             *_depth_image_view,
@@ -1483,9 +2794,21 @@ VulkanRenderer::_end_single_time_commands(vk::CommandBuffer& command_buffer
 ) noexcept {
     vk_expect(command_buffer.end(), "Failed to end single time cmd buffer.");
 
+    // Uploads are ordered after each other by submission order and their
+    // own barriers, frames order themselves after them on _timeline.
+    u64 const signal_value = ++_timeline_value;
+
+    vk::TimelineSemaphoreSubmitInfo const timeline_info {
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues = &signal_value,
+    };
+
     vk::SubmitInfo const submit_info {
+        .pNext = &timeline_info,
         .commandBufferCount = 1,
         .pCommandBuffers = &command_buffer,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &_timeline.get(),
     };
 
     vk_expect(
@@ -1493,9 +2816,15 @@ VulkanRenderer::_end_single_time_commands(vk::CommandBuffer& command_buffer
         "Failed to submit cmd buffer to graphics queue."
     );
 
-    vk_expect(_graphics_queue.waitIdle(), "Failed to wait graphics queue.");
+    _upload_value = _timeline_value;
 
-    _device->freeCommandBuffers(*_command_pool, command_buffer);
+    // Freed through the deletion queue like any other resource.
+    _deletion_queue.defer(
+        _upload_value,
+        [device = *_device, pool = *_command_pool, command_buffer] {
+            device.freeCommandBuffers(pool, command_buffer);
+        }
+    );
 }
 
 void
@@ -1506,8 +2835,9 @@ VulkanRenderer::_create_command_pool() noexcept {
         _find_queue_families(_physical_device, _surface);
 
     vk::CommandPoolCreateInfo const cmd_pool_info {
-        // Allow command buffers to be re-recorded individually.
-        .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+        // Only single time (upload) commands, freed once executed.
+        // Per-frame commands come from _frame_command_pools.
+        .flags = vk::CommandPoolCreateFlagBits::eTransient,
         // We'll record graphics commands and submit them to the respective queue.
         .queueFamilyIndex = queue_family_indices.graphics_family.value(),
     };
@@ -1521,33 +2851,81 @@ VulkanRenderer::_create_command_pool() noexcept {
 }
 
 void
-VulkanRenderer::_create_command_buffers() noexcept {
-    Log::header("Creating Command Buffer.");
+VulkanRenderer::_create_frame_command_pools() noexcept {
+    Log::header("Creating Frame Command Pools.");
 
-    vk::CommandBufferAllocateInfo cmd_alloc_info {
-        .commandPool = *_command_pool,
-        // Primary: Can be submitted to queues, but not called from other cmd buffers.
-        // Secondary: Cannot be submitted to queues, but can be call from a primery cmd buffer.
-        .level = vk::CommandBufferLevel::ePrimary,
-        .commandBufferCount = static_cast<u32>(_command_buffers.size()),
+    QueueFamilyIndices const queue_family_indices =
+        _find_queue_families(_physical_device, _surface);
+
+    vk::CommandPoolCreateInfo const cmd_pool_info {
+        // Short lived buffers, the pool is reset as a whole every frame.
+        .flags = vk::CommandPoolCreateFlagBits::eTransient,
+        .queueFamilyIndex = queue_family_indices.graphics_family.value(),
     };
 
-    auto cmd_buffers = vk_expect_value(
-        _device->allocateCommandBuffersUnique(cmd_alloc_info),
-        "Failed to allocate Command Buffer."
-    );
+    _frame_command_pools.resize(_frames_in_flight);
 
-    core_assert(
-        _command_buffers.size() == cmd_buffers.size(),
-        "Requested command buffers have different size than storage."
+    for (FrameCommandPool& frame_pool : _frame_command_pools) {
+        frame_pool.pool = vk_expect_value(
+            _device->createCommandPoolUnique(cmd_pool_info),
+            "Failed to create Frame Cmd Pool."
+        );
+    }
+
+    Log::info(Log::LIGHT_GREEN, "Frame Command Pools successfully created.");
+}
+
+void
+VulkanRenderer::_reset_frame_command_pool() noexcept {
+    FrameCommandPool& frame_pool = _frame_command_pools[_current_frame];
+
+    // One call instead of resetting each buffer, keeps the memory around.
+    vk_expect(
+        _device->resetCommandPool(*frame_pool.pool),
+        "Failed to reset frame cmd pool."
     );
 
-    std::move(cmd_buffers.begin(), cmd_buffers.end(), _command_buffers.begin());
-    Log::info(Log::LIGHT_GREEN, "Command Buffers successfully created.");
+    frame_pool.primary_used = 0;
+    frame_pool.secondary_used = 0;
+}
+
+vk::CommandBuffer
+VulkanRenderer::_allocate_frame_command_buffer(vk::CommandBufferLevel level
+) noexcept {
+    FrameCommandPool& frame_pool = _frame_command_pools[_current_frame];
+
+    bool const primary = level == vk::CommandBufferLevel::ePrimary;
+    std::vector<vk::CommandBuffer>& buffers =
+        primary ? frame_pool.primary : frame_pool.secondary;
+    usize& used = primary ? frame_pool.primary_used : frame_pool.secondary_used;
+
+    // Buffers allocated in earlier frames are reused, a new one is only
+    // allocated the first time this many are needed in a frame.
+    if (used == buffers.size()) {
+        vk::CommandBufferAllocateInfo const cmd_alloc_info {
+            .commandPool = *frame_pool.pool,
+            // Primary: Can be submitted to queues, but not called from other cmd buffers.
+            // Secondary: Cannot be submitted to queues, but can be call from a primery cmd buffer.
+            .level = level,
+            .commandBufferCount = 1,
+        };
+
+        auto const cmd_buffers = vk_expect_value(
+            _device->allocateCommandBuffers(cmd_alloc_info),
+            "Failed to allocate Command Buffer."
+        );
+
+        buffers.push_back(cmd_buffers[0]);
+    }
+
+    return buffers[used++];
 }
 
 void
-VulkanRenderer::_record_command_buffer(u32 image_index) noexcept {
+VulkanRenderer::_record_command_buffer(
+    vk::CommandBuffer command_buffer,
+    u32 image_index
+) noexcept {
     constexpr vk::CommandBufferBeginInfo begin_info {
         // Possible Flags:
         // vk::CommandBufferUsageFlagBits::eOneTimeSubmit
@@ -1556,17 +2934,514 @@ VulkanRenderer::_record_command_buffer(u32 image_index) noexcept {
         //      -> used for secondary cmd buffers.
         // vk::CommandBufferUsageFlagBits::eSimultaneousUse
         //      -> cmd buffer can be re-submitted while execution is pending.
-        .flags = {}, // Optional.
+        // Recorded from a freshly reset pool every frame.
+        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
 
         // Used for secondary cmd buffers, they can inherit state from primary cmds.
         .pInheritanceInfo = nullptr, // Optional.
     };
 
-    vk_expect(
-        _command_buffers[_current_frame]->begin(begin_info),
-        "Failed to begin cmd record"
+    vk_expect(command_buffer.begin(begin_info), "Failed to begin cmd record");
+
+    // A handful of passes, rebuilt every frame: what runs depends on the
+    // settings and on the frame (capture), compiling is cheap.
+    RenderGraph graph {};
+    _build_frame_graph(graph, command_buffer, image_index);
+
+    graph.execute(
+        graph.compile(),
+        [&](std::span<RenderGraphBarrier const> barriers) {
+            _record_graph_barriers(command_buffer, graph, barriers);
+        }
+    );
+
+    vk_expect(command_buffer.end(), "Failed to record cmd buffer.");
+}
+
+// Pipeline stages and access types of the frame graph's usages.
+struct UsageSync {
+    vk::PipelineStageFlags stages {};
+    vk::AccessFlags reads {};
+    vk::AccessFlags writes {};
+};
+
+constexpr UsageSync
+_usage_sync(RenderGraphUsage usage) noexcept {
+    using Stage = vk::PipelineStageFlagBits;
+    using Access = vk::AccessFlagBits;
+
+    switch (usage) {
+        case RenderGraphUsage::ColorAttachment:
+            return {
+                .stages = Stage::eColorAttachmentOutput,
+                .reads = Access::eColorAttachmentRead,
+                .writes = Access::eColorAttachmentWrite,
+            };
+        case RenderGraphUsage::DepthAttachment:
+            // Tested early, written late.
+            return {
+                .stages =
+                    Stage::eEarlyFragmentTests | Stage::eLateFragmentTests,
+                .reads = Access::eDepthStencilAttachmentRead,
+                .writes = Access::eDepthStencilAttachmentWrite,
+            };
+        case RenderGraphUsage::ComputeSampled:
+            return {
+                .stages = Stage::eComputeShader,
+                .reads = Access::eShaderRead,
+            };
+        case RenderGraphUsage::ComputeStorage:
+            return {
+                .stages = Stage::eComputeShader,
+                .reads = Access::eShaderRead,
+                .writes = Access::eShaderWrite,
+            };
+        case RenderGraphUsage::IndirectArguments:
+            return {
+                .stages = Stage::eDrawIndirect,
+                .reads = Access::eIndirectCommandRead,
+            };
+        case RenderGraphUsage::Transfer:
+            return {
+                .stages = Stage::eTransfer,
+                .reads = Access::eTransferRead,
+                .writes = Access::eTransferWrite,
+            };
+        case RenderGraphUsage::Present:
+            // Waits on a semaphore, only the layout matters.
+            return {.stages = Stage::eBottomOfPipe};
+    }
+
+    return {};
+}
+
+vk::PipelineStageFlags
+_usage_stages(RenderGraphUsageMask usages) noexcept {
+    vk::PipelineStageFlags stages {};
+
+    for (u32 bit {}; usages >> bit != 0; ++bit) {
+        if ((usages >> bit & 1) != 0) {
+            stages |= _usage_sync(static_cast<RenderGraphUsage>(bit)).stages;
+        }
+    }
+
+    return stages;
+}
+
+vk::AccessFlags
+_usage_access(
+    RenderGraphUsageMask reads,
+    RenderGraphUsageMask writes
+) noexcept {
+    vk::AccessFlags access {};
+
+    for (u32 bit {}; (reads | writes) >> bit != 0; ++bit) {
+        UsageSync const sync = _usage_sync(static_cast<RenderGraphUsage>(bit));
+
+        if ((reads >> bit & 1) != 0) {
+            access |= sync.reads;
+        }
+
+        if ((writes >> bit & 1) != 0) {
+            access |= sync.writes;
+        }
+    }
+
+    return access;
+}
+
+constexpr vk::ImageLayout
+_to_vk_layout(RenderGraphLayout layout) noexcept {
+    switch (layout) {
+        case RenderGraphLayout::General: return vk::ImageLayout::eGeneral;
+        case RenderGraphLayout::ColorAttachment:
+            return vk::ImageLayout::eColorAttachmentOptimal;
+        case RenderGraphLayout::DepthAttachment:
+            return vk::ImageLayout::eDepthStencilAttachmentOptimal;
+        case RenderGraphLayout::DepthReadOnly:
+            return vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+        case RenderGraphLayout::ShaderReadOnly:
+            return vk::ImageLayout::eShaderReadOnlyOptimal;
+        case RenderGraphLayout::TransferSource:
+            return vk::ImageLayout::eTransferSrcOptimal;
+        case RenderGraphLayout::TransferDestination:
+            return vk::ImageLayout::eTransferDstOptimal;
+        case RenderGraphLayout::Present: return vk::ImageLayout::ePresentSrcKHR;
+        default: return vk::ImageLayout::eUndefined;
+    }
+}
+
+vk::ImageMemoryBarrier
+_to_image_barrier(
+    RenderGraphBarrier const& barrier,
+    vk::Image image,
+    vk::ImageSubresourceRange const& range
+) noexcept {
+    return {
+        .srcAccessMask = _usage_access(0, barrier.src_writes),
+        .dstAccessMask = _usage_access(barrier.dst_reads, barrier.dst_writes),
+        .oldLayout = _to_vk_layout(barrier.old_layout),
+        .newLayout = _to_vk_layout(barrier.new_layout),
+        .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+        .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+        .image = image,
+        .subresourceRange = range,
+    };
+}
+
+constexpr bool
+_has_stencil_component(vk::Format format) noexcept {
+    return format == vk::Format::eD32SfloatS8Uint ||
+        format == vk::Format::eD24UnormS8Uint;
+}
+
+VulkanRenderer::FrameGraphAttachments
+VulkanRenderer::_build_frame_graph(
+    RenderGraph& graph,
+    vk::CommandBuffer command_buffer,
+    u32 image_index
+) noexcept {
+    using Usage = RenderGraphUsage;
+
+    _frame_graph_images.clear();
+
+    auto const add_image = [&](
+        RenderGraphResource resource,
+        vk::Image image,
+        vk::ImageAspectFlags aspect,
+        u32 mip_levels
+    ) {
+        _frame_graph_images.resize(resource + 1);
+        _frame_graph_images[resource] = {
+            .image = image,
+            .range =
+                {
+                    .aspectMask = aspect,
+                    .baseMipLevel = 0,
+                    .levelCount = mip_levels,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+        };
+    };
+
+    // Acquired (the semaphore wait is at color output), or headless
+    // resolved into by an older frame.
+    RenderGraphResource const target = graph.import_image(
+        "Swap chain image",
+        {
+            .usages = to_mask(Usage::ColorAttachment),
+            .written = _settings.headless,
+        }
+    );
+    add_image(
+        target,
+        _swap_chain_images[image_index],
+        vk::ImageAspectFlagBits::eColor,
+        1
+    );
+
+    if (_settings.headless) {
+        graph.export_resource(target);
+    } else {
+        graph.export_resource(target, Usage::Present);
+    }
+
+    RenderGraphResource const color = graph.create_image(
+        "MSAA color",
+        {
+            .size = _color_image_requirements.size,
+            .alignment = _color_image_requirements.alignment,
+        }
+    );
+    add_image(color, *_color_image, vk::ImageAspectFlagBits::eColor, 1);
+
+    // Layout transitions cover both aspects of combined formats.
+    vk::ImageAspectFlags depth_aspect {vk::ImageAspectFlagBits::eDepth};
+
+    if (_has_stencil_component(_depth_format)) {
+        depth_aspect |= vk::ImageAspectFlagBits::eStencil;
+    }
+
+    RenderGraphResource const depth = graph.create_image(
+        "Depth",
+        {
+            .size = _depth_image_requirements.size,
+            .alignment = _depth_image_requirements.alignment,
+        }
+    );
+    add_image(depth, *_depth_image, depth_aspect, 1);
+
+    // Per frame slot, the slot's previous frame has completed.
+    RenderGraphResource draw_commands {};
+    RenderGraphResource draw_counts {};
+
+    if (_gpu_culling) {
+        draw_commands = graph.import_buffer("Draw commands");
+        draw_counts = graph.import_buffer("Draw counts");
+    }
+
+    // Shared by every frame: the previous one's late cull wrote the
+    // visibility and read the pyramid.
+    RenderGraphResource visibility {};
+    RenderGraphResource depth_pyramid {};
+
+    if (_occlusion_culling) {
+        visibility = graph.import_buffer(
+            "Visibility",
+            {.usages = to_mask(Usage::ComputeStorage), .written = true}
+        );
+        graph.export_resource(visibility);
+
+        depth_pyramid = graph.import_image(
+            "Depth pyramid",
+            {
+                .usages = to_mask(Usage::ComputeStorage),
+                .layout = RenderGraphLayout::General,
+            }
+        );
+        add_image(
+            depth_pyramid,
+            *_depth_pyramid,
+            vk::ImageAspectFlagBits::eColor,
+            _depth_pyramid_levels
+        );
+    }
+
+    auto const add_cull_pass = [&](std::string_view name, CullPhase phase) {
+        RenderGraphPass const pass =
+            graph.add_pass(name, [this, command_buffer, phase] {
+                _record_culling(command_buffer, phase);
+            });
+
+        graph.read(pass, draw_counts, Usage::ComputeStorage);
+        graph.write(pass, draw_counts, Usage::ComputeStorage);
+        graph.write(pass, draw_commands, Usage::ComputeStorage);
+
+        if (_occlusion_culling) {
+            graph.read(pass, visibility, Usage::ComputeStorage);
+        }
+
+        if (phase == CullPhase::Late) {
+            // Sampled in place, in the general layout.
+            graph.read(pass, depth_pyramid, Usage::ComputeStorage);
+            graph.write(pass, visibility, Usage::ComputeStorage);
+        }
+    };
+
+    auto const add_geometry_pass = [&](std::string_view name, CullPhase phase) {
+        RenderGraphPass const pass = graph.add_pass(
+            name,
+            [this, command_buffer, image_index, phase] {
+                _record_geometry_pass(command_buffer, image_index, phase);
+            }
+        );
+
+        if (_gpu_culling) {
+            graph.read(pass, draw_commands, Usage::IndirectArguments);
+            graph.read(pass, draw_counts, Usage::IndirectArguments);
+        }
+
+        // Loaded by the late pass.
+        if (phase == CullPhase::Late) {
+            graph.read(pass, color, Usage::ColorAttachment);
+            graph.read(pass, depth, Usage::DepthAttachment);
+        }
+
+        graph.write(pass, color, Usage::ColorAttachment);
+        graph.write(pass, depth, Usage::DepthAttachment);
+        graph.write(pass, target, Usage::ColorAttachment); // Resolve.
+    };
+
+    if (_gpu_culling) {
+        RenderGraphPass const reset =
+            graph.add_pass("Reset cull counters", [this, command_buffer] {
+                _record_cull_reset(command_buffer);
+            });
+
+        graph.write(reset, draw_counts, Usage::Transfer);
+
+        if (_occlusion_culling && !_visibility_cleared) {
+            graph.write(reset, visibility, Usage::Transfer);
+        }
+
+        add_cull_pass("Early cull", CullPhase::Early);
+    }
+
+    add_geometry_pass("Early geometry", CullPhase::Early);
+
+    // Two-phase occlusion culling: the early pass drew what was visible
+    // last frame, its depth occludes the rest. Objects becoming visible
+    // are drawn this frame (late pass), so nothing pops in a frame late.
+    if (_occlusion_culling) {
+        RenderGraphPass const reduce =
+            graph.add_pass("Depth pyramid", [this, command_buffer] {
+                _record_depth_pyramid(command_buffer);
+            });
+
+        graph.read(reduce, depth, Usage::ComputeSampled);
+        graph.write(reduce, depth_pyramid, Usage::ComputeStorage);
+
+        add_cull_pass("Late cull", CullPhase::Late);
+        add_geometry_pass("Late geometry", CullPhase::Late);
+    }
+
+    // Headless capture: only the last frame is copied to the host.
+    bool const capture_frame = _settings.headless &&
+        !_settings.capture_path.empty() &&
+        _frame_number + 1 == _settings.frame_count;
+
+    if (capture_frame) {
+        RenderGraphResource const readback = graph.import_buffer("Readback");
+        graph.export_resource(readback);
+
+        RenderGraphPass const capture = graph.add_pass(
+            "Capture",
+            [this, command_buffer, image_index] {
+                vk::BufferImageCopy const region {
+                    .bufferOffset = 0,
+                    .bufferRowLength = 0, // Tightly packed.
+                    .bufferImageHeight = 0,
+                    .imageSubresource =
+                        {
+                            .aspectMask = vk::ImageAspectFlagBits::eColor,
+                            .mipLevel = 0,
+                            .baseArrayLayer = 0,
+                            .layerCount = 1,
+                        },
+                    .imageOffset = {0, 0, 0},
+                    .imageExtent =
+                        {_swap_chain_extent.width,
+                         _swap_chain_extent.height,
+                         1},
+                };
+
+                command_buffer.copyImageToBuffer(
+                    _swap_chain_images[image_index],
+                    vk::ImageLayout::eTransferSrcOptimal,
+                    *_readback_buffer,
+                    region
+                );
+            }
+        );
+
+        graph.read(capture, target, Usage::Transfer);
+        graph.write(capture, readback, Usage::Transfer);
+    }
+
+    // Buffers declared last have no entry yet.
+    _frame_graph_images.resize(graph.resource_count());
+
+    return {.color = color, .depth = depth};
+}
+
+void
+VulkanRenderer::_record_graph_barriers(
+    vk::CommandBuffer command_buffer,
+    RenderGraph const& graph,
+    std::span<RenderGraphBarrier const> barriers
+) const noexcept {
+    vk::PipelineStageFlags src_stages {};
+    vk::PipelineStageFlags dst_stages {};
+    vk::MemoryBarrier memory_barrier {};
+    u32 memory_barrier_count {0};
+    std::vector<vk::ImageMemoryBarrier> image_barriers {};
+    image_barriers.reserve(barriers.size());
+
+    for (RenderGraphBarrier const& barrier : barriers) {
+        src_stages |= _usage_stages(barrier.src_usages);
+        dst_stages |= _usage_stages(barrier.dst_reads | barrier.dst_writes);
+
+        if (graph.is_image(barrier.resource)) {
+            FrameGraphImage const& image =
+                _frame_graph_images[barrier.resource];
+            image_barriers.push_back(
+                _to_image_barrier(barrier, image.image, image.range)
+            );
+            continue;
+        }
+
+        // Buffers are not told apart, a global barrier covers them all.
+        memory_barrier.srcAccessMask |= _usage_access(0, barrier.src_writes);
+        memory_barrier.dstAccessMask |=
+            _usage_access(barrier.dst_reads, barrier.dst_writes);
+        memory_barrier_count = 1;
+    }
+
+    // First uses only transition, nothing to wait for.
+    if (!src_stages) {
+        src_stages = vk::PipelineStageFlagBits::eTopOfPipe;
+    }
+
+    command_buffer.pipelineBarrier(
+        src_stages,
+        dst_stages,
+        vk::DependencyFlags {},
+        memory_barrier_count,
+        &memory_barrier,
+        0, // Buffer memory barriers.
+        nullptr,
+        static_cast<u32>(image_barriers.size()),
+        image_barriers.data()
     );
+}
+
+void
+VulkanRenderer::_begin_rendering(
+    vk::CommandBuffer command_buffer,
+    u32 image_index,
+    bool late,
+    std::span<vk::ClearValue const, 2> clear_values
+) const noexcept {
+    // Same attachments and operations as the render passes (see
+    // _create_render_pass()), layouts are the frame graph's.
+    vk::AttachmentLoadOp const load_op =
+        late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+
+    vk::RenderingAttachmentInfo const color_attachment {
+        .imageView = *_color_image_view,
+        .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+        .resolveMode = vk::ResolveModeFlagBits::eAverage,
+        .resolveImageView = *_swap_chain_image_views[image_index],
+        .resolveImageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+        .loadOp = load_op,
+        .storeOp = vk::AttachmentStoreOp::eStore,
+        .clearValue = clear_values[0],
+    };
+
+    // Occlusion culling: the early depth is loaded by the late pass and
+    // reduced into the depth pyramid.
+    vk::RenderingAttachmentInfo const depth_attachment {
+        .imageView = *_depth_image_view,
+        .imageLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+        .loadOp = load_op,
+        .storeOp = _occlusion_culling && !late
+            ? vk::AttachmentStoreOp::eStore
+            : vk::AttachmentStoreOp::eDontCare,
+        .clearValue = clear_values[1],
+    };
+
+    vk::RenderingInfo const rendering_info {
+        .renderArea =
+            {
+                .offset = {0, 0},
+                .extent = _swap_chain_extent,
+            },
+        .layerCount = 1,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &color_attachment,
+        .pDepthAttachment = &depth_attachment,
+    };
+
+    command_buffer.beginRendering(rendering_info);
+}
 
+void
+VulkanRenderer::_record_geometry_pass(
+    vk::CommandBuffer command_buffer,
+    u32 image_index,
+    CullPhase phase
+) noexcept {
     // Note: the order of clear_values should be identical to the order
     // of the attachments (see _create_render_pass()).
     std::array<vk::ClearValue, 2> clear_values {};
@@ -1575,33 +3450,33 @@ VulkanRenderer::_record_command_buffer(u32 image_index) noexcept {
     clear_values[1].depthStencil =
         vk::ClearDepthStencilValue {.depth = 1.0f, .stencil = 0};
 
-    // Start a render pass.
-    vk::RenderPassBeginInfo const render_pass_begin_info {
-        .renderPass = *_render_pass,
-        .framebuffer = *_swap_chain_framebuffers[image_index],
-        .renderArea =
-            {
-                .offset = {0, 0},
-                .extent = {_swap_chain_extent},
-            },
-        .clearValueCount = static_cast<u32>(clear_values.size()),
-        .pClearValues = clear_values.data(),
-    };
+    bool const late = phase == CullPhase::Late;
 
-    _command_buffers[_current_frame]->beginRenderPass(
-        render_pass_begin_info,
-        vk::SubpassContents::eInline // For primary commands.
-    );
+    if (_dynamic_rendering) {
+        _begin_rendering(command_buffer, image_index, late, clear_values);
+    } else {
+        // Start a render pass.
+        vk::RenderPassBeginInfo const render_pass_begin_info {
+            .renderPass = late ? *_late_render_pass : *_render_pass,
+            .framebuffer = *_swap_chain_framebuffers[image_index],
+            .renderArea =
+                {
+                    .offset = {0, 0},
+                    .extent = {_swap_chain_extent},
+                },
+            .clearValueCount = static_cast<u32>(clear_values.size()),
+            .pClearValues = clear_values.data(),
+        };
+
+        command_buffer.beginRenderPass(
+            render_pass_begin_info,
+            vk::SubpassContents::eInline // For primary commands.
+        );
+    }
 
     // Let's start drawing!
     // Note: All commands return void.
 
-    // Bind graphics pipeline.
-    _command_buffers[_current_frame]->bindPipeline(
-        vk::PipelineBindPoint::eGraphics,
-        *_graphics_pipeline
-    );
-
     // Viewport and scissor are dynamic pipeline states :D
     vk::Viewport viewport {
         .x = 0.0f,
@@ -1613,7 +3488,7 @@ VulkanRenderer::_record_command_buffer(u32 image_index) noexcept {
     };
 
     constexpr u32 first_viewport {0};
-    _command_buffers[_current_frame]->setViewport(first_viewport, viewport);
+    command_buffer.setViewport(first_viewport, viewport);
 
     vk::Rect2D scissor {
         .offset = {0, 0},
@@ -1621,62 +3496,131 @@ VulkanRenderer::_record_command_buffer(u32 image_index) noexcept {
     };
 
     constexpr u32 first_scissor {0};
-    _command_buffers[_current_frame]->setScissor(first_scissor, scissor);
+    command_buffer.setScissor(first_scissor, scissor);
 
     // Vertex Buffers.
     std::array const vertex_buffers {*_vertex_buffer};
     constexpr std::array<vk::DeviceSize, 1> offsets = {0};
 
     constexpr u32 first_binding {0};
-    _command_buffers[_current_frame]
-        ->bindVertexBuffers(first_binding, vertex_buffers, offsets);
+    command_buffer.bindVertexBuffers(first_binding, vertex_buffers, offsets);
+
+    command_buffer.bindIndexBuffer(*_index_buffer, 0, vk::IndexType::eUint32);
+
+    // Bound once per frame, whatever the number of materials drawn.
+    std::array const descriptor_sets = {
+        *_descriptor_sets[_current_frame],
+        _bindless_set,
+    };
 
-    _command_buffers[_current_frame]
-        ->bindIndexBuffer(*_index_buffer, 0, vk::IndexType::eUint32);
+    // The scene block of this frame, in its uniform ring.
+    std::array const dynamic_offsets = {_scene_uniform_offset};
 
-    _command_buffers[_current_frame]->bindDescriptorSets(
+    command_buffer.bindDescriptorSets(
         vk::PipelineBindPoint::eGraphics,
-        *_pipeline_Layout,
+        _pipeline_Layout,
         0, // First set.
-        1, // Descriptor set count.
-        &(*_descriptor_sets[_current_frame]),
-        0, // Dynamic offset count.
-        nullptr // Dynamic offsets.
-    );
-
-    // D-D-D-Draaaaaaaawww call!!!!!!
-    u32 const index_count = static_cast<u32>(_indices.size());
-    _command_buffers[_current_frame]->drawIndexed(
-        index_count,
-        1, // Instance count.
-        0, // First Index.
-        0, // Offset.
-        0 // First Instance.
-    );
-
-    // End.
-    _command_buffers[_current_frame]->endRenderPass();
-    vk_expect(
-        _command_buffers[_current_frame]->end(),
-        "Failed to record cmd buffer."
+        static_cast<u32>(descriptor_sets.size()),
+        descriptor_sets.data(),
+        static_cast<u32>(dynamic_offsets.size()),
+        dynamic_offsets.data()
     );
-}
 
-#pragma endregion COMMANDS
+    if (_gpu_culling) {
+        // One draw for every material, so one pipeline: the default one.
+        // Materials only differ by their GpuMaterial here, submit() checks
+        // their state and keywords are the default ones.
+        command_buffer.bindPipeline(
+            vk::PipelineBindPoint::eGraphics,
+            _graphics_pipeline_for(_default_material)
+        );
+
+        InstanceBuffer const& instance_buffer =
+            _instance_buffers[_current_frame];
+        // Each phase has its own count, late draws follow the early ones.
+        u32 const list = static_cast<u32>(phase);
+
+        // One call whatever the number of objects and meshlets, the cull
+        // shaders decided how many draws it holds.
+        command_buffer.drawIndexedIndirectCount(
+            *instance_buffer.draw_commands,
+            list * instance_buffer.draw_capacity *
+                sizeof(vk::DrawIndexedIndirectCommand),
+            *_draw_count_buffers[_current_frame],
+            offsetof(DrawCounters, draw_counts) + list * sizeof(u32),
+            static_cast<u32>(_max_draw_count),
+            sizeof(vk::DrawIndexedIndirectCommand)
+        );
+    }
+
+    // CPU culling: the batches only hold visible instances.
+    vk::Pipeline bound_pipeline {nullptr};
+
+    for (DrawBatch const& batch : _draw_batches) {
+        // GPU culling: already drawn above.
+        if (_gpu_culling || batch.instance_count == 0) {
+            continue;
+        }
+
+        // Materials sharing a state share a pipeline, and the descriptor
+        // sets stay bound (same layout).
+        vk::Pipeline const pipeline = _graphics_pipeline_for(batch.material_id);
+
+        if (pipeline != bound_pipeline) {
+            command_buffer.bindPipeline(
+                vk::PipelineBindPoint::eGraphics,
+                pipeline
+            );
+            bound_pipeline = pipeline;
+        }
+
+        // Selecting a material or placing a lone instance is a push
+        // constant, not a descriptor bind.
+        DrawPushConstants const draw_constants {
+            .model = batch.model,
+            .material_id = batch.material_id,
+            .pushed_model = batch.pushed_model ? 1U : 0U,
+        };
+
+        command_buffer.pushConstants(
+            _pipeline_Layout,
+            _draw_push_constant_stages,
+            0, // Offset.
+            sizeof(draw_constants),
+            &draw_constants
+        );
+
+        // D-D-D-Draaaaaaaawww call!!!!!!
+        command_buffer.drawIndexed(
+            batch.mesh.index_count,
+            batch.instance_count,
+            batch.mesh.first_index,
+            batch.mesh.vertex_offset,
+            // Instances are read from the buffer at gl_InstanceIndex.
+            batch.first_instance
+        );
+    }
+
+    // End.
+    if (_dynamic_rendering) {
+        command_buffer.endRendering();
+    } else {
+        command_buffer.endRenderPass();
+    }
+}
+
+#pragma endregion COMMANDS
 
 #pragma region SYNC_OBJECTS
 
 void
 VulkanRenderer::_create_sync_objects() noexcept {
     constexpr vk::SemaphoreCreateInfo semaphore_info {};
-    constexpr vk::FenceCreateInfo fence_info {
-        // Fence is "open" by default.
-        // This is because in the first frame of the program we do not want
-        // to wait for this fence to be signaled since no frame will be redendering.
-        .flags = vk::FenceCreateFlagBits::eSignaled,
-    };
 
-    for (usize i {}; i < s_max_frames_in_flight; ++i) {
+    _image_available_semaphores.resize(_frames_in_flight);
+    _render_finished_semapahores.resize(_frames_in_flight);
+
+    for (usize i {}; i < _frames_in_flight; ++i) {
         _image_available_semaphores[i] = vk_expect_value(
             _device->createSemaphoreUnique(semaphore_info),
             "Failed to create Image Available Semaphore."
@@ -1686,18 +3630,67 @@ VulkanRenderer::_create_sync_objects() noexcept {
             _device->createSemaphoreUnique(semaphore_info),
             "Failed to create Render Finished Semaphore."
         );
-
-        _frame_in_flight_fences[i] = vk_expect_value(
-            _device->createFenceUnique(fence_info),
-            "Failed to create Frame In Flight Fence"
-        );
     }
 };
 
+void
+VulkanRenderer::_create_timeline_semaphore() noexcept {
+    vk::SemaphoreTypeCreateInfo const type_info {
+        .semaphoreType = vk::SemaphoreType::eTimeline,
+        .initialValue = 0,
+    };
+
+    vk::SemaphoreCreateInfo const semaphore_info {.pNext = &type_info};
+
+    _timeline = vk_expect_value(
+        _device->createSemaphoreUnique(semaphore_info),
+        "Failed to create Timeline Semaphore."
+    );
+}
+
 #pragma endregion SYNC_OBJECTS
 
 #pragma region DRAW
 
+void
+VulkanRenderer::_wait_for_frame() noexcept {
+    // Wait for the last frame rendered with this slot to finish
+    // (value 0, never used, is always reached).
+    u64 const slot_value = _frame_slot_values[_current_frame];
+    constexpr u64 time_out_ns {std::numeric_limits<u64>::max()};
+
+    if (slot_value > _completed_value) {
+        vk::SemaphoreWaitInfo const wait_info {
+            .semaphoreCount = 1,
+            .pSemaphores = &_timeline.get(),
+            .pValues = &slot_value,
+        };
+
+        vk_expect(
+            _device->waitSemaphores(wait_info, time_out_ns),
+            "Failed to wait for frame timeline value."
+        );
+    }
+
+    // Counted once per frame, when its completion is first observed.
+    Clock::time_point& input_time = _frame_input_times[_current_frame];
+
+    if (!_settings.headless && input_time != Clock::time_point {}) {
+        std::chrono::duration<f64, std::milli> const latency =
+            Clock::now() - input_time;
+        _completion_latency.add(latency.count());
+        input_time = {};
+    }
+
+    // The GPU may be further along (later frames, uploads).
+    _completed_value = vk_expect_value(
+        _device->getSemaphoreCounterValue(*_timeline),
+        "Failed to read timeline value."
+    );
+
+    _deletion_queue.collect(_completed_value);
+}
+
 void
 VulkanRenderer::_draw_frame() noexcept {
     // Rendering a frame consists in:
@@ -1720,82 +3713,131 @@ VulkanRenderer::_draw_frame() noexcept {
     // One option for *CPU (Host)* synchronization: Fences.
     // src: https://docs.vulkan.org/tutorial/latest/03_Drawing_a_triangle/03_Drawing/02_Rendering_and_presentation.html#:~:text=will%20now%20describe.-,Fences,-A%20fence%20has
 
-    // Wait for current frame to finish rendering.
-    // Obviously first frame won't be waited because fence is signaled (open)
-    // in first frame.
-    constexpr vk::Bool32 wait_for_all {vk::True};
-    constexpr u64 time_out_ns {std::numeric_limits<u64>::max()};
-    vk_expect(
-        _device->waitForFences(
-            *_frame_in_flight_fences[_current_frame],
-            wait_for_all,
-            time_out_ns
-        ),
-        "Failed to wait for frame in flight fence."
-    );
+    _wait_for_frame();
+
+    // The slot's material buffer is no longer read by the GPU.
+    _upload_materials();
+
+    // Headless: each frame slot owns its offscreen target.
+    u32 image_index {_current_frame};
+
+    if (!_settings.headless) {
+        constexpr u64 time_out_ns {std::numeric_limits<u64>::max()};
+        auto const [acquire_result, acquired_index] =
+            _device->acquireNextImageKHR(
+                *_swap_chain,
+                time_out_ns,
+                *_image_available_semaphores[_current_frame],
+                nullptr
+            );
+
+        // Nothing was acquired and the fence is still signaled,
+        // so this frame slot can simply be retried after recreation.
+        if (acquire_result == vk::Result::eErrorOutOfDateKHR) {
+            _recreate_swap_chain();
+            return;
+        }
 
-    auto image_index = vk_expect_value(
-        _device->acquireNextImageKHR(
-            *_swap_chain,
-            time_out_ns,
-            *_image_available_semaphores[_current_frame],
-            nullptr
-        ),
-        "Failed to acquire image from swapchain."
-    );
+        core_assert(
+            acquire_result == s_success ||
+                acquire_result == vk::Result::eSuboptimalKHR,
+            "Failed to acquire image from swapchain."
+        );
 
-    // Reset fence for next frame.
-    vk_expect(
-        _device->resetFences(*_frame_in_flight_fences[_current_frame]),
-        "Failed to reset frame in flight fence."
-    );
+        image_index = acquired_index;
+    }
 
-    // Make sure cmd buffer is in default state.
-    vk_expect(
-        _command_buffers[_current_frame]->reset(),
-        "Failed to reset cmd buffer"
-    );
+    // The slot's previous frame is done, its command buffers can be reused.
+    _reset_frame_command_pool();
+    // And its uniform blocks were read.
+    _uniform_rings[_current_frame].allocator.reset();
+    vk::CommandBuffer const command_buffer = _allocate_frame_command_buffer();
+
+    // Submitting culls against the frustum (CPU culling).
+    _update_uniform_buffer();
+    _update_scene();
+    _upload_instances();
+
+    // Shared resources were recreated since the slot last recorded, its
+    // previous frame is done with the set.
+    if (_descriptor_sets_stale[_current_frame]) {
+        _write_descriptor_set(_current_frame);
+        _descriptor_sets_stale[_current_frame] = false;
+    }
 
     // Draw to the image :)
-    _record_command_buffer(image_index);
+    _record_command_buffer(command_buffer, image_index);
 
-    _update_uniform_buffer(_current_frame);
+    // Submissions only last one frame.
+    _instances.clear();
+    _draw_batches.clear();
+    _max_draw_count = 0;
 
+    u64 const frame_value = ++_timeline_value;
+
+    // Binary semaphores first, their values are ignored.
+    // Headless frames have no image to wait for and nothing to present,
+    // so only the timeline entries (the last ones) are used.
     std::array const wait_semaphores = {
-        *_image_available_semaphores[_current_frame]
+        *_image_available_semaphores[_current_frame],
+        *_timeline
+    };
+    std::array const wait_values = {u64 {0}, _upload_value};
+    constexpr std::array<vk::PipelineStageFlags, 2> wait_pipelines_stages {
+        // Wait for the image before writing colors.
+        vk::PipelineStageFlagBits::eColorAttachmentOutput,
+        // Wait for pending uploads before reading any resource.
+        vk::PipelineStageFlagBits::eAllCommands,
     };
     std::array const signal_semaphores = {
-        *_render_finished_semapahores[_current_frame]
+        *_render_finished_semapahores[_current_frame],
+        *_timeline
+    };
+    std::array const signal_values = {u64 {0}, frame_value};
+
+    u32 const first = _settings.headless ? 1 : 0;
+    u32 const count = 2 - first;
+
+    vk::TimelineSemaphoreSubmitInfo const timeline_info {
+        .waitSemaphoreValueCount = count,
+        .pWaitSemaphoreValues = wait_values.data() + first,
+        .signalSemaphoreValueCount = count,
+        .pSignalSemaphoreValues = signal_values.data() + first,
     };
-    constexpr vk::PipelineStageFlags wait_pipelines_stages =
-        vk::PipelineStageFlagBits::eColorAttachmentOutput;
 
     vk::SubmitInfo const submit_info {
-        .waitSemaphoreCount = 1,
-        .pWaitSemaphores = wait_semaphores.data(),
-        // Wait for color rendering to finish.
-        .pWaitDstStageMask = &wait_pipelines_stages,
+        .pNext = &timeline_info,
+        .waitSemaphoreCount = count,
+        .pWaitSemaphores = wait_semaphores.data() + first,
+        .pWaitDstStageMask = wait_pipelines_stages.data() + first,
         .commandBufferCount = 1,
-        .pCommandBuffers =
-            &_command_buffers[_current_frame].get(), // Pointer is const.
+        .pCommandBuffers = &command_buffer,
         // Which semaphores to signal (green light) once cmd buffer finishes.
-        .signalSemaphoreCount = 1,
-        .pSignalSemaphores = signal_semaphores.data(),
+        .signalSemaphoreCount = count,
+        .pSignalSemaphores = signal_semaphores.data() + first,
     };
 
     vk_expect(
-        _graphics_queue
-            .submit(submit_info, *_frame_in_flight_fences[_current_frame]),
+        _graphics_queue.submit(submit_info),
         "Failed to submit to graphics queue"
     );
 
+    _frame_slot_values[_current_frame] = frame_value;
+    ++_frame_number;
+    _frame_input_times[_current_frame] = _input_sample_time;
+
+    if (_settings.headless) {
+        _current_frame = (_current_frame + 1) % _frames_in_flight;
+        return;
+    }
+
     // Presentation.
     std::array const swap_chains = {*_swap_chain};
 
     vk::PresentInfoKHR present_info {
         // Semaphores to wait before presentation.
         .waitSemaphoreCount = 1,
-        .pWaitSemaphores = signal_semaphores.data(),
+        .pWaitSemaphores = &signal_semaphores[0], // Binary one.
         .swapchainCount = 1,
         .pSwapchains = swap_chains.data(),
         .pImageIndices = &image_index,
@@ -1807,16 +3849,18 @@ VulkanRenderer::_draw_frame() noexcept {
     // Therefore vk::Result::eSuboptimalKHR is acceptable.
     auto result_present = _present_queue.presentKHR(present_info);
 
+    std::chrono::duration<f64, std::milli> const present_latency =
+        Clock::now() - _input_sample_time;
+    _present_latency.add(present_latency.count());
+
     if (result_present == vk::Result::eErrorOutOfDateKHR ||
         _framebuffer_resized) {
         _framebuffer_resized = false;
         _recreate_swap_chain();
-
-        return;
     }
 
     // Advance to the next frame.
-    _current_frame = (_current_frame + 1) % s_max_frames_in_flight;
+    _current_frame = (_current_frame + 1) % _frames_in_flight;
 }
 
 #pragma endregion DRAW
@@ -1993,6 +4037,10 @@ VulkanRenderer::_create_vertex_buffer() noexcept {
 
     _copy_buffer(staging_buffer, _vertex_buffer, buffer_size);
     Log::info("Vertex Buffer data copied from Staging Buffer.");
+
+    // The copy is still in flight.
+    _retire(std::move(staging_buffer));
+    _retire(std::move(staging_buffer_memory));
 }
 
 void
@@ -2047,56 +4095,184 @@ VulkanRenderer::_create_index_buffer() noexcept {
     Log::info("Index Buffer created.");
 
     _copy_buffer(staging_buffer, _index_buffer, buffer_size);
+
+    // The copy is still in flight.
+    _retire(std::move(staging_buffer));
+    _retire(std::move(staging_buffer_memory));
+}
+
+void
+VulkanRenderer::_create_meshlet_buffer() noexcept {
+    // Bound even when empty (or with CPU culling, which draws whole meshes).
+    Meshlet const placeholder {};
+    std::span<Meshlet const> const meshlets = _meshlets.empty()
+        ? std::span<Meshlet const> {&placeholder, 1}
+        : std::span<Meshlet const> {_meshlets};
+
+    _create_device_local_buffer(
+        std::as_bytes(meshlets),
+        vk::BufferUsageFlagBits::eStorageBuffer,
+        _meshlet_buffer,
+        _meshlet_buffer_memory
+    );
+
+    Log::info("Meshlet Buffer size: ", meshlets.size_bytes());
 }
 
 void
-VulkanRenderer::_create_uniform_buffers() noexcept {
-    constexpr vk::DeviceSize buffer_size = sizeof(UniformBufferObject);
+VulkanRenderer::_create_lod_buffer() noexcept {
+    // Bound even when empty, as the meshlet buffer.
+    MeshLod const placeholder {};
+    std::span<MeshLod const> const lods = _mesh_lods.empty()
+        ? std::span<MeshLod const> {&placeholder, 1}
+        : std::span<MeshLod const> {_mesh_lods};
+
+    _create_device_local_buffer(
+        std::as_bytes(lods),
+        vk::BufferUsageFlagBits::eStorageBuffer,
+        _lod_buffer,
+        _lod_buffer_memory
+    );
+}
+
+void
+VulkanRenderer::_create_device_local_buffer(
+    std::span<std::byte const> data,
+    vk::BufferUsageFlags usage,
+    vk::UniqueBuffer& buffer,
+    vk::UniqueDeviceMemory& buffer_memory
+) noexcept {
+    vk::UniqueBuffer staging_buffer {};
+    vk::UniqueDeviceMemory staging_buffer_memory {};
+
+    _create_buffer_unique(
+        data.size(),
+        vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent,
+        staging_buffer,
+        staging_buffer_memory
+    );
+
+    void* mapped = vk_expect_value(
+        _device->mapMemory(*staging_buffer_memory, 0, data.size()),
+        "Failed to map Staging Buffer Memory."
+    );
+    std::memcpy(mapped, data.data(), data.size());
+    _device->unmapMemory(*staging_buffer_memory);
 
-    for (usize i {}; i < s_max_frames_in_flight; ++i) {
+    _create_buffer_unique(
+        data.size(),
+        usage | vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        buffer,
+        buffer_memory
+    );
+
+    _copy_buffer(staging_buffer, buffer, data.size());
+
+    // The copy is still in flight.
+    _retire(std::move(staging_buffer));
+    _retire(std::move(staging_buffer_memory));
+}
+
+void
+VulkanRenderer::_create_uniform_rings() noexcept {
+    // A power of two, at most 256 bytes.
+    _uniform_alignment = std::max<vk::DeviceSize>(
+        _physical_device.getProperties().limits.minUniformBufferOffsetAlignment,
+        1
+    );
+
+    _uniform_rings.resize(_frames_in_flight);
+
+    for (UniformRing& ring : _uniform_rings) {
+        ring.allocator =
+            LinearAllocator(s_uniform_ring_size, _uniform_alignment);
         _create_buffer_unique(
-            buffer_size,
+            s_uniform_ring_size,
             vk::BufferUsageFlagBits::eUniformBuffer,
             vk::MemoryPropertyFlagBits::eHostVisible |
                 vk::MemoryPropertyFlagBits::eHostCoherent,
-            _uniform_buffers[i],
-            _uniform_buffers_memory[i]
+            ring.buffer,
+            ring.memory
         );
 
         constexpr u32 offset {0};
-        _uniform_buffers_mapped[i] = vk_expect_value(
+        ring.mapped = static_cast<std::byte*>(vk_expect_value(
             // Persistent mapping.
-            _device
-                ->mapMemory(*_uniform_buffers_memory[i], offset, buffer_size),
-            "Failed to map memory for uniform buffer object."
+            _device->mapMemory(*ring.memory, offset, s_uniform_ring_size),
+            "Failed to map memory for uniform ring."
+        ));
+    }
+}
+
+std::optional<u32>
+VulkanRenderer::_push_uniforms(std::span<std::byte const> block) noexcept {
+    UniformRing& ring = _uniform_rings[_current_frame];
+    std::optional<u64> const offset = ring.allocator.allocate(block.size());
+
+    if (!offset) {
+        Log::error(
+            "Uniform ring full (",
+            ring.allocator.capacity(),
+            " bytes), raise s_uniform_ring_size."
         );
+        return std::nullopt;
     }
+
+    std::memcpy(ring.mapped + *offset, block.data(), block.size());
+
+    return static_cast<u32>(*offset);
 }
 
-void
-VulkanRenderer::_update_uniform_buffer(u32 current_image) noexcept {
-    using clock = std::chrono::high_resolution_clock;
-    using period = std::chrono::seconds::period;
-    static auto start_time = clock::now();
+// Gribb & Hartmann: the planes are sums of the rows of the view projection
+// matrix (with a 0..1 depth range the near plane is the third row alone).
+std::array<glm::vec4, 6>
+_extract_frustum_planes(glm::mat4 const& view_projection) noexcept {
+    glm::mat4 const m = glm::transpose(view_projection); // m[i] = row i.
+
+    std::array planes = {
+        m[3] + m[0], // Left.
+        m[3] - m[0], // Right.
+        m[3] + m[1], // Bottom.
+        m[3] - m[1], // Top.
+        m[2], // Near.
+        m[3] - m[2], // Far.
+    };
 
-    auto current_time = clock::now();
-    f32 time =
-        std::chrono::duration<f32, period>(current_time - start_time).count();
+    for (glm::vec4& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
 
+    return planes;
+}
+
+bool
+_is_sphere_in_frustum(
+    std::array<glm::vec4, 6> const& planes,
+    glm::vec3 center,
+    f32 radius
+) noexcept {
+    return std::ranges::all_of(planes, [&](glm::vec4 const& plane) {
+        return glm::dot(glm::vec3(plane), center) + plane.w >= -radius;
+    });
+}
+
+void
+VulkanRenderer::_update_uniform_buffer() noexcept {
     UniformBufferObject ubo {};
-    // Model matrix it's a simple rotation around de Z-axis.
-    ubo.model = glm::rotate(
-        glm::mat4(1.0f),
-        glm::sin(time * glm::radians(10.0f)) * 0.5f,
-        glm::vec3(0.0f, 0.0f, 0.2f)
-    );
 
     // View matrix it's simply a view from above at a 45 degree angle.
+    glm::vec3 const camera_position {2.0f, 2.0f, 2.0f};
     ubo.view = glm::lookAt(
-        glm::vec3(2.0f, 2.0f, 2.0f),
+        camera_position,
         glm::vec3(0.0f, 0.0f, 0.0f),
         glm::vec3(0.0f, 0.0f, 1.0f)
     );
+    // Meshlet cone culling and LOD selection.
+    ubo.camera_position = glm::vec4(camera_position, 1.0f);
+    _camera_position = camera_position;
 
     f32 const aspect_ratio =
         _swap_chain_extent.width / static_cast<f32>(_swap_chain_extent.height);
@@ -2111,12 +4287,564 @@ VulkanRenderer::_update_uniform_buffer(u32 current_image) noexcept {
     */
     ubo.projection[1][1] *= -1;
 
-    // Remember ubo memory uses persistent mapping.
-    std::memcpy(_uniform_buffers_mapped[current_image], &ubo, sizeof(ubo));
+    // A unit at distance d covers projection_scale / d pixels.
+    _projection_scale = static_cast<f32>(_swap_chain_extent.height) /
+        (2.0f * std::tan(vertical_fov * 0.5f));
+    ubo.projection_scale = _projection_scale;
+    ubo.lod_error_threshold = _settings.lod_error_threshold;
+
+    _frustum_planes = _extract_frustum_planes(ubo.projection * ubo.view);
+    std::ranges::copy(_frustum_planes, ubo.frustum_planes);
+
+    // First in the ring, the draws and the cull shaders bind it.
+    std::optional<u32> const offset =
+        _push_uniforms(std::as_bytes(std::span {&ubo, 1}));
+    core_assert(offset, "The scene block must fit in an empty ring.");
+    _scene_uniform_offset = offset.value_or(0);
 }
 
 #pragma endregion BUFFERS
 
+#pragma region SCENE
+
+void
+VulkanRenderer::submit(
+    MeshRange const& mesh,
+    u32 material_id,
+    std::span<glm::mat4 const> transforms
+) noexcept {
+    auto const push_instance = [&](glm::mat4 const& transform) {
+        _instances.push_back({
+            .model = transform,
+            .bounding_sphere = mesh.bounding_sphere,
+            .index_count = mesh.index_count,
+            .first_index = mesh.first_index,
+            .vertex_offset = mesh.vertex_offset,
+            .material_id = material_id,
+            .first_meshlet = mesh.first_meshlet,
+            .meshlet_count = mesh.meshlet_count,
+            .first_lod = mesh.first_lod,
+            .lod_count = mesh.lod_count,
+        });
+    };
+
+    // Culled and given a level of detail in the cull shaders, one by one.
+    if (_gpu_culling) {
+        core_assert(
+            _shares_default_pipeline(material_id),
+            "GPU culling draws every material with the default pipeline."
+        );
+
+        _draw_batches.push_back({
+            .mesh = mesh,
+            .material_id = material_id,
+            .first_instance = static_cast<u32>(_instances.size()),
+            .instance_count = static_cast<u32>(transforms.size()),
+        });
+
+        for (glm::mat4 const& transform : transforms) {
+            push_instance(transform);
+        }
+
+        // Level 0 has the most meshlets.
+        _max_draw_count +=
+            transforms.size() * std::max(mesh.meshlet_count, 1U);
+        return;
+    }
+
+    // CPU culling: only visible instances, grouped by level of detail so
+    // that each level is still a single draw.
+    _visible_instances.clear();
+    glm::vec3 const sphere_center {mesh.bounding_sphere};
+
+    for (u32 i {}; i < transforms.size(); ++i) {
+        glm::mat4 const& transform = transforms[i];
+        glm::vec3 const center {transform * glm::vec4(sphere_center, 1.0f)};
+        // Largest axis scale, so non-uniform scales stay conservative.
+        f32 const scale = std::sqrt(std::max({
+            glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+            glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+            glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])),
+        }));
+        f32 const radius = mesh.bounding_sphere.w * scale;
+
+        if (!_is_sphere_in_frustum(_frustum_planes, center, radius)) {
+            continue;
+        }
+
+        _visible_instances.emplace_back(
+            _select_lod(mesh, center, radius, scale),
+            i
+        );
+    }
+
+    std::ranges::sort(_visible_instances);
+
+    for (usize i {}; i < _visible_instances.size();) {
+        u32 const level = _visible_instances[i].first;
+        MeshLod const lod = _mesh_lod(mesh, level);
+
+        DrawBatch batch {
+            .mesh = mesh,
+            .material_id = material_id,
+            .first_instance = static_cast<u32>(_instances.size()),
+            .instance_count = 0,
+        };
+        batch.mesh.index_count = lod.index_count;
+        batch.mesh.first_index = mesh.first_index + lod.first_index;
+
+        for (; i < _visible_instances.size() &&
+             _visible_instances[i].first == level;
+             ++i) {
+            push_instance(transforms[_visible_instances[i].second]);
+            ++batch.instance_count;
+        }
+
+        // Alone at its level: pushed with the draw, one instance buffer
+        // write less.
+        if (batch.instance_count == 1) {
+            batch.pushed_model = true;
+            batch.model = _instances.back().model;
+            batch.first_instance = 0;
+            _instances.pop_back();
+        }
+
+        _draw_batches.push_back(batch);
+        _max_draw_count += 1;
+    }
+}
+
+u32
+VulkanRenderer::_select_lod(
+    MeshRange const& mesh,
+    glm::vec3 center,
+    f32 radius,
+    f32 scale
+) const noexcept {
+    // From the nearest point of the bounding sphere, so the error on
+    // screen is never underestimated.
+    f32 const distance = std::max(
+        glm::distance(center, _camera_position) - radius,
+        s_min_lod_distance
+    );
+    f32 const pixels_per_unit = _projection_scale * scale / distance;
+
+    u32 level {0};
+
+    // Errors grow with the level.
+    for (u32 i {1}; i < mesh.lod_count; ++i) {
+        f32 const error = _mesh_lods[mesh.first_lod + i].error;
+
+        if (error * pixels_per_unit > _settings.lod_error_threshold) {
+            break;
+        }
+
+        level = i;
+    }
+
+    return level;
+}
+
+MeshLod
+VulkanRenderer::_mesh_lod(MeshRange const& mesh, u32 level) const noexcept {
+    if (mesh.lod_count == 0) {
+        return {
+            .first_index = 0,
+            .index_count = mesh.index_count,
+            .first_meshlet = 0,
+            .meshlet_count = mesh.meshlet_count,
+        };
+    }
+
+    return _mesh_lods[mesh.first_lod + level];
+}
+
+void
+VulkanRenderer::_create_scene() noexcept {
+    u32 const object_count = std::max(_settings.object_count, 1U);
+
+    _meshes.push_back(_model_mesh);
+    _scene_mesh = static_cast<u32>(_meshes.size() - 1);
+    // Every object is a child of the root, which stays where it is.
+    _scene_root = _transforms.create();
+
+    for (u32 i {}; i < object_count; ++i) {
+        _world.create(
+            Transform {},
+            WorldTransform {},
+            SceneNode {.id = _transforms.create(_scene_root)},
+            Mesh {.id = _scene_mesh},
+            Material {.id = _default_material},
+            Bounds {}
+        );
+    }
+
+    _lay_out_scene();
+
+    _scene_frame_transforms.reserve(object_count);
+    _instances.reserve(object_count);
+
+    Log::info("Scene objects: ", object_count);
+}
+
+void
+VulkanRenderer::_lay_out_scene() noexcept {
+    u32 const object_count = std::max(_settings.object_count, 1U);
+    u32 const columns =
+        static_cast<u32>(std::ceil(std::sqrt(static_cast<f64>(object_count))));
+    f32 const spacing = 2.5f * _model_mesh.bounding_sphere.w;
+    f32 const grid_center = static_cast<f32>(columns - 1) * 0.5f;
+
+    // A square grid on the XY plane (Z is up), centered on the origin.
+    u32 i {0};
+    _world.each<Transform, Bounds>([&](Transform& transform, Bounds& bounds) {
+        transform.position = {
+            (static_cast<f32>(i % columns) - grid_center) * spacing,
+            (static_cast<f32>(i / columns) - grid_center) * spacing,
+            0.0f,
+        };
+        bounds.sphere = _model_mesh.bounding_sphere;
+        ++i;
+    });
+}
+
+void
+VulkanRenderer::_update_scene() noexcept {
+    using clock = std::chrono::high_resolution_clock;
+    using period = std::chrono::seconds::period;
+    static auto start_time = clock::now();
+
+    auto current_time = clock::now();
+    f32 time =
+        std::chrono::duration<f32, period>(current_time - start_time).count();
+
+    // Every object does a simple rotation around the Z-axis.
+    glm::quat const rotation = glm::angleAxis(
+        glm::sin(time * glm::radians(10.0f)) * 0.5f,
+        glm::vec3(0.0f, 0.0f, 1.0f)
+    );
+
+    _world.each<Transform, SceneNode const>(
+        _jobs,
+        [this, rotation](Transform& transform, SceneNode const& node) {
+            transform.rotation = rotation;
+            _transforms.set_local(node.id, transform);
+        }
+    );
+
+    // Only what was set above and below it is computed again.
+    _transforms.update(_jobs);
+
+    _world.each<SceneNode const, WorldTransform>(
+        _jobs,
+        [this](SceneNode const& node, WorldTransform& world) {
+            world.matrix = _transforms.world(node.id);
+        }
+    );
+
+    // Entities in a row drawing the same mesh and material are one batch
+    // (every copy of the model here).
+    Mesh batch_mesh {};
+    Material batch_material {};
+
+    auto const submit_batch = [&] {
+        if (!_scene_frame_transforms.empty()) {
+            submit(
+                _meshes[batch_mesh.id],
+                batch_material.id,
+                _scene_frame_transforms
+            );
+            _scene_frame_transforms.clear();
+        }
+    };
+
+    _world.each<WorldTransform const, Mesh const, Material const>(
+        [&](WorldTransform const& world,
+            Mesh const& mesh,
+            Material const& material) {
+            if (mesh.id != batch_mesh.id || material.id != batch_material.id) {
+                submit_batch();
+                batch_mesh = mesh;
+                batch_material = material;
+            }
+
+            _scene_frame_transforms.push_back(world.matrix);
+        }
+    );
+
+    submit_batch();
+}
+
+void
+VulkanRenderer::_create_instance_buffers() noexcept {
+    _instance_buffers.resize(_frames_in_flight);
+    _draw_count_buffers.resize(_frames_in_flight);
+    _draw_count_buffers_memory.resize(_frames_in_flight);
+
+    for (usize i {}; i < _frames_in_flight; ++i) {
+        _create_buffer_unique(
+            sizeof(DrawCounters),
+            vk::BufferUsageFlagBits::eStorageBuffer |
+                vk::BufferUsageFlagBits::eIndirectBuffer |
+                vk::BufferUsageFlagBits::eTransferDst,
+            vk::MemoryPropertyFlagBits::eDeviceLocal,
+            _draw_count_buffers[i],
+            _draw_count_buffers_memory[i]
+        );
+    }
+
+    usize const draws_per_object =
+        _gpu_culling ? std::max(_model_mesh.meshlet_count, 1U) : 1U;
+
+    usize const object_count = _world.entity_count();
+
+    for (usize i {}; i < _frames_in_flight; ++i) {
+        _reserve_instances(
+            i,
+            object_count,
+            object_count * draws_per_object
+        );
+    }
+
+    _reserve_visibility(object_count);
+}
+
+void
+VulkanRenderer::_reserve_instances(
+    usize frame,
+    usize instance_count,
+    usize draw_count
+) noexcept {
+    InstanceBuffer& instance_buffer = _instance_buffers[frame];
+
+    if (instance_count <= instance_buffer.capacity &&
+        draw_count <= instance_buffer.draw_capacity) {
+        return;
+    }
+
+    constexpr usize min_capacity {1'024};
+    usize capacity = std::max(instance_buffer.capacity, min_capacity);
+    usize draw_capacity = std::max(instance_buffer.draw_capacity, capacity);
+
+    while (capacity < instance_count) {
+        capacity *= 2;
+    }
+
+    while (draw_capacity < draw_count) {
+        draw_capacity *= 2;
+    }
+
+    if (instance_buffer.instances) {
+        Log::info(
+            "Instance buffer ",
+            frame,
+            " grows to ",
+            capacity,
+            " instances, ",
+            draw_capacity,
+            " draws"
+        );
+    }
+
+    // The slot's previous frame is done, retired for uniformity only.
+    _retire(std::move(instance_buffer.instances));
+    _retire(std::move(instance_buffer.instances_memory));
+    _retire(std::move(instance_buffer.draw_commands));
+    _retire(std::move(instance_buffer.draw_commands_memory));
+    _retire(std::move(instance_buffer.cluster_work));
+    _retire(std::move(instance_buffer.cluster_work_memory));
+
+    vk::DeviceSize const instances_size = sizeof(GpuObject) * capacity;
+
+    _create_buffer_unique(
+        instances_size,
+        vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent,
+        instance_buffer.instances,
+        instance_buffer.instances_memory
+    );
+
+    instance_buffer.instances_mapped = vk_expect_value(
+        // Persistent mapping.
+        _device->mapMemory(
+            *instance_buffer.instances_memory,
+            0,
+            instances_size
+        ),
+        "Failed to map memory for instance buffer."
+    );
+
+    // Only the GPU touches these. They also exist with CPU culling,
+    // so that set 0 is complete either way (a few bytes per instance).
+    _create_buffer_unique(
+        2 * sizeof(vk::DrawIndexedIndirectCommand) * draw_capacity,
+        vk::BufferUsageFlagBits::eStorageBuffer |
+            vk::BufferUsageFlagBits::eIndirectBuffer,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        instance_buffer.draw_commands,
+        instance_buffer.draw_commands_memory
+    );
+
+    _create_buffer_unique(
+        2 * sizeof(GpuClusterTask) * capacity,
+        vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        instance_buffer.cluster_work,
+        instance_buffer.cluster_work_memory
+    );
+
+    instance_buffer.capacity = capacity;
+    instance_buffer.draw_capacity = draw_capacity;
+
+    // Not in use, the frame slot has been waited (none exist at init).
+    if (!_descriptor_sets.empty()) {
+        _write_descriptor_set(frame);
+    }
+}
+
+void
+VulkanRenderer::_reserve_visibility(usize instance_count) noexcept {
+    if (!_occlusion_culling || instance_count <= _visibility_capacity) {
+        return;
+    }
+
+    constexpr usize min_capacity {1'024};
+    usize capacity = std::max(_visibility_capacity, min_capacity);
+
+    while (capacity < instance_count) {
+        capacity *= 2;
+    }
+
+    // Frames in flight may still use the old one.
+    _retire(std::move(_visibility_buffer));
+    _retire(std::move(_visibility_buffer_memory));
+
+    _create_buffer_unique(
+        sizeof(u32) * capacity,
+        vk::BufferUsageFlagBits::eStorageBuffer |
+            vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        _visibility_buffer,
+        _visibility_buffer_memory
+    );
+
+    _visibility_capacity = capacity;
+    // Cleared by the next frame: nothing is drawn in its early phase,
+    // everything is tested in the late one.
+    _visibility_cleared = false;
+    _mark_descriptor_sets_stale();
+}
+
+void
+VulkanRenderer::_upload_instances() noexcept {
+    _reserve_instances(_current_frame, _instances.size(), _max_draw_count);
+    _reserve_visibility(_instances.size());
+
+    // Streamed in order, write combined memory is never read back.
+    std::memcpy(
+        _instance_buffers[_current_frame].instances_mapped,
+        _instances.data(),
+        _instances.size() * sizeof(GpuObject)
+    );
+}
+
+void
+VulkanRenderer::_record_cull_reset(vk::CommandBuffer command_buffer
+) noexcept {
+    // Zero counts, and dispatches of zero workgroups.
+    DrawCounters const counters {};
+    command_buffer.updateBuffer(
+        *_draw_count_buffers[_current_frame],
+        0, // Offset.
+        sizeof(counters),
+        &counters
+    );
+
+    if (_occlusion_culling && !_visibility_cleared) {
+        command_buffer.fillBuffer(*_visibility_buffer, 0, vk::WholeSize, 0);
+        _visibility_cleared = true;
+    }
+}
+
+void
+VulkanRenderer::_record_culling(
+    vk::CommandBuffer command_buffer,
+    CullPhase phase
+) noexcept {
+    vk::Buffer const draw_count = *_draw_count_buffers[_current_frame];
+    u32 const object_count = static_cast<u32>(_instances.size());
+    u32 const list = static_cast<u32>(phase);
+
+    command_buffer.bindPipeline(
+        vk::PipelineBindPoint::eCompute,
+        *_cull_pipeline
+    );
+
+    command_buffer.bindDescriptorSets(
+        vk::PipelineBindPoint::eCompute,
+        _cull_pipeline_layout,
+        0, // First set.
+        *_descriptor_sets[_current_frame],
+        _scene_uniform_offset // Dynamic offset.
+    );
+
+    CullPushConstants const cull_constants {
+        .object_count = object_count,
+        .phase = phase,
+        .occlusion_culling = _occlusion_culling ? 1U : 0U,
+        .draw_capacity =
+            static_cast<u32>(_instance_buffers[_current_frame].draw_capacity),
+    };
+
+    command_buffer.pushConstants(
+        _cull_pipeline_layout,
+        vk::ShaderStageFlagBits::eCompute,
+        0, // Offset.
+        sizeof(cull_constants),
+        &cull_constants
+    );
+
+    command_buffer.dispatch(
+        (object_count + s_cull_group_size - 1) / s_cull_group_size,
+        1,
+        1
+    );
+
+    // The objects left for cluster culling and their dispatch size. Inside
+    // the pass: both dispatches share their bindings.
+    constexpr vk::MemoryBarrier cluster_work_barrier {
+        .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+        .dstAccessMask = vk::AccessFlagBits::eShaderRead |
+            vk::AccessFlagBits::eShaderWrite |
+            vk::AccessFlagBits::eIndirectCommandRead,
+    };
+
+    command_buffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eComputeShader |
+            vk::PipelineStageFlagBits::eDrawIndirect,
+        vk::DependencyFlags {},
+        cluster_work_barrier,
+        nullptr,
+        nullptr
+    );
+
+    // Same layout: the set and push constants stay bound.
+    command_buffer.bindPipeline(
+        vk::PipelineBindPoint::eCompute,
+        *_cluster_cull_pipeline
+    );
+
+    command_buffer.dispatchIndirect(
+        draw_count,
+        offsetof(DrawCounters, cluster_dispatches) +
+            list * sizeof(vk::DispatchIndirectCommand)
+    );
+}
+
+#pragma endregion SCENE
+
 #pragma region TEXTURES
 
 void
@@ -2132,27 +4860,15 @@ VulkanRenderer::_create_image(
     vk::UniqueImage& image,
     vk::UniqueDeviceMemory& image_memory
 ) noexcept {
-    vk::ImageCreateInfo const image_info {
-        .flags = {}, // Optional.
-        .imageType = vk::ImageType::e2D,
-        .format = format,
-        .extent = {.width = width, .height = height, .depth = 1},
-        .mipLevels = mip_levels,
-        .arrayLayers = 1,
-        .samples = sample_count,
-        .tiling = tiling,
-        .usage = usage,
-        // Image will only be used by one queue family; graphics.
-        .sharingMode = vk::SharingMode::eExclusive,
-        // eUndefined: Not usable by the GPU and the very first transition will discrad the texels.
-        // ePreinitialized: Not usable by the GPU, but the first transition will preserve the texels.
-        // Preinitialized should be use along eLinear ImageTiling.
-        .initialLayout = vk::ImageLayout::eUndefined,
-    };
-
-    image = vk_expect_value(
-        _device->createImageUnique(image_info),
-        "Failed to create image."
+    _create_image(
+        width,
+        height,
+        mip_levels,
+        sample_count,
+        format,
+        tiling,
+        usage,
+        image
     );
 
     vk::MemoryRequirements const mem_requirements =
@@ -2163,7 +4879,7 @@ VulkanRenderer::_create_image(
         .memoryTypeIndex = _find_memory_type(
             _physical_device,
             mem_requirements.memoryTypeBits,
-            vk::MemoryPropertyFlagBits::eDeviceLocal
+            properties
         ),
     };
 
@@ -2178,6 +4894,41 @@ VulkanRenderer::_create_image(
     );
 }
 
+void
+VulkanRenderer::_create_image(
+    u32 width,
+    u32 height,
+    u32 mip_levels,
+    vk::SampleCountFlagBits sample_count,
+    vk::Format format,
+    vk::ImageTiling tiling,
+    vk::ImageUsageFlags usage,
+    vk::UniqueImage& image
+) noexcept {
+    vk::ImageCreateInfo const image_info {
+        .flags = {}, // Optional.
+        .imageType = vk::ImageType::e2D,
+        .format = format,
+        .extent = {.width = width, .height = height, .depth = 1},
+        .mipLevels = mip_levels,
+        .arrayLayers = 1,
+        .samples = sample_count,
+        .tiling = tiling,
+        .usage = usage,
+        // Image will only be used by one queue family; graphics.
+        .sharingMode = vk::SharingMode::eExclusive,
+        // eUndefined: Not usable by the GPU and the very first transition will discrad the texels.
+        // ePreinitialized: Not usable by the GPU, but the first transition will preserve the texels.
+        // Preinitialized should be use along eLinear ImageTiling.
+        .initialLayout = vk::ImageLayout::eUndefined,
+    };
+
+    image = vk_expect_value(
+        _device->createImageUnique(image_info),
+        "Failed to create image."
+    );
+}
+
 void
 VulkanRenderer::_copy_buffer_to_image(
     vk::UniqueBuffer& buffer,
@@ -2218,83 +4969,30 @@ VulkanRenderer::_copy_buffer_to_image(
     Log::info("Buffer successfully copied to image.");
 }
 
-constexpr bool
-_has_stencil_component(vk::Format format) noexcept {
-    return format == vk::Format::eD32SfloatS8Uint ||
-        format == vk::Format::eD24UnormS8Uint;
-}
-
-void
-VulkanRenderer::_transition_image_layout(
-    vk::Image image,
-    vk::Format format,
-    vk::ImageLayout old_layout,
-    vk::ImageLayout new_layout,
-    u32 mip_levels
-) noexcept {
-    auto command_buffer = _begin_single_time_commands();
-
-    // Use a barrier to control access to resources (Images, Buffers).
-    vk::ImageMemoryBarrier image_barrier {
-        .oldLayout = old_layout,
-        .newLayout = new_layout,
-        // If we are using the barrier to transfer queue family ownership,
-        // then these two fields should be the indices of the queue families.
-        .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
-        .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
-        .image = image,
-        .subresourceRange =
-            {.aspectMask = vk::ImageAspectFlagBits::eColor,
-             .baseMipLevel = 0,
-             .levelCount = _mip_levels,
-             .baseArrayLayer = 0,
-             .layerCount = 1},
-    };
-
-    vk::PipelineStageFlags source_stage {};
-    vk::PipelineStageFlags destination_stage {};
-
-    if (old_layout == vk::ImageLayout::eUndefined &&
-        new_layout == vk::ImageLayout::eTransferDstOptimal) {
-        image_barrier.srcAccessMask = {},
-        image_barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-
-        source_stage = vk::PipelineStageFlagBits::eTopOfPipe;
-        destination_stage = vk::PipelineStageFlagBits::eTransfer;
-    } else if (old_layout == vk::ImageLayout::eTransferDstOptimal &&
-               new_layout == vk::ImageLayout::eShaderReadOnlyOptimal) {
-        image_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-        image_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-
-        source_stage = vk::PipelineStageFlagBits::eTransfer;
-        destination_stage = vk::PipelineStageFlagBits::eFragmentShader;
-    } else if (old_layout == vk::ImageLayout::eUndefined &&
-               new_layout == vk::ImageLayout::eDepthStencilAttachmentOptimal) {
-        image_barrier.srcAccessMask = {};
-        image_barrier.dstAccessMask =
-            vk::AccessFlagBits::eDepthStencilAttachmentRead |
-            vk::AccessFlagBits::eDepthStencilAttachmentWrite;
-
-        source_stage = vk::PipelineStageFlagBits::eTopOfPipe;
-        // The depth buffer will be read to perform depth tests to see if
-        // a fragment is visible, and will be written to when a new fragment is drawn.
-        // The reading happens in the eEarlyFragmentTests stage and the writing
-        // in the eLateFragmentTests stage.
-        destination_stage = vk::PipelineStageFlagBits::eEarlyFragmentTests;
-    } else {
-        core_assert(false, "Unsupported layout transition.");
-    }
-
-    if (new_layout == vk::ImageLayout::eDepthStencilAttachmentOptimal) {
-        image_barrier.subresourceRange.aspectMask =
-            vk::ImageAspectFlagBits::eDepth;
+void
+VulkanRenderer::_transition_image_layout(
+    vk::Image image,
+    vk::ImageAspectFlags aspect,
+    u32 mip_levels,
+    RenderGraphBarrier const& barrier
+) noexcept {
+    auto command_buffer = _begin_single_time_commands();
 
-        if (_has_stencil_component(format)) {
-            image_barrier.subresourceRange.aspectMask |=
-                vk::ImageAspectFlagBits::eStencil;
+    vk::ImageMemoryBarrier const image_barrier = _to_image_barrier(
+        barrier,
+        image,
+        {
+            .aspectMask = aspect,
+            .baseMipLevel = 0,
+            .levelCount = mip_levels,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
         }
-    }
-    // Else is default aspect mask (Color).
+    );
+
+    vk::PipelineStageFlags const source_stage = barrier.src_usages != 0
+        ? _usage_stages(barrier.src_usages)
+        : vk::PipelineStageFlagBits::eTopOfPipe;
 
     // Transfer stage is a pseude-stage. See More:
     // src: https://docs.vulkan.org/spec/latest/chapters/synchronization.html#VkPipelineStageFlagBits
@@ -2302,7 +5000,8 @@ VulkanRenderer::_transition_image_layout(
         // Allowed values:
         // src: https://www.khronos.org/registry/vulkan/specs/1.3-extensions/html/chap7.html#synchronization-access-types-supported
         source_stage, // In which pipeline stage the operations happen?
-        destination_stage, // In which pipeline stage will the operations wait?
+        // In which pipeline stage will the operations wait?
+        _usage_stages(barrier.dst_reads | barrier.dst_writes),
         vk::DependencyFlags {},
         nullptr,
         nullptr,
@@ -2443,8 +5142,12 @@ VulkanRenderer::_create_texture_image() noexcept {
     int tex_height {0};
     int tex_channels {0};
 
-    stbi_uc* pixels = stbi_load(
-        _default_texture_path.c_str(),
+    // Decode straight from the page cache, no intermediate file buffer.
+    MappedAsset const texture_file = MappedAsset::open(_default_texture_path);
+
+    stbi_uc* pixels = stbi_load_from_memory(
+        reinterpret_cast<stbi_uc const*>(texture_file.data()),
+        static_cast<int>(texture_file.size()),
         &tex_width,
         &tex_height,
         &tex_channels,
@@ -2513,12 +5216,15 @@ VulkanRenderer::_create_texture_image() noexcept {
         _texture_image_memory
     );
 
+    // Every level is copied or blitted into, nothing to wait for.
     _transition_image_layout(
         *_texture_image,
-        image_format,
-        vk::ImageLayout::eUndefined,
-        vk::ImageLayout::eTransferDstOptimal,
-        _mip_levels
+        vk::ImageAspectFlagBits::eColor,
+        _mip_levels,
+        {
+            .dst_writes = to_mask(RenderGraphUsage::Transfer),
+            .new_layout = RenderGraphLayout::TransferDestination,
+        }
     );
 
     _copy_buffer_to_image(
@@ -2537,6 +5243,10 @@ VulkanRenderer::_create_texture_image() noexcept {
         tex_height,
         _mip_levels
     );
+
+    // The copy is still in flight.
+    _retire(std::move(staging_buffer));
+    _retire(std::move(staging_buffer_memory));
 }
 
 void
@@ -2639,11 +5349,20 @@ VulkanRenderer::_find_depth_format(vk::PhysicalDevice const& physical_device
         vk::Format::eD24UnormS8Uint
     };
 
+    // Occlusion culling reads it to build the depth pyramid.
+    vk::FormatFeatureFlags features {
+        vk::FormatFeatureFlagBits::eDepthStencilAttachment
+    };
+
+    if (_occlusion_culling) {
+        features |= vk::FormatFeatureFlagBits::eSampledImage;
+    }
+
     return _find_supported_format(
         physical_device,
         candidates,
         vk::ImageTiling::eOptimal,
-        vk::FormatFeatureFlagBits::eDepthStencilAttachment
+        features
     );
 }
 
@@ -2651,7 +5370,14 @@ void
 VulkanRenderer::_create_depth_resources() noexcept {
     // Depth image should have the same resolution as the color attachment,
     // defined by the swap chain extent.
-    vk::Format const depth_format = _find_depth_format(_physical_device);
+    vk::Format const depth_format = _depth_format;
+
+    // Occlusion culling reduces it into the depth pyramid.
+    vk::ImageUsageFlags usage {vk::ImageUsageFlagBits::eDepthStencilAttachment};
+
+    if (_occlusion_culling) {
+        usage |= vk::ImageUsageFlagBits::eSampled;
+    }
 
     _create_image(
         _swap_chain_extent.width,
@@ -2660,44 +5386,495 @@ VulkanRenderer::_create_depth_resources() noexcept {
         _msaa_samples,
         depth_format,
         vk::ImageTiling::eOptimal,
-        vk::ImageUsageFlagBits::eDepthStencilAttachment,
-        vk::MemoryPropertyFlagBits::eDeviceLocal,
-        _depth_image,
-        _depth_image_memory
+        usage,
+        _depth_image
     );
 
     core_assert(_depth_image, "OHHHH");
 
-    _depth_image_view = _create_image_view(
-        *_depth_image,
-        depth_format,
-        vk::ImageAspectFlagBits::eDepth,
-        1 // Mip levels.
+    // Its layout is the frame graph's, from undefined every frame.
+    _depth_image_requirements =
+        _device->getImageMemoryRequirements(*_depth_image);
+}
+
+#pragma endregion
+
+#pragma region DEPTH_PYRAMID
+
+// Largest power of two not above value (value > 0).
+constexpr u32
+_previous_power_of_two(u32 value) noexcept {
+    return u32 {1} << (std::bit_width(value) - 1);
+}
+
+void
+VulkanRenderer::_create_depth_pyramid_pipelines() noexcept {
+    if (!_occlusion_culling) {
+        return;
+    }
+
+    // The first level reads the depth buffer, every sample of it.
+    std::vector<std::string> first_level_keywords {"FIRST_LEVEL"};
+    if (_msaa_samples != vk::SampleCountFlagBits::e1) {
+        first_level_keywords.emplace_back("MULTISAMPLED");
+    }
+
+    ShaderVariantId const first_level = _compute_shader_variant(
+        s_depth_pyramid_shader_path,
+        first_level_keywords
     );
+    ShaderVariantId const other_levels =
+        _compute_shader_variant(s_depth_pyramid_shader_path);
 
-    _transition_image_layout(
-        *_depth_image,
-        depth_format,
-        vk::ImageLayout::eUndefined,
-        vk::ImageLayout::eDepthStencilAttachmentOptimal,
-        1 // Mip levels.
+    // Source level (the depth buffer for the first one) and destination,
+    // the same for every level.
+    std::array const stages {_reflect_shader(first_level)};
+    std::optional<ShaderLayout> const layout = merge_shader_layouts(stages);
+    core_assert(
+        layout && layout->sets.size() == 1,
+        "The depth pyramid uses set 0 only."
+    );
+
+    if (!layout || layout->sets.size() != 1) {
+        return;
+    }
+
+    _depth_pyramid_set_layout = _descriptor_set_layout_for(layout->sets[0]);
+    _depth_pyramid_pipeline_layout =
+        _pipeline_layout_for({&_depth_pyramid_set_layout, 1}, *layout);
+
+    auto const create_pipeline = [this](ShaderVariantId variant) {
+        std::span<u32 const> const spirv = _shader_variants.spirv(variant);
+        core_assert(!spirv.empty(), "Failed to compile depth pyramid.");
+
+        vk::UniqueShaderModule const shader_module =
+            _create_shader_module(_device, spirv);
+
+        vk::ComputePipelineCreateInfo const pipeline_info {
+            .stage =
+                {
+                    .stage = vk::ShaderStageFlagBits::eCompute,
+                    .module = *shader_module,
+                    .pName = "main",
+                },
+            .layout = _depth_pyramid_pipeline_layout,
+        };
+
+        return vk_expect_value(
+            _device->createComputePipelineUnique(nullptr, pipeline_info),
+            "Failed to create Depth Pyramid Pipeline"
+        );
+    };
+
+    _depth_pyramid_first_pipeline = create_pipeline(first_level);
+    _depth_pyramid_pipeline = create_pipeline(other_levels);
+
+    // Only read with texelFetch(), filtering does not matter.
+    constexpr vk::SamplerCreateInfo sampler_info {
+        .magFilter = vk::Filter::eNearest,
+        .minFilter = vk::Filter::eNearest,
+        .mipmapMode = vk::SamplerMipmapMode::eNearest,
+        .addressModeU = vk::SamplerAddressMode::eClampToEdge,
+        .addressModeV = vk::SamplerAddressMode::eClampToEdge,
+        .addressModeW = vk::SamplerAddressMode::eClampToEdge,
+        .maxLod = vk::LodClampNone,
+    };
+
+    _depth_pyramid_sampler = vk_expect_value(
+        _device->createSamplerUnique(sampler_info),
+        "Failed to create depth pyramid sampler."
+    );
+
+    Log::info(
+        Log::LIGHT_GREEN,
+        "Depth Pyramid Pipelines successfully created."
     );
 }
 
-#pragma endregion
+void
+VulkanRenderer::_create_depth_pyramid() noexcept {
+    if (!_occlusion_culling) {
+        return;
+    }
+
+    // Rounded down so that every level halves exactly. A texel of the
+    // first level then covers at most 3x3 depth texels.
+    _depth_pyramid_extent = {
+        .width = _previous_power_of_two(_swap_chain_extent.width),
+        .height = _previous_power_of_two(_swap_chain_extent.height),
+    };
+    _depth_pyramid_levels = static_cast<u32>(std::bit_width(
+        std::max(_depth_pyramid_extent.width, _depth_pyramid_extent.height)
+    ));
+
+    constexpr vk::Format format {vk::Format::eR32Sfloat};
+
+    _create_image(
+        _depth_pyramid_extent.width,
+        _depth_pyramid_extent.height,
+        _depth_pyramid_levels,
+        vk::SampleCountFlagBits::e1,
+        format,
+        vk::ImageTiling::eOptimal,
+        vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        _depth_pyramid,
+        _depth_pyramid_memory
+    );
+
+    _depth_pyramid_view = _create_image_view(
+        *_depth_pyramid,
+        format,
+        vk::ImageAspectFlagBits::eColor,
+        _depth_pyramid_levels
+    );
+
+    // Written one level at a time.
+    _depth_pyramid_level_views.resize(_depth_pyramid_levels);
+
+    for (u32 level {}; level < _depth_pyramid_levels; ++level) {
+        vk::ImageViewCreateInfo const view_info {
+            .image = *_depth_pyramid,
+            .viewType = vk::ImageViewType::e2D,
+            .format = format,
+            .subresourceRange =
+                {
+                    .aspectMask = vk::ImageAspectFlagBits::eColor,
+                    .baseMipLevel = level,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+        };
+
+        _depth_pyramid_level_views[level] = vk_expect_value(
+            _device->createImageViewUnique(view_info),
+            "Failed to create depth pyramid level view."
+        );
+    }
+
+    vk::CommandBuffer command_buffer = _begin_single_time_commands();
+
+    // Read and written in place from now on.
+    vk::ImageMemoryBarrier const general_barrier {
+        .srcAccessMask = {},
+        .dstAccessMask =
+            vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        .oldLayout = vk::ImageLayout::eUndefined,
+        .newLayout = vk::ImageLayout::eGeneral,
+        .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+        .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+        .image = *_depth_pyramid,
+        .subresourceRange =
+            {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .baseMipLevel = 0,
+                .levelCount = _depth_pyramid_levels,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+    };
+
+    command_buffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTopOfPipe,
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::DependencyFlags {},
+        nullptr,
+        nullptr,
+        general_barrier
+    );
+
+    _end_single_time_commands(command_buffer);
+
+    std::array const pool_sizes {
+        vk::DescriptorPoolSize {
+            .type = vk::DescriptorType::eCombinedImageSampler,
+            .descriptorCount = _depth_pyramid_levels,
+        },
+        vk::DescriptorPoolSize {
+            .type = vk::DescriptorType::eStorageImage,
+            .descriptorCount = _depth_pyramid_levels,
+        },
+    };
+
+    vk::DescriptorPoolCreateInfo const pool_info {
+        .maxSets = _depth_pyramid_levels,
+        .poolSizeCount = static_cast<u32>(pool_sizes.size()),
+        .pPoolSizes = pool_sizes.data(),
+    };
+
+    _depth_pyramid_descriptor_pool = vk_expect_value(
+        _device->createDescriptorPoolUnique(pool_info),
+        "Failed to create depth pyramid Descriptor Pool."
+    );
+
+    std::vector<vk::DescriptorSetLayout> const layouts(
+        _depth_pyramid_levels,
+        _depth_pyramid_set_layout
+    );
+
+    vk::DescriptorSetAllocateInfo const alloc_info {
+        .descriptorPool = *_depth_pyramid_descriptor_pool,
+        .descriptorSetCount = _depth_pyramid_levels,
+        .pSetLayouts = layouts.data(),
+    };
+
+    _depth_pyramid_sets = vk_expect_value(
+        _device->allocateDescriptorSets(alloc_info),
+        "Failed to allocate depth pyramid Descriptor Sets."
+    );
+
+    for (u32 level {}; level < _depth_pyramid_levels; ++level) {
+        bool const first_level = level == 0;
+
+        vk::DescriptorImageInfo const source_info {
+            .sampler = *_depth_pyramid_sampler,
+            .imageView = first_level ? *_depth_image_view
+                                     : *_depth_pyramid_level_views[level - 1],
+            // See _record_depth_pyramid().
+            .imageLayout = first_level
+                ? vk::ImageLayout::eShaderReadOnlyOptimal
+                : vk::ImageLayout::eGeneral,
+        };
+
+        vk::DescriptorImageInfo const destination_info {
+            .imageView = *_depth_pyramid_level_views[level],
+            .imageLayout = vk::ImageLayout::eGeneral,
+        };
+
+        std::array const level_writes {
+            vk::WriteDescriptorSet {
+                .dstSet = _depth_pyramid_sets[level],
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+                .pImageInfo = &source_info,
+            },
+            vk::WriteDescriptorSet {
+                .dstSet = _depth_pyramid_sets[level],
+                .dstBinding = 1,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = vk::DescriptorType::eStorageImage,
+                .pImageInfo = &destination_info,
+            },
+        };
+
+        _device->updateDescriptorSets(level_writes, nullptr);
+    }
+
+    // Set 0 samples the whole pyramid in the cull shader.
+    _mark_descriptor_sets_stale();
+
+    Log::info(
+        "Depth pyramid created: ",
+        _depth_pyramid_extent.width,
+        "x",
+        _depth_pyramid_extent.height,
+        ", ",
+        _depth_pyramid_levels,
+        " levels."
+    );
+}
+
+void
+VulkanRenderer::_record_depth_pyramid(vk::CommandBuffer command_buffer
+) noexcept {
+    // Each level is read by the next one. The graph orders the depth
+    // buffer before, and the last level before the late cull.
+    constexpr vk::MemoryBarrier level_barrier {
+        .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+        .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+    };
+
+    for (u32 level {}; level < _depth_pyramid_levels; ++level) {
+        if (level < 2) {
+            command_buffer.bindPipeline(
+                vk::PipelineBindPoint::eCompute,
+                level == 0 ? *_depth_pyramid_first_pipeline
+                           : *_depth_pyramid_pipeline
+            );
+        }
+
+        command_buffer.bindDescriptorSets(
+            vk::PipelineBindPoint::eCompute,
+            _depth_pyramid_pipeline_layout,
+            0, // First set.
+            _depth_pyramid_sets[level],
+            nullptr // Dynamic offsets.
+        );
+
+        u32 const width = std::max(_depth_pyramid_extent.width >> level, 1U);
+        u32 const height = std::max(_depth_pyramid_extent.height >> level, 1U);
+
+        command_buffer.dispatch(
+            (width + s_depth_pyramid_group_size - 1) /
+                s_depth_pyramid_group_size,
+            (height + s_depth_pyramid_group_size - 1) /
+                s_depth_pyramid_group_size,
+            1
+        );
+
+        if (level + 1 < _depth_pyramid_levels) {
+            command_buffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::DependencyFlags {},
+                level_barrier,
+                nullptr,
+                nullptr
+            );
+        }
+    }
+}
+
+#pragma endregion DEPTH_PYRAMID
 
 #pragma region MODEL
 
 void
 VulkanRenderer::_load_model() noexcept {
-    static std::unordered_map<Vertex, u32> s_vertex_cache {};
+    core_assert(!_model_file_path.empty(), "Please provide model's file path");
+
+    // Cooked next to the model ("viking_room.obj.vmesh").
+    std::filesystem::path const model_path {_model_file_path};
+    std::filesystem::path cooked_path {model_path};
+    cooked_path += ".vmesh";
+
+    MeshSourceStamp const source = MeshSourceStamp::of(model_path);
+    MeshFile const cooked = MeshFile::open(cooked_path);
+    MeshFileContents const& contents = cooked.contents();
+
+    bool const up_to_date = cooked.is_valid() && contents.source == source &&
+        contents.vertex_stride == sizeof(Vertex);
+
+    glm::vec4 bounding_sphere {};
+
+    if (up_to_date) {
+        _vertices.resize(contents.vertices.size() / sizeof(Vertex));
+        std::memcpy(
+            _vertices.data(),
+            contents.vertices.data(),
+            contents.vertices.size()
+        );
+        _indices.assign(contents.indices.begin(), contents.indices.end());
+        _meshlets.assign(contents.meshlets.begin(), contents.meshlets.end());
+        _mesh_lods.assign(contents.lods.begin(), contents.lods.end());
+        bounding_sphere = contents.bounding_sphere;
+
+        Log::info("Loaded cooked mesh: ", cooked_path.string());
+    } else {
+        _parse_model_obj();
+
+        std::vector<glm::vec3> positions(_vertices.size());
+        std::ranges::transform(
+            _vertices,
+            positions.begin(),
+            &Vertex::position
+        );
+
+        // Every level shares the vertices, each has its own indices and
+        // meshlets.
+        LodMesh lod_mesh = build_lod_chain(positions, _indices);
+        _indices = std::move(lod_mesh.indices);
+        _meshlets = std::move(lod_mesh.meshlets);
+        _mesh_lods = std::move(lod_mesh.lods);
+
+        // Bounding sphere around the center of the bounding box, a bit
+        // looser than the minimal one but good enough for culling.
+        glm::vec3 min_corner {std::numeric_limits<f32>::max()};
+        glm::vec3 max_corner {std::numeric_limits<f32>::lowest()};
+
+        for (glm::vec3 const& position : positions) {
+            min_corner = glm::min(min_corner, position);
+            max_corner = glm::max(max_corner, position);
+        }
+
+        glm::vec3 const center = (min_corner + max_corner) * 0.5f;
+        f32 radius {0.0f};
+
+        for (glm::vec3 const& position : positions) {
+            radius = std::max(radius, glm::distance(center, position));
+        }
+
+        bounding_sphere = glm::vec4(center, radius);
+
+        // Only costs the next load a rebuild if it fails (read-only assets).
+        bool const written = MeshFile::write(
+            cooked_path,
+            {
+                .source = source,
+                .vertex_stride = sizeof(Vertex),
+                .vertices = std::as_bytes(std::span {_vertices}),
+                .indices = _indices,
+                .meshlets = _meshlets,
+                .lods = _mesh_lods,
+                .bounding_sphere = bounding_sphere,
+            }
+        );
+
+        if (!written) {
+            Log::warn("Failed to write cooked mesh: ", cooked_path.string());
+        }
+    }
+
+    core_assert(!_mesh_lods.empty(), "A mesh has at least its full LOD.");
+
+    Log::info(
+        "Model: ",
+        _vertices.size(),
+        " vertices, ",
+        _mesh_lods.size(),
+        " LODs."
+    );
+
+    for (usize i {}; i < _mesh_lods.size(); ++i) {
+        Log::sub_info(
+            "LOD ",
+            i,
+            ": ",
+            _mesh_lods[i].index_count / 3,
+            " triangles, ",
+            _mesh_lods[i].meshlet_count,
+            " meshlets, error ",
+            _mesh_lods[i].error
+        );
+    }
+
+    MeshLod const& full = _mesh_lods.front();
+
+    _model_mesh = {
+        .index_count = full.index_count,
+        .first_index = 0,
+        .vertex_offset = 0,
+        .bounding_sphere = bounding_sphere,
+        .first_meshlet = 0,
+        .meshlet_count = full.meshlet_count,
+        .first_lod = 0,
+        .lod_count = static_cast<u32>(_mesh_lods.size()),
+    };
+}
+
+void
+VulkanRenderer::_parse_model_obj() noexcept {
+    // Local, so that hot-reloading a model starts from an empty cache.
+    std::unordered_map<Vertex, u32> vertex_cache {};
     tinyobj::attrib_t attributes {};
     std::vector<tinyobj::shape_t> shapes {};
     std::vector<tinyobj::material_t> materials {};
     std::string warn {};
     std::string err {};
 
-    core_assert(!_model_file_path.empty(), "Please provide model's file path");
+    // Parse the OBJ text in place from the mapping.
+    MappedAsset const model_file = MappedAsset::open(_model_file_path);
+    SpanStreamBuffer model_buffer {model_file.bytes()};
+    std::istream model_stream {&model_buffer};
+
+    // Materials are still looked up next to the model.
+    tinyobj::MaterialFileReader material_reader {
+        std::filesystem::path(_model_file_path).parent_path().string() + "/"
+    };
 
     if (!tinyobj::LoadObj(
             &attributes,
@@ -2705,7 +5882,8 @@ VulkanRenderer::_load_model() noexcept {
             &materials,
             &warn,
             &err,
-            _model_file_path.c_str()
+            &model_stream,
+            &material_reader
         )) {
         core_assert(false, warn + err);
     }
@@ -2727,16 +5905,203 @@ VulkanRenderer::_load_model() noexcept {
                      1.0f - attributes.texcoords[2 * index.texcoord_index + 1]},
             };
 
-            if (s_vertex_cache.count(vertex) == 0) {
-                s_vertex_cache[vertex] = static_cast<u32>(_vertices.size());
+            if (vertex_cache.count(vertex) == 0) {
+                vertex_cache[vertex] = static_cast<u32>(_vertices.size());
                 _vertices.push_back(vertex);
             }
 
-            _indices.push_back(s_vertex_cache[vertex]);
+            _indices.push_back(vertex_cache[vertex]);
         }
     }
 }
 
 #pragma endregion MODEL
 
-} // namespace core
\ No newline at end of file
+#pragma region HOT_RELOAD
+
+void
+VulkanRenderer::_process_asset_changes() noexcept {
+    std::vector<AssetChange> const changes = _asset_watcher.poll();
+
+    bool pipeline_dirty {false};
+    bool cull_pipeline_dirty {false};
+    bool cluster_cull_pipeline_dirty {false};
+
+    for (AssetChange const& change : changes) {
+        if (change.id == _vertex_shader_id ||
+            change.id == _fragment_shader_id) {
+            pipeline_dirty |= _reload_shader(change.id);
+        } else if (change.id == _cull_shader_id && _gpu_culling) {
+            cull_pipeline_dirty |= _reload_shader(change.id);
+        } else if (change.id == _cluster_cull_shader_id && _gpu_culling) {
+            cluster_cull_pipeline_dirty |= _reload_shader(change.id);
+        } else if (change.id == _texture_id) {
+            _reload_texture();
+        } else if (change.id == _model_id) {
+            _reload_model();
+        }
+    }
+
+    // Both stages may change at once (e.g. a branch checkout), build once.
+    // In the background: drawn with the previous pipelines until then.
+    if (pipeline_dirty) {
+        Log::info("Hot-reload: rebuilding graphics pipelines.");
+
+        for (MaterialPipeline& pipeline : _material_pipelines) {
+            PipelineKey const key = _pipeline_key(pipeline);
+
+            // Reloaded again before the new one was ready: the older, ready,
+            // pipeline stays the one to draw with.
+            if (!pipeline.previous_key && _pipeline_cache.find(key)) {
+                pipeline.previous_key = key;
+            }
+
+            _request_shader_variants(pipeline);
+            _pipeline_cache.find(_pipeline_key(pipeline));
+        }
+    }
+
+    // Materials and the fallback move to their new pipeline once it is
+    // ready, the previous ones are retired when nothing draws with them.
+    std::vector<PipelineKey> previous_keys {};
+
+    for (MaterialPipeline& pipeline : _material_pipelines) {
+        if (pipeline.previous_key &&
+            _pipeline_cache.find(_pipeline_key(pipeline))) {
+            previous_keys.push_back(*pipeline.previous_key);
+            pipeline.previous_key.reset();
+        }
+    }
+
+    PipelineKey const default_key = _default_pipeline_key();
+
+    if (default_key != _fallback_pipeline_key &&
+        _pipeline_cache.find(default_key)) {
+        previous_keys.push_back(_fallback_pipeline_key);
+        _fallback_pipeline_key = default_key;
+    }
+
+    for (PipelineKey const& key : previous_keys) {
+        _retire_unused_pipeline(key);
+    }
+
+    if (cull_pipeline_dirty) {
+        Log::info("Hot-reload: rebuilding cull pipeline.");
+        _retire(std::move(_cull_pipeline));
+        _create_cull_pipeline();
+    }
+
+    if (cluster_cull_pipeline_dirty) {
+        Log::info("Hot-reload: rebuilding cluster cull pipeline.");
+        _retire(std::move(_cluster_cull_pipeline));
+        _create_cluster_cull_pipeline();
+    }
+}
+
+bool
+VulkanRenderer::_reload_shader(AssetId id) noexcept {
+    bool const is_vertex = id == _vertex_shader_id;
+    bool const is_cluster_cull = id == _cluster_cull_shader_id;
+    bool const is_compute = id == _cull_shader_id || is_cluster_cull;
+    std::string const path = is_cluster_cull
+        ? std::string {s_cluster_cull_shader_path}
+        : is_compute ? std::string {s_cull_shader_path}
+        : is_vertex  ? _vertex_shader_path
+                     : _fragment_shader_path;
+
+    shaderc_shader_kind const kind = is_compute
+        ? shaderc_shader_kind::shaderc_compute_shader
+        : is_vertex ? shaderc_shader_kind::shaderc_vertex_shader
+                    : shaderc_shader_kind::shaderc_fragment_shader;
+
+    MappedAsset const source = AssetDatabase::map_asset_file(path);
+    u64 const shader_source = _shader_variants.add_source(
+        AssetDatabase::absolute_path(path).string(),
+        source.text(),
+        kind
+    );
+
+    // Variants compile when pipelines ask for them, a failed one keeps
+    // its material on its previous pipeline.
+    if (!is_compute) {
+        (is_vertex ? _vertex_shader_source : _fragment_shader_source) =
+            shader_source;
+        return true;
+    }
+
+    ShaderVariantId const variant = _shader_variants.request(shader_source, {});
+    std::optional<ShaderReflection> const reflection =
+        reflect_spirv(_shader_variants.spirv(variant));
+
+    // Keep rendering with the old pipeline until the shader compiles. Set
+    // 0 is made once, new bindings need a restart.
+    if (!reflection || !fits_shader_layout(*reflection, _cull_layout)) {
+        Log::warn("Hot-reload: keeping previous version of ", path);
+        return false;
+    }
+
+    (is_cluster_cull ? _cluster_cull_shader : _cull_shader) = variant;
+
+    return true;
+}
+
+void
+VulkanRenderer::_reload_texture() noexcept {
+    Log::info("Hot-reload: re-uploading texture ", _default_texture_path);
+
+    // Frames in flight keep the old slot, the new texture needs another.
+    if (!_has_free_bindless_texture()) {
+        Log::error("Hot-reload: no bindless texture slot left, texture kept.");
+        return;
+    }
+
+    _retire(std::move(_texture_image_view));
+    _retire(std::move(_texture_image));
+    _retire(std::move(_texture_image_memory));
+
+    _create_texture_image();
+    _create_texture_image_view();
+
+    // Frames in flight keep sampling the old slot, new ones read the
+    // updated material (each frame slot has its own material buffer).
+    _release_bindless_texture(_texture_slot);
+    _texture_slot = *_register_bindless_texture(*_texture_image_view);
+
+    GpuMaterial material = _materials[_default_material];
+    material.albedo_texture = _texture_slot;
+    _update_material(_default_material, material);
+}
+
+void
+VulkanRenderer::_reload_model() noexcept {
+    Log::info("Hot-reload: re-uploading model ", _model_file_path);
+
+    _retire(std::move(_vertex_buffer));
+    _retire(std::move(_vertex_buffer_memory));
+    _retire(std::move(_index_buffer));
+    _retire(std::move(_index_buffer_memory));
+    _retire(std::move(_meshlet_buffer));
+    _retire(std::move(_meshlet_buffer_memory));
+    _retire(std::move(_lod_buffer));
+    _retire(std::move(_lod_buffer_memory));
+
+    _vertices.clear();
+    _indices.clear();
+    _meshlets.clear();
+    _mesh_lods.clear();
+
+    _load_model();
+    _create_vertex_buffer();
+    _create_index_buffer();
+    _create_meshlet_buffer();
+    _create_lod_buffer();
+    _mark_descriptor_sets_stale();
+    // Same entities: their mesh is updated in place, only the grid
+    // spacing and bounds change.
+    _meshes[_scene_mesh] = _model_mesh;
+    _lay_out_scene();
+}
+
+#pragma endregion HOT_RELOAD
+
+} // namespace core
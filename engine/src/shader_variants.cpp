@@ -0,0 +1,383 @@
+#include "../include/core/shader_variants.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include "../include/core/hash.hpp"
+#include "../include/core/log.hpp"
+
+namespace core {
+
+// Part of every id: bump it when the compile options change, variants
+// stored on disk with the old ones are never found again.
+static constexpr u64 s_compile_options_version {1};
+
+static constexpr u32 s_spirv_magic {0x07230203};
+
+static constexpr std::string_view s_whitespace {" \t\r"};
+
+// Splits off the first whitespace separated token of text.
+static std::string_view
+s_next_token(std::string_view& text) noexcept {
+    text.remove_prefix(
+        std::min(text.find_first_not_of(s_whitespace), text.size())
+    );
+
+    usize const end = std::min(text.find_first_of(s_whitespace), text.size());
+    std::string_view const token = text.substr(0, end);
+    text.remove_prefix(end);
+
+    return token;
+}
+
+static std::filesystem::path
+s_variant_path(std::filesystem::path const& directory, ShaderVariantId id) {
+    constexpr std::string_view s_digits {"0123456789abcdef"};
+    std::string name(16, '0');
+
+    for (usize i {}; i < name.size(); ++i) {
+        name[name.size() - 1 - i] = s_digits[(id >> (i * 4)) & 0xF];
+    }
+
+    return directory / (name + ".spv");
+}
+
+std::vector<std::string>
+parse_shader_keywords(std::string_view source) {
+    std::vector<std::string> keywords {};
+
+    while (!source.empty()) {
+        usize const line_end = std::min(source.find('\n'), source.size());
+        std::string_view line = source.substr(0, line_end);
+        source.remove_prefix(std::min(line_end + 1, source.size()));
+
+        // "#pragma", or "#" and "pragma" apart.
+        std::string_view directive = s_next_token(line);
+        if (directive == "#") {
+            directive = s_next_token(line);
+        } else if (directive.starts_with('#')) {
+            directive.remove_prefix(1);
+        } else {
+            continue;
+        }
+
+        if (directive != "pragma" || s_next_token(line) != "shader_feature") {
+            continue;
+        }
+
+        for (std::string_view keyword = s_next_token(line); !keyword.empty();
+             keyword = s_next_token(line)) {
+            if (std::ranges::find(keywords, keyword) == keywords.end()) {
+                keywords.emplace_back(keyword);
+            }
+        }
+    }
+
+    return keywords;
+}
+
+ShaderVariantCache::~ShaderVariantCache() {
+    stop();
+}
+
+void
+ShaderVariantCache::start(
+    u32 worker_count,
+    std::filesystem::path const& directory
+) noexcept {
+    core_assert(_workers.empty(), "Shader variant cache already started.");
+    core_assert(worker_count > 0, "Shader variants need at least one worker.");
+
+    _directory = directory;
+
+    if (!_directory.empty()) {
+        std::error_code error {};
+        std::filesystem::create_directories(_directory, error);
+
+        if (error) {
+            Log::warn(
+                "Shader variants won't be stored, failed to create ",
+                _directory.string()
+            );
+            _directory.clear();
+        }
+    }
+
+    _workers.reserve(worker_count);
+
+    for (u32 i {}; i < worker_count; ++i) {
+        _workers.emplace_back([this] { _work(); });
+    }
+}
+
+void
+ShaderVariantCache::stop() noexcept {
+    {
+        std::scoped_lock const lock {_mutex};
+        _stopping = true;
+    }
+
+    _work_available.notify_all();
+
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+
+    _workers.clear();
+    _stopping = false;
+}
+
+u64
+ShaderVariantCache::add_source(
+    std::string_view path,
+    std::string_view text,
+    shaderc_shader_kind kind
+) noexcept {
+    u64 id = hash_combine(hash_fnv1a(text), static_cast<u64>(kind));
+    id = hash_combine(id, s_compile_options_version);
+
+    std::scoped_lock const lock {_mutex};
+    auto const [source, inserted] = _sources.try_emplace(id);
+
+    if (inserted) {
+        source->second = {
+            .path = std::string {path},
+            .text = std::string {text},
+            .kind = kind,
+            .keywords = parse_shader_keywords(text),
+        };
+    }
+
+    return id;
+}
+
+std::span<std::string const>
+ShaderVariantCache::keywords(u64 source) const noexcept {
+    std::scoped_lock const lock {_mutex};
+    auto const found = _sources.find(source);
+
+    if (found == _sources.end()) {
+        return {};
+    }
+
+    return found->second.keywords;
+}
+
+ShaderVariantId
+ShaderVariantCache::request(
+    u64 source,
+    std::span<std::string const> keywords
+) noexcept {
+    std::scoped_lock const lock {_mutex};
+    auto const found = _sources.find(source);
+    core_assert(found != _sources.end(), "Unknown shader source.");
+
+    // Keywords this stage declares, in a stable order.
+    std::vector<std::string> defines {};
+
+    for (std::string const& keyword : keywords) {
+        if (std::ranges::find(found->second.keywords, keyword) !=
+            found->second.keywords.end()) {
+            defines.push_back(keyword);
+        }
+    }
+
+    std::ranges::sort(defines);
+    auto const duplicates = std::ranges::unique(defines);
+    defines.erase(duplicates.begin(), duplicates.end());
+
+    ShaderVariantId id = source;
+
+    for (std::string const& define : defines) {
+        id = hash_combine(id, hash_fnv1a(define));
+    }
+
+    auto const [variant, inserted] = _variants.try_emplace(id);
+
+    if (inserted) {
+        variant->second.source = &found->second;
+        variant->second.defines = std::move(defines);
+        _queue.push_back(id);
+        _work_available.notify_one();
+    }
+
+    return id;
+}
+
+std::span<u32 const>
+ShaderVariantCache::spirv(ShaderVariantId id) noexcept {
+    std::unique_lock lock {_mutex};
+    auto const found = _variants.find(id);
+    core_assert(found != _variants.end(), "Shader variant never requested.");
+
+    Variant& variant = found->second;
+
+    if (variant.state == VariantState::Queued) {
+        // Don't wait behind the rest of the queue.
+        std::erase(_queue, id);
+        variant.state = VariantState::Compiling;
+
+        lock.unlock();
+        shaderc::Compiler const compiler {};
+        std::vector<u32> spirv = _load_or_compile(compiler, id, variant);
+        lock.lock();
+
+        variant.spirv = std::move(spirv);
+        variant.state = VariantState::Ready;
+        _variant_ready.notify_all();
+    }
+
+    _variant_ready.wait(lock, [&variant] {
+        return variant.state == VariantState::Ready;
+    });
+
+    return variant.spirv;
+}
+
+usize
+ShaderVariantCache::compiled_count() const noexcept {
+    std::scoped_lock const lock {_mutex};
+    return _compiled_count;
+}
+
+void
+ShaderVariantCache::_work() noexcept {
+    // One per worker, compilations never share a compiler.
+    shaderc::Compiler const compiler {};
+    std::unique_lock lock {_mutex};
+
+    while (true) {
+        _work_available.wait(lock, [this] {
+            return _stopping || !_queue.empty();
+        });
+
+        if (_stopping) {
+            return;
+        }
+
+        ShaderVariantId const id = _queue.front();
+        _queue.pop_front();
+
+        Variant& variant = _variants.at(id);
+        variant.state = VariantState::Compiling;
+
+        lock.unlock();
+        std::vector<u32> spirv = _load_or_compile(compiler, id, variant);
+        lock.lock();
+
+        variant.spirv = std::move(spirv);
+        variant.state = VariantState::Ready;
+        _variant_ready.notify_all();
+    }
+}
+
+std::vector<u32>
+ShaderVariantCache::_load_or_compile(
+    shaderc::Compiler const& compiler,
+    ShaderVariantId id,
+    Variant const& variant
+) noexcept {
+    std::filesystem::path const path = _directory.empty()
+        ? std::filesystem::path {}
+        : s_variant_path(_directory, id);
+
+    if (!path.empty()) {
+        std::ifstream file(path, std::ios::ate | std::ios::binary);
+        usize const size =
+            file.is_open() ? static_cast<usize>(file.tellg()) : 0;
+
+        if (size >= sizeof(u32) && size % sizeof(u32) == 0) {
+            std::vector<u32> spirv(size / sizeof(u32));
+            file.seekg(0);
+            file.read(
+                reinterpret_cast<char*>(spirv.data()),
+                static_cast<std::streamsize>(size)
+            );
+
+            if (file && spirv.front() == s_spirv_magic) {
+                return spirv;
+            }
+        }
+    }
+
+    Source const& source = *variant.source;
+    shaderc::CompileOptions options {};
+    options.SetTargetEnvironment(
+        shaderc_target_env_vulkan,
+        shaderc_env_version_vulkan_1_3
+    );
+    options.SetOptimizationLevel(shaderc_optimization_level_performance);
+
+    for (std::string const& define : variant.defines) {
+        options.AddMacroDefinition(define);
+    }
+
+    auto const start_time = std::chrono::steady_clock::now();
+
+    shaderc::SpvCompilationResult const result = compiler.CompileGlslToSpv(
+        source.text.data(),
+        source.text.size(),
+        source.kind,
+        source.path.c_str(),
+        options
+    );
+
+    if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+        Log::error(
+            "Shader variant compilation failed: ",
+            result.GetErrorMessage()
+        );
+        return {};
+    }
+
+    std::vector<u32> spirv(result.begin(), result.end());
+
+    std::chrono::duration<f64, std::milli> const elapsed =
+        std::chrono::steady_clock::now() - start_time;
+
+    std::string defines {};
+    for (std::string const& define : variant.defines) {
+        defines += ' ' + define;
+    }
+
+    Log::info(
+        "Shader variant compiled in ",
+        elapsed.count(),
+        " ms: ",
+        source.path,
+        defines
+    );
+
+    {
+        std::scoped_lock const lock {_mutex};
+        ++_compiled_count;
+    }
+
+    if (path.empty()) {
+        return spirv;
+    }
+
+    // Another process may be loading it: write aside, then rename.
+    std::filesystem::path temporary_path = path;
+    temporary_path += ".tmp";
+
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        file.write(
+            reinterpret_cast<char const*>(spirv.data()),
+            static_cast<std::streamsize>(spirv.size() * sizeof(u32))
+        );
+
+        if (!file) {
+            return spirv;
+        }
+    }
+
+    std::error_code error {};
+    std::filesystem::rename(temporary_path, path, error);
+
+    return spirv;
+}
+
+} // namespace core
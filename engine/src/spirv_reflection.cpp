@@ -0,0 +1,567 @@
+#include "../include/core/spirv_reflection.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace core {
+
+static constexpr u32 s_unset {std::numeric_limits<u32>::max()};
+
+// From the SPIR-V specification, only what reflection reads.
+static constexpr u32 s_spirv_magic {0x07230203};
+static constexpr usize s_spirv_header_size {5}; // Words.
+
+enum class SpirvOp : u32 {
+    EntryPoint = 15,
+    TypeInt = 21,
+    TypeFloat = 22,
+    TypeVector = 23,
+    TypeMatrix = 24,
+    TypeImage = 25,
+    TypeSampler = 26,
+    TypeSampledImage = 27,
+    TypeArray = 28,
+    TypeRuntimeArray = 29,
+    TypeStruct = 30,
+    TypePointer = 32,
+    Constant = 43,
+    Variable = 59,
+    Decorate = 71,
+    MemberDecorate = 72,
+};
+
+enum class SpirvDecoration : u32 {
+    Block = 2,
+    BufferBlock = 3,
+    ArrayStride = 6,
+    BuiltIn = 11,
+    Location = 30,
+    Binding = 33,
+    DescriptorSet = 34,
+    Offset = 35,
+};
+
+enum class SpirvStorageClass : u32 {
+    UniformConstant = 0,
+    Input = 1,
+    Uniform = 2,
+    PushConstant = 9,
+    StorageBuffer = 12,
+};
+
+static constexpr u32 s_execution_model_vertex {0};
+static constexpr u32 s_execution_model_fragment {4};
+static constexpr u32 s_execution_model_compute {5};
+static constexpr u32 s_dim_buffer {5};
+static constexpr u32 s_image_storage {2}; // "Sampled" operand of images.
+
+// What reflection needs to know about one result id.
+struct SpirvId {
+    SpirvOp op {};
+    // Of the defining instruction, result id included.
+    std::span<u32 const> operands {};
+    u32 set {s_unset};
+    u32 binding {s_unset};
+    u32 location {s_unset};
+    u32 array_stride {0};
+    bool built_in {false};
+    bool block {false};
+    bool buffer_block {false};
+    std::vector<u32> member_offsets {};
+};
+
+// Where the result id is among the operands, none for other instructions.
+static std::optional<usize>
+s_result_operand(SpirvOp op) noexcept {
+    switch (op) {
+        case SpirvOp::TypeInt:
+        case SpirvOp::TypeFloat:
+        case SpirvOp::TypeVector:
+        case SpirvOp::TypeMatrix:
+        case SpirvOp::TypeImage:
+        case SpirvOp::TypeSampler:
+        case SpirvOp::TypeSampledImage:
+        case SpirvOp::TypeArray:
+        case SpirvOp::TypeRuntimeArray:
+        case SpirvOp::TypeStruct:
+        case SpirvOp::TypePointer:
+            return 0;
+        case SpirvOp::Constant:
+        case SpirvOp::Variable:
+            return 1;
+        default:
+            return std::nullopt;
+    }
+}
+
+// Operands read from each instruction, shorter ones are malformed.
+static usize
+s_minimum_operands(SpirvOp op) noexcept {
+    switch (op) {
+        case SpirvOp::TypeImage:
+            return 8;
+        case SpirvOp::TypeInt:
+        case SpirvOp::TypeVector:
+        case SpirvOp::TypeMatrix:
+        case SpirvOp::TypeArray:
+        case SpirvOp::TypePointer:
+        case SpirvOp::Constant:
+        case SpirvOp::Variable:
+        case SpirvOp::MemberDecorate:
+            return 3;
+        case SpirvOp::TypeFloat:
+        case SpirvOp::TypeSampledImage:
+        case SpirvOp::TypeRuntimeArray:
+        case SpirvOp::Decorate:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+// Types a type is made of. SPIR-V declares them before their use, so
+// following them always ends.
+static std::span<u32 const>
+s_component_types(SpirvOp op, std::span<u32 const> operands) noexcept {
+    switch (op) {
+        case SpirvOp::TypeVector:
+        case SpirvOp::TypeMatrix:
+        case SpirvOp::TypeSampledImage:
+        case SpirvOp::TypeArray:
+        case SpirvOp::TypeRuntimeArray:
+            return operands.subspan(1, 1);
+        case SpirvOp::TypeStruct:
+            return operands.subspan(1);
+        default:
+            return {};
+    }
+}
+
+// Size in bytes, as laid out in a block (offsets and strides come from
+// decorations, matrices follow std430).
+static u32
+s_type_size(std::vector<SpirvId> const& ids, u32 type) noexcept {
+    if (type >= ids.size()) {
+        return 0;
+    }
+
+    SpirvId const& id = ids[type];
+    std::span<u32 const> const operands = id.operands;
+
+    switch (id.op) {
+        case SpirvOp::TypeInt:
+        case SpirvOp::TypeFloat:
+            return operands[1] / 8;
+        case SpirvOp::TypeVector:
+            return operands[2] * s_type_size(ids, operands[1]);
+        case SpirvOp::TypeMatrix: {
+            // Columns are aligned as vectors: vec3 like vec4.
+            u32 const column = s_type_size(ids, operands[1]);
+            u32 const stride = std::bit_ceil(column);
+            return (operands[2] - 1) * stride + column;
+        }
+        case SpirvOp::TypeArray: {
+            u32 const length_id = operands[2];
+            if (length_id >= ids.size() ||
+                ids[length_id].op != SpirvOp::Constant) {
+                return 0;
+            }
+
+            u32 const length = ids[length_id].operands[2];
+            u32 const stride = id.array_stride != 0
+                ? id.array_stride
+                : s_type_size(ids, operands[1]);
+            return length * stride;
+        }
+        case SpirvOp::TypeStruct: {
+            u32 size {0};
+
+            for (usize member {}; member + 1 < operands.size(); ++member) {
+                u32 const offset = member < id.member_offsets.size()
+                    ? id.member_offsets[member]
+                    : 0;
+                size = std::max(
+                    size,
+                    offset + s_type_size(ids, operands[member + 1])
+                );
+            }
+
+            return size;
+        }
+        default:
+            return 0;
+    }
+}
+
+// Descriptor of a variable of that type (arrays unwrapped) in that
+// storage class.
+static std::optional<ShaderDescriptorType>
+s_descriptor_type(SpirvId const& type, SpirvStorageClass storage) noexcept {
+    switch (type.op) {
+        case SpirvOp::TypeStruct:
+            if (storage == SpirvStorageClass::StorageBuffer ||
+                type.buffer_block) {
+                return ShaderDescriptorType::StorageBuffer;
+            }
+            if (type.block) {
+                return ShaderDescriptorType::UniformBuffer;
+            }
+            return std::nullopt;
+        case SpirvOp::TypeImage: {
+            bool const storage_image = type.operands[6] == s_image_storage;
+            if (type.operands[2] == s_dim_buffer) {
+                return storage_image
+                    ? ShaderDescriptorType::StorageTexelBuffer
+                    : ShaderDescriptorType::UniformTexelBuffer;
+            }
+            return storage_image ? ShaderDescriptorType::StorageImage
+                                 : ShaderDescriptorType::SampledImage;
+        }
+        case SpirvOp::TypeSampler:
+            return ShaderDescriptorType::Sampler;
+        case SpirvOp::TypeSampledImage:
+            return ShaderDescriptorType::CombinedImageSampler;
+        default:
+            return std::nullopt;
+    }
+}
+
+std::optional<ShaderReflection>
+reflect_spirv(std::span<u32 const> words) {
+    if (words.size() < s_spirv_header_size || words[0] != s_spirv_magic) {
+        return std::nullopt;
+    }
+
+    u32 const bound = words[3]; // Every id is below.
+    std::vector<SpirvId> ids(bound);
+    std::vector<u32> variables {};
+    std::optional<ShaderStage> stage {};
+
+    for (usize i {s_spirv_header_size}; i < words.size();) {
+        u32 const word_count = words[i] >> 16;
+        auto const op = static_cast<SpirvOp>(words[i] & 0xFFFF);
+
+        if (word_count == 0 || i + word_count > words.size()) {
+            return std::nullopt;
+        }
+
+        std::span<u32 const> const operands =
+            words.subspan(i + 1, word_count - 1);
+        i += word_count;
+
+        if (operands.size() < s_minimum_operands(op)) {
+            return std::nullopt;
+        }
+
+        if (std::optional<usize> const result = s_result_operand(op)) {
+            u32 const id = operands[*result];
+            if (id >= bound || !ids[id].operands.empty()) {
+                return std::nullopt;
+            }
+
+            for (u32 const type : s_component_types(op, operands)) {
+                if (type >= bound || ids[type].operands.empty()) {
+                    return std::nullopt;
+                }
+            }
+
+            ids[id].op = op;
+            ids[id].operands = operands;
+
+            if (op == SpirvOp::Variable) {
+                variables.push_back(id);
+            }
+            continue;
+        }
+
+        switch (op) {
+            case SpirvOp::EntryPoint:
+                // The first one, modules here have a single entry point.
+                if (stage) {
+                    break;
+                }
+                if (operands[0] == s_execution_model_vertex) {
+                    stage = ShaderStage::Vertex;
+                } else if (operands[0] == s_execution_model_fragment) {
+                    stage = ShaderStage::Fragment;
+                } else if (operands[0] == s_execution_model_compute) {
+                    stage = ShaderStage::Compute;
+                } else {
+                    return std::nullopt;
+                }
+                break;
+            case SpirvOp::Decorate: {
+                if (operands[0] >= bound) {
+                    return std::nullopt;
+                }
+
+                SpirvId& target = ids[operands[0]];
+                u32 const value = operands.size() > 2 ? operands[2] : 0;
+
+                switch (static_cast<SpirvDecoration>(operands[1])) {
+                    case SpirvDecoration::Block:
+                        target.block = true;
+                        break;
+                    case SpirvDecoration::BufferBlock:
+                        target.buffer_block = true;
+                        break;
+                    case SpirvDecoration::ArrayStride:
+                        target.array_stride = value;
+                        break;
+                    case SpirvDecoration::BuiltIn:
+                        target.built_in = true;
+                        break;
+                    case SpirvDecoration::Location:
+                        target.location = value;
+                        break;
+                    case SpirvDecoration::Binding:
+                        target.binding = value;
+                        break;
+                    case SpirvDecoration::DescriptorSet:
+                        target.set = value;
+                        break;
+                    default:
+                        break;
+                }
+                break;
+            }
+            case SpirvOp::MemberDecorate: {
+                auto const decoration =
+                    static_cast<SpirvDecoration>(operands[2]);
+                if (decoration != SpirvDecoration::Offset) {
+                    break;
+                }
+                if (operands[0] >= bound || operands.size() < 4) {
+                    return std::nullopt;
+                }
+
+                std::vector<u32>& offsets = ids[operands[0]].member_offsets;
+                u32 const member = operands[1];
+                if (member >= offsets.size()) {
+                    offsets.resize(member + 1, 0);
+                }
+                offsets[member] = operands[3];
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (!stage) {
+        return std::nullopt;
+    }
+
+    ShaderReflection reflection {.stage = *stage};
+
+    // Type an id refers to, none if it is out of the module.
+    auto const type_of = [&ids](u32 id) -> SpirvId const* {
+        return id < ids.size() && ids[id].operands.size() > 0 ? &ids[id]
+                                                              : nullptr;
+    };
+
+    for (u32 const variable_id : variables) {
+        SpirvId const& variable = ids[variable_id];
+        auto const storage = static_cast<SpirvStorageClass>(
+            variable.operands[2]
+        );
+
+        // Function variables and interfaces other than vertex inputs.
+        if (storage != SpirvStorageClass::UniformConstant &&
+            storage != SpirvStorageClass::Uniform &&
+            storage != SpirvStorageClass::StorageBuffer &&
+            storage != SpirvStorageClass::PushConstant &&
+            storage != SpirvStorageClass::Input) {
+            continue;
+        }
+
+        SpirvId const* const pointer = type_of(variable.operands[0]);
+        if (!pointer || pointer->op != SpirvOp::TypePointer) {
+            return std::nullopt;
+        }
+
+        u32 const type_id = pointer->operands[2];
+        SpirvId const* type = type_of(type_id);
+        if (!type) {
+            return std::nullopt;
+        }
+
+        switch (storage) {
+            case SpirvStorageClass::UniformConstant:
+            case SpirvStorageClass::Uniform:
+            case SpirvStorageClass::StorageBuffer: {
+                if (variable.set == s_unset || variable.binding == s_unset) {
+                    break;
+                }
+
+                ShaderBinding binding {
+                    .set = variable.set,
+                    .binding = variable.binding,
+                    .stages = to_mask(*stage),
+                };
+
+                // Arrays of descriptors.
+                while (type->op == SpirvOp::TypeArray ||
+                       type->op == SpirvOp::TypeRuntimeArray) {
+                    if (type->op == SpirvOp::TypeRuntimeArray) {
+                        binding.count = 0;
+                    } else {
+                        SpirvId const* const length =
+                            type_of(type->operands[2]);
+                        if (!length || length->op != SpirvOp::Constant) {
+                            return std::nullopt;
+                        }
+                        binding.count *= length->operands[2];
+                    }
+
+                    type = type_of(type->operands[1]);
+                    if (!type) {
+                        return std::nullopt;
+                    }
+                }
+
+                std::optional<ShaderDescriptorType> const descriptor =
+                    s_descriptor_type(*type, storage);
+                if (!descriptor) {
+                    return std::nullopt;
+                }
+
+                binding.type = *descriptor;
+                reflection.bindings.push_back(binding);
+                break;
+            }
+            case SpirvStorageClass::PushConstant:
+                reflection.push_constant_size = std::max(
+                    reflection.push_constant_size,
+                    s_type_size(ids, type_id)
+                );
+                break;
+            case SpirvStorageClass::Input: {
+                if (*stage != ShaderStage::Vertex || variable.built_in ||
+                    type->built_in) {
+                    break;
+                }
+                if (variable.location == s_unset) {
+                    return std::nullopt;
+                }
+
+                ShaderVertexInput input {.location = variable.location};
+
+                if (type->op == SpirvOp::TypeVector) {
+                    input.component_count = type->operands[2];
+                    type = type_of(type->operands[1]);
+                    if (!type) {
+                        return std::nullopt;
+                    }
+                }
+
+                if (type->op == SpirvOp::TypeFloat) {
+                    input.type = ShaderScalarType::Float;
+                } else if (type->op == SpirvOp::TypeInt) {
+                    input.type = type->operands[2] != 0
+                        ? ShaderScalarType::Int
+                        : ShaderScalarType::Uint;
+                } else {
+                    return std::nullopt;
+                }
+
+                if (type->operands[1] != 32) {
+                    return std::nullopt;
+                }
+
+                reflection.vertex_inputs.push_back(input);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    std::ranges::sort(
+        reflection.bindings,
+        [](ShaderBinding const& a, ShaderBinding const& b) {
+            return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+        }
+    );
+    std::ranges::sort(
+        reflection.vertex_inputs,
+        {},
+        &ShaderVertexInput::location
+    );
+
+    return reflection;
+}
+
+std::optional<ShaderLayout>
+merge_shader_layouts(std::span<ShaderReflection const> stages) {
+    ShaderLayout layout {};
+
+    for (ShaderReflection const& stage : stages) {
+        for (ShaderBinding const& binding : stage.bindings) {
+            if (binding.set >= layout.sets.size()) {
+                layout.sets.resize(binding.set + 1);
+            }
+
+            std::vector<ShaderBinding>& set = layout.sets[binding.set];
+            auto const found = std::ranges::find(
+                set,
+                binding.binding,
+                &ShaderBinding::binding
+            );
+
+            if (found == set.end()) {
+                set.push_back(binding);
+            } else if (found->type != binding.type ||
+                       found->count != binding.count) {
+                return std::nullopt;
+            } else {
+                found->stages |= binding.stages;
+            }
+        }
+
+        if (stage.push_constant_size > 0) {
+            layout.push_constant_size =
+                std::max(layout.push_constant_size, stage.push_constant_size);
+            layout.push_constant_stages |= to_mask(stage.stage);
+        }
+    }
+
+    for (std::vector<ShaderBinding>& set : layout.sets) {
+        std::ranges::sort(set, {}, &ShaderBinding::binding);
+    }
+
+    return layout;
+}
+
+bool
+fits_shader_layout(
+    ShaderReflection const& stage,
+    ShaderLayout const& layout
+) noexcept {
+    ShaderStageMask const mask = to_mask(stage.stage);
+
+    for (ShaderBinding const& binding : stage.bindings) {
+        if (binding.set >= layout.sets.size()) {
+            return false;
+        }
+
+        std::vector<ShaderBinding> const& set = layout.sets[binding.set];
+        auto const found = std::ranges::find(
+            set,
+            binding.binding,
+            &ShaderBinding::binding
+        );
+
+        if (found == set.end() || found->type != binding.type ||
+            found->count != binding.count || (found->stages & mask) == 0) {
+            return false;
+        }
+    }
+
+    return stage.push_constant_size == 0 ||
+        (stage.push_constant_size <= layout.push_constant_size &&
+         (layout.push_constant_stages & mask) != 0);
+}
+
+} // namespace core
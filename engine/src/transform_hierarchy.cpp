@@ -0,0 +1,636 @@
+#include "../include/core/transform_hierarchy.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+#include "../include/core/log.hpp"
+
+namespace core {
+
+static_assert(
+    sizeof(glm::mat4) == 16 * sizeof(f32),
+    "World matrices are read and written as 16 floats."
+);
+
+// Smallest part of a level worth a job.
+static constexpr usize s_min_grain {512};
+
+// What batches read and write, by slot.
+struct Slots {
+    std::array<f32 const*, 3> positions {};
+    std::array<f32 const*, 4> rotations {};
+    std::array<f32 const*, 3> scales {};
+    u32 const* parents {nullptr};
+    u8* dirty {nullptr};
+    u8* changed {nullptr};
+    f32* worlds {nullptr}; // 16 floats per slot, column major.
+};
+
+// One node at a time, what's left of a level after the batches.
+struct ScalarLanes {
+    using Floats = f32;
+    using Offsets = u32;
+
+    static constexpr u32 s_count {1};
+
+    static Floats
+    load(f32 const* values) noexcept {
+        return *values;
+    }
+
+    static Floats
+    broadcast(f32 value) noexcept {
+        return value;
+    }
+
+    static Floats
+    add(Floats a, Floats b) noexcept {
+        return a + b;
+    }
+
+    static Floats
+    sub(Floats a, Floats b) noexcept {
+        return a - b;
+    }
+
+    static Floats
+    mul(Floats a, Floats b) noexcept {
+        return a * b;
+    }
+
+    // a * b + c.
+    static Floats
+    mul_add(Floats a, Floats b, Floats c) noexcept {
+        return a * b + c;
+    }
+
+    // Of the parent world matrices, in floats.
+    static Offsets
+    parent_offsets(u32 const* parents) noexcept {
+        return parents[0] * 16;
+    }
+
+    // One element of every lane's parent matrix.
+    static Floats
+    gather(f32 const* worlds, Offsets offsets, u32 element) noexcept {
+        return worlds[offsets + element];
+    }
+
+    // Elements of the lanes' matrices to consecutive matrices.
+    static void
+    store(f32* worlds, Floats const (&elements)[16]) noexcept {
+        std::copy_n(elements, 16, worlds);
+    }
+};
+
+#if defined(__AVX2__)
+
+struct Avx2Lanes {
+    using Floats = __m256;
+    using Offsets = __m256i;
+
+    static constexpr u32 s_count {8};
+
+    static Floats
+    load(f32 const* values) noexcept {
+        return _mm256_loadu_ps(values);
+    }
+
+    static Floats
+    broadcast(f32 value) noexcept {
+        return _mm256_set1_ps(value);
+    }
+
+    static Floats
+    add(Floats a, Floats b) noexcept {
+        return _mm256_add_ps(a, b);
+    }
+
+    static Floats
+    sub(Floats a, Floats b) noexcept {
+        return _mm256_sub_ps(a, b);
+    }
+
+    static Floats
+    mul(Floats a, Floats b) noexcept {
+        return _mm256_mul_ps(a, b);
+    }
+
+    static Floats
+    mul_add(Floats a, Floats b, Floats c) noexcept {
+    #if defined(__FMA__)
+        return _mm256_fmadd_ps(a, b, c);
+    #else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+    #endif
+    }
+
+    static Offsets
+    parent_offsets(u32 const* parents) noexcept {
+        return _mm256_slli_epi32(
+            _mm256_loadu_si256(reinterpret_cast<__m256i const*>(parents)),
+            4
+        );
+    }
+
+    static Floats
+    gather(f32 const* worlds, Offsets offsets, u32 element) noexcept {
+        return _mm256_i32gather_ps(worlds + element, offsets, sizeof(f32));
+    }
+
+    // Rows of elements to rows of lanes.
+    static void
+    transpose(Floats (&rows)[8]) noexcept {
+        Floats const t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+        Floats const t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+        Floats const t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+        Floats const t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+        Floats const t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+        Floats const t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+        Floats const t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+        Floats const t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+        Floats const u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        Floats const u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        Floats const u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        Floats const u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        Floats const u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+        Floats const u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        Floats const u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+        Floats const u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+        rows[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+        rows[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+        rows[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+        rows[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+        rows[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+        rows[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+        rows[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+        rows[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+    }
+
+    static void
+    store(f32* worlds, Floats const (&elements)[16]) noexcept {
+        // Elements 0 to 7 of every lane, then 8 to 15.
+        for (u32 half {}; half < 2; ++half) {
+            Floats rows[8];
+            std::copy_n(elements + half * 8, 8, rows);
+            transpose(rows);
+
+            for (u32 lane {}; lane < s_count; ++lane) {
+                _mm256_storeu_ps(worlds + lane * 16 + half * 8, rows[lane]);
+            }
+        }
+    }
+};
+
+using BatchLanes = Avx2Lanes;
+
+#elif defined(__SSE2__)
+
+struct Sse2Lanes {
+    using Floats = __m128;
+    using Offsets = std::array<u32, 4>;
+
+    static constexpr u32 s_count {4};
+
+    static Floats
+    load(f32 const* values) noexcept {
+        return _mm_loadu_ps(values);
+    }
+
+    static Floats
+    broadcast(f32 value) noexcept {
+        return _mm_set1_ps(value);
+    }
+
+    static Floats
+    add(Floats a, Floats b) noexcept {
+        return _mm_add_ps(a, b);
+    }
+
+    static Floats
+    sub(Floats a, Floats b) noexcept {
+        return _mm_sub_ps(a, b);
+    }
+
+    static Floats
+    mul(Floats a, Floats b) noexcept {
+        return _mm_mul_ps(a, b);
+    }
+
+    static Floats
+    mul_add(Floats a, Floats b, Floats c) noexcept {
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+    }
+
+    static Offsets
+    parent_offsets(u32 const* parents) noexcept {
+        return {
+            parents[0] * 16,
+            parents[1] * 16,
+            parents[2] * 16,
+            parents[3] * 16,
+        };
+    }
+
+    // No gather before AVX2.
+    static Floats
+    gather(f32 const* worlds, Offsets const& offsets, u32 element) noexcept {
+        return _mm_setr_ps(
+            worlds[offsets[0] + element],
+            worlds[offsets[1] + element],
+            worlds[offsets[2] + element],
+            worlds[offsets[3] + element]
+        );
+    }
+
+    static void
+    store(f32* worlds, Floats const (&elements)[16]) noexcept {
+        // A column of every lane at a time.
+        for (u32 column {}; column < 4; ++column) {
+            Floats row0 = elements[column * 4 + 0];
+            Floats row1 = elements[column * 4 + 1];
+            Floats row2 = elements[column * 4 + 2];
+            Floats row3 = elements[column * 4 + 3];
+            _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+            _mm_storeu_ps(worlds + 0 * 16 + column * 4, row0);
+            _mm_storeu_ps(worlds + 1 * 16 + column * 4, row1);
+            _mm_storeu_ps(worlds + 2 * 16 + column * 4, row2);
+            _mm_storeu_ps(worlds + 3 * 16 + column * 4, row3);
+        }
+    }
+};
+
+using BatchLanes = Sse2Lanes;
+
+#else
+
+using BatchLanes = ScalarLanes;
+
+#endif
+
+// Lanes::s_count nodes from slot, world = parent world * local.
+template <typename Lanes>
+static void
+s_update_batch(Slots const& slots, u32 slot) noexcept {
+    using Floats = typename Lanes::Floats;
+
+    // Flags of every lane are written, the next level reads them.
+    bool any_changed {false};
+
+    for (u32 i = slot; i < slot + Lanes::s_count; ++i) {
+        u8 const changed = slots.dirty[i] | slots.changed[slots.parents[i]];
+        slots.changed[i] = changed;
+        slots.dirty[i] = 0;
+        any_changed = any_changed || changed != 0;
+    }
+
+    // Lanes that didn't change would compute what they hold already.
+    if (!any_changed) {
+        return;
+    }
+
+    auto const load = [slot](f32 const* values) {
+        return Lanes::load(values + slot);
+    };
+
+    Floats const x = load(slots.rotations[0]);
+    Floats const y = load(slots.rotations[1]);
+    Floats const z = load(slots.rotations[2]);
+    Floats const w = load(slots.rotations[3]);
+
+    Floats const x2 = Lanes::add(x, x);
+    Floats const y2 = Lanes::add(y, y);
+    Floats const z2 = Lanes::add(z, z);
+    Floats const xx = Lanes::mul(x, x2);
+    Floats const yy = Lanes::mul(y, y2);
+    Floats const zz = Lanes::mul(z, z2);
+    Floats const xy = Lanes::mul(x, y2);
+    Floats const xz = Lanes::mul(x, z2);
+    Floats const yz = Lanes::mul(y, z2);
+    Floats const wx = Lanes::mul(w, x2);
+    Floats const wy = Lanes::mul(w, y2);
+    Floats const wz = Lanes::mul(w, z2);
+
+    Floats const one = Lanes::broadcast(1.0f);
+    Floats const scale_x = load(slots.scales[0]);
+    Floats const scale_y = load(slots.scales[1]);
+    Floats const scale_z = load(slots.scales[2]);
+
+    // Columns (x, y, z) of the local matrix: the rotation scaled, then
+    // the translation.
+    Floats const local[4][3] {
+        {
+            Lanes::mul(Lanes::sub(one, Lanes::add(yy, zz)), scale_x),
+            Lanes::mul(Lanes::add(xy, wz), scale_x),
+            Lanes::mul(Lanes::sub(xz, wy), scale_x),
+        },
+        {
+            Lanes::mul(Lanes::sub(xy, wz), scale_y),
+            Lanes::mul(Lanes::sub(one, Lanes::add(xx, zz)), scale_y),
+            Lanes::mul(Lanes::add(yz, wx), scale_y),
+        },
+        {
+            Lanes::mul(Lanes::add(xz, wy), scale_z),
+            Lanes::mul(Lanes::sub(yz, wx), scale_z),
+            Lanes::mul(Lanes::sub(one, Lanes::add(xx, yy)), scale_z),
+        },
+        {
+            load(slots.positions[0]),
+            load(slots.positions[1]),
+            load(slots.positions[2]),
+        },
+    };
+
+    auto const offsets = Lanes::parent_offsets(slots.parents + slot);
+    Floats parent[4][3];
+
+    for (u32 column {}; column < 4; ++column) {
+        for (u32 row {}; row < 3; ++row) {
+            parent[column][row] =
+                Lanes::gather(slots.worlds, offsets, column * 4 + row);
+        }
+    }
+
+    // Every column is the parent's columns weighted by the local one's.
+    Floats world[16];
+
+    for (u32 column {}; column < 4; ++column) {
+        for (u32 row {}; row < 3; ++row) {
+            Floats element = Lanes::mul(parent[0][row], local[column][0]);
+            element = Lanes::mul_add(parent[1][row], local[column][1], element);
+            element = Lanes::mul_add(parent[2][row], local[column][2], element);
+
+            if (column == 3) {
+                element = Lanes::add(element, parent[3][row]);
+            }
+
+            world[column * 4 + row] = element;
+        }
+
+        world[column * 4 + 3] = Lanes::broadcast(column == 3 ? 1.0f : 0.0f);
+    }
+
+    Lanes::store(slots.worlds + slot * 16, world);
+}
+
+// Returns the first slot left, fewer than a batch from end.
+template <typename Lanes>
+static u32
+s_update_batches(Slots const& slots, u32 slot, u32 end) noexcept {
+    for (; slot + Lanes::s_count <= end; slot += Lanes::s_count) {
+        s_update_batch<Lanes>(slots, slot);
+    }
+
+    return slot;
+}
+
+TransformHierarchy::TransformHierarchy() noexcept {
+    // The identity roots are children of, never updated.
+    _push_slot(0, 0);
+    _dirty[0] = 0;
+}
+
+TransformNode
+TransformHierarchy::create(TransformNode parent) noexcept {
+    core_assert(
+        parent == s_no_transform_node || parent < _slot_of.size(),
+        "Unknown parent node."
+    );
+
+    u32 const parent_slot = parent < _slot_of.size() ? _slot_of[parent] : 0;
+    u32 const depth = _depths[parent_slot] + 1;
+    u32 const slot = static_cast<u32>(_parents.size());
+    auto const node = static_cast<TransformNode>(_slot_of.size());
+
+    _push_slot(parent_slot, depth);
+    _slot_of.push_back(slot);
+
+    // Appending keeps the slots sorted while depths don't go back.
+    if (!_sorted) {
+        return node;
+    }
+
+    if (depth > _levels.size()) {
+        _levels.push_back({.begin = slot, .end = slot + 1});
+    } else if (depth == _levels.size()) {
+        ++_levels.back().end;
+    } else {
+        _sorted = false;
+    }
+
+    return node;
+}
+
+usize
+TransformHierarchy::node_count() const noexcept {
+    return _slot_of.size();
+}
+
+void
+TransformHierarchy::set_local(
+    TransformNode node,
+    Transform const& local
+) noexcept {
+    core_assert(node < _slot_of.size(), "Unknown node.");
+
+    u32 const slot = _slot_of[node];
+
+    for (u32 i {}; i < 3; ++i) {
+        _positions[i][slot] = local.position[i];
+        _scales[i][slot] = local.scale[i];
+    }
+
+    _rotations[0][slot] = local.rotation.x;
+    _rotations[1][slot] = local.rotation.y;
+    _rotations[2][slot] = local.rotation.z;
+    _rotations[3][slot] = local.rotation.w;
+    _dirty[slot] = 1;
+}
+
+Transform
+TransformHierarchy::local(TransformNode node) const noexcept {
+    core_assert(node < _slot_of.size(), "Unknown node.");
+
+    u32 const slot = _slot_of[node];
+
+    return {
+        .position = glm::vec3(
+            _positions[0][slot],
+            _positions[1][slot],
+            _positions[2][slot]
+        ),
+        .rotation = glm::quat(
+            _rotations[3][slot],
+            _rotations[0][slot],
+            _rotations[1][slot],
+            _rotations[2][slot]
+        ),
+        .scale = glm::vec3(
+            _scales[0][slot],
+            _scales[1][slot],
+            _scales[2][slot]
+        ),
+    };
+}
+
+glm::mat4 const&
+TransformHierarchy::world(TransformNode node) const noexcept {
+    core_assert(node < _slot_of.size(), "Unknown node.");
+    return _worlds[_slot_of[node]];
+}
+
+void
+TransformHierarchy::update(JobSystem& jobs) noexcept {
+    if (!_sorted) {
+        _sort();
+    }
+
+    usize const thread_count = jobs.worker_count() + 1;
+
+    // Parents first: a level reads the world matrices of the one before.
+    for (Level const& level : _levels) {
+        usize const count = level.end - level.begin;
+        // A few whole batches per thread.
+        usize grain = std::max(count / (thread_count * 4), s_min_grain);
+        grain = (grain + BatchLanes::s_count - 1) / BatchLanes::s_count *
+            BatchLanes::s_count;
+
+        jobs.parallel_for(count, grain, [this, &level](usize begin, usize end) {
+            _update_range(
+                level.begin + static_cast<u32>(begin),
+                level.begin + static_cast<u32>(end)
+            );
+        });
+    }
+}
+
+void
+TransformHierarchy::_push_slot(u32 parent, u32 depth) noexcept {
+    for (u32 i {}; i < 3; ++i) {
+        _positions[i].push_back(0.0f);
+        _scales[i].push_back(1.0f);
+    }
+
+    for (u32 i {}; i < 4; ++i) {
+        _rotations[i].push_back(i == 3 ? 1.0f : 0.0f);
+    }
+
+    _parents.push_back(parent);
+    _depths.push_back(depth);
+    _dirty.push_back(1);
+    _changed.push_back(0);
+    _worlds.emplace_back(1.0f);
+}
+
+void
+TransformHierarchy::_sort() noexcept {
+    usize const slot_count = _parents.size();
+    u32 const depth_count =
+        *std::max_element(_depths.begin(), _depths.end()) + 1;
+
+    // Siblings stay in order, depth by depth.
+    std::vector<std::vector<u32>> slots_of_depth(depth_count);
+
+    for (u32 slot = 1; slot < slot_count; ++slot) {
+        slots_of_depth[_depths[slot]].push_back(slot);
+    }
+
+    std::vector<u32> order {0}; // Old slot of every new one.
+    std::vector<u32> new_slot_of(slot_count, 0);
+    order.reserve(slot_count);
+    _levels.clear();
+
+    for (u32 depth = 1; depth < depth_count; ++depth) {
+        std::vector<u32>& slots = slots_of_depth[depth];
+
+        // Children of a parent together, parents in order: the gathers of
+        // a batch read few, close matrices.
+        std::stable_sort(
+            slots.begin(),
+            slots.end(),
+            [this, &new_slot_of](u32 a, u32 b) {
+                return new_slot_of[_parents[a]] < new_slot_of[_parents[b]];
+            }
+        );
+
+        u32 const begin = static_cast<u32>(order.size());
+
+        for (u32 slot : slots) {
+            new_slot_of[slot] = static_cast<u32>(order.size());
+            order.push_back(slot);
+        }
+
+        _levels.push_back({
+            .begin = begin,
+            .end = static_cast<u32>(order.size()),
+        });
+    }
+
+    auto const permute = [&order](auto& values) {
+        std::remove_reference_t<decltype(values)> sorted(values.size());
+
+        for (usize i {}; i < order.size(); ++i) {
+            sorted[i] = values[order[i]];
+        }
+
+        values = std::move(sorted);
+    };
+
+    for (u32 i {}; i < 3; ++i) {
+        permute(_positions[i]);
+        permute(_scales[i]);
+    }
+
+    for (u32 i {}; i < 4; ++i) {
+        permute(_rotations[i]);
+    }
+
+    permute(_parents);
+    permute(_depths);
+    permute(_dirty);
+    permute(_changed);
+    permute(_worlds);
+
+    for (u32& parent : _parents) {
+        parent = new_slot_of[parent];
+    }
+
+    for (u32& slot : _slot_of) {
+        slot = new_slot_of[slot];
+    }
+
+    _sorted = true;
+}
+
+void
+TransformHierarchy::_update_range(u32 begin, u32 end) noexcept {
+    Slots slots {
+        .parents = _parents.data(),
+        .dirty = _dirty.data(),
+        .changed = _changed.data(),
+        .worlds = reinterpret_cast<f32*>(_worlds.data()),
+    };
+
+    for (u32 i {}; i < 3; ++i) {
+        slots.positions[i] = _positions[i].data();
+        slots.scales[i] = _scales[i].data();
+    }
+
+    for (u32 i {}; i < 4; ++i) {
+        slots.rotations[i] = _rotations[i].data();
+    }
+
+    u32 const rest = s_update_batches<BatchLanes>(slots, begin, end);
+    s_update_batches<ScalarLanes>(slots, rest, end);
+}
+
+} // namespace core
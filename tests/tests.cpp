@@ -1,7 +1,1140 @@
 #include <gtest/gtest.h>
 
+#include <core/asset_archive.hpp>
+#include <core/asset_database.hpp>
+#include <core/compression.hpp>
+#include <core/deletion_queue.hpp>
+#include <core/ecs.hpp>
+#include <core/image_writer.hpp>
+#include <core/job_system.hpp>
+#include <core/linear_allocator.hpp>
+#include <core/mesh_file.hpp>
+#include <core/mesh_lod.hpp>
+#include <core/meshlet.hpp>
+#include <core/render_graph.hpp>
+#include <core/shader_variants.hpp>
+#include <core/spirv_reflection.hpp>
+#include <core/transform_hierarchy.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
 TEST(Canary, TestIntegerOne_One) {
   constexpr int expected = 1;
   constexpr int actual = 1 * 1;
   ASSERT_EQ(expected, actual);
 }
+
+TEST(Compression, Lz4RoundTrip) {
+  std::string text;
+  for (int i = 0; i < 1000; ++i) {
+    text += "layout(location = " + std::to_string(i % 7) + ") in vec3 v;\n";
+  }
+  auto const src = std::as_bytes(std::span {text});
+
+  std::vector<std::byte> compressed;
+  core::lz4_compress(src, compressed);
+  ASSERT_LT(compressed.size(), src.size());
+
+  std::vector<std::byte> decompressed(src.size());
+  ASSERT_TRUE(core::lz4_decompress(compressed, decompressed));
+  ASSERT_TRUE(std::equal(src.begin(), src.end(), decompressed.begin()));
+
+  // Truncated input must be rejected, not read out of bounds.
+  std::span<std::byte const> truncated {
+      compressed.data(), compressed.size() / 2};
+  ASSERT_FALSE(core::lz4_decompress(truncated, decompressed));
+}
+
+TEST(AssetArchive, WriteMountAndRead) {
+  std::string const shader = "#version 450\nvoid main() {}\n";
+  std::string const repeated(4096, 'v');
+
+  core::AssetArchiveWriter writer {64};
+  writer.add("shaders/a.vert", std::as_bytes(std::span {shader}), false);
+  writer.add("models\\b.obj", std::as_bytes(std::span {repeated}), true);
+
+  auto const path =
+      std::filesystem::temp_directory_path() / "v_engine_tests.pak";
+  ASSERT_TRUE(writer.write(path));
+
+  auto archive = core::AssetArchive::open(path);
+  ASSERT_NE(archive, nullptr);
+  ASSERT_EQ(archive->entries().size(), 2U);
+  ASSERT_EQ(archive->find("missing.txt"), nullptr);
+
+  core::PakEntry const* a = archive->find("shaders/a.vert");
+  ASSERT_NE(a, nullptr);
+  ASSERT_EQ(a->offset % 64, 0U);
+  ASSERT_EQ(archive->read(*a, true).text(), shader);
+
+  // Paths are normalized and compressible data is stored compressed.
+  core::PakEntry const* b = archive->find("models/b.obj");
+  ASSERT_NE(b, nullptr);
+  ASSERT_EQ(b->compression, core::PakCompression::Lz4);
+  ASSERT_EQ(archive->read(*b, true).text(), repeated);
+
+  archive.reset();
+  std::filesystem::remove(path);
+}
+
+TEST(AssetArchive, RejectsCorruptArchives) {
+  std::string const repeated(4096, 'v');
+
+  core::AssetArchiveWriter writer {};
+  writer.add("a.txt", std::as_bytes(std::span {repeated}), true);
+
+  auto const path =
+      std::filesystem::temp_directory_path() / "v_engine_corrupt.pak";
+  ASSERT_TRUE(writer.write(path));
+
+  std::vector<char> bytes(std::filesystem::file_size(path));
+  std::ifstream {path, std::ios::binary}.read(bytes.data(), bytes.size());
+
+  auto const open_with = [&path](std::vector<char> const& content) {
+    std::ofstream {path, std::ios::binary | std::ios::trunc}.write(
+        content.data(),
+        static_cast<std::streamsize>(content.size())
+    );
+    return core::AssetArchive::open(path);
+  };
+
+  core::PakHeader header {};
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  core::usize const entry_at = header.entries_offset;
+
+  // Data past the end of the file.
+  std::vector<char> truncated(bytes.begin(), bytes.end() - 16);
+  ASSERT_EQ(open_with(truncated), nullptr);
+
+  // An offset that wraps around when the size is added.
+  std::vector<char> wrapped = bytes;
+  core::u64 const offset = ~core::u64 {0} - 8;
+  std::memcpy(
+      wrapped.data() + entry_at + offsetof(core::PakEntry, offset),
+      &offset,
+      sizeof(offset)
+  );
+  ASSERT_EQ(open_with(wrapped), nullptr);
+
+  // A path out of the strings section.
+  std::vector<char> bad_path = bytes;
+  core::u32 const path_length = 1'000;
+  std::memcpy(
+      bad_path.data() + entry_at + offsetof(core::PakEntry, path_length),
+      &path_length,
+      sizeof(path_length)
+  );
+  ASSERT_EQ(open_with(bad_path), nullptr);
+
+  // No empty bucket: a missing path would be probed for forever.
+  std::vector<char> full_buckets = bytes;
+  std::vector<core::u32> const buckets(header.bucket_count, 0);
+  std::memcpy(
+      full_buckets.data() + header.buckets_offset,
+      buckets.data(),
+      buckets.size() * sizeof(core::u32)
+  );
+  ASSERT_EQ(open_with(full_buckets), nullptr);
+
+  // Compressed bytes that don't decode: an invalid asset, not garbage.
+  core::PakEntry entry {};
+  std::memcpy(&entry, bytes.data() + entry_at, sizeof(entry));
+  ASSERT_EQ(entry.compression, core::PakCompression::Lz4);
+  std::vector<char> bad_data = bytes;
+  std::fill_n(bad_data.begin() + entry.offset, entry.stored_size, '\xFF');
+  auto archive = open_with(bad_data);
+  ASSERT_NE(archive, nullptr);
+  ASSERT_FALSE(archive->read(archive->entries()[0]).is_valid());
+
+  archive.reset();
+  std::filesystem::remove(path);
+}
+
+TEST(AssetId, NormalizesPaths) {
+  auto const normalized = [](std::string_view path) {
+    return core::normalize_asset_path(path);
+  };
+
+  // Separators, "." and empty segments.
+  ASSERT_EQ(normalized("shaders\\sh_default.vert"), "shaders/sh_default.vert");
+  ASSERT_EQ(normalized("./shaders//./a.vert/"), "shaders/a.vert");
+  ASSERT_EQ(normalized(".\\.\\a"), "a");
+
+  // ".." takes the segment before it, or climbs out of the root.
+  ASSERT_EQ(normalized("models/../shaders/a.vert"), "shaders/a.vert");
+  ASSERT_EQ(normalized("a/b/c/../../d"), "a/d");
+  ASSERT_EQ(normalized("a/../../b"), "../b");
+  ASSERT_EQ(normalized("a/.."), "");
+
+  // Case is kept.
+  ASSERT_EQ(normalized("Shaders/A.vert"), "Shaders/A.vert");
+  ASSERT_NE(core::AssetId {"Shaders/A.vert"}, core::AssetId {"shaders/a.vert"});
+
+  // Ids and comparisons see the normalized path, without allocating.
+  static_assert(core::AssetId {"a\\./b/../c"} == core::AssetId {"a/c"});
+  static_assert(core::asset_paths_equal("./x/y/../z", "x\\z"));
+  static_assert(!core::asset_paths_equal("x/y", "x/y/z"));
+
+  // Archives hash the normalized path as written.
+  for (std::string_view const path : {"a\\./b/../c", "../x", "s/t.vert"}) {
+    ASSERT_EQ(
+        core::AssetId {path}.value,
+        core::hash_fnv1a(normalized(path))
+    );
+  }
+}
+
+TEST(AssetDatabase, CachesResolvedPaths) {
+  // Never seen: not in the cache.
+  core::AssetId const unseen {"tests/never_interned.txt"};
+  ASSERT_FALSE(core::AssetDatabase::metadata(unseen).exists);
+  ASSERT_FALSE(core::AssetDatabase::refresh(unseen).exists);
+
+  // First sighting resolves and stats, others spelled differently hit it.
+  core::AssetId const id =
+      core::AssetDatabase::intern("shaders/sh_default.vert");
+  std::filesystem::path const& resolved = core::AssetDatabase::resolve(id);
+  ASSERT_EQ(core::AssetDatabase::intern(".\\shaders\\sh_default.vert"), id);
+  ASSERT_EQ(
+      &core::AssetDatabase::resolve("models/../shaders/sh_default.vert"),
+      &resolved
+  );
+  ASSERT_EQ(resolved, core::AssetDatabase::root() / "shaders/sh_default.vert");
+
+  core::AssetMetadata const metadata = core::AssetDatabase::metadata(id);
+  ASSERT_TRUE(metadata.exists);
+  ASSERT_FALSE(metadata.archived);
+  ASSERT_EQ(metadata.size, std::filesystem::file_size(resolved));
+
+  // Missing files are cached too.
+  ASSERT_FALSE(core::AssetDatabase::exists("tests/missing.txt"));
+  ASSERT_FALSE(
+      core::AssetDatabase::metadata(core::AssetId {"tests/missing.txt"}).exists
+  );
+}
+
+TEST(AssetDatabase, ReadsCompressedArchiveEntries) {
+  std::string const text(8192, 'z');
+
+  core::AssetArchiveWriter writer {};
+  writer.add("tests/archived.txt", std::as_bytes(std::span {text}), true);
+
+  auto const path =
+      std::filesystem::temp_directory_path() / "v_engine_database.pak";
+  ASSERT_TRUE(writer.write(path));
+  ASSERT_TRUE(core::AssetDatabase::mount(path));
+
+  // Decompressed into a buffer the returned string must not point into.
+  core::AssetId const id = core::AssetDatabase::intern("tests/archived.txt");
+  ASSERT_TRUE(core::AssetDatabase::metadata(id).archived);
+  ASSERT_EQ(core::AssetDatabase::read_asset_file("tests/archived.txt"), text);
+
+  core::AssetDatabase::unmount_all();
+  ASSERT_FALSE(core::AssetDatabase::exists("tests/archived.txt"));
+  std::filesystem::remove(path);
+}
+
+TEST(ImageWriter, PngSignatureAndChunkCrc) {
+  std::string const check = "123456789";
+  ASSERT_EQ(core::crc32(std::as_bytes(std::span {check})), 0xCBF43926U);
+
+  std::vector<std::byte> pixels(4 * 3 * 4, std::byte {0x7F});
+  auto const path =
+      std::filesystem::temp_directory_path() / "v_engine_tests.png";
+  ASSERT_TRUE(core::write_png(path, 4, 3, 4, pixels));
+
+  std::ifstream file(path, std::ios::binary);
+  std::vector<char> const bytes {
+      std::istreambuf_iterator<char> {file}, std::istreambuf_iterator<char> {}
+  };
+  ASSERT_GT(bytes.size(), 33U);
+  ASSERT_EQ(std::string(bytes.begin() + 1, bytes.begin() + 4), "PNG");
+
+  // IHDR: 4 byte type + 13 byte payload, followed by its big endian CRC.
+  auto const ihdr = std::as_bytes(std::span {bytes}.subspan(12, 17));
+  core::u32 const crc = core::crc32(ihdr);
+  ASSERT_EQ(static_cast<unsigned char>(bytes[29]), crc >> 24);
+  ASSERT_EQ(static_cast<unsigned char>(bytes[32]), crc & 0xFF);
+
+  file.close();
+  std::filesystem::remove(path);
+}
+
+TEST(DeletionQueue, CollectsInOrderUpToCompletedValue) {
+  std::vector<int> destroyed;
+  auto const record = [&destroyed](int id) {
+    return [&destroyed, id] { destroyed.push_back(id); };
+  };
+
+  {
+    core::DeletionQueue queue;
+    queue.defer(1, record(1));
+    queue.defer(2, record(2));
+    queue.push(2, std::make_unique<int>(42));
+    queue.defer(5, record(5));
+    ASSERT_EQ(queue.size(), 4U);
+
+    queue.collect(0);
+    ASSERT_TRUE(destroyed.empty());
+
+    queue.collect(2);
+    ASSERT_EQ(destroyed, (std::vector<int> {1, 2}));
+    ASSERT_EQ(queue.size(), 1U);
+
+    queue.defer(7, record(7));
+  } // Whatever is left is destroyed with the queue, in order.
+
+  ASSERT_EQ(destroyed, (std::vector<int> {1, 2, 5, 7}));
+}
+
+TEST(LinearAllocator, AlignsAndFailsOnceFull) {
+  core::LinearAllocator allocator {256, 64};
+
+  ASSERT_EQ(allocator.allocate(100), std::optional<core::u64> {0});
+  ASSERT_EQ(allocator.allocate(64), std::optional<core::u64> {128});
+  ASSERT_EQ(allocator.used(), 192U);
+
+  // Full: nothing is handed out twice.
+  ASSERT_FALSE(allocator.allocate(65).has_value());
+  ASSERT_EQ(allocator.allocate(64), std::optional<core::u64> {192});
+  ASSERT_FALSE(allocator.allocate(1).has_value());
+  ASSERT_EQ(allocator.used(), allocator.capacity());
+
+  allocator.reset();
+  ASSERT_EQ(allocator.allocate(256), std::optional<core::u64> {0});
+
+  // The capacity need not be aligned.
+  core::LinearAllocator unaligned {100, 64};
+  ASSERT_EQ(unaligned.allocate(1), std::optional<core::u64> {0});
+  ASSERT_EQ(unaligned.allocate(36), std::optional<core::u64> {64});
+  ASSERT_FALSE(unaligned.allocate(1).has_value());
+}
+
+TEST(Meshlet, CoversEveryTriangleWithinLimits) {
+  // A flat 40x40 quad grid facing +Z.
+  constexpr core::u32 side {41};
+  std::vector<glm::vec3> positions;
+  std::vector<core::u32> indices;
+
+  for (core::u32 y {}; y < side; ++y) {
+    for (core::u32 x {}; x < side; ++x) {
+      positions.emplace_back(static_cast<float>(x), static_cast<float>(y), 0);
+    }
+  }
+
+  for (core::u32 y {}; y + 1 < side; ++y) {
+    for (core::u32 x {}; x + 1 < side; ++x) {
+      core::u32 const i = y * side + x;
+      indices.insert(indices.end(), {i, i + 1, i + side});
+      indices.insert(indices.end(), {i + 1, i + side + 1, i + side});
+    }
+  }
+
+  core::MeshletLimits const limits {};
+  core::MeshletMesh const mesh = core::build_meshlets(positions, indices);
+  ASSERT_EQ(mesh.indices.size(), indices.size());
+
+  core::u32 next_index {0};
+  for (core::Meshlet const& meshlet : mesh.meshlets) {
+    // Contiguous ranges, within the limits.
+    ASSERT_EQ(meshlet.first_index, next_index);
+    ASSERT_LE(meshlet.vertex_count, limits.max_vertices);
+    ASSERT_LE(meshlet.index_count, 3 * limits.max_triangles);
+    next_index += meshlet.index_count;
+
+    // Flat: the cone is the plane normal, as narrow as it gets.
+    ASSERT_NEAR(meshlet.cone.z, 1.0f, 1e-5f);
+    ASSERT_NEAR(meshlet.cone.w, 0.0f, 1e-3f);
+  }
+  ASSERT_EQ(next_index, indices.size());
+
+  // Same triangles, in another order.
+  auto const sorted_triangles = [](std::vector<core::u32> const& source) {
+    std::vector<std::array<core::u32, 3>> triangles;
+    for (size_t i {}; i < source.size(); i += 3) {
+      triangles.push_back({source[i], source[i + 1], source[i + 2]});
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+  };
+  ASSERT_EQ(sorted_triangles(mesh.indices), sorted_triangles(indices));
+}
+
+TEST(MeshFile, WriteAndOpen) {
+  std::vector<std::byte> const vertices(3 * 20, std::byte {0x2A});
+  std::vector<core::u32> const indices {0, 1, 2};
+  std::vector<core::Meshlet> const meshlets {{.index_count = 3}};
+  std::vector<core::MeshLod> const lods {
+      {.index_count = 3, .meshlet_count = 1}
+  };
+  core::MeshSourceStamp const source {.size = 1234, .modified_ticks = 42};
+
+  auto const path =
+      std::filesystem::temp_directory_path() / "v_engine_tests.vmesh";
+  ASSERT_TRUE(core::MeshFile::write(
+      path,
+      {
+          .source = source,
+          .vertex_stride = 20,
+          .vertices = vertices,
+          .indices = indices,
+          .meshlets = meshlets,
+          .lods = lods,
+      }
+  ));
+
+  {
+    core::MeshFile const mesh = core::MeshFile::open(path);
+    ASSERT_TRUE(mesh.is_valid());
+
+    core::MeshFileContents const& contents = mesh.contents();
+    ASSERT_EQ(contents.source, source);
+    ASSERT_EQ(contents.vertex_stride, 20U);
+    ASSERT_TRUE(std::ranges::equal(contents.vertices, vertices));
+    ASSERT_TRUE(std::ranges::equal(contents.indices, indices));
+    ASSERT_EQ(contents.meshlets.size(), 1U);
+    ASSERT_EQ(contents.meshlets[0].index_count, 3U);
+    ASSERT_EQ(contents.lods.size(), 1U);
+    ASSERT_EQ(contents.lods[0].meshlet_count, 1U);
+  }
+
+  ASSERT_FALSE(core::MeshFile::open(path.string() + ".missing").is_valid());
+  std::filesystem::remove(path);
+}
+
+TEST(MeshFile, RejectsOutOfRangeContents) {
+  std::vector<std::byte> const vertices(3 * 20, std::byte {0x2A});
+  std::vector<core::u32> const indices {0, 1, 2};
+  std::vector<core::Meshlet> const meshlets {{.index_count = 3}};
+  std::vector<core::MeshLod> const lods {
+      {.index_count = 3, .meshlet_count = 1}
+  };
+
+  auto const path =
+      std::filesystem::temp_directory_path() / "v_engine_tests_bad.vmesh";
+  auto const opens = [&](core::MeshFileContents const& contents) {
+    return core::MeshFile::write(path, contents) &&
+           core::MeshFile::open(path).is_valid();
+  };
+
+  core::MeshFileContents const valid {
+      .vertex_stride = 20,
+      .vertices = vertices,
+      .indices = indices,
+      .meshlets = meshlets,
+      .lods = lods,
+  };
+  ASSERT_TRUE(opens(valid));
+
+  // An index past the last vertex.
+  std::vector<core::u32> const bad_indices {0, 1, 3};
+  core::MeshFileContents contents = valid;
+  contents.indices = bad_indices;
+  ASSERT_FALSE(opens(contents));
+
+  // A meshlet past the last index.
+  std::vector<core::Meshlet> const bad_meshlets {
+      {.first_index = 1, .index_count = 3}
+  };
+  contents = valid;
+  contents.meshlets = bad_meshlets;
+  ASSERT_FALSE(opens(contents));
+
+  // A level past the last meshlet.
+  std::vector<core::MeshLod> const bad_lods {
+      {.index_count = 3, .first_meshlet = 1, .meshlet_count = 1}
+  };
+  contents = valid;
+  contents.lods = bad_lods;
+  ASSERT_FALSE(opens(contents));
+
+  // No level at all, the loader needs the full resolution one.
+  contents = valid;
+  contents.lods = {};
+  ASSERT_FALSE(opens(contents));
+
+  // An offset whose end wraps around.
+  ASSERT_TRUE(opens(valid));
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    core::u64 const wrapping {~core::u64 {0} - 7};
+    file.seekp(offsetof(core::MeshFileHeader, indices_offset));
+    file.write(reinterpret_cast<char const*>(&wrapping), sizeof(wrapping));
+  }
+  ASSERT_FALSE(core::MeshFile::open(path).is_valid());
+
+  std::filesystem::remove(path);
+}
+
+TEST(MeshLod, ChainHalvesTrianglesWithGrowingError) {
+  // A 60x60 quad grid with bumps, so simplifying it costs something.
+  constexpr core::u32 side {61};
+  std::vector<glm::vec3> positions;
+  std::vector<core::u32> indices;
+
+  for (core::u32 y {}; y < side; ++y) {
+    for (core::u32 x {}; x < side; ++x) {
+      float const height = static_cast<float>((x * 7 + y * 13) % 5) * 0.05f;
+      positions.emplace_back(
+          static_cast<float>(x), static_cast<float>(y), height
+      );
+    }
+  }
+
+  for (core::u32 y {}; y + 1 < side; ++y) {
+    for (core::u32 x {}; x + 1 < side; ++x) {
+      core::u32 const i = y * side + x;
+      indices.insert(indices.end(), {i, i + 1, i + side});
+      indices.insert(indices.end(), {i + 1, i + side + 1, i + side});
+    }
+  }
+
+  core::LodMesh const mesh = core::build_lod_chain(positions, indices, 4);
+  ASSERT_GT(mesh.lods.size(), 1U);
+  ASSERT_LE(mesh.lods.size(), 4U);
+
+  // The full mesh first, as is.
+  ASSERT_EQ(mesh.lods[0].index_count, indices.size());
+  ASSERT_EQ(mesh.lods[0].error, 0.0f);
+
+  core::u32 next_index {0};
+  core::u32 next_meshlet {0};
+  for (size_t i {}; i < mesh.lods.size(); ++i) {
+    core::MeshLod const& lod = mesh.lods[i];
+
+    // Levels one after another, each made of its own meshlets.
+    ASSERT_EQ(lod.first_index, next_index);
+    ASSERT_EQ(lod.first_meshlet, next_meshlet);
+    ASSERT_EQ(mesh.meshlets[lod.first_meshlet].first_index, lod.first_index);
+    next_index += lod.index_count;
+    next_meshlet += lod.meshlet_count;
+
+    if (i > 0) {
+      core::MeshLod const& finer = mesh.lods[i - 1];
+      // About half the triangles each time, never a free lunch.
+      ASSERT_LE(lod.index_count, finer.index_count * 6 / 10);
+      ASSERT_GE(lod.error, finer.error);
+    }
+  }
+  ASSERT_EQ(next_index, mesh.indices.size());
+  ASSERT_EQ(next_meshlet, mesh.meshlets.size());
+
+  for (core::u32 const index : mesh.indices) {
+    ASSERT_LT(index, positions.size());
+  }
+}
+
+TEST(RenderGraph, BarriersAndCulling) {
+  using Usage = core::RenderGraphUsage;
+  using Layout = core::RenderGraphLayout;
+
+  core::RenderGraph graph;
+  auto const depth = graph.create_image("depth", {.size = 1024});
+  auto const pyramid = graph.import_image(
+      "pyramid", {.layout = Layout::General}
+  );
+  auto const draws = graph.import_buffer("draws");
+  auto const debug = graph.create_image("debug", {.size = 1024});
+  auto const target = graph.import_image(
+      "target", {.usages = core::to_mask(Usage::ColorAttachment)}
+  );
+  graph.export_resource(target, Usage::Present);
+
+  auto const cull = graph.add_pass("cull");
+  graph.write(cull, draws, Usage::ComputeStorage);
+
+  auto const draw = graph.add_pass("draw");
+  graph.read(draw, draws, Usage::IndirectArguments);
+  graph.write(draw, depth, Usage::DepthAttachment);
+  graph.write(draw, target, Usage::ColorAttachment);
+
+  // Nobody reads what it writes.
+  auto const unused = graph.add_pass("debug view");
+  graph.read(unused, depth, Usage::ComputeSampled);
+  graph.write(unused, debug, Usage::ComputeStorage);
+
+  auto const reduce = graph.add_pass("reduce depth");
+  graph.read(reduce, depth, Usage::ComputeSampled);
+  graph.write(reduce, pyramid, Usage::ComputeStorage);
+
+  auto const late_cull = graph.add_pass("late cull");
+  graph.read(late_cull, pyramid, Usage::ComputeStorage);
+  graph.read(late_cull, draws, Usage::ComputeStorage);
+  graph.write(late_cull, draws, Usage::ComputeStorage);
+
+  auto const late_draw = graph.add_pass("late draw");
+  graph.read(late_draw, draws, Usage::IndirectArguments);
+  graph.read(late_draw, depth, Usage::DepthAttachment);
+  graph.write(late_draw, depth, Usage::DepthAttachment);
+  graph.write(late_draw, target, Usage::ColorAttachment);
+
+  core::CompiledRenderGraph const compiled = graph.compile();
+
+  std::vector<std::string_view> names;
+  for (core::RenderGraphStep const& step : compiled.steps) {
+    names.push_back(graph.pass_name(step.pass));
+  }
+  ASSERT_EQ(
+      names,
+      (std::vector<std::string_view> {
+          "cull", "draw", "reduce depth", "late cull", "late draw"
+      })
+  );
+
+  auto const find = [&](size_t step, core::RenderGraphResource resource) {
+    for (core::RenderGraphBarrier const& barrier :
+         compiled.steps[step].barriers) {
+      if (barrier.resource == resource) {
+        return barrier;
+      }
+    }
+    return core::RenderGraphBarrier {.resource = ~0U};
+  };
+
+  // First use of a buffer: nothing to wait for.
+  ASSERT_TRUE(compiled.steps[0].barriers.empty());
+
+  // Draw: the indirect arguments, and the first layouts of the images.
+  ASSERT_EQ(compiled.steps[1].barriers.size(), 3U);
+  auto const arguments = find(1, draws);
+  ASSERT_EQ(arguments.src_usages, core::to_mask(Usage::ComputeStorage));
+  ASSERT_EQ(arguments.src_writes, core::to_mask(Usage::ComputeStorage));
+  ASSERT_EQ(arguments.dst_reads, core::to_mask(Usage::IndirectArguments));
+  // Transient: its memory was last written by the previous execution.
+  auto const depth_layout = find(1, depth);
+  ASSERT_EQ(depth_layout.src_usages, core::to_mask(Usage::DepthAttachment));
+  ASSERT_EQ(depth_layout.src_writes, core::to_mask(Usage::DepthAttachment));
+  ASSERT_TRUE(depth_layout.old_layout == Layout::Undefined);
+  ASSERT_TRUE(depth_layout.new_layout == Layout::DepthAttachment);
+  // Waits for whoever used it before the graph (e.g. an acquire).
+  auto const target_layout = find(1, target);
+  ASSERT_EQ(target_layout.src_usages, core::to_mask(Usage::ColorAttachment));
+  ASSERT_EQ(target_layout.src_writes, 0U);
+
+  // Reduce: depth to sampled, the pyramid stays General.
+  ASSERT_EQ(compiled.steps[2].barriers.size(), 1U);
+  auto const sampled = find(2, depth);
+  ASSERT_EQ(sampled.src_writes, core::to_mask(Usage::DepthAttachment));
+  ASSERT_TRUE(sampled.old_layout == Layout::DepthAttachment);
+  ASSERT_TRUE(sampled.new_layout == Layout::ShaderReadOnly);
+
+  // Late cull: reads the pyramid, and overwrites the draws after the
+  // indirect reads (which already waited for the first cull).
+  auto const pyramid_read = find(3, pyramid);
+  ASSERT_EQ(pyramid_read.src_writes, core::to_mask(Usage::ComputeStorage));
+  auto const overwrite = find(3, draws);
+  ASSERT_EQ(overwrite.src_usages, core::to_mask(Usage::IndirectArguments));
+  ASSERT_EQ(overwrite.src_writes, 0U);
+
+  // Late draw: depth back to an attachment, after the sampled reads.
+  auto const attachment = find(4, depth);
+  ASSERT_EQ(attachment.src_usages, core::to_mask(Usage::ComputeSampled));
+  ASSERT_TRUE(attachment.new_layout == Layout::DepthAttachment);
+  auto const target_again = find(4, target);
+  ASSERT_EQ(target_again.src_writes, core::to_mask(Usage::ColorAttachment));
+
+  ASSERT_EQ(compiled.final_barriers.size(), 1U);
+  ASSERT_EQ(compiled.final_barriers[0].resource, target);
+  ASSERT_TRUE(compiled.final_barriers[0].new_layout == Layout::Present);
+
+  // Culled, so no memory either.
+  ASSERT_EQ(
+      compiled.memory_offsets[debug], core::CompiledRenderGraph::s_no_memory
+  );
+}
+
+TEST(RenderGraph, AliasesTransientMemory) {
+  using Usage = core::RenderGraphUsage;
+
+  core::RenderGraph graph;
+  auto const output = graph.import_image("output");
+  graph.export_resource(output);
+
+  // a -> b -> output, c lives from b's pass on: a and c never coexist.
+  auto const a = graph.create_image("a", {.size = 4096, .alignment = 256});
+  auto const b = graph.create_image("b", {.size = 1000, .alignment = 256});
+  auto const c = graph.create_image("c", {.size = 3000, .alignment = 256});
+
+  auto const first = graph.add_pass("first");
+  graph.write(first, a, Usage::ColorAttachment);
+
+  auto const second = graph.add_pass("second");
+  graph.read(second, a, Usage::ComputeSampled);
+  graph.write(second, b, Usage::ComputeStorage);
+
+  auto const third = graph.add_pass("third");
+  graph.read(third, b, Usage::ComputeStorage);
+  graph.write(third, c, Usage::ColorAttachment);
+
+  auto const fourth = graph.add_pass("fourth");
+  graph.read(fourth, c, Usage::ComputeSampled);
+  graph.write(fourth, output, Usage::Transfer);
+
+  core::CompiledRenderGraph const compiled = graph.compile();
+  ASSERT_EQ(compiled.steps.size(), 4U);
+
+  // a and b overlap in time, b and c too, a and c share memory.
+  ASSERT_EQ(compiled.memory_offsets[a], 0U);
+  ASSERT_EQ(compiled.memory_offsets[b], 4096U);
+  ASSERT_EQ(compiled.memory_offsets[c], 0U);
+  ASSERT_EQ(compiled.memory_size, 4096U + 1000U);
+
+  // c's first use waits for a's last reader, and a's for c's in the
+  // previous execution.
+  auto const find = [&](size_t step, core::RenderGraphResource resource) {
+    for (core::RenderGraphBarrier const& barrier :
+         compiled.steps[step].barriers) {
+      if (barrier.resource == resource) {
+        return barrier;
+      }
+    }
+    return core::RenderGraphBarrier {.resource = ~0U};
+  };
+  auto const alias = find(2, c);
+  ASSERT_EQ(alias.resource, c);
+  ASSERT_EQ(alias.src_usages, core::to_mask(Usage::ComputeSampled));
+  auto const reuse = find(0, a);
+  ASSERT_EQ(reuse.resource, a);
+  ASSERT_EQ(reuse.src_usages, core::to_mask(Usage::ComputeSampled));
+}
+
+TEST(ShaderVariants, CompilesRequestedVariantsOnce) {
+  constexpr std::string_view source =
+      "#version 450\n"
+      "#pragma shader_feature DOUBLE HALF\n"
+      "# pragma shader_feature DOUBLE QUARTER\n"
+      "layout(local_size_x = 1) in;\n"
+      "layout(set = 0, binding = 0) buffer Values { float values[]; };\n"
+      "void main() {\n"
+      "#ifdef DOUBLE\n"
+      "  values[0] *= 2.0;\n"
+      "#endif\n"
+      "}\n";
+  ASSERT_EQ(
+      core::parse_shader_keywords(source),
+      (std::vector<std::string> {"DOUBLE", "HALF", "QUARTER"})
+  );
+
+  auto const directory =
+      std::filesystem::temp_directory_path() / "v_engine_tests_variants";
+  std::filesystem::remove_all(directory);
+
+  std::vector<std::string> const none {};
+  std::vector<std::string> const doubled {"DOUBLE", "UNDECLARED", "DOUBLE"};
+  std::vector<std::string> const half_double {"HALF", "DOUBLE"};
+  std::vector<std::string> const double_half {"DOUBLE", "HALF"};
+  std::vector<core::ShaderVariantId> ids {};
+  {
+    core::ShaderVariantCache cache;
+    cache.start(2, directory);
+    core::u64 const compute =
+        cache.add_source("test.comp", source, shaderc_compute_shader);
+    ASSERT_EQ(
+        cache.add_source("test.comp", source, shaderc_compute_shader),
+        compute
+    );
+
+    ids = {
+        cache.request(compute, none),
+        cache.request(compute, doubled),
+        cache.request(compute, half_double),
+    };
+    ASSERT_NE(ids[0], ids[1]);
+    ASSERT_NE(ids[1], ids[2]);
+    ASSERT_EQ(cache.request(compute, double_half), ids[2]);
+
+    for (core::ShaderVariantId const id : ids) {
+      std::span<core::u32 const> const spirv = cache.spirv(id);
+      ASSERT_FALSE(spirv.empty());
+      ASSERT_EQ(spirv.front(), 0x07230203U);
+    }
+    ASSERT_EQ(cache.compiled_count(), 3U);
+
+    core::u64 const broken = cache.add_source(
+        "broken.comp",
+        "#version 450\nnot glsl",
+        shaderc_compute_shader
+    );
+    ASSERT_TRUE(cache.spirv(cache.request(broken, none)).empty());
+  }
+
+  // Stored by id, another run loads them.
+  core::ShaderVariantCache cache;
+  cache.start(1, directory);
+  core::u64 const compute =
+      cache.add_source("test.comp", source, shaderc_compute_shader);
+  ASSERT_EQ(cache.request(compute, doubled), ids[1]);
+  ASSERT_FALSE(cache.spirv(ids[1]).empty());
+  ASSERT_EQ(cache.compiled_count(), 0U);
+
+  cache.stop();
+  std::filesystem::remove_all(directory);
+}
+
+TEST(SpirvReflection, ReflectsAndMergesLayouts) {
+  constexpr std::string_view vertex_source =
+      "#version 450\n"
+      "layout(set = 0, binding = 0) uniform Camera {\n"
+      "  mat4 view_projection;\n"
+      "};\n"
+      "layout(set = 0, binding = 2) readonly buffer Models {\n"
+      "  mat4 models[];\n"
+      "};\n"
+      "layout(push_constant) uniform Draw { uint index; vec2 offset; };\n"
+      "layout(location = 0) in vec3 position;\n"
+      "layout(location = 2) in ivec2 cell;\n"
+      "void main() {\n"
+      "  vec2 moved = position.xy + offset + vec2(cell);\n"
+      "  mat4 model = models[index];\n"
+      "  gl_Position = view_projection * model * vec4(moved, position.z, 1);\n"
+      "}\n";
+  constexpr std::string_view fragment_source =
+      "#version 450\n"
+      "#extension GL_EXT_nonuniform_qualifier : require\n"
+      "layout(set = 0, binding = 0) uniform Camera {\n"
+      "  mat4 view_projection;\n"
+      "};\n"
+      "layout(set = 1, binding = 0) uniform texture2D textures[];\n"
+      "layout(set = 1, binding = 1) uniform sampler samplers[4];\n"
+      "layout(push_constant) uniform Draw { uint index; vec2 offset; };\n"
+      "layout(location = 0) out vec4 color;\n"
+      "void main() {\n"
+      "  color = view_projection[0] * texture(\n"
+      "      sampler2D(textures[nonuniformEXT(index)], samplers[index % 4]),\n"
+      "      offset\n"
+      "  );\n"
+      "}\n";
+
+  core::ShaderVariantCache cache;
+  cache.start(1);
+  std::vector<std::string> const none {};
+  core::ShaderVariantId const vertex_id = cache.request(
+      cache.add_source("test.vert", vertex_source, shaderc_vertex_shader),
+      none
+  );
+  core::ShaderVariantId const fragment_id = cache.request(
+      cache.add_source("test.frag", fragment_source, shaderc_fragment_shader),
+      none
+  );
+
+  std::optional<core::ShaderReflection> const vertex =
+      core::reflect_spirv(cache.spirv(vertex_id));
+  std::optional<core::ShaderReflection> const fragment =
+      core::reflect_spirv(cache.spirv(fragment_id));
+  ASSERT_TRUE(vertex && fragment);
+
+  using core::ShaderDescriptorType;
+  core::ShaderStageMask const vertex_stage =
+      core::to_mask(core::ShaderStage::Vertex);
+  core::ShaderStageMask const fragment_stage =
+      core::to_mask(core::ShaderStage::Fragment);
+
+  ASSERT_EQ(vertex->stage, core::ShaderStage::Vertex);
+  ASSERT_EQ(
+      vertex->bindings,
+      (std::vector<core::ShaderBinding> {
+          {0, 0, ShaderDescriptorType::UniformBuffer, 1, vertex_stage},
+          {0, 2, ShaderDescriptorType::StorageBuffer, 1, vertex_stage},
+      })
+  );
+  ASSERT_EQ(vertex->push_constant_size, 16U);
+  ASSERT_EQ(
+      vertex->vertex_inputs,
+      (std::vector<core::ShaderVertexInput> {
+          {0, core::ShaderScalarType::Float, 3},
+          {2, core::ShaderScalarType::Int, 2},
+      })
+  );
+
+  ASSERT_EQ(fragment->stage, core::ShaderStage::Fragment);
+  ASSERT_EQ(
+      fragment->bindings,
+      (std::vector<core::ShaderBinding> {
+          {0, 0, ShaderDescriptorType::UniformBuffer, 1, fragment_stage},
+          {1, 0, ShaderDescriptorType::SampledImage, 0, fragment_stage},
+          {1, 1, ShaderDescriptorType::Sampler, 4, fragment_stage},
+      })
+  );
+  ASSERT_TRUE(fragment->vertex_inputs.empty());
+
+  std::array const stages {*vertex, *fragment};
+  std::optional<core::ShaderLayout> const layout =
+      core::merge_shader_layouts(stages);
+  ASSERT_TRUE(layout);
+  ASSERT_EQ(layout->sets.size(), 2U);
+  ASSERT_EQ(layout->sets[0].size(), 2U);
+  ASSERT_EQ(layout->sets[0][0].stages, vertex_stage | fragment_stage);
+  ASSERT_EQ(layout->sets[1].size(), 2U);
+  ASSERT_EQ(layout->push_constant_size, 16U);
+  ASSERT_EQ(layout->push_constant_stages, vertex_stage | fragment_stage);
+  ASSERT_TRUE(core::fits_shader_layout(*vertex, *layout));
+  ASSERT_TRUE(core::fits_shader_layout(*fragment, *layout));
+
+  // Same binding, another type.
+  core::ShaderReflection storage_camera = *fragment;
+  storage_camera.bindings[0].type = ShaderDescriptorType::StorageBuffer;
+  std::array const conflicting {*vertex, storage_camera};
+  ASSERT_FALSE(core::merge_shader_layouts(conflicting));
+  ASSERT_FALSE(core::fits_shader_layout(storage_camera, *layout));
+
+  // Not in the layout at all.
+  core::ShaderReflection unknown = *vertex;
+  unknown.bindings.push_back(
+      {2, 0, ShaderDescriptorType::StorageImage, 1, vertex_stage}
+  );
+  ASSERT_FALSE(core::fits_shader_layout(unknown, *layout));
+
+  std::span<core::u32 const> const spirv = cache.spirv(vertex_id);
+  std::vector<core::u32> words(spirv.begin(), spirv.end());
+  words.back() = 0xFFFFFFFF; // Longer than the module.
+  ASSERT_FALSE(core::reflect_spirv(words));
+  ASSERT_FALSE(core::reflect_spirv({}));
+}
+
+TEST(SpirvReflection, RejectsTypesUsedBeforeTheirDeclaration) {
+  // A compute shader with one array of 4 samplers, of element_type.
+  auto const module = [](core::u32 element_type, core::u32 storage) {
+    auto const op = [](core::u32 code, core::u32 word_count) {
+      return word_count << 16 | code;
+    };
+    return std::vector<core::u32> {
+        0x07230203, 0x00010000, 0, 9, 0, // Header, ids below 9.
+        op(15, 5), 5, 1, 0x6E69616D, 0, // OpEntryPoint GLCompute %1 "main".
+        op(21, 4), 2, 32, 0, // %2 = OpTypeInt 32 0.
+        op(43, 4), 2, 3, 4, // %3 = OpConstant %2 4.
+        op(26, 2), 4, // %4 = OpTypeSampler.
+        op(28, 4), 5, element_type, 3, // %5 = OpTypeArray %element %3.
+        op(32, 4), 6, storage, 5, // %6 = OpTypePointer storage %5.
+        op(59, 4), 6, 7, storage, // %7 = OpVariable %6 storage.
+        op(71, 4), 7, 34, 0, // OpDecorate %7 DescriptorSet 0.
+        op(71, 4), 7, 33, 0, // OpDecorate %7 Binding 0.
+    };
+  };
+  constexpr core::u32 uniform_constant {0};
+  constexpr core::u32 push_constant {9};
+
+  std::optional<core::ShaderReflection> const samplers =
+      core::reflect_spirv(module(4, uniform_constant));
+  ASSERT_TRUE(samplers.has_value());
+  ASSERT_EQ(samplers->bindings.size(), 1U);
+  ASSERT_EQ(samplers->bindings[0].count, 4U);
+  ASSERT_EQ(
+      samplers->bindings[0].type,
+      core::ShaderDescriptorType::Sampler
+  );
+
+  // An array of itself would be unwrapped, or sized, forever.
+  ASSERT_FALSE(core::reflect_spirv(module(5, uniform_constant)));
+  ASSERT_FALSE(core::reflect_spirv(module(5, push_constant)));
+  // Declared later.
+  ASSERT_FALSE(core::reflect_spirv(module(6, uniform_constant)));
+  // Not declared at all.
+  ASSERT_FALSE(core::reflect_spirv(module(8, uniform_constant)));
+}
+
+TEST(JobSystem, ParallelForRunsEveryIndexOnce) {
+  core::JobSystem jobs;
+  jobs.start(3);
+
+  std::vector<std::atomic<core::u32>> runs(10'000);
+  jobs.parallel_for(runs.size(), 64, [&](core::usize begin, core::usize end) {
+    // Nested loops are run by the waiting threads too.
+    auto const inner = [&](core::usize first, core::usize last) {
+      for (core::usize i = first; i < last; ++i) {
+        runs[begin + i].fetch_add(1);
+      }
+    };
+    jobs.parallel_for(end - begin, 16, inner);
+  });
+
+  ASSERT_TRUE(std::ranges::all_of(runs, [](auto const& count) {
+    return count.load() == 1;
+  }));
+
+  // Without workers, on the caller.
+  jobs.stop();
+  core::usize sum {0};
+  jobs.parallel_for(100, 8, [&](core::usize begin, core::usize end) {
+    sum += end - begin;
+  });
+  ASSERT_EQ(sum, 100U);
+}
+
+namespace {
+struct Position {
+  float x {0.0f};
+};
+struct Velocity {
+  float x {0.0f};
+};
+struct Frozen {};
+} // namespace
+
+TEST(Ecs, MovesEntitiesBetweenArchetypes) {
+  core::World world;
+  std::vector<core::Entity> entities {};
+
+  // Several chunks per archetype.
+  for (core::u32 i {}; i < 10'000; ++i) {
+    entities.push_back(
+        i % 2 == 0 ? world.create(Position {static_cast<float>(i)})
+                   : world.create(
+                         Position {static_cast<float>(i)},
+                         Velocity {1.0f}
+                     )
+    );
+  }
+  for (core::u32 i {}; i < entities.size(); i += 3) {
+    world.add<Frozen>(entities[i]);
+  }
+  for (core::u32 i {}; i < entities.size(); i += 5) {
+    world.remove<Velocity>(entities[i]);
+  }
+  for (core::u32 i {}; i < entities.size(); i += 7) {
+    world.destroy(entities[i]);
+  }
+
+  core::usize alive {0};
+  for (core::u32 i {}; i < entities.size(); ++i) {
+    core::Entity const entity = entities[i];
+    if (i % 7 == 0) {
+      ASSERT_FALSE(world.alive(entity));
+      ASSERT_EQ(world.get<Position>(entity), nullptr);
+      continue;
+    }
+
+    ++alive;
+    ASSERT_EQ(world.get<Position>(entity)->x, static_cast<float>(i));
+    ASSERT_EQ(world.has<Velocity>(entity), i % 2 == 1 && i % 5 != 0);
+    ASSERT_EQ(world.has<Frozen>(entity), i % 3 == 0);
+  }
+  ASSERT_EQ(world.entity_count(), alive);
+
+  // Destroyed indices come back with another generation.
+  core::Entity const reused = world.create();
+  ASSERT_EQ(reused.index, entities[9'996].index);
+  ASSERT_TRUE(world.alive(reused));
+  ASSERT_FALSE(world.alive(entities[9'996]));
+
+  // Moving entities (frozen or not), on every thread.
+  core::JobSystem jobs;
+  jobs.start(2);
+  world.each<Position, Velocity const>(
+      jobs,
+      [](Position& position, Velocity const& velocity) {
+        position.x += velocity.x;
+      }
+  );
+
+  core::usize visited {0};
+  world.each_chunk<Position const, Velocity const>(
+      [&](std::span<core::Entity const> chunk_entities,
+          std::span<Position const> positions,
+          std::span<Velocity const>) {
+        for (core::usize i {}; i < chunk_entities.size(); ++i) {
+          core::u32 const index = chunk_entities[i].index;
+          ASSERT_EQ(positions[i].x, static_cast<float>(index) + 1.0f);
+          ++visited;
+        }
+      }
+  );
+
+  core::usize const moving = static_cast<core::usize>(
+      std::ranges::count_if(entities, [&](core::Entity entity) {
+        return world.has<Velocity>(entity);
+      })
+  );
+  ASSERT_EQ(visited, moving);
+}
+
+TEST(TransformHierarchy, MatchesGlmThroughDirtySubtrees) {
+  core::JobSystem jobs;
+  jobs.start(3);
+  core::TransformHierarchy transforms;
+
+  // Depths interleaved, so the nodes get sorted, and levels of batches
+  // with some nodes left over.
+  std::vector<core::TransformNode> parents {};
+  for (core::u32 root {}; root < 40; ++root) {
+    core::TransformNode const root_node = transforms.create();
+    parents.push_back(core::s_no_transform_node);
+    for (core::u32 child {}; child < 29; ++child) {
+      core::TransformNode const child_node = transforms.create(root_node);
+      parents.push_back(root_node);
+      transforms.create(child_node);
+      parents.push_back(child_node);
+    }
+  }
+  ASSERT_EQ(transforms.node_count(), parents.size());
+
+  auto const local_of = [](core::u32 node, float time) {
+    float const t = static_cast<float>(node) * 0.37f + time;
+    return core::Transform {
+        .position = glm::vec3(std::sin(t), std::cos(t) * 2.0f, t * 0.01f),
+        .rotation = glm::angleAxis(t, glm::normalize(glm::vec3(1, t, 2))),
+        .scale = glm::vec3(1.0f + 0.1f * std::sin(t), 0.5f, 2.0f),
+    };
+  };
+  auto const matrix_of = [](core::Transform const& local) {
+    return glm::translate(glm::mat4(1.0f), local.position) *
+        glm::mat4_cast(local.rotation) *
+        glm::scale(glm::mat4(1.0f), local.scale);
+  };
+
+  std::vector<core::Transform> locals(parents.size());
+  auto const expect_glm = [&] {
+    std::vector<glm::mat4> worlds(parents.size());
+    // Parents are created before their children.
+    for (core::u32 node {}; node < parents.size(); ++node) {
+      worlds[node] = parents[node] == core::s_no_transform_node
+          ? matrix_of(locals[node])
+          : worlds[parents[node]] * matrix_of(locals[node]);
+
+      glm::mat4 const& world = transforms.world(node);
+      for (int column {}; column < 4; ++column) {
+        for (int row {}; row < 4; ++row) {
+          ASSERT_NEAR(world[column][row], worlds[node][column][row], 1e-4f);
+        }
+      }
+    }
+  };
+
+  for (core::u32 node {}; node < parents.size(); ++node) {
+    locals[node] = local_of(node, 0.0f);
+    transforms.set_local(node, locals[node]);
+  }
+  transforms.update(jobs);
+  expect_glm();
+
+  // A root and a leaf move, what's below them follows.
+  for (core::u32 node : {59U, 600U}) {
+    locals[node] = local_of(node, 1.0f);
+    transforms.set_local(node, locals[node]);
+  }
+  transforms.update(jobs);
+  expect_glm();
+
+  core::Transform const local = transforms.local(600);
+  ASSERT_EQ(local.position, locals[600].position);
+  ASSERT_EQ(local.scale, locals[600].scale);
+
+  // Nothing set, nothing changes.
+  transforms.update(jobs);
+  expect_glm();
+}
@@ -0,0 +1,121 @@
+#include <core/asset_archive.hpp>
+#include <core/mapped_asset.hpp>
+
+#include <bit>
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+using namespace core;
+
+namespace {
+
+void
+print_usage() {
+    Log::info("Usage: vpak <assets_dir> <output.pak> [options]");
+    Log::sub_info("--compress       LZ4 compress entries that shrink.");
+    Log::sub_info("--align <bytes>  Per-entry data alignment (default 16).");
+}
+
+// A power of two that fits in a u32, the whole argument or nothing.
+std::optional<u32>
+parse_alignment(std::string_view text) {
+    u64 value {0};
+    auto const [end, error] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+
+    if (error != std::errc {} || end != text.data() + text.size() ||
+        value > std::numeric_limits<u32>::max() ||
+        !std::has_single_bit(value)) {
+        return std::nullopt;
+    }
+
+    return static_cast<u32>(value);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv) {
+    if (argc < 3) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    std::filesystem::path const input_dir = argv[1];
+    std::filesystem::path const output_path = argv[2];
+    bool compress {false};
+    u32 alignment {16};
+
+    for (int i {3}; i < argc; ++i) {
+        std::string_view const arg = argv[i];
+
+        if (arg == "--compress") {
+            compress = true;
+        } else if (arg == "--align" && i + 1 < argc) {
+            std::optional<u32> const parsed = parse_alignment(argv[++i]);
+
+            if (!parsed) {
+                Log::error("Not a power of two alignment: ", argv[i]);
+                print_usage();
+                return EXIT_FAILURE;
+            }
+
+            alignment = *parsed;
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!std::filesystem::is_directory(input_dir)) {
+        Log::error("Not a directory: ", input_dir.string());
+        return EXIT_FAILURE;
+    }
+
+    Log::header("Packing assets.");
+
+    AssetArchiveWriter writer {alignment};
+    u64 total_bytes {0};
+
+    for (auto const& item :
+         std::filesystem::recursive_directory_iterator(input_dir)) {
+        if (!item.is_regular_file()) {
+            continue;
+        }
+
+        std::string const relative =
+            item.path().lexically_relative(input_dir).generic_string();
+
+        MappedAsset const file = MappedAsset::open(item.path());
+        writer.add(relative, file.bytes(), compress);
+        total_bytes += file.size();
+
+        Log::sub_info(relative, " (", file.size(), " bytes)");
+    }
+
+    if (!writer.write(output_path)) {
+        Log::error("Failed to write archive: ", output_path.string());
+        return EXIT_FAILURE;
+    }
+
+    Log::info(
+        Log::LIGHT_GREEN,
+        "Packed ",
+        writer.entry_count(),
+        " assets (",
+        total_bytes,
+        " bytes) into ",
+        output_path.string(),
+        " (",
+        std::filesystem::file_size(output_path),
+        " bytes)."
+    );
+
+    return EXIT_SUCCESS;
+}